@@ -0,0 +1,149 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "AdapterSync.h"
+#include "Log.h"
+#include "Trace.h"
+
+bool AdapterSync::readAdapters(HypervisorBackend *backend, int machine, std::vector<backend_adapter_t> *adapters)
+{
+	TRACE_SCOPE("backend", "AdapterSync::readAdapters");
+
+	uint32_t count = backend->getMaxNetworkAdapters(machine);
+	adapters->resize(count);
+
+	for(uint32_t slot = 0; slot < count; slot++)
+	{
+		if(!backend->getAdapter(machine, slot, &adapters->at(slot)))
+		{
+			LOG_ERROR(LOG_VM, "[%s] Cannot read adapter %u", backend->getName(machine).toStdString().c_str(), slot);
+			adapters->resize(slot);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t AdapterSync::writtenFields(const Iface *iface)
+{
+	uint32_t dirty = iface->dirty & IFACE_DIRTY_MACHINE;
+
+	//Settings of a disabled iface are not written, so they are all written once it is enabled
+	if(!iface->enabled)
+		return dirty & (ADAPTER_FIELD_ENABLED | ADAPTER_FIELD_MAC);
+
+	if(dirty & IFACE_DIRTY_ENABLED)
+		dirty |= IFACE_DIRTY_CONNECTED | IFACE_DIRTY_ATTACHMENT_TYPE | IFACE_DIRTY_ATTACHMENT_DATA;
+
+	//Attachment data depends on the attachment type
+	if(dirty & IFACE_DIRTY_ATTACHMENT_TYPE)
+		dirty |= IFACE_DIRTY_ATTACHMENT_DATA;
+
+	return dirty;
+}
+
+bool AdapterSync::writeIfaces(HypervisorBackend *backend, int machine, Iface **ifaces, int ifaces_size)
+{
+	TRACE_SCOPE("backend", "AdapterSync::writeIfaces");
+
+	bool succeeded = true;
+
+	for(int i = 0; i < ifaces_size; i++)
+	{
+		uint32_t fields = writtenFields(ifaces[i]);
+		if(fields == 0)
+			continue;
+
+		backend_adapter_t adapter;
+		adapter.enabled = ifaces[i]->enabled;
+		adapter.mac = ifaces[i]->mac;
+		adapter.cableConnected = ifaces[i]->cableConnected;
+		adapter.attachmentType = ifaces[i]->attachmentType;
+		adapter.attachmentData = ifaces[i]->attachmentData;
+
+		if(backend->setAdapter(machine, i, &adapter, fields))
+			continue;
+
+		LOG_ERROR(LOG_VM, "[%s] Cannot write adapter %d, fields 0x%x", backend->getName(machine).toStdString().c_str(), i, fields);
+		succeeded = false;
+
+		//The iface shows what the machine has
+		if(!backend->getAdapter(machine, i, &adapter))
+			continue;
+
+		if(fields & ADAPTER_FIELD_ENABLED)
+			ifaces[i]->enabled = adapter.enabled;
+		if(fields & ADAPTER_FIELD_MAC)
+			ifaces[i]->setMac(adapter.mac);
+		if(fields & ADAPTER_FIELD_CONNECTED)
+			ifaces[i]->cableConnected = adapter.cableConnected;
+		if(fields & ADAPTER_FIELD_ATTACHMENT_TYPE)
+			ifaces[i]->setAttachmentType(adapter.attachmentType);
+		if(fields & ADAPTER_FIELD_ATTACHMENT_DATA)
+			ifaces[i]->setAttachmentData(adapter.attachmentData);
+	}
+
+	return succeeded;
+}
+
+bool AdapterSync::writeCableStates(HypervisorBackend *backend, int machine, Iface **ifaces, int ifaces_size)
+{
+	TRACE_SCOPE("backend", "AdapterSync::writeCableStates");
+
+	bool succeeded = true;
+
+	for(int i = 0; i < ifaces_size; i++)
+	{
+		if(ifaces[i]->enabled && !writeCableState(backend, machine, i, ifaces[i]->cableConnected))
+			succeeded = false;
+	}
+
+	return succeeded;
+}
+
+bool AdapterSync::writeCableStates(HypervisorBackend *backend, int machine, const settings_iface_t *ifaces, int ifaces_size)
+{
+	TRACE_SCOPE("backend", "AdapterSync::writeCableStates");
+
+	bool succeeded = true;
+
+	for(int i = 0; i < ifaces_size; i++)
+	{
+		if(ifaces[i].enabled && !writeCableState(backend, machine, i, ifaces[i].cableConnected))
+			succeeded = false;
+	}
+
+	return succeeded;
+}
+
+bool AdapterSync::writeCableState(HypervisorBackend *backend, int machine, int iface, bool cableConnected)
+{
+	backend_adapter_t adapter;
+	adapter.cableConnected = cableConnected;
+	if(!backend->setAdapter(machine, iface, &adapter, ADAPTER_FIELD_CONNECTED))
+	{
+		LOG_ERROR(LOG_VM, "[%s] Cannot set cable of adapter %d", backend->getName(machine).toStdString().c_str(), iface);
+		return false;
+	}
+
+	return true;
+}
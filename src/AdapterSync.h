@@ -0,0 +1,70 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ADAPTERSYNC_H
+#define ADAPTERSYNC_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "HypervisorBackend.h"
+#include "Iface.h"
+
+/**
+ * Transfers of the iface settings between a machine of a HypervisorBackend
+ * and its Ifaces, shared by the startup, import and start paths
+ */
+class AdapterSync
+{
+	public:
+		/**
+		 * This function reads every adapter of machine, in slot order,
+		 * and returns false if one of them cannot be read
+		 */
+		static bool readAdapters(HypervisorBackend *backend, int machine, std::vector<backend_adapter_t> *adapters);
+
+		/**
+		 * This function writes to the adapters of machine the dirty
+		 * machine fields of ifaces; it must be called between
+		 * lockMachine() and unlockMachine(). Fields which cannot be
+		 * written are read back into ifaces.
+		 */
+		static bool writeIfaces(HypervisorBackend *backend, int machine, Iface **ifaces, int ifaces_size);
+
+		/**
+		 * This function writes the cable state of the enabled ifaces to
+		 * the adapters of machine before it is started; it must be
+		 * called between lockMachine() and unlockMachine()
+		 */
+		static bool writeCableStates(HypervisorBackend *backend, int machine, Iface **ifaces, int ifaces_size);
+
+		/**
+		 * This function writes the cable states like the one above,
+		 * reading them from a copy of the ifaces taken by another thread
+		 */
+		static bool writeCableStates(HypervisorBackend *backend, int machine, const settings_iface_t *ifaces, int ifaces_size);
+
+	private:
+		static bool writeCableState(HypervisorBackend *backend, int machine, int iface, bool cableConnected);
+		static uint32_t writtenFields(const Iface *iface);
+};
+
+#endif //ADAPTERSYNC_H
@@ -0,0 +1,414 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "AddressParser.h"
+
+static inline uint16_t code(QChar c)
+{
+	return c.unicode();
+}
+
+static inline uint16_t code(char c)
+{
+	return (unsigned char) c;
+}
+
+static inline int hexValue(uint16_t c)
+{
+	if(c >= '0' && c <= '9')
+		return c - '0';
+	if(c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if(c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static inline bool isAlnum(uint16_t c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+template<typename char_t>
+static bool __parseMac(const char_t *str, int length, uint64_t *mac)
+{
+	if(length <= 0)
+		return false;
+
+	uint16_t separator = 0;
+	int separators = 0;
+	for(int i = 0; i < length; i++)
+	{
+		uint16_t c = code(str[i]);
+		if(c != ':' && c != '-' && c != '.')
+			continue;
+
+		if(separator != 0 && c != separator)
+			return false;
+		separator = c;
+		separators++;
+	}
+
+	uint64_t value = 0;
+
+	if(separator == 0)
+	{
+		if(length != 12)
+			return false;
+
+		for(int i = 0; i < length; i++)
+		{
+			int h = hexValue(code(str[i]));
+			if(h < 0)
+				return false;
+			value = (value << 4) | h;
+		}
+
+		*mac = value;
+		return true;
+	}
+
+	//Dotted groups hold four digits, other groups hold one or two
+	bool dotted = (separator == '.');
+	if(separators != (dotted ? 2 : 5))
+		return false;
+
+	int min_digits = dotted ? 4 : 1;
+	int max_digits = dotted ? 4 : 2;
+	int shift = dotted ? 16 : 8;
+
+	uint32_t group = 0;
+	int digits = 0;
+	for(int i = 0; i <= length; i++)
+	{
+		if(i == length || code(str[i]) == separator)
+		{
+			if(digits < min_digits)
+				return false;
+
+			value = (value << shift) | group;
+			group = 0;
+			digits = 0;
+			continue;
+		}
+
+		int h = hexValue(code(str[i]));
+		if(h < 0)
+			return false;
+
+		group = (group << 4) | h;
+		digits++;
+		if(digits > max_digits)
+			return false;
+	}
+
+	*mac = value;
+	return true;
+}
+
+template<typename char_t>
+static bool __parseDecimal(const char_t *str, int length, uint32_t max, uint32_t *value)
+{
+	if(length <= 0)
+		return false;
+
+	uint32_t v = 0;
+	for(int i = 0; i < length; i++)
+	{
+		uint16_t c = code(str[i]);
+		if(c < '0' || c > '9')
+			return false;
+
+		v = v * 10 + (c - '0');
+		if(v > max)
+			return false;
+	}
+
+	*value = v;
+	return true;
+}
+
+template<typename char_t>
+static bool __parseIPv4(const char_t *str, int length, uint32_t *ip)
+{
+	uint32_t value = 0;
+	int octets = 0;
+	int begin = 0;
+
+	for(int i = 0; i <= length; i++)
+	{
+		if(i < length && code(str[i]) != '.')
+			continue;
+
+		uint32_t octet;
+		if(octets == 4 || !__parseDecimal(str + begin, i - begin, 255, &octet))
+			return false;
+
+		value = (value << 8) | octet;
+		octets++;
+		begin = i + 1;
+	}
+
+	if(octets != 4)
+		return false;
+
+	*ip = value;
+	return true;
+}
+
+template<typename char_t>
+static bool __parseIPv6(const char_t *str, int length, ipv6_address_t *ip)
+{
+	int end = length;
+	for(int i = 0; i < length; i++)
+		if(code(str[i]) == '%')
+		{
+			end = i;
+			break;
+		}
+
+	if(end == 0 || end == length - 1)
+		return false;
+
+	for(int i = end + 1; i < length; i++)
+		if(!isAlnum(code(str[i])))
+			return false;
+
+	uint16_t words[8];
+	int count = 0;
+	int gap = -1;
+	int i = 0;
+
+	if(code(str[0]) == ':')
+	{
+		if(end < 2 || code(str[1]) != ':')
+			return false;
+		gap = 0;
+		i = 2;
+	}
+
+	while(i < end)
+	{
+		int j = i;
+		while(j < end && code(str[j]) != ':' && code(str[j]) != '.')
+			j++;
+
+		//A trailing IPv4 address fills the last two words
+		if(j < end && code(str[j]) == '.')
+		{
+			uint32_t ipv4;
+			if(count > 6 || !__parseIPv4(str + i, end - i, &ipv4))
+				return false;
+
+			words[count++] = ipv4 >> 16;
+			words[count++] = ipv4 & 0xFFFF;
+			i = end;
+			break;
+		}
+
+		if(j - i < 1 || j - i > 4 || count == 8)
+			return false;
+
+		uint16_t word = 0;
+		for(int k = i; k < j; k++)
+		{
+			int h = hexValue(code(str[k]));
+			if(h < 0)
+				return false;
+			word = (word << 4) | h;
+		}
+		words[count++] = word;
+
+		i = j;
+		if(i == end)
+			break;
+
+		i++;
+		if(i < end && code(str[i]) == ':')
+		{
+			if(gap >= 0)
+				return false;
+			gap = count;
+			i++;
+		}
+		else if(i == end)
+			return false;
+	}
+
+	if((gap < 0 && count != 8) || (gap >= 0 && count > 7))
+		return false;
+
+	uint16_t full[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	if(gap < 0)
+		gap = count;
+
+	for(int k = 0; k < gap; k++)
+		full[k] = words[k];
+	for(int k = gap; k < count; k++)
+		full[8 - count + k] = words[k];
+
+	//Zone indexes are allowed only on link-local addresses, fe80::/10
+	if(end < length && (full[0] & 0xFFC0) != 0xFE80)
+		return false;
+
+	ip->high = ((uint64_t) full[0] << 48) | ((uint64_t) full[1] << 32) | ((uint64_t) full[2] << 16) | full[3];
+	ip->low = ((uint64_t) full[4] << 48) | ((uint64_t) full[5] << 32) | ((uint64_t) full[6] << 16) | full[7];
+	return true;
+}
+
+bool AddressParser::parseMac(const QChar *str, int length, uint64_t *mac)
+{
+	return __parseMac(str, length, mac);
+}
+
+bool AddressParser::parseMac(const char *str, int length, uint64_t *mac)
+{
+	return __parseMac(str, length, mac);
+}
+
+void AddressParser::formatMac(uint64_t mac, char *out)
+{
+	static const char digits[] = "0123456789ABCDEF";
+
+	for(int i = 0; i < 6; i++)
+	{
+		uint8_t byte = (mac >> (8 * (5 - i))) & 0xFF;
+		out[i * 3] = digits[byte >> 4];
+		out[i * 3 + 1] = digits[byte & 0x0F];
+		out[i * 3 + 2] = (i == 5) ? '\0' : ':';
+	}
+}
+
+QString AddressParser::formatMac(uint64_t mac)
+{
+	if(mac == MAC_NONE)
+		return QString::fromUtf8("");
+
+	char out[MAC_STRING_LENGTH + 1];
+	formatMac(mac, out);
+	return QString::fromLatin1(out, MAC_STRING_LENGTH);
+}
+
+bool AddressParser::parseIPv4(const QChar *str, int length, uint32_t *ip)
+{
+	return __parseIPv4(str, length, ip);
+}
+
+bool AddressParser::parseIPv4(const char *str, int length, uint32_t *ip)
+{
+	return __parseIPv4(str, length, ip);
+}
+
+QString AddressParser::formatIPv4(uint32_t ip)
+{
+	char out[16];
+	int length = 0;
+
+	for(int i = 3; i >= 0; i--)
+	{
+		uint8_t octet = (ip >> (8 * i)) & 0xFF;
+		if(octet >= 100)
+			out[length++] = '0' + octet / 100;
+		if(octet >= 10)
+			out[length++] = '0' + (octet / 10) % 10;
+		out[length++] = '0' + octet % 10;
+		if(i > 0)
+			out[length++] = '.';
+	}
+
+	return QString::fromLatin1(out, length);
+}
+
+bool AddressParser::isReservedIPv4(uint32_t ip)
+{
+	uint8_t a = ip >> 24, b = (ip >> 16) & 0xFF;
+
+	return
+		// Used for broadcast messages to the current network as specified by RFC 1700, page 4
+		(a == 0) ||
+
+		// Used for loopback addresses to the local host, as specified by RFC 990.
+		(a == 127) ||
+
+		/* Used for link-local addresses between two hosts on a single link
+		 * when no IP address is otherwise specified, such as would have
+		 * normally been retrieved from a DHCP server, as specified by RFC 3927.
+		 */
+		(a == 169 && b == 254) ||
+
+		// Reserved for the "limited broadcast" destination address, as specified by RFC 6890.
+		(ip == 0xFFFFFFFF);
+}
+
+bool AddressParser::parseSubnetMask(const QChar *str, int length, uint32_t *mask)
+{
+	uint32_t value;
+	if(!__parseIPv4(str, length, &value))
+		return false;
+
+	//Inverted mask of contiguous bits is one less than a power of two
+	if(((~value + 1) & ~value) != 0)
+		return false;
+
+	*mask = value;
+	return true;
+}
+
+bool AddressParser::parsePrefixLength(const QChar *str, int length, int max, int *prefix)
+{
+	uint32_t value;
+	if(!__parseDecimal(str, length, max, &value))
+		return false;
+
+	*prefix = value;
+	return true;
+}
+
+uint32_t AddressParser::subnetMaskFromPrefix(int prefix)
+{
+	if(prefix <= 0)
+		return 0;
+	if(prefix >= 32)
+		return 0xFFFFFFFF;
+	return 0xFFFFFFFF << (32 - prefix);
+}
+
+int AddressParser::prefixFromSubnetMask(uint32_t mask)
+{
+	int prefix = 0;
+	while(mask & 0x80000000)
+	{
+		prefix++;
+		mask <<= 1;
+	}
+	return prefix;
+}
+
+bool AddressParser::parseIPv6(const QChar *str, int length, ipv6_address_t *ip)
+{
+	return __parseIPv6(str, length, ip);
+}
+
+bool AddressParser::parseIPv6(const char *str, int length, ipv6_address_t *ip)
+{
+	return __parseIPv6(str, length, ip);
+}
@@ -0,0 +1,108 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef ADDRESSPARSER_H
+#define ADDRESSPARSER_H
+
+#include <QChar>
+#include <QString>
+#include <stdint.h>
+
+/** Packed value of an iface without MAC address */
+#define MAC_NONE ((uint64_t) -1)
+
+/** Length of a formatted MAC address, like 01:23:45:67:89:AB */
+#define MAC_STRING_LENGTH 17
+
+#define IP_FAMILY_NONE	0
+#define IP_FAMILY_IPV4	4
+#define IP_FAMILY_IPV6	6
+
+typedef struct
+{
+	uint64_t high, low;
+} ipv6_address_t;
+
+typedef struct
+{
+	int family;
+	uint32_t ipv4;
+	ipv6_address_t ipv6;
+} ip_address_t;
+
+/**
+ * Parsers and formatters for MAC and IP addresses. Parsers work on spans of
+ * UTF-16 (QString::constData()) or ASCII characters without allocating and
+ * return packed values: a MAC address in the 48 lower bits of a uint64_t,
+ * an IPv4 address or subnet mask in host byte order.
+ */
+class AddressParser
+{
+	public:
+		/**
+		 * This function parses a MAC address written as six groups of two
+		 * hexadecimal digits separated by colons or hyphens, three groups of
+		 * four hexadecimal digits separated by dots or twelve hexadecimal
+		 * digits
+		 */
+		static bool parseMac(const QChar *str, int length, uint64_t *mac);
+		static bool parseMac(const char *str, int length, uint64_t *mac);
+
+		/**
+		 * This function writes mac as XX:XX:XX:XX:XX:XX to out, which must
+		 * hold MAC_STRING_LENGTH + 1 characters
+		 */
+		static void formatMac(uint64_t mac, char *out);
+		static QString formatMac(uint64_t mac);
+
+		/**
+		 * This function parses an IPv4 address in dotted decimal notation
+		 */
+		static bool parseIPv4(const QChar *str, int length, uint32_t *ip);
+		static bool parseIPv4(const char *str, int length, uint32_t *ip);
+		static QString formatIPv4(uint32_t ip);
+		static bool isReservedIPv4(uint32_t ip);
+
+		/**
+		 * This function parses a subnet mask in dotted decimal notation,
+		 * accepting only masks with contiguous bits
+		 */
+		static bool parseSubnetMask(const QChar *str, int length, uint32_t *mask);
+
+		/**
+		 * This function parses a prefix length in decimal notation, from 0
+		 * to max
+		 */
+		static bool parsePrefixLength(const QChar *str, int length, int max, int *prefix);
+		static uint32_t subnetMaskFromPrefix(int prefix);
+		static int prefixFromSubnetMask(uint32_t mask);
+
+		/**
+		 * This function parses an IPv6 address, with at most one "::", an
+		 * optional trailing IPv4 address and an optional zone index for
+		 * link-local addresses (fe80::1%eth0)
+		 */
+		static bool parseIPv6(const QChar *str, int length, ipv6_address_t *ip);
+		static bool parseIPv6(const char *str, int length, ipv6_address_t *ip);
+};
+
+#endif //ADDRESSPARSER_H
@@ -0,0 +1,138 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "Benchmark.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+
+Benchmark::Benchmark(uint32_t min_time)
+: min_time_ns(min_time * 1000000ULL)
+{
+	char date[64];
+	time_t t = time(NULL);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&t));
+	addContext("date", date);
+
+	char host_name[256];
+	if(gethostname(host_name, sizeof(host_name)) == 0)
+	{
+		host_name[sizeof(host_name) - 1] = '\0';
+		addContext("host_name", host_name);
+	}
+
+	std::stringstream num_cpus_ss; num_cpus_ss << sysconf(_SC_NPROCESSORS_ONLN);
+	addContext("num_cpus", num_cpus_ss.str());
+}
+
+void Benchmark::setFilter(std::string filter)
+{
+	this->filter = filter;
+}
+
+void Benchmark::addContext(std::string key, std::string value)
+{
+	context.push_back(std::make_pair(key, value));
+}
+
+uint64_t Benchmark::now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void Benchmark::run(std::string name, benchmark_func_t func, void *data, uint64_t bytes_per_iteration)
+{
+	if(!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+
+	uint64_t iterations = 1;
+	uint64_t elapsed;
+
+	while(true)
+	{
+		uint64_t begin = now();
+		func(data, iterations);
+		elapsed = now() - begin;
+
+		if(elapsed >= min_time_ns || iterations >= BENCHMARK_MAX_ITERATIONS)
+			break;
+
+		//Short runs are only used to size the next one, which should last a bit more than the minimum time
+		uint64_t next;
+		if(elapsed < min_time_ns / 10)
+			next = iterations * 10;
+		else
+			next = iterations * (min_time_ns * 1.2 / elapsed) + 1;
+
+		iterations = (next < BENCHMARK_MAX_ITERATIONS) ? next : BENCHMARK_MAX_ITERATIONS;
+	}
+
+	benchmark_result_t result;
+	result.name = name;
+	result.iterations = iterations;
+	result.ns_per_iteration = (double) elapsed / iterations;
+	result.bytes_per_iteration = bytes_per_iteration;
+	results.push_back(result);
+
+	std::cerr << std::left << std::setw(40) << name << std::right << std::setw(16) << std::fixed << std::setprecision(1) << result.ns_per_iteration << " ns" << std::setw(14) << iterations << std::endl;
+}
+
+std::string Benchmark::escape(std::string s)
+{
+	std::string escaped;
+	for(int i = 0; i < s.size(); i++)
+	{
+		if(s.at(i) == '"' || s.at(i) == '\\')
+			escaped.push_back('\\');
+		escaped.push_back(s.at(i));
+	}
+
+	return escaped;
+}
+
+void Benchmark::writeJson(std::ostream &out)
+{
+	out << "{" << std::endl << "  \"context\": {" << std::endl;
+	for(int i = 0; i < context.size(); i++)
+		out << "    \"" << escape(context.at(i).first) << "\": \"" << escape(context.at(i).second) << "\"" << ((i + 1 < context.size()) ? "," : "") << std::endl;
+	out << "  }," << std::endl << "  \"benchmarks\": [" << std::endl;
+
+	for(int i = 0; i < results.size(); i++)
+	{
+		const benchmark_result_t *result = &results.at(i);
+		out << "    {" << std::endl
+		    << "      \"name\": \"" << escape(result->name) << "\"," << std::endl
+		    << "      \"iterations\": " << result->iterations << "," << std::endl
+		    << "      \"real_time\": " << std::fixed << std::setprecision(3) << result->ns_per_iteration << "," << std::endl;
+
+		if(result->bytes_per_iteration > 0)
+			out << "      \"bytes_per_second\": " << std::setprecision(0) << (result->bytes_per_iteration * 1e9 / result->ns_per_iteration) << "," << std::endl;
+
+		out << "      \"time_unit\": \"ns\"" << std::endl
+		    << "    }" << ((i + 1 < results.size()) ? "," : "") << std::endl;
+	}
+
+	out << "  ]" << std::endl << "}" << std::endl;
+}
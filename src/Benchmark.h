@@ -0,0 +1,91 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <ostream>
+#include <stdint.h>
+
+/** Minimum time a benchmark case is run for, in ms */
+#define BENCHMARK_MIN_TIME 500
+
+/** Maximum number of iterations of a benchmark case */
+#define BENCHMARK_MAX_ITERATIONS 1000000000ULL
+
+/**
+ * Benchmark case: runs the measured operation iterations times on data
+ */
+typedef void (*benchmark_func_t)(void *data, uint64_t iterations);
+
+typedef struct
+{
+	std::string name;
+	uint64_t iterations;
+	double ns_per_iteration;
+	uint64_t bytes_per_iteration;
+} benchmark_result_t;
+
+/**
+ * Minimal benchmark harness. Each case is run again with more iterations
+ * until it lasts at least the minimum time, then its time per iteration is
+ * recorded. Results are written as JSON, with the same keys used by Google
+ * Benchmark so the usual comparison tools can read them.
+ */
+class Benchmark
+{
+	public:
+		Benchmark(uint32_t min_time = BENCHMARK_MIN_TIME);
+
+		/**
+		 * This function makes run() skip the cases whose name does not
+		 * contain filter
+		 */
+		void setFilter(std::string filter);
+
+		/**
+		 * This function adds key to the context written with the results
+		 */
+		void addContext(std::string key, std::string value);
+
+		/**
+		 * This function measures func and records its result. If
+		 * bytes_per_iteration is not 0 the throughput is recorded too.
+		 */
+		void run(std::string name, benchmark_func_t func, void *data, uint64_t bytes_per_iteration = 0);
+
+		void writeJson(std::ostream &out);
+		const std::vector<benchmark_result_t> &getResults() const { return results; };
+
+	private:
+		static uint64_t now();
+		static std::string escape(std::string s);
+
+		uint64_t min_time_ns;
+		std::string filter;
+		std::vector<std::pair<std::string, std::string> > context;
+		std::vector<benchmark_result_t> results;
+};
+
+#endif //BENCHMARK_H
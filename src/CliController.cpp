@@ -0,0 +1,393 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "CliController.h"
+#include "MacAllocator.h"
+#include "OSBridge.h"
+#include "XpcomBackend.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+CliController::CliController(std::ostream &out)
+: out(out), vboxbridge(new VirtualBoxBridge()), nbdChecked(false)
+{
+	machines_vec = vboxbridge->getMachines(NULL);
+	vm_vec.assign(machines_vec.size(), NULL);
+	backend = new XpcomBackend(&machines_vec);
+
+	for(int i = 0; i < machines_vec.size(); i++)
+		vboxbridge->getMacAllocator()->addMachine(machines_vec.at(i));
+
+	const char *tmpdir = getenv("TMPDIR");
+	if(tmpdir == NULL)
+		tmpdir = "/tmp";
+
+	std::stringstream tmpdir_prefix_ss; tmpdir_prefix_ss << tmpdir << "/" << PROGRAM_NAME;
+	tmpdir_prefix = tmpdir_prefix_ss.str();
+}
+
+CliController::~CliController()
+{
+	while(!vm_vec.empty())
+	{
+		if(vm_vec.back() != NULL)
+		{
+			delete vm_vec.back()->vmSettings;
+			delete vm_vec.back();
+		}
+		vm_vec.pop_back();
+	}
+
+	while(!machines_vec.empty())
+	{
+		delete machines_vec.back();
+		machines_vec.pop_back();
+	}
+
+	delete backend;
+	delete vboxbridge;
+}
+
+int CliController::list()
+{
+	for(int i = 0; i < backend->getMachinesCount(); i++)
+		out << backend->getName(i).toStdString() << "\t"
+		    << backend->getUUID(i).toStdString() << "\t"
+		    << stateName(backend->getState(i)) << std::endl;
+
+	return EXIT_SUCCESS;
+}
+
+int CliController::start(QStringList names)
+{
+	std::vector<int> machines;
+	bool succeeded = select(names, machines);
+
+	//Every machine is launched before waiting for the first one
+	std::vector<HypervisorProgress*> progresses(machines.size(), (HypervisorProgress *) NULL);
+	for(int i = 0; i < machines.size(); i++)
+	{
+		if(isRunning(backend->getState(machines.at(i))))
+		{
+			out << backend->getName(machines.at(i)).toStdString() << "\talready running" << std::endl;
+			continue;
+		}
+
+		//Cable state is already the one saved on the adapters
+		progresses[i] = backend->launch(machines.at(i));
+		if(progresses.at(i) == NULL)
+		{
+			out << backend->getName(machines.at(i)).toStdString() << "\tfailed" << std::endl;
+			succeeded = false;
+		}
+	}
+
+	succeeded = waitAll(machines, progresses, "started") && succeeded;
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int CliController::stop(QStringList names, bool acpi)
+{
+	std::vector<int> machines;
+	bool succeeded = select(names, machines);
+
+	std::vector<HypervisorProgress*> progresses(machines.size(), (HypervisorProgress *) NULL);
+	for(int i = 0; i < machines.size(); i++)
+	{
+		if(!isRunning(backend->getState(machines.at(i))))
+		{
+			out << backend->getName(machines.at(i)).toStdString() << "\tnot running" << std::endl;
+			continue;
+		}
+
+		//The power button has no progress, the guest shuts down by itself
+		if(acpi)
+		{
+			bool stopped = machines_vec.at(machines.at(i))->stop(false);
+			out << backend->getName(machines.at(i)).toStdString() << "\t" << (stopped ? "stopped" : "failed") << std::endl;
+			succeeded = succeeded && stopped;
+			continue;
+		}
+
+		progresses[i] = backend->powerDown(machines.at(i));
+		if(progresses.at(i) == NULL)
+		{
+			out << backend->getName(machines.at(i)).toStdString() << "\tfailed" << std::endl;
+			succeeded = false;
+		}
+	}
+
+	succeeded = waitAll(machines, progresses, "stopped") && succeeded;
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int CliController::exportMachines(QString fileName, QStringList names, bool deflate, QString base_fileName)
+{
+	std::vector<int> machines;
+	if(!select(names, machines))
+		return EXIT_FAILURE;
+
+	std::vector<VirtualMachine*> vms;
+	for(int i = 0; i < machines.size(); i++)
+		vms.push_back(getVM(machines.at(i)));
+
+	char type;
+	if(!base_fileName.isEmpty())
+		type = 'D';
+#ifdef USE_ZLIB
+	else if(deflate)
+		type = 'Z';
+#endif
+	else
+		type = 'P';
+
+	if(!VMSettings::write_machines(fileName, vms, type, base_fileName))
+	{
+		std::cerr << "Cannot write " << fileName.toStdString() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	for(int i = 0; i < vms.size(); i++)
+		out << vms.at(i)->machine->getName().toStdString() << "\texported" << std::endl;
+
+	return EXIT_SUCCESS;
+}
+
+int CliController::importMachines(QString fileName, QStringList names, bool stopRunning, bool create)
+{
+	MachinesArchive archive;
+	if(archive.open(fileName) != NO_ERROR)
+	{
+		std::cerr << "Cannot read " << fileName.toStdString() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	//Machines created here need an nbd device too
+	loadNbdModule(machines_vec.size() + archive.size());
+
+	bool succeeded = true;
+	for(uint32_t i = 0; i < archive.size(); i++)
+	{
+		const settings_header_t *settings_header = archive.header(i);
+		QString name = QString::fromUtf8(settings_header->machine_name);
+		QString uuid = QString::fromUtf8(settings_header->machine_uuid);
+
+		if(!names.isEmpty() && !names.contains(name) && !names.contains(uuid))
+			continue;
+
+		int machine = find(uuid);
+		if(machine < 0)
+		{
+			if(!create)
+			{
+				out << name.toStdString() << "\tmissing" << std::endl;
+				succeeded = false;
+				continue;
+			}
+
+			machine = createMachine(settings_header);
+			if(machine < 0)
+			{
+				out << name.toStdString() << "\tfailed" << std::endl;
+				succeeded = false;
+				continue;
+			}
+		}
+
+		if(isRunning(backend->getState(machine)))
+		{
+			if(!stopRunning || !machines_vec.at(machine)->stop(true))
+			{
+				out << name.toStdString() << "\trunning" << std::endl;
+				succeeded = false;
+				continue;
+			}
+		}
+
+		VirtualMachine *vm = getVM(machine);
+		if(!vm->vmSettings->set_machine(*settings_header, archive.ifaces(i)))
+		{
+			out << name.toStdString() << "\tinvalid" << std::endl;
+			succeeded = false;
+			continue;
+		}
+
+		vm->vmSettings->restore();
+		bool saved = vm->saveSettings();
+		out << name.toStdString() << "\t" << (saved ? "imported" : "failed") << std::endl;
+		succeeded = succeeded && saved;
+
+		MacAllocator *macAllocator = vboxbridge->getMacAllocator();
+		macAllocator->updateMachine(vm);
+		QStringList collisions = macAllocator->collisions(vm);
+		if(!collisions.isEmpty())
+			std::cerr << "[" << settings_header->machine_name << "] Duplicate MAC addresses: " << collisions.join(", ").toStdString() << std::endl;
+	}
+
+	return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool CliController::waitAll(std::vector<int> &machines, std::vector<HypervisorProgress*> &progresses, const char *result)
+{
+	bool succeeded = true;
+
+	for(int i = 0; i < progresses.size(); i++)
+	{
+		if(progresses.at(i) == NULL)
+			continue;
+
+		int32_t resultCode = HypervisorBackend::wait(progresses.at(i));
+		delete progresses.at(i);
+		progresses[i] = NULL;
+
+		if(resultCode != 0)
+			std::cerr << "[" << backend->getName(machines.at(i)).toStdString() << "] Result code: 0x" << std::hex << resultCode << std::dec << std::endl;
+
+		out << backend->getName(machines.at(i)).toStdString() << "\t" << ((resultCode == 0) ? result : "failed") << std::endl;
+		succeeded = succeeded && (resultCode == 0);
+	}
+
+	return succeeded;
+}
+
+int CliController::find(QString name)
+{
+	for(int i = 0; i < machines_vec.size(); i++)
+		if(machines_vec.at(i)->getUUID() == name || machines_vec.at(i)->getName() == name)
+			return i;
+
+	return -1;
+}
+
+bool CliController::select(QStringList names, std::vector<int> &machines)
+{
+	if(names.isEmpty())
+	{
+		for(int i = 0; i < machines_vec.size(); i++)
+			machines.push_back(i);
+		return true;
+	}
+
+	bool found = true;
+	for(int i = 0; i < names.size(); i++)
+	{
+		int machine = find(names.at(i));
+		if(machine < 0)
+		{
+			std::cerr << "Machine " << names.at(i).toStdString() << " not found" << std::endl;
+			found = false;
+		}
+		else
+			machines.push_back(machine);
+	}
+
+	return found;
+}
+
+int CliController::createMachine(const settings_header_t *settings_header)
+{
+	IMachine *m = vboxbridge->newVM(QString::fromUtf8(settings_header->machine_name));
+	if(m == NULL)
+		return -1;
+
+	MachineBridge *machine = new MachineBridge(vboxbridge, m, NULL);
+	machines_vec.push_back(machine);
+	vm_vec.push_back(NULL);
+	vboxbridge->getMacAllocator()->addMachine(machine);
+
+	if(!machine->lockMachine())
+	{
+		std::cerr << "[" << machine->getName().toStdString() <<  "] Cannot lock machine" << std::endl;
+		return -1;
+	}
+
+	bool succeeded = machine->setUUID(settings_header->machine_uuid);
+	machine->saveSettings();
+
+	if(!machine->unlockMachine() || !succeeded)
+		return -1;
+
+	return machines_vec.size() - 1;
+}
+
+VirtualMachine *CliController::getVM(int machine)
+{
+	if(vm_vec.at(machine) != NULL)
+		return vm_vec.at(machine);
+
+	loadNbdModule(machines_vec.size());
+
+	struct stat s;
+	if(stat(tmpdir_prefix.c_str(), &s) < 0 && errno == ENOENT)
+		mkdir(tmpdir_prefix.c_str(), 0777);
+
+	//Devices are numbered as in the main window, so each machine always uses the same one
+	std::stringstream mountpoint_ss; mountpoint_ss << "/dev/nbd" << machine;
+	std::stringstream partition_mountpoint_prefix_ss; partition_mountpoint_prefix_ss << tmpdir_prefix << "/nbd" << machine;
+
+	VirtualMachine *vm = new VirtualMachine(machines_vec.at(machine), mountpoint_ss.str(), partition_mountpoint_prefix_ss.str(), backend, machine);
+	vm->vmSettings = new VMSettings(vm);
+	vm_vec[machine] = vm;
+
+	vboxbridge->getMacAllocator()->updateMachine(vm);
+	return vm;
+}
+
+void CliController::loadNbdModule(int devices)
+{
+	//A module loaded by another instance is kept, its devices may be in use
+	if(nbdChecked)
+		return;
+
+	if(!OSBridge::checkNbdModule())
+		OSBridge::loadNbdModule(devices);
+	nbdChecked = true;
+}
+
+bool CliController::isRunning(uint32_t machineState)
+{
+	return machineState == MachineState::Running ||
+	       machineState == MachineState::Paused ||
+	       machineState == MachineState::Starting;
+}
+
+const char *CliController::stateName(uint32_t machineState)
+{
+	switch(machineState)
+	{
+		case MachineState::PoweredOff:	return "poweredoff";
+		case MachineState::Saved:	return "saved";
+		case MachineState::Aborted:	return "aborted";
+		case MachineState::Running:	return "running";
+		case MachineState::Paused:	return "paused";
+		case MachineState::Stuck:	return "stuck";
+		case MachineState::Starting:	return "starting";
+		case MachineState::Stopping:	return "stopping";
+		case MachineState::Saving:	return "saving";
+		case MachineState::Restoring:	return "restoring";
+		default:			return "unknown";
+	}
+}
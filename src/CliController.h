@@ -0,0 +1,107 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef CLICONTROLLER_H
+#define CLICONTROLLER_H
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "VirtualBoxBridge.h"
+#include "VirtualMachine.h"
+#include "MachinesArchive.h"
+#include "HypervisorBackend.h"
+
+/**
+ * Front end of the command line tool, built on the same core of the main
+ * window but without widgets. Machines are read from VirtualBox once; their
+ * guest settings are loaded only by the commands which need them (export
+ * and import), so listing, starting and stopping never mount a disk.
+ * Machines are started and powered down through a HypervisorBackend, all of
+ * them at once. Command results are written to out, diagnostics to std::cerr.
+ * Each command returns EXIT_SUCCESS if every selected machine succeeded.
+ */
+class CliController
+{
+	public:
+		CliController(std::ostream &out);
+		virtual ~CliController();
+
+		int list();
+		int start(QStringList names);
+		int stop(QStringList names, bool acpi = false);
+
+		/**
+		 * This function saves the settings of the selected machines (all
+		 * of them if names is empty) to a machines set file. A delta
+		 * archive is written if base_fileName is not empty.
+		 */
+		int exportMachines(QString fileName, QStringList names, bool deflate = false, QString base_fileName = "");
+
+		/**
+		 * This function applies the settings of the selected machines of a
+		 * machines set file (all of them if names is empty). Running
+		 * machines are stopped only if stopRunning is true, missing ones
+		 * are created only if create is true.
+		 */
+		int importMachines(QString fileName, QStringList names, bool stopRunning = false, bool create = false);
+
+	private:
+		/**
+		 * This function returns the index of the machine named or
+		 * identified by name, -1 if it does not exist
+		 */
+		int find(QString name);
+
+		/**
+		 * This function appends to machines the indexes of the machines
+		 * in names (all of them if names is empty) and returns false if
+		 * any of them does not exist
+		 */
+		bool select(QStringList names, std::vector<int> &machines);
+
+		/**
+		 * This function waits for the progresses of machines, writing
+		 * result for each succeeded one, and deletes them. This function
+		 * returns false if any of them failed.
+		 */
+		bool waitAll(std::vector<int> &machines, std::vector<HypervisorProgress*> &progresses, const char *result);
+
+		int createMachine(const settings_header_t *settings_header);
+		VirtualMachine *getVM(int machine);
+		void loadNbdModule(int devices);
+
+		static bool isRunning(uint32_t machineState);
+		static const char *stateName(uint32_t machineState);
+
+		std::ostream &out;
+		VirtualBoxBridge *vboxbridge;
+		std::vector<MachineBridge*> machines_vec;
+		HypervisorBackend *backend;
+		std::vector<VirtualMachine*> vm_vec;
+		std::string tmpdir_prefix;
+		bool nbdChecked;
+};
+
+#endif //CLICONTROLLER_H
@@ -0,0 +1,282 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "FakeBackend.h"
+#include "VirtualBox_XPCOM.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+FakeProgress::FakeProgress(uint32_t duration, uint32_t *state, uint32_t finalState, int32_t resultCode)
+: duration(duration), state(state), finalState(finalState), resultCode(resultCode), completed(false)
+{
+	timer.start();
+}
+
+FakeProgress::~FakeProgress()
+{
+
+}
+
+bool FakeProgress::isCompleted()
+{
+	if(!completed && timer.elapsed() >= duration)
+	{
+		*state = finalState;
+		completed = true;
+	}
+
+	return completed;
+}
+
+uint32_t FakeProgress::getPercent()
+{
+	if(isCompleted() || duration == 0)
+		return 100;
+
+	return timer.elapsed() * 100 / duration;
+}
+
+int32_t FakeProgress::getResultCode()
+{
+	return resultCode;
+}
+
+void FakeProgress::waitForCompletion(int timeout)
+{
+	if(isCompleted())
+		return;
+
+	qint64 remaining = duration - timer.elapsed();
+	if(timeout >= 0 && timeout < remaining)
+		remaining = timeout;
+
+	if(remaining > 0)
+		usleep(remaining * 1000);
+
+	isCompleted();
+}
+
+FakeBackend::FakeBackend(int machines, uint32_t adapters)
+: callLatency(0), progressDuration(0), calls(0)
+{
+	for(int i = 0; i < machines; i++)
+	{
+		fake_machine_t machine;
+		char uuid[37];
+		snprintf(uuid, sizeof(uuid), "00000000-0000-0000-0000-%012x", i);
+
+		machine.name = QString("vm%1").arg(i);
+		machine.uuid = QString::fromUtf8(uuid);
+		machine.state = MachineState::PoweredOff;
+		machine.locked = false;
+		machine.launchResult = 0;
+
+		//Only the first adapter is enabled, as in a new VirtualBox machine
+		for(uint32_t slot = 0; slot < adapters; slot++)
+		{
+			backend_adapter_t adapter;
+			uint32_t index = i * adapters + slot;
+			char mac[18];
+			snprintf(mac, sizeof(mac), "08:00:27:%02X:%02X:%02X", (index >> 16) & 0xFF, (index >> 8) & 0xFF, index & 0xFF);
+
+			adapter.enabled = (slot == 0);
+			adapter.mac = QString::fromUtf8(mac);
+			adapter.cableConnected = (slot == 0);
+			adapter.attachmentType = (slot == 0) ? NetworkAttachmentType::NAT : NetworkAttachmentType::Null;
+			adapter.attachmentData = QString::fromUtf8("");
+			machine.adapters.push_back(adapter);
+		}
+
+		this->machines.push_back(machine);
+	}
+}
+
+FakeBackend::~FakeBackend()
+{
+
+}
+
+void FakeBackend::setCallLatency(uint32_t latency)
+{
+	callLatency = latency;
+}
+
+void FakeBackend::setProgressDuration(uint32_t duration)
+{
+	progressDuration = duration;
+}
+
+void FakeBackend::setLaunchResult(int machine, int32_t resultCode)
+{
+	machines.at(machine).launchResult = resultCode;
+}
+
+uint64_t FakeBackend::getCalls()
+{
+	return calls;
+}
+
+void FakeBackend::call()
+{
+	calls++;
+	if(callLatency > 0)
+		usleep(callLatency);
+}
+
+bool FakeBackend::isRunning(uint32_t state)
+{
+	return state == MachineState::Starting ||
+	       state == MachineState::Running ||
+	       state == MachineState::Paused ||
+	       state == MachineState::Stopping;
+}
+
+int FakeBackend::getMachinesCount()
+{
+	call();
+	return machines.size();
+}
+
+QString FakeBackend::getName(int machine)
+{
+	call();
+	return machines.at(machine).name;
+}
+
+QString FakeBackend::getUUID(int machine)
+{
+	call();
+	return machines.at(machine).uuid;
+}
+
+uint32_t FakeBackend::getState(int machine)
+{
+	call();
+	return machines.at(machine).state;
+}
+
+uint32_t FakeBackend::getMaxNetworkAdapters(int machine)
+{
+	call();
+	return machines.at(machine).adapters.size();
+}
+
+bool FakeBackend::getAdapter(int machine, uint32_t slot, backend_adapter_t *adapter)
+{
+	call();
+	if(slot >= machines.at(machine).adapters.size())
+		return false;
+
+	*adapter = machines.at(machine).adapters.at(slot);
+	return true;
+}
+
+bool FakeBackend::setAdapter(int machine, uint32_t slot, const backend_adapter_t *adapter, uint32_t fields)
+{
+	fake_machine_t *m = &machines.at(machine);
+	if(!m->locked || slot >= m->adapters.size())
+		return false;
+
+	//Each field is a separate call in VirtualBox
+	backend_adapter_t *current = &m->adapters.at(slot);
+	if(fields & ADAPTER_FIELD_ENABLED)
+	{
+		call();
+		current->enabled = adapter->enabled;
+	}
+	if(fields & ADAPTER_FIELD_MAC)
+	{
+		call();
+		current->mac = adapter->mac;
+	}
+	if(fields & ADAPTER_FIELD_CONNECTED)
+	{
+		call();
+		current->cableConnected = adapter->cableConnected;
+	}
+	if(fields & ADAPTER_FIELD_ATTACHMENT_TYPE)
+	{
+		call();
+		current->attachmentType = adapter->attachmentType;
+	}
+	if(fields & ADAPTER_FIELD_ATTACHMENT_DATA)
+	{
+		call();
+		current->attachmentData = adapter->attachmentData;
+	}
+
+	return true;
+}
+
+bool FakeBackend::lockMachine(int machine)
+{
+	call();
+	fake_machine_t *m = &machines.at(machine);
+	if(m->locked || isRunning(m->state))
+		return false;
+
+	m->locked = true;
+	return true;
+}
+
+bool FakeBackend::saveSettings(int machine)
+{
+	call();
+	fake_machine_t *m = &machines.at(machine);
+	if(!m->locked)
+		return false;
+
+	return true;
+}
+
+bool FakeBackend::unlockMachine(int machine)
+{
+	call();
+	fake_machine_t *m = &machines.at(machine);
+	if(!m->locked)
+		return false;
+
+	m->locked = false;
+	return true;
+}
+
+HypervisorProgress *FakeBackend::launch(int machine)
+{
+	call();
+	fake_machine_t *m = &machines.at(machine);
+	if(m->locked || isRunning(m->state))
+		return NULL;
+
+	m->state = MachineState::Starting;
+	return new FakeProgress(progressDuration, &m->state, (m->launchResult == 0) ? MachineState::Running : MachineState::PoweredOff, m->launchResult);
+}
+
+HypervisorProgress *FakeBackend::powerDown(int machine)
+{
+	call();
+	fake_machine_t *m = &machines.at(machine);
+	if(m->state != MachineState::Running && m->state != MachineState::Paused)
+		return NULL;
+
+	m->state = MachineState::Stopping;
+	return new FakeProgress(progressDuration, &m->state, MachineState::PoweredOff);
+}
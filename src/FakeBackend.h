@@ -0,0 +1,126 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef FAKEBACKEND_H
+#define FAKEBACKEND_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <vector>
+#include <stdint.h>
+
+#include "HypervisorBackend.h"
+
+/**
+ * Progress completed after a fixed duration, its percent grows linearly.
+ * On completion state is set to finalState.
+ */
+class FakeProgress : public HypervisorProgress
+{
+	public:
+		FakeProgress(uint32_t duration, uint32_t *state, uint32_t finalState, int32_t resultCode = 0);
+		virtual ~FakeProgress();
+
+		bool isCompleted();
+		uint32_t getPercent();
+		int32_t getResultCode();
+		void waitForCompletion(int timeout);
+
+	private:
+		QElapsedTimer timer;
+		uint32_t duration;
+		uint32_t *state;
+		uint32_t finalState;
+		int32_t resultCode;
+		bool completed;
+};
+
+/**
+ * In-memory HypervisorBackend for benchmarks and tests, with no VirtualBox
+ * behind it. Every call waits for the configured latency before running;
+ * launches and power downs complete after the configured progress duration.
+ * Machine states change only when their progress is checked.
+ */
+class FakeBackend : public HypervisorBackend
+{
+	public:
+		FakeBackend(int machines, uint32_t adapters = 8);
+		virtual ~FakeBackend();
+
+		/**
+		 * This function sets the time spent in each call, in us
+		 */
+		void setCallLatency(uint32_t latency);
+
+		/**
+		 * This function sets the time taken by launches and power downs,
+		 * in ms
+		 */
+		void setProgressDuration(uint32_t duration);
+
+		/**
+		 * This function sets the result code of the next launches of
+		 * machine, a launch fails if resultCode is not 0
+		 */
+		void setLaunchResult(int machine, int32_t resultCode);
+
+		/**
+		 * This function returns the number of calls made to the backend
+		 */
+		uint64_t getCalls();
+
+		int getMachinesCount();
+		QString getName(int machine);
+		QString getUUID(int machine);
+		uint32_t getState(int machine);
+		uint32_t getMaxNetworkAdapters(int machine);
+
+		bool getAdapter(int machine, uint32_t slot, backend_adapter_t *adapter);
+		bool setAdapter(int machine, uint32_t slot, const backend_adapter_t *adapter, uint32_t fields = ADAPTER_FIELD_ALL);
+
+		bool lockMachine(int machine);
+		bool saveSettings(int machine);
+		bool unlockMachine(int machine);
+
+		HypervisorProgress *launch(int machine);
+		HypervisorProgress *powerDown(int machine);
+
+	private:
+		typedef struct
+		{
+			QString name;
+			QString uuid;
+			uint32_t state;
+			bool locked;
+			int32_t launchResult;
+			std::vector<backend_adapter_t> adapters;
+		} fake_machine_t;
+
+		void call();
+		static bool isRunning(uint32_t state);
+
+		std::vector<fake_machine_t> machines;
+		uint32_t callLatency;
+		uint32_t progressDuration;
+		uint64_t calls;
+};
+
+#endif //FAKEBACKEND_H
@@ -0,0 +1,134 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "GuestConfig.h"
+
+#include <QFile>
+#include <string>
+
+QString GuestConfig::parseIfaceName(QString fileName, QString mac, QString defaultName)
+{
+	//read from /etc/udev/rules.d/70-persistent-net.rules
+	/* .
+	 * .
+	 * 
+	 * # (01:23:45:67:89:0A) iface0
+	 * SUBSYSTEM=="net", ACTION=="add", DRIVERS=="?*", ATTR{address}=="01:23:45:67:89:0A", ATTR{dev_id}=="0x0", ATTR{type}=="1", KERNEL=="eth*", NAME="iface0"
+	 * 
+	 * -
+	 * -
+	 */
+	QString iface_name = defaultName;
+	QString match = QString::fromUtf8("{address}==\"").toUpper().append(mac.toUpper()).append("\"");
+
+	QFile file(fileName);
+
+	if(file.open(QIODevice::ReadOnly))
+	{
+		while(!file.atEnd())
+		{
+			QString line = file.readLine();
+			if(!line.trimmed().startsWith('#') && line.toUpper().contains(match))
+			{
+				int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("NAME="));
+				int ifacename_index_end = QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 6)).lastIndexOf(QString::fromUtf8("\""));
+				iface_name = QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 6, ifacename_index_end));
+				break;
+			}
+		}
+		file.close();
+	}
+
+	return iface_name;
+}
+
+bool GuestConfig::parseIfcfg(QString fileName, QString ifaceName, QString mac, ifcfg_settings_t *ifcfg)
+{
+	//read from /etc/sysconfig/network-scripts/ifcfg-IFACE_NAME
+	/*
+	 * DEVICE=eth0
+	 * HWADDR=08:00:27:C9:2D:87
+	 * IPADDR=208.164.186.1
+	 * NETMASK=255.255.255.0
+	 * ONBOOT=yes
+	 * BOOTPROTO=none
+	 */
+	ifcfg->ip = QString::fromUtf8("");
+	ifcfg->subnetMask = QString::fromUtf8("");
+	ifcfg->nameMatches = false;
+	ifcfg->macMatches = false;
+
+	QString match_name = QString::fromUtf8("DEVICE=").append(ifaceName.toUpper());
+	QString match_mac = QString::fromUtf8("HWADDR=").append(mac.toUpper());
+
+	QFile file(fileName);
+
+	if(!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QString iface_ip_tmp = QString::fromUtf8("");
+	QString iface_subnetMask_tmp = QString::fromUtf8("");
+	while(!file.atEnd())
+	{
+		QString line = file.readLine();
+		QString line_upper = line.toUpper();
+		if(!ifcfg->nameMatches && line_upper.contains(match_name))
+			ifcfg->nameMatches = true;
+		if(!ifcfg->macMatches && line_upper.contains(match_mac))
+			ifcfg->macMatches = true;
+
+		if(line_upper.contains(QString::fromUtf8("IPADDR=")))
+		{
+			int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("IPADDR="));
+			iface_ip_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 7))).trimmed();
+		}
+		else if(line_upper.contains(QString::fromUtf8("IPV6ADDR=")))
+		{
+			int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("IPV6ADDR="));
+			int ifacename_index_end = line.lastIndexOf(QString::fromUtf8("/"));
+			iface_ip_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 9, ifacename_index_end - (ifacename_index_begin + 9)))).trimmed();
+		}
+
+		if(line_upper.contains(QString::fromUtf8("NETMASK=")))
+		{
+			int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("NETMASK="));
+			iface_subnetMask_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 8))).trimmed();
+		}
+#ifdef ENABLE_IPv6
+		else if(line_upper.contains(QString::fromUtf8("IPV6ADDR=")))
+		{
+			int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("/"));
+			if(ifacename_index_begin > -1)
+				iface_subnetMask_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 1))).trimmed();
+		}
+#endif
+	}
+
+	file.close();
+
+	if(ifcfg->macMatches)
+	{
+		ifcfg->ip = iface_ip_tmp;
+		ifcfg->subnetMask = iface_subnetMask_tmp;
+	}
+
+	return true;
+}
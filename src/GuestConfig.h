@@ -0,0 +1,58 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef GUESTCONFIG_H
+#define GUESTCONFIG_H
+
+#include <QString>
+
+/**
+ * Settings of an iface read from its ifcfg file: ip and subnetMask are set
+ * only if the file belongs to the iface MAC address
+ */
+typedef struct
+{
+	QString ip;
+	QString subnetMask;
+	bool nameMatches;
+	bool macMatches;
+} ifcfg_settings_t;
+
+/**
+ * Parsers of the network settings files of a guest partition
+ */
+class GuestConfig
+{
+	public:
+		/**
+		 * This function returns the name given to mac by the udev rules
+		 * file fileName, defaultName if mac is not found
+		 */
+		static QString parseIfaceName(QString fileName, QString mac, QString defaultName);
+
+		/**
+		 * This function reads the settings of ifaceName from the ifcfg
+		 * file fileName and returns false if it cannot be read
+		 */
+		static bool parseIfcfg(QString fileName, QString ifaceName, QString mac, ifcfg_settings_t *ifcfg);
+};
+
+#endif //GUESTCONFIG_H
@@ -0,0 +1,119 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef HYPERVISORBACKEND_H
+#define HYPERVISORBACKEND_H
+
+#include <QString>
+#include <stdint.h>
+
+/**
+ * Adapter fields written by HypervisorBackend::setAdapter. Their values are
+ * the ones of IFACE_DIRTY_MACHINE bits, so a dirty mask can be passed as is.
+ */
+#define ADAPTER_FIELD_ENABLED		(1 << 0)
+#define ADAPTER_FIELD_MAC		(1 << 1)
+#define ADAPTER_FIELD_CONNECTED		(1 << 2)
+#define ADAPTER_FIELD_ATTACHMENT_TYPE	(1 << 3)
+#define ADAPTER_FIELD_ATTACHMENT_DATA	(1 << 4)
+#define ADAPTER_FIELD_ALL		0x1F
+
+/** Milliseconds between two checks of a progress in HypervisorBackend::wait */
+#define BACKEND_WAIT_INTERVAL 100
+
+typedef struct
+{
+	bool enabled;
+	QString mac; //Formatted as xx:xx:xx:xx:xx:xx
+	bool cableConnected;
+	uint32_t attachmentType;
+	QString attachmentData;
+} backend_adapter_t;
+
+/**
+ * Operation started by a HypervisorBackend, completed in background
+ */
+class HypervisorProgress
+{
+	public:
+		virtual ~HypervisorProgress() {};
+
+		virtual bool isCompleted() = 0;
+		virtual uint32_t getPercent() = 0;
+
+		/**
+		 * This function returns 0 if the operation succeeded
+		 */
+		virtual int32_t getResultCode() = 0;
+
+		/**
+		 * This function returns when the operation is completed or after
+		 * timeout ms
+		 */
+		virtual void waitForCompletion(int timeout) = 0;
+};
+
+/**
+ * Machine operations of the startup, import and start paths, with either
+ * VirtualBox (XpcomBackend) or an in-memory model (FakeBackend) behind them.
+ * Machines are identified by their index, states are MachineState values and
+ * attachment types are NetworkAttachmentType values. Adapters are written
+ * only between lockMachine() and unlockMachine().
+ */
+class HypervisorBackend
+{
+	public:
+		virtual ~HypervisorBackend() {};
+
+		virtual int getMachinesCount() = 0;
+		virtual QString getName(int machine) = 0;
+		virtual QString getUUID(int machine) = 0;
+		virtual uint32_t getState(int machine) = 0;
+		virtual uint32_t getMaxNetworkAdapters(int machine) = 0;
+
+		virtual bool getAdapter(int machine, uint32_t slot, backend_adapter_t *adapter) = 0;
+
+		/**
+		 * This function writes the fields of adapter selected by fields
+		 * (ADAPTER_FIELD_* flags) to the adapter in slot
+		 */
+		virtual bool setAdapter(int machine, uint32_t slot, const backend_adapter_t *adapter, uint32_t fields = ADAPTER_FIELD_ALL) = 0;
+
+		virtual bool lockMachine(int machine) = 0;
+		virtual bool saveSettings(int machine) = 0;
+		virtual bool unlockMachine(int machine) = 0;
+
+		/**
+		 * These functions start and power down machine without waiting,
+		 * returning the progress of the operation (deleted by the caller),
+		 * NULL if it cannot be started
+		 */
+		virtual HypervisorProgress *launch(int machine) = 0;
+		virtual HypervisorProgress *powerDown(int machine) = 0;
+
+		/**
+		 * This function waits for progress to complete and returns its
+		 * result code
+		 */
+		static int32_t wait(HypervisorProgress *progress);
+};
+
+#endif //HYPERVISORBACKEND_H
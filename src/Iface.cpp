@@ -23,110 +23,31 @@
 
 #include <QStringList>
 #include <string>
-#include <sstream>
 #include <iostream>
 #include <stdint.h>
-#include <regex>
 #include "VirtualBoxBridge.h"
+#include "AddressParser.h"
 
-#define IPV6_REGEX "(([0-9a-fA-F]{1,4}:){7,7}[0-9a-fA-F]{1,4}|([0-9a-fA-F]{1,4}:){1,7}:|([0-9a-fA-F]{1,4}:){1,6}:[0-9a-fA-F]{1,4}|([0-9a-fA-F]{1,4}:){1,5}(:[0-9a-fA-F]{1,4}){1,2}|([0-9a-fA-F]{1,4}:){1,4}(:[0-9a-fA-F]{1,4}){1,3}|([0-9a-fA-F]{1,4}:){1,3}(:[0-9a-fA-F]{1,4}){1,4}|([0-9a-fA-F]{1,4}:){1,2}(:[0-9a-fA-F]{1,4}){1,5}|[0-9a-fA-F]{1,4}:((:[0-9a-fA-F]{1,4}){1,6})|:((:[0-9a-fA-F]{1,4}){1,7}|:)|fe80:(:[0-9a-fA-F]{0,4}){0,4}%[0-9a-zA-Z]{1,}|::(ffff(:0{1,4}){0,1}:){0,1}((25[0-5]|(2[0-4]|1{0,1}[0-9]){0,1}[0-9])\\.){3,3}(25[0-5]|(2[0-4]|1{0,1}[0-9]){0,1}[0-9])|([0-9a-fA-F]{1,4}:){1,4}:((25[0-5]|(2[0-4]|1{0,1}[0-9]){0,1}[0-9])\\.){3,3}(25[0-5]|(2[0-4]|1{0,1}[0-9]){0,1}[0-9]))"
-
-static QString subnetMaskFromSubnetSize(int subnetSize)
-{
-	typedef union
-	{
-		uint64_t subnetMask_ipv6[2];
-		uint32_t subnetMask_ipv4[4];
-		uint8_t subnetMask_byte[4][4];
-	} subnetMask_t;
-
-	subnetMask_t subnetMask;
-	subnetMask.subnetMask_ipv6[0] = subnetMask.subnetMask_ipv6[1] = 0;
-
-	for (int i = 31; i > (31 - subnetSize); i--)
-		subnetMask.subnetMask_ipv4[0] |= 1 << i;
-
-	std::stringstream ss;
-	ss << (int) subnetMask.subnetMask_byte[0][3] << "." << (int) subnetMask.subnetMask_byte[0][2] << "." << (int) subnetMask.subnetMask_byte[0][1] << "." << (int) subnetMask.subnetMask_byte[0][0];
-
-	std::string out;
-	ss >> out;
-	
-	return QString::fromUtf8(out.c_str());
-}
-
-#ifdef ENABLE_IPv6
+#ifdef CONFIGURABLE_IP
 int Iface::subnetSizeFromSubnetMask(QString qSubnetMask)
 {
-	typedef union
-	{
-		uint64_t subnetMask_ipv6[2];
-		uint32_t subnetMask_ipv4[4];
-		uint8_t subnetMask_byte[4][4];
-	} subnetMask_t;
-
-	subnetMask_t subnetMask;
-	subnetMask.subnetMask_ipv6[0] = subnetMask.subnetMask_ipv6[1] = 0;
+	uint32_t subnetMask;
+	if(!AddressParser::parseSubnetMask(qSubnetMask.constData(), qSubnetMask.length(), &subnetMask))
+		return 0;
 
-	QStringList s_qSubnetMask = qSubnetMask.split(".");
-	
-	for (int i = 0; i < s_qSubnetMask.size(); i++)
-		subnetMask.subnetMask_byte[0][i] = s_qSubnetMask[3-i].toInt();
-
-	int size = 0;
-	for (int i = 0; i < 32; i++)
-		if(subnetMask.subnetMask_ipv4[0] & (1<<i))
-			size++;
-
-	return size;
+	return AddressParser::prefixFromSubnetMask(subnetMask);
 }
 #endif
 
-static bool isValidHexNumber(std::string hex, int min, int max)
-{
-	int i;
-	if (hex.length() == 0)
-		return false;
-	for(i = 0; i < hex.length(); i++)
-		if(!isxdigit(hex.c_str()[i]))
-			return false;
-		
-	unsigned int x;
-	std::stringstream ss;
-	
-	ss << std::hex << hex;
-	ss >> x;
-	
-	return (x >= min && x <= max);
-}
-
-static bool isValidDecNumber(std::string num, int min, int max)
-{
-	int i;
-	if (num.length() == 0)
-		return false;
-	
-	for (i = 0; i < num.length(); i++)
-		if(!isdigit(num.c_str()[i]))
-			return false;
-		
-	unsigned int x;
-	std::stringstream ss;
-	
-	ss << std::dec << num;
-	ss >> x;
-	
-	return (x >= min && x <= max);
-}
-
 #ifdef CONFIGURABLE_IP
 Iface::Iface(bool enabled, QString mac, bool cableConnected, uint32_t attachmentType, QString attachmentData, QString name, QString ip, QString subnetMask)
-: enabled(enabled), cableConnected(cableConnected)
+: enabled(enabled), cableConnected(cableConnected), dirty(0)
 #else
 Iface::Iface(bool enabled, QString mac, bool cableConnected, uint32_t attachmentType, QString attachmentData, QString name)
-: enabled(enabled), cableConnected(cableConnected)
+: enabled(enabled), cableConnected(cableConnected), dirty(0)
 #endif
 {
+	clearRecord();
 	setName(name);
 	last_valid_name = name;
 	setMac(mac);
@@ -136,11 +57,17 @@ Iface::Iface(bool enabled, QString mac, bool cableConnected, uint32_t attachment
 	setIp(ip);
 	setSubnetMask(subnetMask);
 #endif
+	clearDirty();
 }
 
 Iface::Iface(settings_iface_t settings_iface)
+: enabled(false), cableConnected(false), dirty(0)
 {
+	clearRecord();
 	applyFromSerializableIface(settings_iface);
+
+	//Nothing of a new iface has been written yet
+	markDirty(IFACE_DIRTY_ALL);
 }
 
 Iface::~Iface()
@@ -148,10 +75,23 @@ Iface::~Iface()
 
 }
 
+void Iface::clearRecord()
+{
+	memset(&record, 0, sizeof(iface_record_t));
+	record.mac = MAC_NONE;
+	record.attachmentData = NAME_NONE;
+#ifdef CONFIGURABLE_IP
+	record.ip.family = IP_FAMILY_NONE;
+	record.prefix_length = -1;
+#endif
+}
+
 bool Iface::setName(QString _name)
 {
 	if(isValidName(_name, true))
 	{
+		if(name != _name)
+			markDirty(IFACE_DIRTY_NAME);
 		last_valid_name = name;
 		name = _name;
 		return true;
@@ -161,52 +101,94 @@ bool Iface::setName(QString _name)
 
 bool Iface::setMac(QString _mac)
 {
-	if(isValidMac(_mac))
+	uint64_t value;
+	if(AddressParser::parseMac(_mac.constData(), _mac.length(), &value))
 	{
-		mac = formatMac(_mac);
+		if(record.mac != value)
+			markDirty(IFACE_DIRTY_MAC);
+		record.mac = value;
+		mac = AddressParser::formatMac(value);
 		return true;
 	}
+
+	if(record.mac != MAC_NONE)
+		markDirty(IFACE_DIRTY_MAC);
+	record.mac = MAC_NONE;
 	mac = "";
-	return false;
+	return _mac.length() == 0;
 }
 
 #ifdef CONFIGURABLE_IP
 bool Iface::setIp(QString _ip)
 {
-	if(
+	ip_address_t value;
+	value.family = IP_FAMILY_NONE;
+
+	if(AddressParser::parseIPv4(_ip.constData(), _ip.length(), &value.ipv4))
+		value.family = IP_FAMILY_IPV4;
 #ifdef ENABLE_IPv6
-		isValidIPv6(_ip) ||
+	else if(AddressParser::parseIPv6(_ip.constData(), _ip.length(), &value.ipv6))
+		value.family = IP_FAMILY_IPV6;
+#endif
+
+#ifdef VALIDATE_IP
+	bool valid = (_ip.length() == 0) || (value.family == IP_FAMILY_IPV4 && !AddressParser::isReservedIPv4(value.ipv4));
+  #ifdef ENABLE_IPv6
+	valid = valid || (value.family == IP_FAMILY_IPV6);
+  #endif
+#else
+	bool valid = true;
 #endif
-		isValidIPv4(_ip))
+
+	QString old_ip = ip;
+	if(!valid)
 	{
-		ip = _ip;
-		return true;
+		ip = "";
+		record.ip.family = IP_FAMILY_NONE;
 	}
-	ip = "";
-	return false;	
+	else
+	{
+		record.ip = value;
+		ip = (value.family == IP_FAMILY_IPV4) ? AddressParser::formatIPv4(value.ipv4) : _ip;
+	}
+
+	if(ip != old_ip)
+		markDirty(IFACE_DIRTY_IP);
+	return valid;
 }
 
 bool Iface::setSubnetMask(QString _subnetMask)
 {
+	QString old_subnetMask = subnetMask;
 	if(isValidSubnetMask(_subnetMask, ip))
 	{
+		int prefix;
+		uint32_t mask;
+
+		subnetMask = _subnetMask;
+		record.prefix_length = -1;
+
+		if(AddressParser::parsePrefixLength(_subnetMask.constData(), _subnetMask.length(), (record.ip.family == IP_FAMILY_IPV6) ? 64 : 32, &prefix))
+		{
+			record.prefix_length = prefix;
 #ifdef VALIDATE_IP
-		if(_subnetMask.length() == 0)
-			subnetMask = _subnetMask;
-		else if(_subnetMask.split(".").count() == 1
-#ifdef ENABLE_IPv6
-			&& !isValidIPv6(ip)
+			if(record.ip.family != IP_FAMILY_IPV6)
+				subnetMask = AddressParser::formatIPv4(AddressParser::subnetMaskFromPrefix(prefix));
 #endif
-		)
-			subnetMask = subnetMaskFromSubnetSize(_subnetMask.toInt());
-		else
-#endif
-			subnetMask = _subnetMask;
+		}
+		else if(AddressParser::parseSubnetMask(_subnetMask.constData(), _subnetMask.length(), &mask))
+			record.prefix_length = AddressParser::prefixFromSubnetMask(mask);
+
+		if(subnetMask != old_subnetMask)
+			markDirty(IFACE_DIRTY_SUBNETMASK);
 		return true;
 	}
 	else if(subnetMask == _subnetMask)
 	{
 		subnetMask = "";
+		record.prefix_length = -1;
+		if(old_subnetMask.length() > 0)
+			markDirty(IFACE_DIRTY_SUBNETMASK);
 		return true;
 	}
 	return false;
@@ -217,7 +199,11 @@ bool Iface::setAttachmentData(QString _attachmentData)
 {
 	if(isValidName(_attachmentData, true))
 	{
+		uint32_t id = NameTable::intern(_attachmentData);
+		if(record.attachmentData != id)
+			markDirty(IFACE_DIRTY_ATTACHMENT_DATA);
 		attachmentData = _attachmentData;
+		record.attachmentData = id;
 		return true;
 	}
 	return false;
@@ -227,6 +213,8 @@ bool Iface::setAttachmentType(uint32_t _attachmentType)
 {
 	if(isValidAttachmentType(_attachmentType))
 	{
+		if(attachmentType != _attachmentType)
+			markDirty(IFACE_DIRTY_ATTACHMENT_TYPE);
 		attachmentType = _attachmentType;
 		return true;
 	}
@@ -239,9 +227,9 @@ bool Iface::isValidName(QString name, bool blankAllowed)
 	if(blankAllowed && name.length() == 0)
 		return true;
 	
-	int i;
-	for (i = 0; i < name.length(); i++)
-		if(!isalnum(name.toStdString().c_str()[i]))
+	const QChar *str = name.constData();
+	for (int i = 0; i < name.length(); i++)
+		if(str[i].unicode() >= 0x80 || !isalnum(str[i].unicode()))
 			return false;
 
 	return true;
@@ -274,138 +262,16 @@ bool Iface::isValidMac(QString mac)
 	if (mac.length() == 0)
 		return true;
 
-	int i;
-	QStringList s_mac;
-
-	s_mac = mac.split(":");
-	if (s_mac.count() == 6)
-	{
-		for (i = 0; i < 6; i++)
-			if (!isValidHexNumber(s_mac.at(i).toStdString(), 0x00, 0xFF))
-				return false;
-		return true;
-	}
-
-	s_mac = mac.split("-");
-	if (s_mac.count() == 6)
-	{
-		for (i = 0; i < 6; i++)
-			if (!isValidHexNumber(s_mac.at(i).toStdString(), 0x00, 0xFF))
-			return false;
-		return true;
-	}
-
-	s_mac = mac.split(".");
-	if (s_mac.count() == 3)
-	{
-		for (i = 0; i < 3; i++)
-			if (s_mac.at(i).length() < 4 || !isValidHexNumber(s_mac.at(i).toStdString(), 0x0000, 0xFFFF))
-				return false;
-		return true;
-	}
-	
-	std::string str_mac = mac.toStdString();
-	if (str_mac.length() == 12)
-	{
-		for (i = 0; i < 6; i++)
-			if (!isValidHexNumber(str_mac.substr(i*2, 2), 0x00 , 0xFF))
-				return false;
-		return true;
-	}
-
-	return false;
+	uint64_t value;
+	return AddressParser::parseMac(mac.constData(), mac.length(), &value);
 }
 
 QString Iface::formatMac(QString mac)
 {
-	if (isValidMac(mac))
-	{
-		int i;
-		QStringList s_mac;
-		std::stringstream ss;
-
-		s_mac = mac.split(":");
-		if (s_mac.count() == 6)
-		{
-			std::string temp;
-			for (i = 0; i < 6; i++)
-			{
-				temp = s_mac.at(i).toStdString();
-				
-				if (temp.length() < 2)
-					ss << std::string("0");
-				
-				ss << temp;
-				
-				if(i != 5)
-					ss << ":";
-			}
-			
-			std::string mac_out;
-			ss >> mac_out;
-			
-			return (QString::fromStdString(mac_out)).toUpper();
-		}
-		
-		s_mac = mac.split("-");
-		if (s_mac.count() == 6)
-		{
-			std::string temp;
-			for (i = 0; i < 6; i++)
-			{
-				temp = s_mac.at(i).toStdString();
-				
-				if (temp.length() < 2)
-					ss << std::string("0");
-				
-				ss << temp;
-				
-				if(i != 5)
-					ss << ":";
-			}
-
-			std::string mac_out;
-			ss >> mac_out;
-			
-			return (QString::fromStdString(mac_out)).toUpper();
-		}
+	uint64_t value;
+	if (AddressParser::parseMac(mac.constData(), mac.length(), &value))
+		return AddressParser::formatMac(value);
 
-		s_mac = mac.split(".");
-		if (s_mac.count() == 3)
-		{
-			std::string temp;
-			for (i = 0; i < 3; i++)
-			{
-				temp = s_mac.at(i).toStdString();
-				if (temp.length() == 4)
-					ss << temp.substr(0,2).append(":").append(temp.substr(2,2));
-				if(i != 2)
-					ss << ":";
-			}
-
-			std::string mac_out;
-			ss >> mac_out;
-
-			return (QString::fromStdString(mac_out)).toUpper();
-		}
-		
-		std::string str_mac = mac.toStdString();
-		if (str_mac.length() == 12)
-		{
-			std::string temp;
-			for (i = 0; i < 6; i++)
-			{
-				ss << str_mac.substr((i*2),2);
-				if(i != 5)
-					ss << ":";
-			}
-			
-			std::string mac_out;
-			ss >> mac_out;
-			
-			return (QString::fromStdString(mac_out)).toUpper();
-		}
-	}
 	return QString::fromUtf8("");
 }
 
@@ -415,45 +281,15 @@ bool Iface::isValidIPv4(QString ip)
 	if (ip.length() == 0)
 		return true;
 
-	int i;
-#ifdef EXCLUDE_RESERVED_IP
-	int ip_a[] = {0, 0, 0, 0};
-#endif
-	
-	QStringList s_ip = ip.split(".");
-	if (s_ip.count() == 4)
-	{
-		for (i = 0; i < 4; i++)
-		{
-			if (!isValidDecNumber(s_ip.at(i).toStdString(), 0, 255))
-				return false;
-#ifdef EXCLUDE_RESERVED_IP
-			ip_a[i] = s_ip.at(i).toShort();
-#endif
-		}
-	}
+	uint32_t value;
+	if (!AddressParser::parseIPv4(ip.constData(), ip.length(), &value))
+		return false;
 
 #ifdef EXCLUDE_RESERVED_IP
-	if
-	(
-	   // Used for broadcast messages to the current network as specified by RFC 1700, page 4
-	   (ip_a[0] == 0) ||
-
-	   // Used for loopback addresses to the local host, as specified by RFC 990.
-	   (ip_a[0] == 127) ||
-
-	   /* Used for link-local addresses between two hosts on a single link
-	    * when no IP address is otherwise specified, such as would have
-	    * normally been retrieved from a DHCP server, as specified by RFC 3927.
-	    */
-	   (ip_a[0] == 169 && ip_a[1] == 254) ||
-
-	   // Reserved for the "limited broadcast" destination address, as specified by RFC 6890.
-	   (ip_a[0] == 255 && ip_a[1] == 255 && ip_a[2] == 255 && ip_a[3] == 255)
-	)
+	if (AddressParser::isReservedIPv4(value))
 		return false;
 #endif
-	
+
 	return true;
 }
 
@@ -462,49 +298,25 @@ bool Iface::isValidSubnetMask(QString subnetMask, QString ip)
 	if (subnetMask.length() == 0)
 		return true;
 
-	int i;
-	int smask_a[] = {0, 0, 0, 0};
+	int prefix;
+	if (AddressParser::parsePrefixLength(subnetMask.constData(), subnetMask.length(), 32, &prefix))
+		return true;
 
-	QStringList s_smask = subnetMask.split(".");
-	if (s_smask.count() == 1)
-	{
-		if(isValidDecNumber(s_smask.at(0).toStdString(), 0, 32)
 #ifdef ENABLE_IPv6
-		|| (isValidIPv6(ip) && isValidDecNumber(s_smask.at(0).toStdString(), 0, 64))
+	if (isValidIPv6(ip) && AddressParser::parsePrefixLength(subnetMask.constData(), subnetMask.length(), 64, &prefix))
+		return true;
 #endif
-		)
-			return true;
-		return false;
-	}
-
-	if (s_smask.count() == 4)
-	{
-		uint32_t subnetMask_32 = 0;
-		for (i = 0; i < 4; i++)
-		{
-			if (!isValidDecNumber(s_smask.at(i).toStdString(), 0, 255))
-				return false;
-			subnetMask_32 += (uint32_t) (s_smask.at(i).toInt() << 8 * (3-i));
-		}
 
-		uint32_t checkMask = 0;
-		for (i = 31; i >= 0; i--)
-		{
-			if (subnetMask_32 == checkMask)
-				return true;
-			checkMask |= 1 << i;
-		}
-		if (subnetMask_32 == checkMask)
-			return true;
-	}
-	return false;
+	uint32_t value;
+	return AddressParser::parseSubnetMask(subnetMask.constData(), subnetMask.length(), &value);
 }
 #endif
 
 #if defined(CONFIGURABLE_IP) && defined(ENABLE_IPv6)
 bool Iface::isValidIPv6(QString ip)
 {
-	return std::regex_match (ip.toStdString().c_str(), std::regex(IPV6_REGEX));
+	ipv6_address_t value;
+	return AddressParser::parseIPv6(ip.constData(), ip.length(), &value);
 }
 #endif
 
@@ -541,6 +353,10 @@ settings_iface_t Iface::getSerializableIface()
 
 void Iface::applyFromSerializableIface(settings_iface_t settings_iface)
 {
+	if(enabled != settings_iface.enabled)
+		markDirty(IFACE_DIRTY_ENABLED);
+	if(cableConnected != settings_iface.cableConnected)
+		markDirty(IFACE_DIRTY_CONNECTED);
 	enabled = settings_iface.enabled;
 	cableConnected = settings_iface.cableConnected;
 	setName(QString::fromUtf8(settings_iface.name));
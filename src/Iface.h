@@ -27,6 +27,8 @@
 #include <QString>
 #include <stdint.h>
 #include "VirtualBoxBridge.h"
+#include "AddressParser.h"
+#include "NameTable.h"
 
 typedef struct
 {
@@ -39,6 +41,38 @@ typedef struct
 	bool enabled, cableConnected;
 } settings_iface_t;
 
+/**
+ * Packed copy of the addresses and of the attachment network of an iface,
+ * kept up to date by the Iface setters: lookups compare these values
+ * instead of strings
+ */
+typedef struct
+{
+	uint64_t mac;
+	uint32_t attachmentData;
+#ifdef CONFIGURABLE_IP
+	ip_address_t ip;
+	int prefix_length;
+#endif
+} iface_record_t;
+
+/** Fields of an iface changed since they were last read from or written to the machine */
+#define IFACE_DIRTY_ENABLED		(1 << 0)
+#define IFACE_DIRTY_MAC			(1 << 1)
+#define IFACE_DIRTY_CONNECTED		(1 << 2)
+#define IFACE_DIRTY_ATTACHMENT_TYPE	(1 << 3)
+#define IFACE_DIRTY_ATTACHMENT_DATA	(1 << 4)
+#define IFACE_DIRTY_NAME		(1 << 5)
+#define IFACE_DIRTY_IP			(1 << 6)
+#define IFACE_DIRTY_SUBNETMASK		(1 << 7)
+#define IFACE_DIRTY_ALL			0xFF
+
+/** Fields written to the machine settings */
+#define IFACE_DIRTY_MACHINE		(IFACE_DIRTY_ENABLED | IFACE_DIRTY_MAC | IFACE_DIRTY_CONNECTED | IFACE_DIRTY_ATTACHMENT_TYPE | IFACE_DIRTY_ATTACHMENT_DATA)
+
+/** Fields written to the guest partition */
+#define IFACE_DIRTY_GUEST		(IFACE_DIRTY_ENABLED | IFACE_DIRTY_MAC | IFACE_DIRTY_NAME | IFACE_DIRTY_IP | IFACE_DIRTY_SUBNETMASK)
+
 class Iface
 {
 	public:
@@ -77,11 +111,16 @@ class Iface
   #endif
 #endif//CONFIGURABLE_IP
 
-		inline bool operator==(const Iface *i) const { return mac == i->mac; };
+		inline bool operator==(const Iface *i) const { return record.mac == i->record.mac; };
 		inline bool operator!=(const Iface *i) const { return !operator==(i); };
 		Iface *copyIface();
 		settings_iface_t getSerializableIface();
 		void applyFromSerializableIface(settings_iface_t settings_iface);
+		void clearRecord();
+
+		inline void markDirty(uint32_t fields) { dirty |= fields; };
+		inline void clearDirty(uint32_t fields = IFACE_DIRTY_ALL) { dirty &= ~fields; };
+		inline bool isDirty(uint32_t fields = IFACE_DIRTY_ALL) const { return (dirty & fields) != 0; };
 		
 		QString last_valid_name, name, mac, attachmentData;
 #ifdef CONFIGURABLE_IP
@@ -89,6 +128,12 @@ class Iface
 #endif
 		uint32_t attachmentType;
 		bool enabled, cableConnected;
+
+		/** Packed values of mac, attachmentData, ip and subnetMask, written by their setters */
+		iface_record_t record;
+
+		/** IFACE_DIRTY_* flags of the fields which have to be saved */
+		uint32_t dirty;
 // 	private:
 };
 
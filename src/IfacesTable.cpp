@@ -30,6 +30,8 @@
 #include <QObject>
 #include <QLineEdit>
 #include <QComboBox>
+#include <QStringListModel>
+#include <QApplication>
 #include <vector>
 
 #include <iostream>
@@ -37,6 +39,7 @@
 #include "VirtualMachine.h"
 #include "VMTabSettings.h"
 #include "Iface.h"
+#include "MacAllocator.h"
 
 #ifdef CONFIGURABLE_IP
 	#define HORIZONTAL_HEADERS "Abilita;Indirizzo MAC;Collegata;Nome;Indirizzo IP;Maschera sottorete;Connessa a;Nome"
@@ -53,6 +56,7 @@ MacWidgetField::MacWidgetField(QWidget *parent, int row, IfacesTable *destinatio
 
 	lineEdit = new QLineEdit(this);
 	lineEdit->setObjectName(QString::fromUtf8("lineEdit"));
+	lineEdit->setAlignment(Qt::AlignCenter);
 	horizontalLayout->addWidget(lineEdit);
 
 	button = new QToolButton(this);
@@ -63,14 +67,13 @@ MacWidgetField::MacWidgetField(QWidget *parent, int row, IfacesTable *destinatio
 	horizontalLayout->addWidget(button);
 	
 	setLayout(horizontalLayout);
+	setFocusProxy(lineEdit);
 	
-	connect(lineEdit, SIGNAL(editingFinished()), this, SLOT(editingFinishedSlot()));
 	connect(button, SIGNAL(released()), this, SLOT(releasedSlot()));
 }
 
 MacWidgetField::~MacWidgetField()
 {
-	disconnect(lineEdit, SIGNAL(editingFinished()), this, SLOT(editingFinishedSlot()));
 	disconnect(button, SIGNAL(released()), this, SLOT(releasedSlot()));
 	
 	delete button;
@@ -83,309 +86,158 @@ void MacWidgetField::setText(const QString &text)
 	lineEdit->setText(text);
 }
 
-void MacWidgetField::editingFinishedSlot()
+QString MacWidgetField::text() const
 {
-	destination->setMac(row, ((QLineEdit *)sender())->text());
+	return lineEdit->text();
 }
 
 void MacWidgetField::releasedSlot()
 {
 	destination->generateMac(row);
+	setText((*destination)[row]->mac);
 }
 
-CustomCheckBox::CustomCheckBox(QWidget *parent, int row, void* destination, bool (*function_forwarder)(void*, int, bool)) : QWidget(parent)
-, row(row), function_forwarder(function_forwarder), destination(destination)
+IfacesTableDelegate::IfacesTableDelegate(QObject *parent) : QStyledItemDelegate(parent)
 {
-	QHBoxLayout *horizontalLayout = new QHBoxLayout(this);
-	horizontalLayout->setObjectName(QString::fromUtf8("horizontalLayout"));
-	horizontalLayout->setContentsMargins(0, 0, 0, 0);
-	
-	checkbox = new QCheckBox(this);
-	horizontalLayout->addWidget(checkbox);
-	horizontalLayout->setAlignment(Qt::AlignCenter);
-	
-	setLayout(horizontalLayout);
-	
-	connect(checkbox, SIGNAL(toggled(bool)), this, SLOT(toggledSlot(bool)));
-}
 
-CustomCheckBox::~CustomCheckBox()
-{
-	disconnect(checkbox, SIGNAL(toggled(bool)), this, SLOT(toggledSlot(bool)));
-	delete layout();
-	delete checkbox;
 }
 
-void CustomCheckBox::setCheckState(Qt::CheckState checked)
+IfacesTableDelegate::~IfacesTableDelegate()
 {
-	checkbox->setCheckState(checked);
+
 }
 
-void CustomCheckBox::toggledSlot(bool checked)
+IfacesTable *IfacesTableDelegate::table(const QModelIndex &index)
 {
-	function_forwarder(destination, row, checked);
+	//The model of a QTableWidget is owned by the table itself
+	return (IfacesTable *)index.model()->parent();
 }
 
-AttachmentComboBox::AttachmentComboBox(QWidget *parent, int row, IfacesTable *destination) : QWidget(parent)
-, row(row), destination(destination)
+QWidget *IfacesTableDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
-	QHBoxLayout *horizontalLayout = new QHBoxLayout(this);
-	horizontalLayout->setObjectName(QString::fromUtf8("horizontalLayout"));
-	horizontalLayout->setContentsMargins(0, 0, 0, 0);
+	IfacesTable *destination = table(index);
 
-	uint32_t maxIndex = std::max(
-		std::max(
-			std::max((uint32_t) NetworkAttachmentType::Null, (uint32_t) NetworkAttachmentType::Bridged),
-			 std::max((uint32_t) NetworkAttachmentType::Generic, (uint32_t) NetworkAttachmentType::Generic)
-		),
-		std::max(
-			std::max((uint32_t) NetworkAttachmentType::HostOnly, (uint32_t) NetworkAttachmentType::Internal),
-			 std::max((uint32_t) NetworkAttachmentType::NAT, (uint32_t) NetworkAttachmentType::NATNetwork)
-		)
-	);
-	
-	uint32_t minIndex = std::min(
-		std::min(
-			std::min((uint32_t) NetworkAttachmentType::Null, (uint32_t) NetworkAttachmentType::Bridged),
-			 std::min((uint32_t) NetworkAttachmentType::Generic, (uint32_t) NetworkAttachmentType::Generic)
-		),
-		std::min(
-			std::min((uint32_t) NetworkAttachmentType::HostOnly, (uint32_t) NetworkAttachmentType::Internal),
-			 std::min((uint32_t) NetworkAttachmentType::NAT, (uint32_t) NetworkAttachmentType::NATNetwork)
-		)
-	);
-	
-	comboBox = new QComboBox(this);
-	
-	for(int i = minIndex; i <= maxIndex; i++)
+	switch(index.column())
 	{
-		switch(i)
+		case COLUMN_MAC:
+			return new MacWidgetField(parent, index.row(), destination);
+
+		case COLUMN_IFACE_TYPE:
 		{
-			case NetworkAttachmentType::Null: comboBox->addItem(QString::fromUtf8("Non connesso")); break;
-			case NetworkAttachmentType::Bridged: comboBox->addItem(QString::fromUtf8("Scheda con bridge")); break;
-			case NetworkAttachmentType::Generic: comboBox->addItem(QString::fromUtf8("Driver generico")); break;
-			case NetworkAttachmentType::HostOnly: comboBox->addItem(QString::fromUtf8("Scheda solo host")); break;
-			case NetworkAttachmentType::Internal: comboBox->addItem(QString::fromUtf8("Rete interna")); break;
-			case NetworkAttachmentType::NAT: comboBox->addItem(QString::fromUtf8("NAT")); break;
-			case NetworkAttachmentType::NATNetwork: comboBox->addItem(QString::fromUtf8("Rete con NAT")); break;
-			default: std::cout << "NetworkAttachmentType::" << i << " is an unknown attachment type" << std::endl; break;
+			uint32_t maxIndex = std::max(
+				std::max(
+					std::max((uint32_t) NetworkAttachmentType::Null, (uint32_t) NetworkAttachmentType::Bridged),
+					 std::max((uint32_t) NetworkAttachmentType::Generic, (uint32_t) NetworkAttachmentType::Generic)
+				),
+				std::max(
+					std::max((uint32_t) NetworkAttachmentType::HostOnly, (uint32_t) NetworkAttachmentType::Internal),
+					 std::max((uint32_t) NetworkAttachmentType::NAT, (uint32_t) NetworkAttachmentType::NATNetwork)
+				)
+			);
+
+			QComboBox *comboBox = new QComboBox(parent);
+			for(uint32_t i = NetworkAttachmentType::Null; i <= maxIndex; i++)
+				comboBox->addItem(IfacesTable::attachmentTypeName(i));
+
+			connect(comboBox, SIGNAL(activated(int)), this, SLOT(activatedSlot(int)));
+			return comboBox;
 		}
-	}
-	
-	horizontalLayout->addWidget(comboBox);
-	horizontalLayout->setAlignment(Qt::AlignCenter);
-	
-	setLayout(horizontalLayout);
-}
-
-void AttachmentComboBox::add_connection()
-{
-	comboBox->connect(comboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(currentIndexChangedSlot(int)));
-}
-
-void AttachmentComboBox::remove_connection()
-{
-	comboBox->disconnect(comboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(currentIndexChangedSlot(int)));
-}
 
-AttachmentComboBox::~AttachmentComboBox()
-{
-	remove_connection();
-	delete comboBox;
-}
-
-void AttachmentComboBox::currentIndexChangedSlot(int index)
-{
-	destination->setAttachmentType(row, index);
-}
-
-bool setStatus_forwarder(void *context, int row, bool checked)
-{
-	return static_cast<IfacesTable*>(context)->setStatus(row, checked);
-}
-
-bool setCableConnected_forwarder(void *context, int row, bool checked)
-{
-	return static_cast<IfacesTable*>(context)->setCableConnected(row, checked);
-}
-
-AttachmentDataWidget::AttachmentDataWidget(QWidget *parent, int row, IfacesTable *destination) : QWidget(parent)
-, comboBox(new QComboBox(this)), row(row), destination(destination)
-{
-	QHBoxLayout *horizontalLayout = new QHBoxLayout(this);
-	horizontalLayout->setObjectName(QString::fromUtf8("horizontalLayout"));
-	horizontalLayout->setContentsMargins(0, 0, 0, 0);
-
-	QSizePolicy sizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-	sizePolicy.setHorizontalStretch(0);
-	sizePolicy.setVerticalStretch(0);
-	setSizePolicy(sizePolicy);
+		case COLUMN_IFACE_TYPE_DATA:
+		{
+			uint32_t attachmentType = destination->ifaces[index.row()]->attachmentType;
 
-	comboBox->setSizePolicy(sizePolicy);
+			//Editors of every table share the models of the host network catalog
+			QComboBox *comboBox = new QComboBox(parent);
+			QStringListModel *model = destination->vboxbridge->getHostNetworkCatalog()->model(attachmentType);
+			if(model != NULL)
+				comboBox->setModel(model);
 
-	refreshWidget();
+			if(attachmentType == NetworkAttachmentType::Internal || attachmentType == NetworkAttachmentType::Generic)
+			{
+				comboBox->setEditable(true);
+				comboBox->setInsertPolicy(QComboBox::NoInsert);
+				comboBox->setAutoCompletion(true);
+				comboBox->setAutoCompletionCaseSensitivity(Qt::CaseSensitive);
+			}
 
-	horizontalLayout->addWidget(comboBox);
-	horizontalLayout->setAlignment(Qt::AlignCenter);
-	
-	setLayout(horizontalLayout);
-}
+			connect(comboBox, SIGNAL(activated(int)), this, SLOT(activatedSlot(int)));
+			return comboBox;
+		}
 
-AttachmentDataWidget::~AttachmentDataWidget()
-{
-	remove_connection();
-	delete comboBox;
+		default:
+			return QStyledItemDelegate::createEditor(parent, option, index);
+	}
 }
 
-void AttachmentDataWidget::add_connection()
+void IfacesTableDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const
 {
-	connect(comboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(currentIndexChangedSlot(int)));
-}
+	IfacesTable *destination = table(index);
+	Iface *iface = destination->ifaces[index.row()];
 
-void AttachmentDataWidget::remove_connection()
-{
-	disconnect(comboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(currentIndexChangedSlot(int)));
-}
-
-void AttachmentDataWidget::refreshWidget()
-{
-	switch(destination->ifaces[row]->attachmentType)
+	switch(index.column())
 	{
-		case NetworkAttachmentType::NATNetwork:
-		{
-			std::vector<nsCOMPtr<INATNetwork> > natNetworks_vec = destination->vboxbridge->getNatNetworks();
-			comboBox->clear();
-
-			for(int i = 0; i < natNetworks_vec.size(); i++)
-			{
-				nsXPIDLString name;
-				natNetworks_vec.at(i)->GetNetworkName(getter_Copies(name));
-				comboBox->addItem(returnQStringValue(name));
-			}
+		case COLUMN_MAC:
+			((MacWidgetField *)editor)->setText(iface->mac);
 			break;
-		}
-		case NetworkAttachmentType::Bridged:
-		{
-			std::vector<nsCOMPtr<IHostNetworkInterface> > host_ifaces_vec = destination->vboxbridge->getHostNetworkInterfaces();
-			comboBox->clear();
 
-			for(int i = 0; i < host_ifaces_vec.size(); i++)
-			{
-				nsXPIDLString name;
-				host_ifaces_vec.at(i)->GetName(getter_Copies(name));
-				comboBox->addItem(returnQStringValue(name));
-			}
+		case COLUMN_IFACE_TYPE:
+			((QComboBox *)editor)->setCurrentIndex(iface->attachmentType);
 			break;
-		}
-		case NetworkAttachmentType::Internal:
-		{
-			std::vector<QString> host_ifaces_vec = destination->vboxbridge->getInternalNetworkList();
-			comboBox->clear();
 
-			for(int i = 0; i < host_ifaces_vec.size(); i++)
-				comboBox->addItem(host_ifaces_vec.at(i));
-			break;
-		}
-		case NetworkAttachmentType::HostOnly:
+		case COLUMN_IFACE_TYPE_DATA:
 		{
-			std::vector<nsCOMPtr<IHostNetworkInterface> > hostOnly_ifaces_vec = destination->vboxbridge->getHostOnlyInterfaces();
-			comboBox->clear();
+			QComboBox *comboBox = (QComboBox *)editor;
+			comboBox->setCurrentIndex(comboBox->findText(iface->attachmentData));
 
-			for(int i = 0; i < hostOnly_ifaces_vec.size(); i++)
-			{
-				nsXPIDLString name;
-				((nsCOMPtr<IHostNetworkInterface>) hostOnly_ifaces_vec.at(i))->GetName(getter_Copies(name));
-				comboBox->addItem(returnQStringValue(name));
-			}
-			break;
-		}
-		case NetworkAttachmentType::Generic:
-		{
-			std::vector<QString> generic_drivers_vec = destination->vboxbridge->getGenericDriversList();
-			comboBox->clear();
-			
-			for(int i = 0; i < generic_drivers_vec.size(); i++)
-				comboBox->addItem(generic_drivers_vec.at(i));
+			//A network not yet known to VirtualBox is still shown, without adding it to the shared model
+			if(comboBox->currentIndex() < 0 && comboBox->isEditable())
+				comboBox->setEditText(iface->attachmentData);
 			break;
 		}
+
 		default:
-			std::cout << "NetworkAttachmentType::" << destination->ifaces[row]->attachmentType << " is an unknown attachment type" << std::endl;
-		case NetworkAttachmentType::Null:
-		case NetworkAttachmentType::NAT:
-		{
-			comboBox->clear();
+			QStyledItemDelegate::setEditorData(editor, index);
 			break;
-		}
-		
 	}
-	refreshData();
-	refreshStatus();
 }
 
-void AttachmentDataWidget::refreshStatus() //FIXME
+void IfacesTableDelegate::setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const
 {
-	switch(destination->ifaces[row]->attachmentType)
+	IfacesTable *destination = table(index);
+
+	switch(index.column())
 	{
-		case NetworkAttachmentType::NATNetwork:
-		case NetworkAttachmentType::Bridged:
-		case NetworkAttachmentType::HostOnly:
-		{
-			if(comboBox->isEditable())
-				comboBox->lineEdit()->disconnect(comboBox->lineEdit(), SIGNAL(editingFinished()), this, SLOT(editingFinishedSlot()));
-			comboBox->setEditable(false);
+		case COLUMN_MAC:
+			destination->setMac(index.row(), ((MacWidgetField *)editor)->text());
 			break;
-		}
-		case NetworkAttachmentType::Internal:
-		case NetworkAttachmentType::Generic:
+
+		case COLUMN_IFACE_TYPE:
+			destination->setAttachmentType(index.row(), ((QComboBox *)editor)->currentIndex());
+			break;
+
+		case COLUMN_IFACE_TYPE_DATA:
 		{
-			comboBox->setEditable(true);
-			comboBox->setAutoCompletion(true);
-			comboBox->setAutoCompletionCaseSensitivity(Qt::CaseSensitive);
-			comboBox->lineEdit()->connect(comboBox->lineEdit(), SIGNAL(editingFinished()), this, SLOT(editingFinishedSlot()));
+			QComboBox *comboBox = (QComboBox *)editor;
+			if(comboBox->currentText().length() > 0)
+				destination->setAttachmentData(index.row(), comboBox->currentText());
 			break;
 		}
-		default:
-			std::cout << "NetworkAttachmentType::" << destination->ifaces[row]->attachmentType << " is an unknown attachment type" << std::endl;
-		case NetworkAttachmentType::Null:
-		case NetworkAttachmentType::NAT:
-			setEnabled(false);
-			return;
-	}
-	setEnabled(true);
-}
 
-void AttachmentDataWidget::refreshData()
-{
-	QString selected_entry;
-	switch(destination->ifaces[row]->attachmentType)
-	{
-		case NetworkAttachmentType::NATNetwork: selected_entry = destination->machine->getNatNetwork(row); break;
-		case NetworkAttachmentType::Bridged: selected_entry = destination->machine->getBridgedIface(row); break;
-		case NetworkAttachmentType::Internal: selected_entry = destination->machine->getInternalName(row); break;
-		case NetworkAttachmentType::HostOnly: selected_entry = destination->machine->getHostIface(row); break;
-		case NetworkAttachmentType::Generic: selected_entry = destination->machine->getGenericDriver(row); break;
 		default:
-			std::cout << "NetworkAttachmentType::" << destination->ifaces[row]->attachmentType << " is an unknown attachment type" << std::endl;
-		case NetworkAttachmentType::Null:
-		case NetworkAttachmentType::NAT:
+			//Text cells are stored by IfacesTable::cellChangedSlot
+			QStyledItemDelegate::setModelData(editor, model, index);
 			return;
 	}
 
-	for(int i = 0; i < comboBox->count(); i++)
-		if(selected_entry == comboBox->itemText(i))
-			comboBox->setCurrentIndex(i);
-}
-
-void AttachmentDataWidget::currentIndexChangedSlot(int index)
-{
-	QString str = comboBox->currentText();
-	destination->setAttachmentData(row, str);
+	emit destination->ifaceEdited(index.row());
 }
 
-void AttachmentDataWidget::editingFinishedSlot()
+void IfacesTableDelegate::activatedSlot(int index)
 {
-	QString str = comboBox->lineEdit()->text();
-	destination->setAttachmentData(row, str);
+	QWidget *editor = (QWidget *)sender();
+	emit commitData(editor);
+	emit closeEditor(editor);
 }
 
 IfacesTable::IfacesTable(QWidget *parent, QBoxLayout *layout, VirtualBoxBridge *vboxbridge, MachineBridge *machine, Iface **ifaces) : QTableWidget(parent)
@@ -408,6 +260,9 @@ IfacesTable::IfacesTable(QWidget *parent, QBoxLayout *layout, VirtualBoxBridge *
 	setHorizontalHeader(headerView);
 	horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
 	horizontalHeader()->setStretchLastSection(true);
+
+	setItemDelegate(sharedDelegate());
+	setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::SelectedClicked | QAbstractItemView::EditKeyPressed);
 	
 	resizeRowsToContents();
 	resizeColumnsToContents();
@@ -417,32 +272,52 @@ IfacesTable::IfacesTable(QWidget *parent, QBoxLayout *layout, VirtualBoxBridge *
 
 IfacesTable::~IfacesTable()
 {
-	int row, col;
-	for(row = 0; row < rowCount(); row++)
+	//Items are owned and deleted by QTableWidget
+}
+
+IfacesTableDelegate *IfacesTable::sharedDelegate()
+{
+	static IfacesTableDelegate *delegate = NULL;
+	if(delegate == NULL)
+		delegate = new IfacesTableDelegate(qApp);
+
+	return delegate;
+}
+
+QString IfacesTable::attachmentTypeName(uint32_t attachmentType)
+{
+	switch(attachmentType)
 	{
-		for(col = 0; col < columnAt(row); col++)
-		{
-			if(col == COLUMN_IFACE_ENABLED)
-				delete ((CustomCheckBox *)cellWidget(row, col));
-			else if(col == COLUMN_MAC)
-				delete ((MacWidgetField *)cellWidget(row, col));
-			else if(col == COLUMN_IFACE_TYPE)
-				delete ((AttachmentComboBox *)cellWidget(row, col));
-			else if(col == COLUMN_IFACE_TYPE_DATA)
-				delete ((AttachmentDataWidget *)cellWidget(row, col));
-			else
-				delete itemAt(row, col);
-		}
+		case NetworkAttachmentType::Null: return QString::fromUtf8("Non connesso");
+		case NetworkAttachmentType::Bridged: return QString::fromUtf8("Scheda con bridge");
+		case NetworkAttachmentType::Generic: return QString::fromUtf8("Driver generico");
+		case NetworkAttachmentType::HostOnly: return QString::fromUtf8("Scheda solo host");
+		case NetworkAttachmentType::Internal: return QString::fromUtf8("Rete interna");
+		case NetworkAttachmentType::NAT: return QString::fromUtf8("NAT");
+		case NetworkAttachmentType::NATNetwork: return QString::fromUtf8("Rete con NAT");
+		default:
+			std::cout << "NetworkAttachmentType::" << attachmentType << " is an unknown attachment type" << std::endl;
+			return QString();
 	}
 }
 
+void IfacesTable::setItemEnabled(int iface, int column, bool enabled)
+{
+	Qt::ItemFlags flags = item(iface, column)->flags();
+	if(enabled)
+		flags |= Qt::ItemIsEnabled;
+	else
+		flags &= ~Qt::ItemIsEnabled;
+	item(iface, column)->setFlags(flags);
+}
+
 #ifdef CONFIGURABLE_IP
 int IfacesTable::setIface(int iface, bool enabled, QString mac, bool cableConnected, uint32_t attachmentType, QString attachmentData, QString name, QString ip, QString subnetMask)
 #else
 int IfacesTable::setIface(int iface, bool enabled, QString mac, bool cableConnected, uint32_t attachmentType, QString attachmentData, QString name)
 #endif
 {
-	blockSignals(true);
+	bool blocked = blockSignals(true);
 
 	if(ifaces[iface] == NULL)
 	{
@@ -454,9 +329,8 @@ int IfacesTable::setIface(int iface, bool enabled, QString mac, bool cableConnec
 	}
 	else
 	{
-		ifaces[iface]->enabled = enabled;
+		//enabled and cableConnected are stored by setStatus() and setCableConnected()
 		ifaces[iface]->setMac(mac);
-		ifaces[iface]->cableConnected = cableConnected;
 		ifaces[iface]->setAttachmentType(attachmentType);
 		ifaces[iface]->setName(name);
 #ifdef CONFIGURABLE_IP
@@ -466,114 +340,62 @@ int IfacesTable::setIface(int iface, bool enabled, QString mac, bool cableConnec
 		ifaces[iface]->setAttachmentData(attachmentData);
 	}
 
-	setCellWidget(iface, COLUMN_IFACE_ENABLED, new CustomCheckBox(this, iface, this, &setStatus_forwarder));
-	setCellWidget(iface, COLUMN_MAC, new MacWidgetField(this, iface, this));
-	setCellWidget(iface, COLUMN_IFACE_CONNECTED, new CustomCheckBox(this, iface, this, &setCableConnected_forwarder));
-	setItem(iface, COLUMN_IFACE_NAME, new QTableWidgetItem());
-#ifdef CONFIGURABLE_IP
-	setItem(iface, COLUMN_IP, new QTableWidgetItem());
-	setItem(iface, COLUMN_SUBNETMASK, new QTableWidgetItem());
-#endif
-	AttachmentComboBox *attachmentComboBox = new AttachmentComboBox(this, iface, this);
-	setCellWidget(iface, COLUMN_IFACE_TYPE, attachmentComboBox);
-// 	CustomComboBox *customComboBox = new CustomComboBox(this, iface, this);
-	AttachmentDataWidget *attachmentDataWidget = new AttachmentDataWidget(this, iface, this);
-	setCellWidget(iface, COLUMN_IFACE_TYPE_DATA, attachmentDataWidget);
-
-	int col;
-	for (col = 1; col < columnCount(); col++)
+	//Items are created once and then only updated
+	if(item(iface, COLUMN_IFACE_ENABLED) == NULL)
 	{
-		if(col == COLUMN_MAC)
-			((MacWidgetField *)cellWidget(iface, col))->lineEdit->setAlignment(Qt::AlignCenter);
-		else if(col != COLUMN_IFACE_TYPE && col != COLUMN_IFACE_TYPE_DATA && col != COLUMN_IFACE_CONNECTED)
-			item(iface, col)->setTextAlignment(Qt::AlignCenter);
+		for(int col = 0; col < columnCount(); col++)
+		{
+			QTableWidgetItem *newItem = new QTableWidgetItem();
+			if(col == COLUMN_IFACE_ENABLED || col == COLUMN_IFACE_CONNECTED)
+				newItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+			else if(col != COLUMN_IFACE_TYPE && col != COLUMN_IFACE_TYPE_DATA)
+				newItem->setTextAlignment(Qt::AlignCenter);
+			setItem(iface, col, newItem);
+		}
 	}
 
-	setMac(iface, ifaces[iface]->mac);
-	setCableConnected(iface, ifaces[iface]->cableConnected);
-	setName(iface, ifaces[iface]->name);
+	item(iface, COLUMN_MAC)->setText(ifaces[iface]->mac);
+	setCableConnected(iface, cableConnected);
+	item(iface, COLUMN_IFACE_NAME)->setText(ifaces[iface]->name);
 #ifdef CONFIGURABLE_IP
 	setIp(iface, ifaces[iface]->ip);
 	setSubnetMask(iface, ifaces[iface]->subnetMask);
 #endif
 	setAttachmentType(iface, ifaces[iface]->attachmentType);
 	setAttachmentData(iface, ifaces[iface]->attachmentData);
-	setStatus(iface, ifaces[iface]->enabled);
+	setStatus(iface, enabled);
 
-	blockSignals(false);
-
-	attachmentComboBox->add_connection();
-	attachmentDataWidget->add_connection();
+	blockSignals(blocked);
 
 	return iface;
 }
 
 bool IfacesTable::setStatus(int iface, bool checked)
 {
-	CustomCheckBox *cCheckBox = ((CustomCheckBox *)cellWidget(iface, COLUMN_IFACE_ENABLED));
-	cCheckBox->blockSignals(true);
-	cCheckBox->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
-	cCheckBox->blockSignals(false);
+	bool blocked = blockSignals(true);
+	item(iface, COLUMN_IFACE_ENABLED)->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
 	
 	for (int col = 1; col < columnCount(); col++)
 	{
-		Qt::ItemFlags flags;
-		switch(col)
-		{
-			case COLUMN_MAC:
-			{
-				MacWidgetField *w = (MacWidgetField *)cellWidget(iface, col);
-				w->button->setEnabled(checked);
-				w->lineEdit->setEnabled(checked);
-				break;
-			}
-			case COLUMN_IFACE_CONNECTED:
-			{
-				CustomCheckBox *c = (CustomCheckBox *)cellWidget(iface, col);
-				c->checkbox->setEnabled(checked);
-				break;
-			}
-			case COLUMN_IFACE_TYPE:
-			{
-				AttachmentComboBox *a = (AttachmentComboBox *)cellWidget(iface, col);
-				a->setEnabled(checked);
-				break;
-			}
-			case COLUMN_IFACE_TYPE_DATA:
-			{
-				AttachmentDataWidget *a = (AttachmentDataWidget *)cellWidget(iface, col);
-				if(checked &&
-					(ifaces[iface]->attachmentType != NetworkAttachmentType::Null
-					&& ifaces[iface]->attachmentType != NetworkAttachmentType::NAT))
-					a->setEnabled(true);
-				else
-					a->setEnabled(false);
-
-				break;
-			}
-			default:
-			{
-				flags = item(iface, col)->flags();
-				if (checked)
-					flags |= Qt::ItemIsEnabled;
-				else
-					flags &= ~Qt::ItemIsEnabled;
-				item(iface, col)->setFlags(flags);
-
-				break;
-			}
-		}
+		if(col == COLUMN_IFACE_TYPE_DATA)
+			setItemEnabled(iface, col, checked &&
+				ifaces[iface]->attachmentType != NetworkAttachmentType::Null &&
+				ifaces[iface]->attachmentType != NetworkAttachmentType::NAT);
+		else
+			setItemEnabled(iface, col, checked);
 	}
+	blockSignals(blocked);
 
+	if(ifaces[iface]->enabled != checked)
+		ifaces[iface]->markDirty(IFACE_DIRTY_ENABLED);
 	ifaces[iface]->enabled = checked;
 	return true;
 }
 
 bool IfacesTable::setIfaceEnabled(int iface, bool enabled)
 {
-	((CustomCheckBox *)cellWidget(iface, COLUMN_IFACE_ENABLED))->setCheckState(enabled ? Qt::Checked : Qt::Unchecked);
+	return setStatus(iface, enabled);
 // 	emit sigIfaceChange(iface, IFACE_ENABLED, &enabled);
-	return true;
 }
 
 bool IfacesTable::setName(int iface, QString name)
@@ -603,28 +425,43 @@ bool IfacesTable::setMac(int iface, QString mac)
 	{
 		if (Iface::formatMac(mac) == ifaces[i]->mac)
 		{
-			((MacWidgetField *)cellWidget(iface, COLUMN_MAC))->setText(ifaces[iface]->mac);
+			item(iface, COLUMN_MAC)->setText(ifaces[iface]->mac);
 			return false;
 		}
 	}
 	
+	//Addresses of the other machines are checked in the lab wide index
+	uint64_t value;
+	if (AddressParser::parseMac(mac.constData(), mac.length(), &value) && vboxbridge->getMacAllocator()->isInUse(value, machine, iface))
+	{
+		std::cerr << "MAC address " << Iface::formatMac(mac).toStdString() << " is already in use" << std::endl;
+		item(iface, COLUMN_MAC)->setText(ifaces[iface]->mac);
+		return false;
+	}
+
 	QString old_mac = ifaces[iface]->mac;
 	bool done = ifaces[iface]->setMac(mac);
 	if (done)
 	{
 		QString new_mac = ifaces[iface]->mac;
-		((MacWidgetField *)cellWidget(iface, COLUMN_MAC))->setText(new_mac);
+		item(iface, COLUMN_MAC)->setText(new_mac);
+		vboxbridge->getMacAllocator()->setMac(machine, iface, ifaces[iface]->record.mac);
 // 		emit sigIfaceChange(iface, IFACE_MAC, &new_mac);
 	}
 	else
-		((MacWidgetField *)cellWidget(iface, COLUMN_MAC))->setText(old_mac);
+		item(iface, COLUMN_MAC)->setText(old_mac);
 	
 	return done;
 }
 
 bool IfacesTable::setCableConnected(int iface, bool checked)
 {
-	((CustomCheckBox *)cellWidget(iface, COLUMN_IFACE_CONNECTED))->checkbox->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+	bool blocked = blockSignals(true);
+	item(iface, COLUMN_IFACE_CONNECTED)->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+	blockSignals(blocked);
+
+	if(ifaces[iface]->cableConnected != checked)
+		ifaces[iface]->markDirty(IFACE_DIRTY_CONNECTED);
 	ifaces[iface]->cableConnected = checked;
 	emit sigIfaceChange(iface, IFACE_CONNECTED, &checked);
 	return true;
@@ -675,18 +512,21 @@ bool IfacesTable::setSubnetMask(int iface, QString subnetMask)
 
 bool IfacesTable::setAttachmentType(int iface, uint32_t attachmentType)
 {
-	AttachmentComboBox *attachmentComboBox = (AttachmentComboBox *)cellWidget(iface, COLUMN_IFACE_TYPE);
-	AttachmentDataWidget *attachmentDataWidget = (AttachmentDataWidget *)cellWidget(iface, COLUMN_IFACE_TYPE_DATA);
+	uint32_t old_attachmentType = ifaces[iface]->attachmentType;
 
 	if(ifaces[iface]->setAttachmentType(attachmentType))
 	{
-		attachmentComboBox->remove_connection();
-		attachmentDataWidget->remove_connection();
-		attachmentComboBox->comboBox->setCurrentIndex(ifaces[iface]->attachmentType);
-		attachmentDataWidget->refreshWidget();
-		attachmentDataWidget->refreshStatus();
-		attachmentDataWidget->add_connection();
-		attachmentComboBox->add_connection();
+		//A new attachment type starts from the value VirtualBox keeps for it
+		if(ifaces[iface]->attachmentType != old_attachmentType)
+			ifaces[iface]->setAttachmentData(machine->getAttachmentData(iface, ifaces[iface]->attachmentType));
+
+		bool blocked = blockSignals(true);
+		item(iface, COLUMN_IFACE_TYPE)->setText(attachmentTypeName(ifaces[iface]->attachmentType));
+		item(iface, COLUMN_IFACE_TYPE_DATA)->setText(ifaces[iface]->attachmentData);
+		setItemEnabled(iface, COLUMN_IFACE_TYPE_DATA, ifaces[iface]->enabled &&
+			ifaces[iface]->attachmentType != NetworkAttachmentType::Null &&
+			ifaces[iface]->attachmentType != NetworkAttachmentType::NAT);
+		blockSignals(blocked);
 		return true;
 	}
 	
@@ -698,37 +538,11 @@ bool IfacesTable::setAttachmentData(int iface, QString attachmentData)
 	ifaces[iface]->setAttachmentData(attachmentData);
 	QString new_attachmentData = ifaces[iface]->attachmentData;	
 
-	AttachmentDataWidget *attachmentDataWidget = (AttachmentDataWidget *)cellWidget(iface, COLUMN_IFACE_TYPE_DATA);
-// 	AttachmentComboBox *attachmentComboBox = (AttachmentComboBox *)cellWidget(iface, COLUMN_IFACE_TYPE);
-	if((ifaces[iface]->attachmentType == NetworkAttachmentType::Internal && vboxbridge->isNewInternalNetwork(attachmentData)) ||
-		(ifaces[iface]->attachmentType == NetworkAttachmentType::Generic && vboxbridge->isNewGenericDriver(attachmentData)))
-	{
-		bool inserted = false;
-		for(int i = 0; i < attachmentDataWidget->comboBox->count(); i++)
-		{
-			if(attachmentDataWidget->comboBox->itemText(i) == attachmentData)
-			{
-				inserted = true;
-				break;
-			}
-		}
-
-		if(!inserted)
-		{
-			attachmentDataWidget->comboBox->blockSignals(true);
-			attachmentDataWidget->comboBox->addItem(attachmentData);
-			attachmentDataWidget->comboBox->blockSignals(false);
-		}
-	}
-
-// 	uint32_t attachmentType = attachmentComboBox->comboBox->currentIndex();
-//
-// 	if(attachmentType == NetworkAttachmentType::Internal ||
-// 	   attachmentType == NetworkAttachmentType::Generic)
-// 		((AttachmentDataWidget *)cellWidget(iface, COLUMN_IFACE_TYPE_DATA))->comboBox->lineEdit()->setText(new_attachmentData);
+	bool blocked = blockSignals(true);
+	item(iface, COLUMN_IFACE_TYPE_DATA)->setText(new_attachmentData);
+	blockSignals(blocked);
 // 	emit sigIfaceChange(iface, IFACE_ATTACHMENT_DATA, &new_attachmentData);
 
-	attachmentDataWidget->refreshStatus();
 	return true;
 }
 
@@ -756,13 +570,16 @@ QStringList IfacesTable::getIfaceInfo(int iface)
 
 void IfacesTable::slotRefreshIface(int iface)
 {
-	((MacWidgetField *)cellWidget(iface, COLUMN_MAC))->setText(ifaces[iface]->mac);
-	((CustomCheckBox *)cellWidget(iface, COLUMN_IFACE_CONNECTED))->checkbox->setCheckState(ifaces[iface]->cableConnected ? Qt::Checked : Qt::Unchecked);
+	bool blocked = blockSignals(true);
+	item(iface, COLUMN_MAC)->setText(ifaces[iface]->mac);
+	item(iface, COLUMN_IFACE_CONNECTED)->setCheckState(ifaces[iface]->cableConnected ? Qt::Checked : Qt::Unchecked);
 	item(iface, COLUMN_IFACE_NAME)->setText(ifaces[iface]->name);
 #ifdef CONFIGURABLE_IP
 	item(iface, COLUMN_IP)->setText(ifaces[iface]->ip);
 	item(iface, COLUMN_SUBNETMASK)->setText(ifaces[iface]->subnetMask);
 #endif
+	blockSignals(blocked);
+
 	setAttachmentType(iface, ifaces[iface]->attachmentType);
 	setAttachmentData(iface, ifaces[iface]->attachmentData);
 
@@ -775,35 +592,17 @@ void IfacesTable::lockSettings()
 	{
 		for (int col = 0; col < columnCount(); col++)
 		{
-			Qt::ItemFlags flags;
 			switch(col)
 			{
 				case COLUMN_IFACE_ENABLED:
-				{
-					CustomCheckBox *c = (CustomCheckBox *)cellWidget(iface, col);
-					c->checkbox->setEnabled(false);
-					break;
-				}
-
 				case COLUMN_MAC:
-				{
-					MacWidgetField *w = (MacWidgetField *)cellWidget(iface, col);
-					w->button->setEnabled(false);
-					w->lineEdit->setEnabled(false);
-					break;
-				}
-
 				case COLUMN_IFACE_NAME:
 #ifdef CONFIGURABLE_IP
 				case COLUMN_IP:
 				case COLUMN_SUBNETMASK:
 #endif
-				{
-					flags = item(iface, col)->flags();
-					flags &= ~Qt::ItemIsEnabled;
-					item(iface, col)->setFlags(flags);
+					setItemEnabled(iface, col, false);
 					break;
-				}
 
 				case COLUMN_IFACE_CONNECTED:
 				case COLUMN_IFACE_TYPE:
@@ -818,8 +617,8 @@ void IfacesTable::unlockSettings()
 {
 	for(int iface = 0; iface < rowCount(); iface++)
 	{
-		((CustomCheckBox *)cellWidget(iface, COLUMN_IFACE_ENABLED))->checkbox->setEnabled(true);
-		setStatus(iface, ((CustomCheckBox *)cellWidget(iface, COLUMN_IFACE_ENABLED))->checkbox->isChecked());
+		setItemEnabled(iface, COLUMN_IFACE_ENABLED, true);
+		setStatus(iface, item(iface, COLUMN_IFACE_ENABLED)->checkState() == Qt::Checked);
 	}
 }
 
@@ -833,6 +632,9 @@ void IfacesTable::cellChangedSlot(int row, int column)
 		case COLUMN_MAC:
 // 			setMac(row, item(row, COLUMN_MAC)->text());
 			break;
+		case COLUMN_IFACE_CONNECTED:
+			setCableConnected(row, item(row, COLUMN_IFACE_CONNECTED)->checkState() == Qt::Checked);
+			break;
 		case COLUMN_IFACE_NAME:
 			setName(row, item(row, COLUMN_IFACE_NAME)->text());
 			break;
@@ -845,10 +647,10 @@ void IfacesTable::cellChangedSlot(int row, int column)
 			break;
 #endif
 		case COLUMN_IFACE_TYPE:
-// 			setIfaceDataWidgetContent(row);
-			break;
 		case COLUMN_IFACE_TYPE_DATA:
-// 			setSubnetName(row, item(row, COLUMN_SUBNETNAME)->text());
-			break;
+			//Edited through IfacesTableDelegate
+			return;
 	}
+
+	emit ifaceEdited(row);
 }
@@ -28,6 +28,7 @@
 #include <QToolButton>
 #include <QLineEdit>
 #include <QComboBox>
+#include <QStyledItemDelegate>
 #include <vector>
 
 #include "Iface.h"
@@ -52,8 +53,10 @@
 #endif
 
 class IfacesTable;
-class MacWidgetFieldBridge;
 
+/**
+ * Editor of the MAC address column, with a button to generate a new address
+ */
 class MacWidgetField : public QWidget
 {
 	Q_OBJECT
@@ -62,11 +65,11 @@ class MacWidgetField : public QWidget
 		MacWidgetField(QWidget *parent, int row, IfacesTable *destination);
 		virtual ~MacWidgetField();
 		void setText(const QString &text);
+		QString text() const;
 		QToolButton *button;
 		QLineEdit *lineEdit;
 		
 	public slots:
-		void editingFinishedSlot();
 		void releasedSlot();
 		
 	private:
@@ -74,69 +77,33 @@ class MacWidgetField : public QWidget
 		IfacesTable *destination;
 };
 
-class CustomCheckBox : public QWidget
+/**
+ * Delegate shared by every IfacesTable. Cells hold plain items and editors
+ * are created only while a cell is being edited, so a table costs the same
+ * whatever the number of rows.
+ */
+class IfacesTableDelegate : public QStyledItemDelegate
 {
 	Q_OBJECT
-	
-	public:
-		CustomCheckBox(QWidget *parent, int row, void *destination, bool (*function_forwarder)(void*, int, bool));
-		virtual ~CustomCheckBox();
-		void setCheckState(Qt::CheckState checked);
-		QCheckBox *checkbox;
-		
-	public slots:
-		void toggledSlot(bool checked);
-		
-	private:
-		int row;
-		void *destination;
-		bool (*function_forwarder)(void*, int, bool);
-};
 
-class AttachmentComboBox : public QWidget
-{
-	Q_OBJECT
-	
 	public:
-		AttachmentComboBox(QWidget *parent, int row, IfacesTable *destination);
-		virtual ~AttachmentComboBox();
-		void add_connection();
-		void remove_connection();
-		QComboBox *comboBox;
-	
-	public slots:
-		void currentIndexChangedSlot(int index);
-	
-	private:
-		int row;
-		IfacesTable *destination;
-};
+		IfacesTableDelegate(QObject *parent = 0);
+		virtual ~IfacesTableDelegate();
 
-class AttachmentDataWidget : public QWidget
-{
-	Q_OBJECT
-	public:
-		AttachmentDataWidget(QWidget *parent, int row, IfacesTable *destination);
-		virtual ~AttachmentDataWidget();
-		void add_connection();
-		void remove_connection();
-		void refreshWidget();
-		void refreshData();
-		void refreshStatus();
-		QComboBox *comboBox;
+		QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+		void setEditorData(QWidget *editor, const QModelIndex &index) const;
+		void setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const;
 
-	public slots:
-		void currentIndexChangedSlot(int index);
-		void editingFinishedSlot();
+	private slots:
+		void activatedSlot(int index);
 
 	private:
-		int row;
-		IfacesTable *destination;
+		static IfacesTable *table(const QModelIndex &index);
 };
 
 class IfacesTable : public QTableWidget
 {
-	friend class AttachmentDataWidget;
+	friend class IfacesTableDelegate;
 	Q_OBJECT
 	
 	public:
@@ -171,6 +138,12 @@ class IfacesTable : public QTableWidget
 	signals:
 		void sigIfaceChange(int iface, ifacekey_t key, void *value_ptr);
 
+		/**
+		 * Emitted when the user edits a cell of iface, after the new
+		 * value has been stored in the iface
+		 */
+		void ifaceEdited(int iface);
+
 	private slots:
 		void cellChangedSlot(int row, int column);
 
@@ -182,6 +155,10 @@ class IfacesTable : public QTableWidget
 		QTableWidget *ifaces_table;
 		
 	private:
+		void setItemEnabled(int iface, int column, bool enabled);
+		static QString attachmentTypeName(uint32_t attachmentType);
+		static IfacesTableDelegate *sharedDelegate();
+
 		VirtualBoxBridge *vboxbridge;
 		MachineBridge *machine;
 };
@@ -0,0 +1,335 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "ImportExecutor.h"
+#include "MainWindow.h"
+#include "VMTabSettings.h"
+#include "ProgressDialog.h"
+#include "MacAllocator.h"
+#include "OperationsStats.h"
+#include "Log.h"
+#include <iostream>
+#include <QThread>
+#include <QThreadPool>
+#include <QMessageBox>
+
+ImportSaveTask::ImportSaveTask(import_operation_t *operation, QAtomicInt *completed)
+: operation(operation), completed(completed)
+{
+
+}
+
+void ImportSaveTask::run()
+{
+	//Tabs were built on the GUI thread when restored, getVM() does not build here
+	operation->succeeded = operation->vmtab->getVM()->saveSettings();
+	if(!operation->succeeded)
+		operation->error = QString::fromUtf8("salvataggio delle impostazioni non riuscito");
+
+	OperationsStats::addPendingBulk(-1);
+	completed->ref();
+}
+
+ImportExecutor::ImportExecutor(MainWindow *mainwindow, std::vector<VMTabSettings*> *vmTab_vec, int maxThreads)
+: mainwindow(mainwindow), vmTab_vec(vmTab_vec), maxThreads(maxThreads), progressDialog(NULL)
+, completed_steps(0), total_steps(0)
+{
+
+}
+
+ImportExecutor::~ImportExecutor()
+{
+
+}
+
+void ImportExecutor::addUpdate(VMTabSettings *vmtab, const settings_header_t *settings_header, const settings_iface_view_t *settings_ifaces, bool stop)
+{
+	import_operation_t operation;
+	operation.type = IMPORT_UPDATE;
+	operation.vmtab = vmtab;
+	operation.settings_header = settings_header;
+	operation.settings_ifaces = settings_ifaces;
+	operation.stop = stop;
+	operation.succeeded = true;
+	operations.push_back(operation);
+}
+
+void ImportExecutor::addCreate(const settings_header_t *settings_header, const settings_iface_view_t *settings_ifaces)
+{
+	import_operation_t operation;
+	operation.type = IMPORT_CREATE;
+	operation.vmtab = NULL;
+	operation.settings_header = settings_header;
+	operation.settings_ifaces = settings_ifaces;
+	operation.stop = false;
+	operation.succeeded = true;
+	operations.push_back(operation);
+}
+
+bool ImportExecutor::exec(QWidget *parent)
+{
+	if(operations.size() == 0)
+		return true;
+
+	//Each machine is restored and saved, some are also stopped or created
+	completed_steps = 0;
+	total_steps = 2 * operations.size();
+	for(int i = 0; i < operations.size(); i++)
+		if(operations.at(i).stop || operations.at(i).type == IMPORT_CREATE)
+			total_steps++;
+
+	OperationsStats::addPendingBulk(operations.size());
+
+	ProgressDialog p("");
+	p.ui->label->setText("Importazione macchine...");
+	p.ui->progressBar->setValue(0);
+	p.open();
+	progressDialog = &p;
+
+	stopMachines();
+	createMachines();
+	restoreMachines();
+	saveMachines();
+	checkMacAddresses();
+
+	p.ui->label->setText("Importazione completata");
+	p.ui->progressBar->setValue(100);
+	p.refresh();
+	progressDialog = NULL;
+	p.close();
+
+	report(parent);
+
+	return errors().isEmpty();
+}
+
+QStringList ImportExecutor::errors() const
+{
+	QStringList errors;
+	for(int i = 0; i < operations.size(); i++)
+		if(!operations.at(i).succeeded)
+			errors << QString::fromUtf8(operations.at(i).settings_header->machine_name).append(": ").append(operations.at(i).error);
+
+	return errors;
+}
+
+QStringList ImportExecutor::collisions() const
+{
+	QStringList collisions;
+	for(int i = 0; i < operations.size(); i++)
+		for(int j = 0; j < operations.at(i).collisions.size(); j++)
+			collisions << QString::fromUtf8(operations.at(i).settings_header->machine_name).append(": ").append(operations.at(i).collisions.at(j));
+
+	return collisions;
+}
+
+void ImportExecutor::stopMachines()
+{
+	for(int i = 0; i < operations.size(); i++)
+	{
+		import_operation_t *operation = &operations.at(i);
+		if(!operation->stop)
+			continue;
+
+		step(QString::fromUtf8("Arresto macchina \"").append(operation->settings_header->machine_name).append("\""));
+
+		uint32_t machineState = operation->vmtab->getVM()->getState();
+		if(machineState == MachineState::Running ||
+		   machineState == MachineState::Paused ||
+		   machineState == MachineState::Starting)
+			operation->vmtab->getVM()->stop();
+	}
+}
+
+void ImportExecutor::createMachines()
+{
+	//Machines are registered in VirtualBox and added to the main window one at a time
+	for(int i = 0; i < operations.size(); i++)
+	{
+		import_operation_t *operation = &operations.at(i);
+		if(operation->type != IMPORT_CREATE)
+			continue;
+
+		step(QString::fromUtf8("Creazione macchina \"").append(operation->settings_header->machine_name).append("\""));
+
+		//Imported settings are saved later, so the new machine is not initialized
+		int newMachine = mainwindow->launchCreateProcess(operation->settings_header->machine_name, true, true);
+		if(newMachine < 0)
+		{
+			fail(operation, QString::fromUtf8("creazione della macchina non riuscita"));
+			continue;
+		}
+
+		if(!vmTab_vec->at(newMachine)->setMachineUUID(operation->settings_header->machine_uuid))
+		{
+			fail(operation, QString::fromUtf8("impossibile impostare l'UUID della macchina"));
+			continue;
+		}
+
+		operation->vmtab = vmTab_vec->at(newMachine);
+	}
+}
+
+void ImportExecutor::restoreMachines()
+{
+	for(int i = 0; i < operations.size(); i++)
+	{
+		import_operation_t *operation = &operations.at(i);
+		step(QString::fromUtf8("Caricamento impostazioni \"").append(operation->settings_header->machine_name).append("\""));
+
+		if(!operation->succeeded)
+			continue;
+
+		uint32_t machineState = operation->vmtab->getVM()->getState();
+		if(machineState == MachineState::Running ||
+		   machineState == MachineState::Paused ||
+		   machineState == MachineState::Starting)
+		{
+			fail(operation, QString::fromUtf8("la macchina è in esecuzione"));
+			continue;
+		}
+
+		if(!operation->vmtab->getVM()->vmSettings->set_machine(*operation->settings_header, operation->settings_ifaces))
+		{
+			fail(operation, QString::fromUtf8("impostazioni non valide"));
+			continue;
+		}
+
+		operation->vmtab->getVM()->vmSettings->restore();
+	}
+}
+
+void ImportExecutor::saveMachines()
+{
+	std::vector<import_operation_t*> queued;
+	for(int i = 0; i < operations.size(); i++)
+		if(operations.at(i).succeeded)
+			queued.push_back(&operations.at(i));
+
+	//Operations already failed are not pending anymore, the others are done by their task
+	OperationsStats::addPendingBulk((int32_t) queued.size() - (int32_t) operations.size());
+
+	if(queued.size() == 0)
+		return;
+
+	int threads = QThread::idealThreadCount();
+	if(threads < 1 || threads > maxThreads)
+		threads = maxThreads;
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threads);
+	QAtomicInt completed(0);
+
+	/*
+	 * Signals of the machines are blocked while saving, so that slots of
+	 * GUI objects are never called from pool threads
+	 */
+	for(int i = 0; i < queued.size(); i++)
+	{
+		queued.at(i)->vmtab->getVM()->blockSignals(true);
+		pool.start(new ImportSaveTask(queued.at(i), &completed));
+	}
+
+	LOG_DEBUG(LOG_SETTINGS, "Saving %d machines on %d threads", (int)queued.size(), threads);
+
+	int saved = 0;
+	while(!pool.waitForDone(IMPORT_PROGRESS_INTERVAL) || saved < queued.size())
+	{
+		int done = completed;
+		step(QString::fromUtf8("Salvataggio impostazioni (%1/%2)").arg(done).arg(queued.size()), done - saved);
+		saved = done;
+	}
+
+	for(int i = 0; i < queued.size(); i++)
+	{
+		VirtualMachine *vm = queued.at(i)->vmtab->getVM();
+		vm->blockSignals(false);
+
+		for(int iface = 0; iface < vm->ifaces_size; iface++)
+			emit vm->ifaceChanged(iface);
+		emit vm->settingsChanged(vm);
+	}
+}
+
+void ImportExecutor::checkMacAddresses()
+{
+	//Saved machines are already in the lab wide index, through settingsChanged
+	MacAllocator *macAllocator = mainwindow->vboxbridge->getMacAllocator();
+	for(int i = 0; i < operations.size(); i++)
+	{
+		import_operation_t *operation = &operations.at(i);
+		if(!operation->succeeded)
+			continue;
+
+		operation->collisions = macAllocator->collisions(operation->vmtab->getVM());
+		if(!operation->collisions.isEmpty())
+			std::cerr << "[" << operation->settings_header->machine_name << "] Duplicate MAC addresses: " << operation->collisions.join(", ").toStdString() << std::endl;
+	}
+}
+
+void ImportExecutor::fail(import_operation_t *operation, QString error)
+{
+	operation->succeeded = false;
+	operation->error = error;
+	std::cerr << "[" << operation->settings_header->machine_name << "] Import failed: " << error.toStdString() << std::endl;
+}
+
+void ImportExecutor::step(QString label, int steps)
+{
+	completed_steps += steps;
+
+	if(progressDialog == NULL)
+		return;
+
+	progressDialog->ui->label->setText(label);
+	progressDialog->ui->progressBar->setValue((completed_steps * 100) / total_steps);
+	progressDialog->refresh();
+}
+
+void ImportExecutor::report(QWidget *parent)
+{
+	QStringList errors = this->errors();
+	QStringList collisions = this->collisions();
+
+	if(errors.isEmpty() && collisions.isEmpty())
+		return;
+
+	QString text;
+	QString detailedText = errors.join("\n");
+	if(!collisions.isEmpty())
+	{
+		if(!detailedText.isEmpty())
+			detailedText.append("\n\n");
+		detailedText.append(QString::fromUtf8("Indirizzi MAC già assegnati ad altre macchine:\n")).append(collisions.join("\n"));
+	}
+
+	if(errors.isEmpty())
+		text = QString::fromUtf8("%1 indirizzi MAC importati sono già assegnati ad altre macchine.").arg(collisions.size());
+	else
+		text = QString::fromUtf8("Importazione non riuscita per %1 macchine su %2.").arg(errors.size()).arg(operations.size());
+
+	QMessageBox qm(errors.isEmpty() ? QMessageBox::Warning : QMessageBox::Critical, "Importazione macchine", text, QMessageBox::Ok, parent);
+	qm.setDetailedText(detailedText);
+	if(parent != NULL)
+		qm.setPalette(parent->palette());
+	qm.exec();
+}
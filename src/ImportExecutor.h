@@ -0,0 +1,126 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef IMPORTEXECUTOR_H
+#define IMPORTEXECUTOR_H
+
+#include <QWidget>
+#include <QString>
+#include <QStringList>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <vector>
+
+#include "VMSettings.h"
+
+/** Upper bound for machines whose settings are saved at the same time */
+#define IMPORT_MAX_THREADS 4
+
+/** Interval between progress dialog refreshes while saving, in ms */
+#define IMPORT_PROGRESS_INTERVAL 250
+
+class MainWindow;
+class VMTabSettings;
+class ProgressDialog;
+
+typedef enum
+{
+	IMPORT_UPDATE,
+	IMPORT_CREATE
+} import_operation_type_t;
+
+typedef struct
+{
+	import_operation_type_t type;
+	VMTabSettings *vmtab;
+	const settings_header_t *settings_header;
+	const settings_iface_view_t *settings_ifaces;
+	bool stop;
+	bool succeeded;
+	QString error;
+	QStringList collisions;
+} import_operation_t;
+
+/**
+ * Applies a set of machines read from an archive. Operations are grouped by
+ * type: machines are stopped and created one at a time on the GUI thread,
+ * then the imported settings are restored and the slow part of
+ * VirtualMachine::saveSettings (VirtualBox properties, guest disk mount and
+ * write) runs for several machines at once on a bounded thread pool.
+ */
+class ImportExecutor
+{
+	public:
+		ImportExecutor(MainWindow *mainwindow, std::vector<VMTabSettings*> *vmTab_vec, int maxThreads = IMPORT_MAX_THREADS);
+		virtual ~ImportExecutor();
+
+		void addUpdate(VMTabSettings *vmtab, const settings_header_t *settings_header, const settings_iface_view_t *settings_ifaces, bool stop = false);
+		void addCreate(const settings_header_t *settings_header, const settings_iface_view_t *settings_ifaces);
+
+		/**
+		 * This function runs every queued operation, showing a single
+		 * progress dialog and, at the end, a single report.
+		 * This function returns true if every operation succeeded.
+		 */
+		bool exec(QWidget *parent = 0);
+		QStringList errors() const;
+
+		/**
+		 * This function returns the imported MAC addresses which are
+		 * used by other machines too
+		 */
+		QStringList collisions() const;
+
+	private:
+		void createMachines();
+		void stopMachines();
+		void restoreMachines();
+		void saveMachines();
+		void checkMacAddresses();
+		void fail(import_operation_t *operation, QString error);
+		void step(QString label, int steps = 1);
+		void report(QWidget *parent);
+
+		MainWindow *mainwindow;
+		std::vector<VMTabSettings*> *vmTab_vec;
+		int maxThreads;
+		std::vector<import_operation_t> operations;
+		ProgressDialog *progressDialog;
+		int completed_steps;
+		int total_steps;
+};
+
+/**
+ * Saves the settings of a single machine on a pool thread
+ */
+class ImportSaveTask : public QRunnable
+{
+	public:
+		ImportSaveTask(import_operation_t *operation, QAtomicInt *completed);
+		void run();
+
+	private:
+		import_operation_t *operation;
+		QAtomicInt *completed;
+};
+
+#endif //IMPORTEXECUTOR_H
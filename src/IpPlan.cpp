@@ -0,0 +1,328 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "IpPlan.h"
+
+#ifdef CONFIGURABLE_IP
+
+#include "VirtualMachine.h"
+#include "NameTable.h"
+
+IpPlan::IpPlan(QObject *parent)
+: QObject(parent), conflicting_networks(0)
+{
+
+}
+
+IpPlan::~IpPlan()
+{
+
+}
+
+void IpPlan::addMachine(VirtualMachine *vm)
+{
+	if(machines.find(vm) != machines.end())
+		return;
+
+	machines.insert(vm);
+	updateMachine(vm);
+}
+
+void IpPlan::removeMachine(VirtualMachine *vm)
+{
+	if(machines.find(vm) == machines.end())
+		return;
+
+	std::map<ip_plan_endpoint_t, ip_plan_entry_t>::iterator it = entries.lower_bound(ip_plan_endpoint_t(vm, 0));
+	while(it != entries.end() && it->first.first == vm)
+		remove((it++)->first);
+
+	machines.erase(vm);
+}
+
+void IpPlan::validate()
+{
+	entries.clear();
+	networks.clear();
+	conflicting_networks = 0;
+
+	for(std::set<VirtualMachine*>::iterator vm = machines.begin(); vm != machines.end(); ++vm)
+		for(int iface = 0; iface < (*vm)->ifaces_size; iface++)
+		{
+			ip_plan_entry_t entry;
+			if(this->entry(*vm, iface, &entry))
+				insert(ip_plan_endpoint_t(*vm, iface), entry);
+		}
+}
+
+void IpPlan::updateMachine(VirtualMachine *vm)
+{
+	if(machines.find(vm) == machines.end())
+		return;
+
+	//Ifaces no longer present are removed
+	std::map<ip_plan_endpoint_t, ip_plan_entry_t>::iterator it = entries.lower_bound(ip_plan_endpoint_t(vm, vm->ifaces_size));
+	while(it != entries.end() && it->first.first == vm)
+		remove((it++)->first);
+
+	for(int iface = 0; iface < vm->ifaces_size; iface++)
+		updateIface(vm, iface);
+}
+
+void IpPlan::updateIface(VirtualMachine *vm, int iface)
+{
+	if(machines.find(vm) == machines.end() || iface < 0 || iface >= vm->ifaces_size)
+		return;
+
+	ip_plan_endpoint_t endpoint(vm, iface);
+	ip_plan_entry_t new_entry;
+	bool indexed = entry(vm, iface, &new_entry);
+
+	std::map<ip_plan_endpoint_t, ip_plan_entry_t>::iterator it = entries.find(endpoint);
+	if(it != entries.end())
+	{
+		const ip_plan_entry_t &old_entry = it->second;
+		if(indexed && old_entry.network == new_entry.network && old_entry.address == new_entry.address &&
+		   old_entry.has_subnet == new_entry.has_subnet && old_entry.subnet == new_entry.subnet)
+			return;
+
+		remove(endpoint);
+	}
+
+	if(indexed)
+		insert(endpoint, new_entry);
+}
+
+bool IpPlan::entry(VirtualMachine *vm, int iface, ip_plan_entry_t *entry) const
+{
+	const Iface *i = vm->ifaces[iface];
+	if(!i->enabled || i->attachmentType != NetworkAttachmentType::Internal ||
+	   i->record.attachmentData == NAME_NONE || i->record.ip.family == IP_FAMILY_NONE)
+		return false;
+
+	entry->network = i->record.attachmentData;
+
+	entry->address.family = i->record.ip.family;
+	entry->address.prefix_length = 0;
+	if(i->record.ip.family == IP_FAMILY_IPV4)
+	{
+		entry->address.high = 0;
+		entry->address.low = i->record.ip.ipv4;
+	}
+	else
+	{
+		entry->address.high = i->record.ip.ipv6.high;
+		entry->address.low = i->record.ip.ipv6.low;
+	}
+
+	entry->has_subnet = (i->record.prefix_length >= 0);
+	entry->subnet = entry->address;
+	if(entry->has_subnet)
+	{
+		int prefix = i->record.prefix_length;
+		entry->subnet.prefix_length = prefix;
+
+		if(i->record.ip.family == IP_FAMILY_IPV4)
+			entry->subnet.low &= AddressParser::subnetMaskFromPrefix(prefix);
+		else
+		{
+			entry->subnet.high &= (prefix <= 0) ? 0 : (prefix >= 64) ? ~0ULL : ~0ULL << (64 - prefix);
+			entry->subnet.low &= (prefix <= 64) ? 0 : (prefix >= 128) ? ~0ULL : ~0ULL << (128 - prefix);
+		}
+	}
+
+	return true;
+}
+
+void IpPlan::insert(ip_plan_endpoint_t endpoint, const ip_plan_entry_t &entry)
+{
+	std::map<uint32_t, ip_plan_network_t>::iterator network_it = networks.find(entry.network);
+	if(network_it == networks.end())
+	{
+		network_it = networks.insert(std::make_pair(entry.network, ip_plan_network_t())).first;
+		network_it->second.duplicates = 0;
+	}
+
+	ip_plan_network_t &network = network_it->second;
+	bool was_conflicting = isConflicting(network);
+
+	std::set<ip_plan_endpoint_t> &address = network.addresses[entry.address];
+	address.insert(endpoint);
+	if(address.size() == 2)
+		network.duplicates++;
+
+	if(entry.has_subnet)
+		network.subnets[entry.subnet].insert(endpoint);
+
+	entries[endpoint] = entry;
+
+	bool is_conflicting = isConflicting(network);
+	if(is_conflicting != was_conflicting)
+		conflicting_networks += is_conflicting ? 1 : -1;
+}
+
+void IpPlan::remove(ip_plan_endpoint_t endpoint)
+{
+	std::map<ip_plan_endpoint_t, ip_plan_entry_t>::iterator it = entries.find(endpoint);
+	if(it == entries.end())
+		return;
+
+	ip_plan_entry_t entry = it->second;
+	entries.erase(it);
+
+	std::map<uint32_t, ip_plan_network_t>::iterator network_it = networks.find(entry.network);
+	ip_plan_network_t &network = network_it->second;
+	bool was_conflicting = isConflicting(network);
+
+	std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> >::iterator address = network.addresses.find(entry.address);
+	address->second.erase(endpoint);
+	if(address->second.size() == 1)
+		network.duplicates--;
+	else if(address->second.empty())
+		network.addresses.erase(address);
+
+	if(entry.has_subnet)
+	{
+		std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> >::iterator subnet = network.subnets.find(entry.subnet);
+		subnet->second.erase(endpoint);
+		if(subnet->second.empty())
+			network.subnets.erase(subnet);
+	}
+
+	bool is_conflicting = isConflicting(network);
+	if(is_conflicting != was_conflicting)
+		conflicting_networks += is_conflicting ? 1 : -1;
+
+	if(network.addresses.empty())
+		networks.erase(network_it);
+}
+
+bool IpPlan::isConflicting(const ip_plan_network_t &network) const
+{
+	return network.duplicates > 0 || network.subnets.size() > 1;
+}
+
+bool IpPlan::isMinoritySubnet(const ip_plan_network_t &network, const ip_plan_key_t &subnet) const
+{
+	if(network.subnets.size() < 2)
+		return false;
+
+	//The subnet used by most ifaces is the expected one; if there is a tie, none is
+	size_t majority_size = 0;
+	int majority_count = 0;
+	for(std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> >::const_iterator it = network.subnets.begin(); it != network.subnets.end(); ++it)
+	{
+		if(it->second.size() > majority_size)
+		{
+			majority_size = it->second.size();
+			majority_count = 1;
+		}
+		else if(it->second.size() == majority_size)
+			majority_count++;
+	}
+
+	std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> >::const_iterator it = network.subnets.find(subnet);
+	return it == network.subnets.end() || it->second.size() < majority_size || majority_count > 1;
+}
+
+int IpPlan::conflicts(VirtualMachine *vm, int iface) const
+{
+	std::map<ip_plan_endpoint_t, ip_plan_entry_t>::const_iterator it = entries.find(ip_plan_endpoint_t(vm, iface));
+	if(it == entries.end())
+		return IP_CONFLICT_NONE;
+
+	const ip_plan_network_t &network = networks.find(it->second.network)->second;
+	int flags = IP_CONFLICT_NONE;
+
+	if(network.addresses.find(it->second.address)->second.size() > 1)
+		flags |= IP_CONFLICT_DUPLICATE;
+
+	if(it->second.has_subnet && isMinoritySubnet(network, it->second.subnet))
+		flags |= IP_CONFLICT_SUBNET;
+
+	return flags;
+}
+
+QString IpPlan::endpointName(ip_plan_endpoint_t endpoint)
+{
+	VirtualMachine *vm = endpoint.first;
+	QString ifaceName = vm->ifaces[endpoint.second]->name;
+	if(ifaceName.isEmpty())
+		ifaceName = QString::fromUtf8("interfaccia %1").arg(endpoint.second);
+
+	return vm->machine->getName().append(" (").append(ifaceName).append(")");
+}
+
+QStringList IpPlan::report() const
+{
+	QStringList report;
+	if(!hasConflicts())
+		return report;
+
+	std::map<QString, const ip_plan_network_t*> sorted;
+	for(std::map<uint32_t, ip_plan_network_t>::const_iterator it = networks.begin(); it != networks.end(); ++it)
+		if(isConflicting(it->second))
+			sorted[NameTable::name(it->first)] = &it->second;
+
+	for(std::map<QString, const ip_plan_network_t*>::iterator it = sorted.begin(); it != sorted.end(); ++it)
+	{
+		const ip_plan_network_t *network = it->second;
+
+		if(network->duplicates > 0)
+		{
+			for(std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> >::const_iterator address = network->addresses.begin(); address != network->addresses.end(); ++address)
+			{
+				if(address->second.size() < 2)
+					continue;
+
+				QStringList endpoints;
+				for(std::set<ip_plan_endpoint_t>::const_iterator endpoint = address->second.begin(); endpoint != address->second.end(); ++endpoint)
+					endpoints << endpointName(*endpoint);
+
+				const ip_plan_endpoint_t &first = *address->second.begin();
+				report << QString::fromUtf8("Rete \"%1\": indirizzo %2 assegnato a %3")
+					.arg(it->first).arg(first.first->ifaces[first.second]->ip).arg(endpoints.join(", "));
+			}
+		}
+
+		if(network->subnets.size() > 1)
+		{
+			QStringList subnets;
+			for(std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> >::const_iterator subnet = network->subnets.begin(); subnet != network->subnets.end(); ++subnet)
+			{
+				QStringList endpoints;
+				for(std::set<ip_plan_endpoint_t>::const_iterator endpoint = subnet->second.begin(); endpoint != subnet->second.end(); ++endpoint)
+					endpoints << endpointName(*endpoint);
+
+				const ip_plan_endpoint_t &first = *subnet->second.begin();
+				QString address = (subnet->first.family == IP_FAMILY_IPV4) ? AddressParser::formatIPv4(subnet->first.low) : first.first->ifaces[first.second]->ip;
+				subnets << QString::fromUtf8("%1/%2 (%3)").arg(address).arg(subnet->first.prefix_length).arg(endpoints.join(", "));
+			}
+
+			report << QString::fromUtf8("Rete \"%1\": sottoreti diverse: %2").arg(it->first).arg(subnets.join("; "));
+		}
+	}
+
+	return report;
+}
+
+#endif //CONFIGURABLE_IP
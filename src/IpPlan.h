@@ -0,0 +1,149 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef IPPLAN_H
+#define IPPLAN_H
+
+#ifdef CONFIGURABLE_IP
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include <map>
+#include <set>
+#include <stdint.h>
+
+class VirtualMachine;
+
+/** Conflicts of an iface, as returned by IpPlan::conflicts() */
+#define IP_CONFLICT_NONE	0
+#define IP_CONFLICT_DUPLICATE	(1 << 0)
+#define IP_CONFLICT_SUBNET	(1 << 1)
+
+typedef std::pair<VirtualMachine*, int> ip_plan_endpoint_t;
+
+/**
+ * Packed address or subnet: IPv4 values are kept in low, subnets are
+ * stored by their first address and prefix length
+ */
+typedef struct ip_plan_key
+{
+	int family;
+	uint64_t high, low;
+	int prefix_length;
+
+	bool operator<(const struct ip_plan_key &key) const
+	{
+		if(family != key.family)
+			return family < key.family;
+		if(high != key.high)
+			return high < key.high;
+		if(low != key.low)
+			return low < key.low;
+		return prefix_length < key.prefix_length;
+	}
+
+	bool operator==(const struct ip_plan_key &key) const
+	{
+		return family == key.family && high == key.high && low == key.low && prefix_length == key.prefix_length;
+	}
+} ip_plan_key_t;
+
+typedef struct
+{
+	uint32_t network;
+	ip_plan_key_t address;
+	ip_plan_key_t subnet;
+	bool has_subnet;
+} ip_plan_entry_t;
+
+typedef struct
+{
+	std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> > addresses;
+	std::map<ip_plan_key_t, std::set<ip_plan_endpoint_t> > subnets;
+
+	/** Number of addresses assigned to more than one iface */
+	int duplicates;
+} ip_plan_network_t;
+
+/**
+ * Index of the IP addresses assigned on each internal network: addresses
+ * and subnets (as intervals ordered by their first address) map to the
+ * ifaces using them, so duplicate addresses and ifaces whose subnet differs
+ * from the one of the other ifaces on the same network are found without
+ * comparing every pair of machines. Disabled ifaces and ifaces without an
+ * address are not indexed. The index is updated one iface at a time; the
+ * number of networks with conflicts is kept, so a lab without conflicts is
+ * recognized in constant time.
+ */
+class IpPlan : public QObject
+{
+	Q_OBJECT
+
+	public:
+		IpPlan(QObject *parent = 0);
+		virtual ~IpPlan();
+
+		void addMachine(VirtualMachine *vm);
+		void removeMachine(VirtualMachine *vm);
+
+		/**
+		 * This function rebuilds the index from the ifaces of every added
+		 * machine
+		 */
+		void validate();
+
+		bool hasConflicts() const { return conflicting_networks > 0; };
+
+		/**
+		 * This function returns the IP_CONFLICT_* flags of iface of vm
+		 */
+		int conflicts(VirtualMachine *vm, int iface) const;
+
+		/**
+		 * This function returns a description of each conflict, sorted
+		 * by network name
+		 */
+		QStringList report() const;
+
+	public slots:
+		void updateMachine(VirtualMachine *vm);
+		void updateIface(VirtualMachine *vm, int iface);
+
+	private:
+		bool entry(VirtualMachine *vm, int iface, ip_plan_entry_t *entry) const;
+		void insert(ip_plan_endpoint_t endpoint, const ip_plan_entry_t &entry);
+		void remove(ip_plan_endpoint_t endpoint);
+		bool isConflicting(const ip_plan_network_t &network) const;
+		bool isMinoritySubnet(const ip_plan_network_t &network, const ip_plan_key_t &subnet) const;
+		static QString endpointName(ip_plan_endpoint_t endpoint);
+
+		std::set<VirtualMachine*> machines;
+		std::map<ip_plan_endpoint_t, ip_plan_entry_t> entries;
+		std::map<uint32_t, ip_plan_network_t> networks;
+		int conflicting_networks;
+};
+
+#endif //CONFIGURABLE_IP
+
+#endif //IPPLAN_H
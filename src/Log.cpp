@@ -0,0 +1,235 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "Log.h"
+#include "Trace.h"
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+static const char *level_names[] = { "error", "warning", "info", "debug" };
+static const char *subsystem_names[LOG_SUBSYSTEMS] = { "vm", "vbox", "os", "settings", "gui", "cli" };
+
+int Log::levels[LOG_SUBSYSTEMS] = { LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO };
+log_entry_t Log::ring[LOG_RING_SIZE];
+volatile uint64_t Log::head = 0;
+volatile uint64_t Log::tail = 0;
+volatile uint64_t Log::dropped = 0;
+volatile bool Log::running = false;
+uint64_t Log::start = 0;
+pthread_t Log::writer;
+sem_t Log::sem;
+
+bool Log::parseLevel(const char *name, int length, int *level)
+{
+	for(int i = 0; i <= LOG_LEVEL_DEBUG; i++)
+		if((int) strlen(level_names[i]) == length && strncasecmp(name, level_names[i], length) == 0)
+		{
+			*level = i;
+			return true;
+		}
+
+	return false;
+}
+
+void Log::init()
+{
+	if(running)
+		return;
+
+	start = Trace::now();
+
+	//Each comma separated filter is "level" or "subsystem=level", "*" is every other subsystem
+	bool filtered[LOG_SUBSYSTEMS] = { false };
+	const char *env = getenv(LOG_ENV);
+	while(env != NULL && *env != '\0')
+	{
+		const char *end = strchr(env, ',');
+		int length = (end == NULL) ? strlen(env) : end - env;
+		const char *equal = (const char *)memchr(env, '=', length);
+
+		int subsystem = -1, level;
+		const char *level_name = env;
+		int level_length = length;
+		if(equal != NULL)
+		{
+			level_name = equal + 1;
+			level_length = length - (level_name - env);
+			for(int i = 0; i < LOG_SUBSYSTEMS; i++)
+				if((int) strlen(subsystem_names[i]) == equal - env && strncmp(env, subsystem_names[i], equal - env) == 0)
+					subsystem = i;
+			if(subsystem < 0 && !(equal - env == 1 && *env == '*'))
+				subsystem = LOG_SUBSYSTEMS;
+		}
+
+		if(subsystem == LOG_SUBSYSTEMS || !parseLevel(level_name, level_length, &level))
+			std::cerr << "Ignoring log filter \"" << std::string(env, length) << "\"" << std::endl;
+		else if(subsystem < 0)
+		{
+			for(int i = 0; i < LOG_SUBSYSTEMS; i++)
+				if(!filtered[i])
+					levels[i] = level;
+		}
+		else
+		{
+			levels[subsystem] = level;
+			filtered[subsystem] = true;
+		}
+
+		env = (end == NULL) ? NULL : end + 1;
+	}
+
+	for(uint64_t i = 0; i < LOG_RING_SIZE; i++)
+		ring[i].sequence = i;
+	head = tail = 0;
+
+	sem_init(&sem, 0, 0);
+	running = (pthread_create(&writer, NULL, writerThread, NULL) == 0);
+}
+
+void Log::shutdown()
+{
+	if(!running)
+		return;
+
+	running = false;
+	sem_post(&sem);
+	pthread_join(writer, NULL);
+
+	//Messages queued while the writer was stopping
+	log_entry_t entry;
+	while(pop(&entry))
+		print(&entry);
+	std::cout.flush();
+
+	sem_destroy(&sem);
+}
+
+void Log::write(log_level_t level, log_subsystem_t subsystem, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+
+	if(!running)
+	{
+		log_entry_t entry;
+		entry.timestamp = Trace::now();
+		entry.level = level;
+		entry.subsystem = subsystem;
+		vsnprintf(entry.message, LOG_MESSAGE_SIZE, format, args);
+		va_end(args);
+		print(&entry);
+		return;
+	}
+
+	//A slot is claimed by moving the tail past it, then published through its sequence
+	log_entry_t *entry;
+	uint64_t position = tail;
+	while(true)
+	{
+		entry = &ring[position & (LOG_RING_SIZE - 1)];
+		int64_t available = (int64_t)(__sync_add_and_fetch(&entry->sequence, 0) - position);
+
+		if(available == 0)
+		{
+			uint64_t claimed = __sync_val_compare_and_swap(&tail, position, position + 1);
+			if(claimed == position)
+				break;
+			position = claimed;
+		}
+		else if(available < 0)
+		{
+			va_end(args);
+			__sync_fetch_and_add(&dropped, 1);
+			return;
+		}
+		else
+			position = tail;
+	}
+
+	entry->timestamp = Trace::now();
+	entry->level = level;
+	entry->subsystem = subsystem;
+	vsnprintf(entry->message, LOG_MESSAGE_SIZE, format, args);
+	va_end(args);
+
+	__sync_synchronize();
+	entry->sequence = position + 1;
+	sem_post(&sem);
+}
+
+bool Log::pop(log_entry_t *entry)
+{
+	log_entry_t *slot = &ring[head & (LOG_RING_SIZE - 1)];
+	if(__sync_add_and_fetch(&slot->sequence, 0) != head + 1)
+		return false;
+
+	memcpy(entry, slot, sizeof(log_entry_t));
+
+	//The slot is released for the producers of the next round
+	__sync_synchronize();
+	slot->sequence = head + LOG_RING_SIZE;
+	head++;
+	return true;
+}
+
+void *Log::writerThread(void *)
+{
+	log_entry_t entry;
+	bool stop = false;
+
+	while(!stop)
+	{
+		while(sem_wait(&sem) < 0);
+
+		//A single pass writes every message posted so far
+		while(sem_trywait(&sem) == 0);
+		stop = !running;
+
+		while(pop(&entry))
+			print(&entry);
+
+		uint64_t lost = __sync_fetch_and_and(&dropped, 0);
+		if(lost > 0)
+			std::cerr << "[log] " << lost << " messages dropped, ring full" << std::endl;
+
+		std::cout.flush();
+		std::cerr.flush();
+	}
+
+	return NULL;
+}
+
+void Log::print(const log_entry_t *entry)
+{
+	char line[LOG_MESSAGE_SIZE + 64];
+	snprintf(line, sizeof(line), "[%.6f] %s %s: %s\n", (entry->timestamp - start) / 1e9,
+		 subsystem_names[entry->subsystem], level_names[entry->level], entry->message);
+
+	//Only errors and warnings go to stderr, as they did before
+	if(entry->level <= LOG_LEVEL_WARNING)
+		std::cerr << line;
+	else
+		std::cout << line;
+}
@@ -0,0 +1,134 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+
+/**
+ * Environment variable with the log levels, e.g. "debug" or
+ * "vm=debug,vbox=error,*=warning"; the default level is info
+ */
+#define LOG_ENV "VBANT_LOG"
+
+/** Messages kept until written, must be a power of two */
+#define LOG_RING_SIZE 4096
+
+/** Bytes of each message, longer ones are truncated */
+#define LOG_MESSAGE_SIZE 240
+
+typedef enum
+{
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_WARNING,
+	LOG_LEVEL_INFO,
+	LOG_LEVEL_DEBUG
+} log_level_t;
+
+typedef enum
+{
+	LOG_VM,
+	LOG_VBOX,
+	LOG_OS,
+	LOG_SETTINGS,
+	LOG_GUI,
+	LOG_CLI,
+	LOG_SUBSYSTEMS
+} log_subsystem_t;
+
+/**
+ * Messages above this level are not compiled, debug ones are kept only in
+ * builds with DEBUG_FLAG unless it is given explicitly
+ */
+#ifndef LOG_COMPILE_LEVEL
+	#ifdef DEBUG_FLAG
+		#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+	#else
+		#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+	#endif
+#endif
+
+typedef struct
+{
+	volatile uint64_t sequence;
+	uint64_t timestamp;
+	log_level_t level;
+	log_subsystem_t subsystem;
+	char message[LOG_MESSAGE_SIZE];
+} log_entry_t;
+
+/**
+ * Leveled logger. Messages are formatted by the calling thread into a
+ * preallocated ring shared by every thread and written by a single writer
+ * thread, which flushes once for each batch. When the ring is full messages
+ * are dropped and counted, so a caller never waits for the console.
+ * Before init() and after shutdown() messages are written synchronously.
+ */
+class Log
+{
+	public:
+		/**
+		 * This function reads the levels from LOG_ENV and starts the
+		 * writer thread
+		 */
+		static void init();
+
+		/**
+		 * This function writes pending messages and stops the writer
+		 * thread
+		 */
+		static void shutdown();
+
+		static inline bool isEnabled(log_level_t level, log_subsystem_t subsystem) { return level <= levels[subsystem]; };
+		static void write(log_level_t level, log_subsystem_t subsystem, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+	private:
+		static bool parseLevel(const char *name, int length, int *level);
+		static void *writerThread(void *);
+		static bool pop(log_entry_t *entry);
+		static void print(const log_entry_t *entry);
+
+		static int levels[LOG_SUBSYSTEMS];
+		static log_entry_t ring[LOG_RING_SIZE];
+		static volatile uint64_t head;
+		static volatile uint64_t tail;
+		static volatile uint64_t dropped;
+		static volatile bool running;
+		static uint64_t start;
+		static pthread_t writer;
+		static sem_t sem;
+};
+
+#define LOG(level, subsystem, ...) \
+	do { \
+		if(level <= LOG_COMPILE_LEVEL && Log::isEnabled(level, subsystem)) \
+			Log::write(level, subsystem, __VA_ARGS__); \
+	} while (0)
+
+#define LOG_ERROR(subsystem, ...)	LOG(LOG_LEVEL_ERROR, subsystem, __VA_ARGS__)
+#define LOG_WARNING(subsystem, ...)	LOG(LOG_LEVEL_WARNING, subsystem, __VA_ARGS__)
+#define LOG_INFO(subsystem, ...)	LOG(LOG_LEVEL_INFO, subsystem, __VA_ARGS__)
+#define LOG_DEBUG(subsystem, ...)	LOG(LOG_LEVEL_DEBUG, subsystem, __VA_ARGS__)
+
+#endif //LOG_H
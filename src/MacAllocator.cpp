@@ -0,0 +1,205 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "MacAllocator.h"
+#include "VirtualMachine.h"
+#include "AddressParser.h"
+#include <QSet>
+#include <time.h>
+#include <unistd.h>
+
+/** Number of addresses with the VirtualBox OUI */
+#define MAC_VBOX_SUFFIXES (1 << 24)
+
+MacAllocator::MacAllocator(QObject *parent)
+: QObject(parent)
+{
+	seed = ((uint64_t) time(NULL) << 20) ^ ((uint64_t) getpid() << 40) ^ (uint64_t) (uintptr_t) this;
+	if(seed == 0)
+		seed = MAC_VBOX_OUI;
+}
+
+MacAllocator::~MacAllocator()
+{
+
+}
+
+void MacAllocator::addMachine(MachineBridge *machine)
+{
+	if(machines.find(machine) != machines.end())
+		return;
+
+	machines[machine] = std::vector<uint64_t>();
+	pending.insert(machine);
+}
+
+void MacAllocator::removeMachine(MachineBridge *machine)
+{
+	std::map<MachineBridge*, std::vector<uint64_t> >::iterator it = machines.find(machine);
+	if(it == machines.end())
+		return;
+
+	for(int iface = 0; iface < it->second.size(); iface++)
+		assign(it->second, iface, MAC_NONE);
+
+	machines.erase(it);
+	pending.erase(machine);
+}
+
+void MacAllocator::index()
+{
+	//Machines without a tab are read once, the first time they are needed
+	while(!pending.empty())
+	{
+		MachineBridge *machine = *pending.begin();
+		pending.erase(pending.begin());
+
+		std::vector<nsCOMPtr<INetworkAdapter> > networkAdapter_vec = machine->getNetworkInterfaces();
+		std::vector<uint64_t> &macs = machines[machine];
+		for(int iface = 0; iface < networkAdapter_vec.size(); iface++)
+		{
+			QString mac = machine->getIfaceMac(networkAdapter_vec.at(iface));
+			uint64_t value = MAC_NONE;
+			AddressParser::parseMac(mac.constData(), mac.length(), &value);
+			assign(macs, iface, value);
+		}
+	}
+}
+
+void MacAllocator::assign(std::vector<uint64_t> &macs, int iface, uint64_t mac)
+{
+	if(iface >= macs.size())
+		macs.resize(iface + 1, MAC_NONE);
+
+	uint64_t old_mac = macs.at(iface);
+	if(old_mac == mac)
+		return;
+
+	if(old_mac != MAC_NONE)
+	{
+		QHash<quint64, int>::iterator it = counts.find(old_mac);
+		if(--it.value() == 0)
+			counts.erase(it);
+	}
+
+	if(mac != MAC_NONE)
+		counts[mac]++;
+
+	macs[iface] = mac;
+}
+
+void MacAllocator::setMac(MachineBridge *machine, int iface, uint64_t mac)
+{
+	//Addresses read later from VirtualBox would override this one
+	index();
+	assign(machines[machine], iface, mac);
+}
+
+void MacAllocator::updateMachine(VirtualMachine *vm)
+{
+	index();
+
+	std::vector<uint64_t> &macs = machines[vm->machine];
+	for(int iface = macs.size() - 1; iface >= vm->ifaces_size; iface--)
+		assign(macs, iface, MAC_NONE);
+	macs.resize(vm->ifaces_size, MAC_NONE);
+
+	for(int iface = 0; iface < vm->ifaces_size; iface++)
+		assign(macs, iface, vm->ifaces[iface]->record.mac);
+}
+
+void MacAllocator::updateIface(VirtualMachine *vm, int iface)
+{
+	if(iface < 0 || iface >= vm->ifaces_size)
+		return;
+
+	setMac(vm->machine, iface, vm->ifaces[iface]->record.mac);
+}
+
+int MacAllocator::useCount(uint64_t mac)
+{
+	index();
+	return counts.value(mac, 0);
+}
+
+bool MacAllocator::isInUse(uint64_t mac, MachineBridge *machine, int iface)
+{
+	if(mac == MAC_NONE)
+		return false;
+
+	int count = useCount(mac);
+
+	std::map<MachineBridge*, std::vector<uint64_t> >::const_iterator it = machines.find(machine);
+	if(it != machines.end() && iface >= 0 && iface < it->second.size() && it->second.at(iface) == mac)
+		count--;
+
+	return count > 0;
+}
+
+QStringList MacAllocator::collisions(VirtualMachine *vm)
+{
+	QStringList collisions;
+	for(int iface = 0; iface < vm->ifaces_size; iface++)
+		if(isInUse(vm->ifaces[iface]->record.mac, vm->machine, iface))
+			collisions << vm->ifaces[iface]->mac;
+
+	return collisions;
+}
+
+uint64_t MacAllocator::random()
+{
+	//xorshift64*
+	seed ^= seed >> 12;
+	seed ^= seed << 25;
+	seed ^= seed >> 27;
+	return seed * 2685821657736338717ULL;
+}
+
+uint64_t MacAllocator::generate()
+{
+	std::vector<uint64_t> macs = generate(1);
+	return macs.empty() ? MAC_NONE : macs.at(0);
+}
+
+std::vector<uint64_t> MacAllocator::generate(int count)
+{
+	index();
+
+	std::vector<uint64_t> macs;
+	QSet<quint64> generated;
+
+	if(count <= 0 || counts.size() + count > MAC_VBOX_SUFFIXES)
+		return macs;
+
+	macs.reserve(count);
+	while(macs.size() < count)
+	{
+		uint64_t mac = (MAC_VBOX_OUI << 24) | (random() >> 40);
+		if(counts.contains(mac) || generated.contains(mac))
+			continue;
+
+		generated.insert(mac);
+		macs.push_back(mac);
+	}
+
+	return macs;
+}
@@ -0,0 +1,109 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef MACALLOCATOR_H
+#define MACALLOCATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <vector>
+#include <map>
+#include <set>
+#include <stdint.h>
+
+/** Organizationally unique identifier of VirtualBox network adapters, 08:00:27 */
+#define MAC_VBOX_OUI 0x080027ULL
+
+class MachineBridge;
+class VirtualMachine;
+
+/**
+ * Lab wide index of the MAC addresses in use: each machine maps to the MAC
+ * addresses of its ifaces, and a use count is kept for each address, so a
+ * collision is found without scanning every machine. Machines whose tab has
+ * not been built yet are read from VirtualBox the first time the index is
+ * queried. New addresses are generated locally from the VirtualBox OUI,
+ * skipping the ones in use.
+ */
+class MacAllocator : public QObject
+{
+	Q_OBJECT
+
+	public:
+		MacAllocator(QObject *parent = 0);
+		virtual ~MacAllocator();
+
+		/**
+		 * This function adds machine to the index; its addresses are read
+		 * from VirtualBox when the index is first queried
+		 */
+		void addMachine(MachineBridge *machine);
+		void removeMachine(MachineBridge *machine);
+
+		/**
+		 * This function records mac as the address of iface of machine
+		 */
+		void setMac(MachineBridge *machine, int iface, uint64_t mac);
+
+		int useCount(uint64_t mac);
+
+		/**
+		 * This function returns true if mac is used by any iface other
+		 * than iface of machine
+		 */
+		bool isInUse(uint64_t mac, MachineBridge *machine = NULL, int iface = -1);
+
+		/**
+		 * This function returns the formatted addresses of vm which are
+		 * used by other ifaces too
+		 */
+		QStringList collisions(VirtualMachine *vm);
+
+		/**
+		 * This function returns an address not in use, MAC_NONE if every
+		 * address of the OUI is taken
+		 */
+		uint64_t generate();
+
+		/**
+		 * This function returns count distinct addresses not in use
+		 */
+		std::vector<uint64_t> generate(int count);
+
+	public slots:
+		void updateMachine(VirtualMachine *vm);
+		void updateIface(VirtualMachine *vm, int iface);
+
+	private:
+		void index();
+		void assign(std::vector<uint64_t> &macs, int iface, uint64_t mac);
+		uint64_t random();
+
+		std::set<MachineBridge*> pending;
+		std::map<MachineBridge*, std::vector<uint64_t> > machines;
+		QHash<quint64, int> counts;
+		uint64_t seed;
+};
+
+#endif //MACALLOCATOR_H
@@ -0,0 +1,507 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "MachinesArchive.h"
+#include "crc32.h"
+#include "Log.h"
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+
+#ifdef USE_ZLIB
+	#include "ZlibWrapper.h"
+#endif
+
+/** 'S', archive type, number of machines, machines data size */
+#define ARCHIVE_PREAMBLE_SIZE (3 * sizeof(char) + sizeof(uint32_t))
+
+MachinesArchive::MachinesArchive()
+: type(0), map(NULL), map_size(0), inflated_data(NULL), data(NULL), data_size(0), base(NULL)
+{
+
+}
+
+MachinesArchive::~MachinesArchive()
+{
+	close();
+}
+
+read_result_t MachinesArchive::open(QString fileName)
+{
+	TRACE_SCOPE_ARG("io", "MachinesArchive::open", fileName.toUtf8().constData());
+
+	return openArchive(fileName, 0);
+}
+
+read_result_t MachinesArchive::openArchive(QString fileName, int depth)
+{
+	close();
+
+	int fd = ::open(fileName.toStdString().c_str(), O_RDONLY);
+	if(fd < 0)
+		return E_UNKNOWN;
+
+	struct stat st;
+	if(fstat(fd, &st) < 0 || st.st_size < (off_t)ARCHIVE_PREAMBLE_SIZE)
+	{
+		::close(fd);
+		return E_INVALID_FILE;
+	}
+
+	map_size = st.st_size;
+	void *addr = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if(addr == MAP_FAILED)
+	{
+		map_size = 0;
+		return E_UNKNOWN;
+	}
+
+	map = (char *)addr;
+	madvise(map, map_size, MADV_SEQUENTIAL);
+
+	//read header
+	const char *magicbytes_line = map + ARCHIVE_PREAMBLE_SIZE;
+	const char *magicbytes_end = (const char *)memchr(magicbytes_line, '\n', map_size - ARCHIVE_PREAMBLE_SIZE);
+
+	if(map[0] != 'S' || magicbytes_end == NULL ||
+	   magicbytes_end - magicbytes_line < (long)strlen(PROGRAM_NAME) ||
+	   strncmp(magicbytes_line, SAVEFILE_MAGIC_BYTES, strlen(PROGRAM_NAME)))
+	{
+		close();
+		return E_INVALID_FILE;
+	}
+
+	type = map[1];
+	uint8_t machines_number = (uint8_t) map[2];
+	uint32_t expected_size;
+	memcpy(&expected_size, map + 2 + sizeof(uint8_t), sizeof(uint32_t));
+
+	size_t data_offset = magicbytes_end + 1 - map;
+
+	LOG_INFO(LOG_SETTINGS, "Opening file created with %s v. %.*s", PROGRAM_NAME, (int)(magicbytes_end - magicbytes_line - strlen(PROGRAM_NAME)), magicbytes_line + strlen(PROGRAM_NAME));
+	LOG_DEBUG(LOG_SETTINGS, "Expected data lenght: %u", expected_size);
+	LOG_INFO(LOG_SETTINGS, "Reading %d machines...", (int)machines_number);
+
+	if((machines_number <= 0 && type != 'D') || expected_size > map_size - data_offset)
+	{
+		close();
+		return E_INVALID_FILE;
+	}
+
+	switch(type)
+	{
+		case 'P':
+		case 'D':
+			data = map + data_offset;
+			data_size = expected_size;
+			break;
+#ifdef USE_ZLIB
+		case 'Z':
+		{
+			int inflated_size = ZlibWrapper::inf(&inflated_data, map + data_offset, expected_size);
+
+			//Compressed data is no longer needed once inflated
+			munmap(map, map_size);
+			map = NULL;
+			map_size = 0;
+
+			if(inflated_size <= 0)
+			{
+				inflated_data = NULL;
+				close();
+				return E_INVALID_FILE;
+			}
+
+			data = inflated_data;
+			data_size = inflated_size;
+			break;
+		}
+#endif
+#ifdef EXAM_MODE
+		case 'X': //TODO
+			close();
+			return E_UNINMPLEMENTED;
+#endif
+		default:
+			close();
+			return E_INVALID_HEADER;
+	}
+
+	read_result_t retval = NO_ERROR;
+	if(type == 'D')
+		retval = openBase(fileName, depth);
+
+	if(retval == NO_ERROR)
+		retval = index(machines_number);
+
+	if(retval != NO_ERROR)
+		close();
+
+	return retval;
+}
+
+read_result_t MachinesArchive::openBase(QString fileName, int depth)
+{
+	if(depth >= MAX_DELTA_CHAIN)
+		return E_INVALID_FILE;
+
+	if(data_size < sizeof(delta_header_t))
+		return E_INVALID_HEADER;
+
+	const delta_header_t *delta_header = (const delta_header_t *)data;
+	if(memchr(delta_header->base_file_name, '\0', sizeof(delta_header->base_file_name)) == NULL ||
+	   memchr(delta_header->base_checksum, '\0', sizeof(delta_header->base_checksum)) == NULL)
+		return E_INVALID_HEADER;
+
+	//Base archive may have been moved together with the delta archive
+	QString base_fileName = QString::fromUtf8(delta_header->base_file_name);
+	if(!QFile::exists(base_fileName))
+		base_fileName = QFileInfo(fileName).dir().filePath(QFileInfo(base_fileName).fileName());
+
+	LOG_INFO(LOG_SETTINGS, "Opening base archive %s", base_fileName.toStdString().c_str());
+
+	base = new MachinesArchive();
+	read_result_t retval = base->openArchive(base_fileName, depth + 1);
+	if(retval != NO_ERROR)
+		return retval;
+
+	if(base->checksum() != delta_header->base_checksum)
+		return E_INVALID_CHECKSUM;
+
+	return NO_ERROR;
+}
+
+read_result_t MachinesArchive::index(uint8_t machines_number)
+{
+	uint32_t offset = (type == 'D') ? sizeof(delta_header_t) : 0;
+	records.reserve(machines_number);
+
+	for(int i = 0; i < machines_number; i++)
+	{
+		uint32_t machine_size;
+		if(data_size - offset < sizeof(uint32_t))
+			return E_INVALID_FILE;
+
+		memcpy(&machine_size, data + offset, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+
+		if(machine_size < sizeof(settings_header_t) || machine_size > data_size - offset)
+			return E_INVALID_FILE;
+
+		const settings_header_t *settings_header = (const settings_header_t *)(data + offset);
+		if(settings_header->settings_iface_size * sizeof(settings_iface_t) > machine_size - sizeof(settings_header_t))
+			return E_INVALID_FILE;
+
+		if(memchr(settings_header->machine_name, '\0', sizeof(settings_header->machine_name)) == NULL ||
+		   memchr(settings_header->machine_uuid, '\0', sizeof(settings_header->machine_uuid)) == NULL ||
+		   memchr(settings_header->ifaces_checksum, '\0', sizeof(settings_header->ifaces_checksum)) == NULL)
+			return E_INVALID_HEADER;
+
+		records.push_back(data + offset);
+		offset += machine_size;
+	}
+
+	if(base != NULL)
+	{
+		std::vector<const char*> delta_records = records;
+		std::map<std::string, uint32_t> base_index;
+
+		records = base->records;
+		for(uint32_t i = 0; i < records.size(); i++)
+			base_index[((const settings_header_t *)records.at(i))->machine_uuid] = i;
+
+		for(uint32_t i = 0; i < delta_records.size(); i++)
+		{
+			std::map<std::string, uint32_t>::iterator it = base_index.find(((const settings_header_t *)delta_records.at(i))->machine_uuid);
+			if(it != base_index.end())
+				records[it->second] = delta_records.at(i);
+			else
+				records.push_back(delta_records.at(i));
+		}
+	}
+
+	return NO_ERROR;
+}
+
+void MachinesArchive::close()
+{
+	if(map != NULL)
+		munmap(map, map_size);
+
+	free(inflated_data);
+	delete base;
+
+	map = NULL;
+	map_size = 0;
+	inflated_data = NULL;
+	data = NULL;
+	data_size = 0;
+	type = 0;
+	records.clear();
+	base = NULL;
+}
+
+uint32_t MachinesArchive::size() const
+{
+	return records.size();
+}
+
+bool MachinesArchive::isMapped() const
+{
+	return data != NULL && data != inflated_data;
+}
+
+char MachinesArchive::getType() const
+{
+	return type;
+}
+
+QString MachinesArchive::getBaseFileName() const
+{
+	if(type != 'D')
+		return "";
+
+	return QString::fromUtf8(((const delta_header_t *)data)->base_file_name);
+}
+
+const settings_header_t *MachinesArchive::header(uint32_t machine) const
+{
+	if(machine >= records.size())
+		return NULL;
+
+	return (const settings_header_t *)records.at(machine);
+}
+
+const settings_iface_view_t *MachinesArchive::ifaces(uint32_t machine) const
+{
+	if(machine >= records.size())
+		return NULL;
+
+	return (const settings_iface_view_t *)(records.at(machine) + sizeof(settings_header_t));
+}
+
+QString MachinesArchive::field(const char *__field, size_t __size)
+{
+	return QString::fromUtf8(__field, strnlen(__field, __size));
+}
+
+std::string MachinesArchive::checksum() const
+{
+	CRC32 crc32;
+	return crc32(data, data_size);
+}
+
+bool MachinesArchive::write(QString fileName, std::vector<machine_record_t> records, char type, QString base_fileName)
+{
+	TRACE_SCOPE_ARG("io", "MachinesArchive::write", fileName.toUtf8().constData());
+
+	if(records.size() > UINT8_MAX)
+		return false;
+
+	uint32_t total_size = 0;
+	delta_header_t delta_header;
+
+	if(type == 'D')
+	{
+		MachinesArchive base;
+		if(base.open(base_fileName) != NO_ERROR)
+			return false;
+
+		memset(&delta_header, 0, sizeof(delta_header_t));
+		strncpy(delta_header.base_file_name, QFileInfo(base_fileName).absoluteFilePath().toUtf8().constData(), sizeof(delta_header.base_file_name) - 1);
+		strncpy(delta_header.base_checksum, base.checksum().c_str(), sizeof(delta_header.base_checksum) - 1);
+		total_size += sizeof(delta_header_t);
+	}
+
+	for(int i = 0; i < records.size(); i++)
+		total_size += sizeof(uint32_t) + sizeof(settings_header_t) + records.at(i).serialized_ifaces_size;
+
+	char *serialized_data = (char *)malloc(total_size);
+	memset(serialized_data, 0, total_size);
+	int copied_bytes = 0;
+
+	if(type == 'D')
+	{
+		memcpy(serialized_data, &delta_header, sizeof(delta_header_t));
+		copied_bytes += sizeof(delta_header_t);
+	}
+
+	for(int i = 0; i < records.size(); i++)
+	{
+		uint32_t machine_size = sizeof(settings_header_t) + records.at(i).serialized_ifaces_size;
+
+		memcpy(serialized_data + copied_bytes, &machine_size, sizeof(uint32_t));
+		memcpy(serialized_data + copied_bytes + sizeof(uint32_t), &records.at(i).settings_header, sizeof(settings_header_t));
+		memcpy(serialized_data + copied_bytes + sizeof(uint32_t) + sizeof(settings_header_t), records.at(i).serialized_ifaces, records.at(i).serialized_ifaces_size);
+		copied_bytes += sizeof(uint32_t) + machine_size;
+	}
+
+	bool retval;
+	QFile file(fileName);
+	if(file.open(QIODevice::WriteOnly))
+	{
+		uint8_t magicBytes_size = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(char) * (strlen(SAVEFILE_MAGIC_BYTES)+2);
+		char *magicBytes = (char *)malloc(magicBytes_size + 1);
+		memset(magicBytes, 0, magicBytes_size + 1);
+
+		magicBytes[0] = 'S';
+		magicBytes[1] = type;
+		magicBytes[2] = (uint8_t) records.size();
+		strncpy(magicBytes + 2 + sizeof(uint8_t) + sizeof(uint32_t), SAVEFILE_MAGIC_BYTES, strlen(SAVEFILE_MAGIC_BYTES)+1);
+
+		uint32_t bytes_written = 0;
+		uint32_t expected_size = 0;
+
+		switch(type)
+		{
+#ifdef EXAM_MODE
+			case 'X':
+			{ //Exam mode format
+				memcpy(magicBytes + 2 + sizeof(uint8_t), &total_size, sizeof(uint32_t));
+				bytes_written = file.write(magicBytes, magicBytes_size);
+// 				bytes_written += file.write(DATA, SIZE); //TODO
+				expected_size = total_size;
+				break;
+			}
+#endif
+#ifdef USE_ZLIB
+			case 'Z':
+			{ // Zlib format
+				char *z_serialized_data;
+				int z_serialized_data_size = ZlibWrapper::def(&z_serialized_data, serialized_data, total_size, -1);
+
+				memcpy(magicBytes + 2 + sizeof(uint8_t), &z_serialized_data_size, sizeof(uint32_t));
+				bytes_written = file.write(magicBytes, magicBytes_size);
+				bytes_written += file.write(z_serialized_data, z_serialized_data_size);
+				expected_size = z_serialized_data_size;
+
+				free(z_serialized_data);
+				break;
+			}
+#endif
+			case 'P':
+			case 'D':
+			{ // Plain text format
+				memcpy(magicBytes + 2 + sizeof(uint8_t), &total_size, sizeof(uint32_t));
+				bytes_written = file.write(magicBytes, magicBytes_size);
+				bytes_written += file.write(serialized_data, total_size);
+				expected_size = total_size;
+				break;
+			}
+			default:
+				break;
+		}
+
+		file.flush();
+		file.close();
+		free(magicBytes);
+
+		LOG_DEBUG(LOG_SETTINGS, "Expected size: %u", (uint32_t)(expected_size + magicBytes_size));
+		LOG_DEBUG(LOG_SETTINGS, "Written size:  %u", bytes_written);
+		retval = expected_size > 0 && (bytes_written == expected_size + magicBytes_size);
+	}
+	else
+		retval = false;
+
+	free(serialized_data);
+	return retval;
+}
+
+std::vector<machine_record_t> MachinesArchive::snapshot(const std::vector<VirtualMachine*> &vm_vec)
+{
+	std::vector<machine_record_t> records;
+	for(int i = 0; i < vm_vec.size(); i++)
+	{
+		machine_record_t record;
+		char *serialized_ifaces = NULL;
+		record.serialized_ifaces_size = vm_vec.at(i)->vmSettings->get_serializable_machine(&record.settings_header, &serialized_ifaces);
+		record.serialized_ifaces = serialized_ifaces;
+		records.push_back(record);
+	}
+
+	return records;
+}
+
+bool MachinesArchive::writeSnapshot(QString fileName, std::vector<machine_record_t> records, char type, QString base_fileName)
+{
+	MachinesArchive base;
+	std::map<std::string, const settings_header_t*> base_headers;
+
+	bool retval = base_fileName.isEmpty() || base.open(base_fileName) == NO_ERROR;
+	if(retval)
+	{
+		for(uint32_t i = 0; i < base.size(); i++)
+			base_headers[base.header(i)->machine_uuid] = base.header(i);
+
+		//Skip machines whose ifaces checksum and name match the base archive
+		std::vector<machine_record_t> changed;
+		for(int i = 0; i < records.size(); i++)
+		{
+			std::map<std::string, const settings_header_t*>::iterator it = base_headers.find(records.at(i).settings_header.machine_uuid);
+			if(it == base_headers.end() ||
+			   strcmp(it->second->ifaces_checksum, records.at(i).settings_header.ifaces_checksum) ||
+			   strcmp(it->second->machine_name, records.at(i).settings_header.machine_name))
+				changed.push_back(records.at(i));
+		}
+
+		LOG_INFO(LOG_SETTINGS, "Saving %d of %d machines", (int)changed.size(), (int)records.size());
+
+		retval = write(fileName, changed, type, base_fileName);
+	}
+
+	for(int i = 0; i < records.size(); i++)
+		free((char *)records.at(i).serialized_ifaces);
+
+	return retval;
+}
+
+bool MachinesArchive::merge(QString delta_fileName, QString fileName, bool deflate)
+{
+	MachinesArchive archive;
+	if(archive.open(delta_fileName) != NO_ERROR)
+		return false;
+
+	std::vector<machine_record_t> records;
+	for(uint32_t i = 0; i < archive.size(); i++)
+	{
+		machine_record_t record;
+		record.settings_header = *archive.header(i);
+		record.serialized_ifaces = (const char *)archive.ifaces(i);
+		record.serialized_ifaces_size = record.settings_header.settings_iface_size * sizeof(settings_iface_t);
+		records.push_back(record);
+	}
+
+#ifdef USE_ZLIB
+	return write(fileName, records, deflate ? 'Z' : 'P');
+#else
+	return write(fileName, records, 'P');
+#endif
+}
@@ -0,0 +1,133 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef MACHINESARCHIVE_H
+#define MACHINESARCHIVE_H
+
+#include <QString>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "VMSettings.h"
+
+/** Maximum number of delta archives followed while resolving a base archive */
+#define MAX_DELTA_CHAIN 16
+
+/**
+ * Machine data to be written in a machines set file; serialized_ifaces is
+ * not owned by the record.
+ */
+typedef struct
+{
+	settings_header_t settings_header;
+	const char *serialized_ifaces;
+	uint32_t serialized_ifaces_size;
+} machine_record_t;
+
+/**
+ * Base archive reference stored at the beginning of a delta archive data
+ */
+typedef struct
+{
+	char base_file_name[1024];
+	char base_checksum[10];
+} delta_header_t;
+
+/**
+ * Read-only access to a machines set file (see MachinesDialog.h for format).
+ * Plain archives are mapped in memory and headers and ifaces are returned as
+ * views into the mapping, without copying them; compressed archives are
+ * inflated once in a private buffer and accessed the same way.
+ * Each record is bounds checked when the archive is opened, so returned views
+ * are always fully contained in the archive data.
+ * A delta archive is opened together with its base archive and shows the
+ * merged machine set: machines found in the delta replace the ones with the
+ * same uuid in the base, new machines are appended.
+ */
+class MachinesArchive
+{
+	public:
+		MachinesArchive();
+		virtual ~MachinesArchive();
+
+		read_result_t open(QString fileName);
+		void close();
+
+		uint32_t size() const;
+		bool isMapped() const;
+		char getType() const;
+		QString getBaseFileName() const;
+
+		const settings_header_t *header(uint32_t machine) const;
+		const settings_iface_view_t *ifaces(uint32_t machine) const;
+
+		/**
+		 * Iface fields of a view are not guaranteed to be NUL terminated,
+		 * this function converts at most __size bytes of __field
+		 */
+		static QString field(const char *__field, size_t __size);
+
+		/**
+		 * This function writes records to a machines set file of the
+		 * specified type ('P', 'Z', 'X' or 'D'). A delta archive ('D')
+		 * references base_fileName, which must be a valid machines set
+		 * file.
+		 */
+		static bool write(QString fileName, std::vector<machine_record_t> records, char type, QString base_fileName = "");
+
+		/**
+		 * This function returns records of the saved settings of vm_vec
+		 * which own their serialized ifaces, so they can be written by
+		 * another thread with writeSnapshot()
+		 */
+		static std::vector<machine_record_t> snapshot(const std::vector<VirtualMachine*> &vm_vec);
+
+		/**
+		 * This function writes the records of a snapshot like write(),
+		 * skipping the machines whose name and ifaces checksum match
+		 * base_fileName, and frees their serialized ifaces
+		 */
+		static bool writeSnapshot(QString fileName, std::vector<machine_record_t> records, char type, QString base_fileName = "");
+
+		/**
+		 * This function resolves the delta archive delta_fileName against
+		 * its base and writes the merged machine set to fileName
+		 */
+		static bool merge(QString delta_fileName, QString fileName, bool deflate);
+
+	private:
+		read_result_t openArchive(QString fileName, int depth);
+		read_result_t openBase(QString fileName, int depth);
+		read_result_t index(uint8_t machines_number);
+		std::string checksum() const;
+
+		char type;
+		char *map;
+		size_t map_size;
+		char *inflated_data;
+		const char *data;
+		uint32_t data_size;
+		std::vector<const char*> records;
+		MachinesArchive *base;
+};
+
+#endif //MACHINESARCHIVE_H
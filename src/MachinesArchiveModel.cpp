@@ -0,0 +1,250 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "MachinesArchiveModel.h"
+
+/**
+ * Internal id of top level indexes is 0, internal id of iface indexes is
+ * machine row + 1
+ */
+#define MACHINE_ID 0
+
+#define COLUMN_IFACE_NAME	0
+#define COLUMN_IFACE_MAC	1
+#define COLUMN_IFACE_IP		2
+#define COLUMN_IFACE_SUBNETMASK	3
+
+MachinesArchiveModel::MachinesArchiveModel(MachinesArchive *archive, QStringList headerLabels, bool checkable, Qt::CheckState checkState, QObject *parent)
+: QAbstractItemModel(parent), archive(archive), headerLabels(headerLabels), checkable(checkable)
+, checkStates(archive->size(), checkState), fetched(archive->size(), false)
+{
+
+}
+
+MachinesArchiveModel::~MachinesArchiveModel()
+{
+
+}
+
+QModelIndex MachinesArchiveModel::index(int row, int column, const QModelIndex &parent) const
+{
+	if(!hasIndex(row, column, parent))
+		return QModelIndex();
+
+	if(!parent.isValid())
+		return createIndex(row, column, (quint32) MACHINE_ID);
+
+	return createIndex(row, column, (quint32) (parent.row() + 1));
+}
+
+QModelIndex MachinesArchiveModel::parent(const QModelIndex &index) const
+{
+	if(!index.isValid() || index.internalId() == MACHINE_ID)
+		return QModelIndex();
+
+	return createIndex(index.internalId() - 1, 0, (quint32) MACHINE_ID);
+}
+
+int MachinesArchiveModel::rowCount(const QModelIndex &parent) const
+{
+	if(!parent.isValid())
+		return archive->size();
+
+	if(parent.internalId() != MACHINE_ID || parent.column() != 0 || !fetched.at(parent.row()))
+		return 0;
+
+	return archive->header(parent.row())->settings_iface_size;
+}
+
+int MachinesArchiveModel::columnCount(const QModelIndex &parent) const
+{
+	return headerLabels.count();
+}
+
+bool MachinesArchiveModel::hasChildren(const QModelIndex &parent) const
+{
+	if(!parent.isValid())
+		return archive->size() > 0;
+
+	if(parent.internalId() != MACHINE_ID || parent.column() != 0)
+		return false;
+
+	return archive->header(parent.row())->settings_iface_size > 0;
+}
+
+bool MachinesArchiveModel::canFetchMore(const QModelIndex &parent) const
+{
+	if(!parent.isValid() || parent.internalId() != MACHINE_ID || parent.column() != 0)
+		return false;
+
+	return !fetched.at(parent.row()) && archive->header(parent.row())->settings_iface_size > 0;
+}
+
+void MachinesArchiveModel::fetchMore(const QModelIndex &parent)
+{
+	if(!canFetchMore(parent))
+		return;
+
+	beginInsertRows(parent, 0, archive->header(parent.row())->settings_iface_size - 1);
+	fetched[parent.row()] = true;
+	endInsertRows();
+}
+
+QString MachinesArchiveModel::ifaceField(int machine, int iface, int column) const
+{
+	const settings_iface_view_t *settings_iface = &archive->ifaces(machine)[iface];
+
+	switch(column)
+	{
+		case COLUMN_IFACE_NAME:
+			return MachinesArchive::field(settings_iface->name, sizeof(settings_iface_t::name));
+		case COLUMN_IFACE_MAC:
+			return MachinesArchive::field(settings_iface->mac, sizeof(settings_iface_t::mac));
+		case COLUMN_IFACE_IP:
+			return MachinesArchive::field(settings_iface->ip, sizeof(settings_iface_t::ip));
+		case COLUMN_IFACE_SUBNETMASK:
+			return MachinesArchive::field(settings_iface->subnetMask, sizeof(settings_iface_t::subnetMask));
+		default:
+			return QString();
+	}
+}
+
+QVariant MachinesArchiveModel::data(const QModelIndex &index, int role) const
+{
+	if(!index.isValid())
+		return QVariant();
+
+	if(index.internalId() == MACHINE_ID)
+	{
+		if(index.column() != 0)
+			return QVariant();
+
+		if(role == Qt::DisplayRole)
+			return QString("Macchina: ").append(archive->header(index.row())->machine_name);
+		if(role == Qt::CheckStateRole && checkable)
+			return checkStates.at(index.row());
+
+		return QVariant();
+	}
+
+	if(role == Qt::DisplayRole)
+		return ifaceField(index.internalId() - 1, index.row(), index.column());
+
+	return QVariant();
+}
+
+bool MachinesArchiveModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+	if(!checkable || !index.isValid() || index.internalId() != MACHINE_ID || index.column() != 0 || role != Qt::CheckStateRole)
+		return false;
+
+	checkStates[index.row()] = (Qt::CheckState) value.toInt();
+	emit dataChanged(index, index);
+	return true;
+}
+
+Qt::ItemFlags MachinesArchiveModel::flags(const QModelIndex &index) const
+{
+	if(!index.isValid())
+		return 0;
+
+	if(checkable && index.internalId() == MACHINE_ID && index.column() == 0)
+		return Qt::ItemIsEnabled | Qt::ItemIsUserCheckable;
+
+	return Qt::ItemIsEnabled;
+}
+
+QVariant MachinesArchiveModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if(orientation == Qt::Horizontal && role == Qt::DisplayRole && section < headerLabels.count())
+		return headerLabels.at(section);
+
+	return QVariant();
+}
+
+Qt::CheckState MachinesArchiveModel::checkState(int machine) const
+{
+	return checkStates.at(machine);
+}
+
+std::vector<int> MachinesArchiveModel::checkedMachines() const
+{
+	std::vector<int> machines;
+	for(int i = 0; i < checkStates.size(); i++)
+		if(checkStates.at(i) == Qt::Checked)
+			machines.push_back(i);
+
+	return machines;
+}
+
+bool MachinesArchiveModel::machineMatches(int machine, QString text) const
+{
+	if(QString::fromUtf8(archive->header(machine)->machine_name).contains(text, Qt::CaseInsensitive))
+		return true;
+
+	for(int iface = 0; iface < archive->header(machine)->settings_iface_size; iface++)
+		for(int column = 0; column < headerLabels.count(); column++)
+			if(ifaceField(machine, iface, column).contains(text, Qt::CaseInsensitive))
+				return true;
+
+	return false;
+}
+
+MachinesArchiveFilterModel::MachinesArchiveFilterModel(QObject *parent)
+: QSortFilterProxyModel(parent)
+{
+
+}
+
+void MachinesArchiveFilterModel::setMachines(std::vector<int> machines)
+{
+	int machines_size = 0;
+	for(int i = 0; i < machines.size(); i++)
+		if(machines.at(i) + 1 > machines_size)
+			machines_size = machines.at(i) + 1;
+
+	this->machines.assign(machines_size, false);
+	for(int i = 0; i < machines.size(); i++)
+		this->machines[machines.at(i)] = true;
+
+	invalidateFilter();
+}
+
+void MachinesArchiveFilterModel::setSearchText(QString text)
+{
+	searchText = text.trimmed();
+	invalidateFilter();
+}
+
+bool MachinesArchiveFilterModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+{
+	//Ifaces of a visible machine are always shown
+	if(source_parent.isValid())
+		return true;
+
+	if(!machines.empty() && (source_row >= machines.size() || !machines.at(source_row)))
+		return false;
+
+	if(searchText.isEmpty())
+		return true;
+
+	return ((MachinesArchiveModel *) sourceModel())->machineMatches(source_row, searchText);
+}
@@ -0,0 +1,96 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef MACHINESARCHIVEMODEL_H
+#define MACHINESARCHIVEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QSortFilterProxyModel>
+#include <QStringList>
+#include <vector>
+
+#include "MachinesArchive.h"
+
+/**
+ * Tree model over a MachinesArchive: a top level row for each machine and a
+ * child row for each iface. Data is read from the archive views when
+ * requested; iface rows are inserted only when a machine is expanded.
+ */
+class MachinesArchiveModel : public QAbstractItemModel
+{
+	Q_OBJECT
+
+	public:
+		MachinesArchiveModel(MachinesArchive *archive, QStringList headerLabels, bool checkable = true, Qt::CheckState checkState = Qt::Unchecked, QObject *parent = 0);
+		virtual ~MachinesArchiveModel();
+
+		QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+		QModelIndex parent(const QModelIndex &index) const;
+		int rowCount(const QModelIndex &parent = QModelIndex()) const;
+		int columnCount(const QModelIndex &parent = QModelIndex()) const;
+		bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+		bool canFetchMore(const QModelIndex &parent) const;
+		void fetchMore(const QModelIndex &parent);
+
+		QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+		bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
+		Qt::ItemFlags flags(const QModelIndex &index) const;
+		QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+		Qt::CheckState checkState(int machine) const;
+		std::vector<int> checkedMachines() const;
+		bool machineMatches(int machine, QString text) const;
+
+	private:
+		QString ifaceField(int machine, int iface, int column) const;
+
+		MachinesArchive *archive;
+		QStringList headerLabels;
+		bool checkable;
+		std::vector<Qt::CheckState> checkStates;
+		std::vector<bool> fetched;
+};
+
+/**
+ * Filter over a MachinesArchiveModel, showing only the selected machines
+ * (all of them if none is selected) which match the search text in their
+ * name or in any iface field.
+ */
+class MachinesArchiveFilterModel : public QSortFilterProxyModel
+{
+	Q_OBJECT
+
+	public:
+		MachinesArchiveFilterModel(QObject *parent = 0);
+		void setMachines(std::vector<int> machines);
+
+	public slots:
+		void setSearchText(QString text);
+
+	protected:
+		bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const;
+
+	private:
+		std::vector<bool> machines;
+		QString searchText;
+};
+
+#endif //MACHINESARCHIVEMODEL_H
@@ -25,11 +25,14 @@
 #include <QDialog>
 #include <QString>
 #include <QCheckBox>
+#include <QTreeView>
 #include <vector>
 
 #include "ui_MachinesDialog.h"
 #include "VirtualMachine.h"
 #include "VMSettings.h"
+#include "MachinesArchive.h"
+#include "MachinesArchiveModel.h"
 
 class MainWindow;
 class VMTabSettings;
@@ -39,10 +42,15 @@ class Ui_MachinesDialog;
  * Format for machines set save file:
  * magic bytes:
  * 	'S'					[   1 B]
+ * 	archive type				[   1 B]
+ * 		'P' plain, 'Z' zlib compressed, 'X' exam, 'D' delta
  * 	number of machines			[   1 B]
  * 	machines data size			[   4 B]
  * 	SAVEFILE_MAGIC_BYTES			[variable lenght]
  * --- new line ---				[   1 B]
+ * delta archive only, base archive reference [1034 B]:
+ * 	base archive file name			[1024 B]
+ * 	base archive data checksum		[  10 B]
  * machine #1 data [variable lenght]:
  * 	machine data lenght			[   4 B]
  * 	header [2055 B]:
@@ -64,6 +72,9 @@ class Ui_MachinesDialog;
  * 	ifaces #n data (each iface) [5186 B]
  * machine #2 data [variable lenght]
  * machine #n data [variable lenght]
+ *
+ * A delta archive contains only the machines whose name or ifaces checksum
+ * differ from the base archive; it is merged with the base when opened.
  */
 
 class MachinesDialog : public QDialog
@@ -83,29 +94,32 @@ class MachinesDialog : public QDialog
 	private slots:
 		void slotExportMachines();
 		void slotImportMachines();
+		void slotMergeArchive();
 #ifdef EXAM_MODE
 		void slotExamExportMachines();
 #endif
 
 	private:
+		/**
+		 * This function queues the export of vm_vec to fileName, errors are
+		 * reported by MainWindow when the export completes
+		 */
 #ifndef EXAM_MODE
-		bool saveMachines(std::vector<VirtualMachine*> vm_vec, bool deflate);
+		void saveMachines(std::vector<VirtualMachine*> vm_vec, bool deflate, QString base_fileName = "");
 #else
-		bool saveMachines(std::vector<VirtualMachine*> vm_vec, bool deflate, bool examMode = false);
+		void saveMachines(std::vector<VirtualMachine*> vm_vec, bool deflate, QString base_fileName = "", bool examMode = false);
 #endif
-		read_result_t loadMachines(settings_header_t **settings_header, settings_iface_t ***settings_ifaces, uint32_t *machines_number);
-		bool updateMachine(VMTabSettings *vmtab, settings_header_t settings_header, settings_iface_t *settings_ifaces);
-		bool createMachine(settings_header_t settings_header, settings_iface_t *settings_ifaces);
+		void setupPreview(QTreeView *treeView, MachinesArchiveModel *model, std::vector<int> machines = std::vector<int>());
 		
 		MainWindow *mainwindow;
 		Ui_MachinesDialog *ui;
 		std::vector<VMTabSettings*> *vmTab_vec;
 		QString fileName;
 		QCheckBox *checkBox;
+		QCheckBox *deltaCheckBox;
 
-		settings_header_t *settings_header;
-		settings_iface_t **settings_ifaces;
-		uint32_t machines_number;
+		MachinesArchive archive;
+		MachinesArchiveModel *archiveModel;
 };
 
 #endif //MACHINESDIALOG_H
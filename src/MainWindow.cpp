@@ -43,6 +43,7 @@
 #include "ProgressDialog.h"
 #include "SummaryDialog.h"
 #include "MachinesDialog.h"
+#include "MacAllocator.h"
 
 static QPalette __palette;
 
@@ -77,15 +78,10 @@ MainWindow::MainWindow(const QString &fileToOpen, QWidget *parent)
 	
 	OSBridge::cleanEnvironment(tmpdir_prefix.str());
 
-	ProgressDialog p("");
-	p.ui->label->setText("Caricamento impostazioni...");
-	p.ui->progressBar->setValue(0);
-	p.show();
-
+	//Tabs are placeholders until shown, the current one is built below
 	for (int i = 0; i < machines_vec.size(); i++)
 	{
 		QString tabname = machines_vec.at(i)->getName();
-		p.ui->label->setText(QString::fromUtf8("Caricamento macchina \"").append(tabname).append("\""));
 
 		std::stringstream mountpoint_ss; mountpoint_ss << "/dev/nbd" << i;
 		std::stringstream partition_mountpoint_prefix_ss; partition_mountpoint_prefix_ss << tmpdir_prefix.str() << "/nbd" << i;
@@ -94,19 +90,28 @@ MainWindow::MainWindow(const QString &fileToOpen, QWidget *parent)
 
 		ui->vm_tabs->addTab(vmTabSettings, tabname);
 		VMTabSettings_vec.push_back(vmTabSettings);
-		p.ui->progressBar->setValue(((i+1)*100)/machines_vec.size());
-		p.refresh();
+		vboxbridge->getMacAllocator()->addMachine(machines_vec.at(i));
 	}
-	p.ui->label->setText("Caricamento completato");
-	p.ui->progressBar->setValue(100);
 
+	topology = new NetworkTopology(this);
+#ifdef CONFIGURABLE_IP
+	ipPlan = new IpPlan(this);
+#endif
 	summaryDialog = new SummaryDialog(this);
+	connect(this, SIGNAL(machinesPoolChanged()), summaryDialog, SLOT(populateComboBox()));
+	connect(topology, SIGNAL(ifaceMoved(VirtualMachine*, int, QString, QString)), summaryDialog, SLOT(slotIfaceMoved(VirtualMachine*, int, QString, QString)));
+	operationsDialog = new OperationsDialog(this);
+	connect(this, SIGNAL(machinesPoolChanged()), operationsDialog, SLOT(populate()));
+
+	VMCommandExecutor *executor = VMCommandExecutor::instance();
+	connect(executor, SIGNAL(commandProgress(uint32_t, QString, uint32_t)), this, SLOT(slotCommandProgress(uint32_t, QString, uint32_t)));
+	connect(executor, SIGNAL(commandFinished(vm_command_result_t)), this, SLOT(slotCommandFinished(vm_command_result_t)));
 
 	for (int i = 0; i < VMTabSettings_vec.size(); i++)
-	{
-		connect(VMTabSettings_vec.at(i)->vm, SIGNAL(settingsChanged(VirtualMachine*)), summaryDialog, SLOT(refresh()));
-		connect(this, SIGNAL(machinesPoolChanged()), summaryDialog, SLOT(populateComboBox()));
-	}
+		connect(VMTabSettings_vec.at(i), SIGNAL(machineLoaded(VirtualMachine*)), this, SLOT(watchMachine(VirtualMachine*)));
+
+	if(!VMTabSettings_vec.empty())
+		VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->ensureLoaded();
 
 	connect(ui->actionInfo_su, SIGNAL(triggered(bool)), this, SLOT(slotInfo()));
 // 	connect(ui->actionopen, SIGNAL(triggered(bool)), this, SLOT(slotActionOpen()));
@@ -120,9 +125,11 @@ MainWindow::MainWindow(const QString &fileToOpen, QWidget *parent)
 	connect(ui->actionRinomina, SIGNAL(triggered(bool)), this, SLOT(slotRename()));
 	connect(ui->actionAvviaAll, SIGNAL(triggered(bool)), this, SLOT(slotStartAll()));
 	connect(ui->actionInterrompiAll, SIGNAL(triggered(bool)), this, SLOT(slotInterrompiAll()));
+	connect(ui->actionApplicaAll, SIGNAL(triggered(bool)), this, SLOT(slotApplyAll()));
 	connect(ui->actionAbilitaAll, SIGNAL(triggered(bool)), this, SLOT(slotEnableAll()));
 	connect(ui->actionDisabilitaAll, SIGNAL(triggered(bool)), this, SLOT(slotDisableAll()));
 	connect(ui->actionMostraRiepilogo, SIGNAL(triggered(bool)), this, SLOT(slotShowSummary()));
+	connect(ui->actionMostraOperazioni, SIGNAL(triggered(bool)), this, SLOT(slotShowOperations()));
 	connect(ui->actionAvvia, SIGNAL(triggered(bool)), this, SLOT(slotStart()));
 	connect(ui->actionPausa, SIGNAL(triggered(bool)), this, SLOT(slotPause()));
 	connect(ui->actionReset, SIGNAL(triggered(bool)), this, SLOT(slotReset()));
@@ -190,6 +197,7 @@ MainWindow::~MainWindow()
 	if(stat(tmpdir_prefix.str().c_str(), &s) >= 0 && ((s.st_mode & S_IFMT) == S_IFDIR))
 		rmdir(tmpdir_prefix.str().c_str());
 
+	delete operationsDialog;
 	delete summaryDialog;
 	delete vboxbridge;
 	delete ui;
@@ -200,7 +208,10 @@ void MainWindow::closeEvent(QCloseEvent *event)
 	if (!queryClose())
 		event->ignore();
 	else
+	{
 		summaryDialog->close();
+		operationsDialog->close();
+	}
 }
 
 bool MainWindow::queryClose()
@@ -263,6 +274,10 @@ void MainWindow::slotExamExport()
 #else
 bool MainWindow::slotVMSave()
 {
+	//Queued saves of the settings write the snapshot being saved here
+	if(!checkPendingCommands())
+		return false;
+
 	VMSettings *vmSettings = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vmSettings;
 	if (vmSettings->fileName.isEmpty())
 		return slotVMSaveAs();
@@ -280,10 +295,13 @@ bool MainWindow::slotVMSave()
 
 bool MainWindow::slotVMSaveAs()
 {
+	if(!checkPendingCommands())
+		return false;
+
 	VMSettings *vmSettings = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vmSettings;
 	QString selectedFileName;
 	if (vmSettings->fileName.isEmpty())
-		selectedFileName = QFileDialog::getSaveFileName(this, "Salva macchina", VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->machine->getName(), "Machine VB-Ant file (*.vam)");
+		selectedFileName = QFileDialog::getSaveFileName(this, "Salva macchina", VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->getMachineName(), "Machine VB-Ant file (*.vam)");
 	else
 		selectedFileName = QFileDialog::getSaveFileName(this, "Salva macchina", vmSettings->fileName, "Machine VB-Ant file (*.vam)");
 
@@ -296,6 +314,9 @@ bool MainWindow::slotVMSaveAs()
 
 void MainWindow::slotVMLoad()
 {
+	if(!checkPendingCommands())
+		return;
+
 	VMSettings *vmSettings = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vmSettings;
 	const QString selectedFileName = QFileDialog::getOpenFileName(this, "Apri macchina", vmSettings->fileName, "Machine VB-Ant file (*.vam)");
 
@@ -371,6 +392,9 @@ void MainWindow::slotExportMachines()
 
 void MainWindow::slotImportMachines()
 {
+	if(!checkPendingCommands())
+		return;
+
 	const QString fileName = QFileDialog::getOpenFileName(this, "Importa macchine", "", "Machine set VB-Ant file (*.vas)");
 	if(fileName == "")
 		return;
@@ -387,6 +411,10 @@ void MainWindow::slotInfo()
 
 void MainWindow::currentChangedSlot(int tab)
 {
+	//The current tab is always built, actions on it can use its settings
+	if(tab >= 0 && tab < VMTabSettings_vec.size())
+		VMTabSettings_vec.at(tab)->ensureLoaded();
+
 	refreshUI(tab);
 }
 
@@ -394,6 +422,19 @@ void MainWindow::slotStartAll()
 {
 	QMessageBox qm(QMessageBox::Question, "Avvio multiplo macchine", "Avviare tutte le macchine abilitate?", QMessageBox::Yes|QMessageBox::No, this);
 	qm.setPalette(palette());
+
+#ifdef CONFIGURABLE_IP
+	//Every machine is loaded so the plan indexes the addresses of all of them
+	VMTabSettings::loadAll(VMTabSettings_vec);
+	if(ipPlan->hasConflicts())
+	{
+		QStringList report = ipPlan->report();
+		qm.setIcon(QMessageBox::Warning);
+		qm.setText(QString::fromUtf8("Il piano di indirizzamento contiene %1 conflitti. Avviare comunque tutte le macchine abilitate?").arg(report.size()));
+		qm.setDetailedText(report.join("\n"));
+	}
+#endif
+
 	for(int i = 0; i < qm.buttons().size(); i++)
 	{
 		switch(qm.standardButton(qm.buttons()[i]))
@@ -416,12 +457,9 @@ void MainWindow::slotStartAll()
 				machineState != MachineState::Paused ||
 				machineState != MachineState::Starting)
 			{
-				VMTabSettings_vec.at(i)->vm->start();
-
-				uint32_t machineState = VMTabSettings_vec.at(i)->machine->getState();
-				setSettingsPolicy(i, machineState);
-
-				refreshUI(i);
+				//Cable state of a placeholder tab is already the one on the adapters
+				VirtualMachine *vm = VMTabSettings_vec.at(i)->isLoaded() ? VMTabSettings_vec.at(i)->getVM() : NULL;
+				VMCommandExecutor::instance()->start(VMTabSettings_vec.at(i)->machine, vm);
 			}
 		}
 	}
@@ -450,10 +488,35 @@ void MainWindow::slotInterrompiAll()
 		if(machineState == MachineState::Running ||
 		   machineState == MachineState::Paused ||
 		   machineState == MachineState::Starting)
-			VMTabSettings_vec.at(i)->vm->stop();
+			VMCommandExecutor::instance()->stop(VMTabSettings_vec.at(i)->machine, true);
 	}
 }
 
+void MainWindow::slotApplyAll()
+{
+	std::vector<VirtualMachine*> vm_vec;
+
+	//Tabs not opened yet have no changes to apply
+	for(int i = 0; i < ui->vm_tabs->count(); i++)
+	{
+		VMTabSettings *vmtab = VMTabSettings_vec.at(i);
+		if(!vmtab->isLoaded())
+			continue;
+
+		uint32_t machineState = vmtab->machine->getState();
+		if(machineState == MachineState::Running ||
+		   machineState == MachineState::Paused ||
+		   machineState == MachineState::Starting)
+		{
+			vmtab->lockForSave();
+			vm_vec.push_back(vmtab->getVM());
+		}
+	}
+
+	if(!vm_vec.empty())
+		VMCommandExecutor::instance()->saveSettingsRunTime(vm_vec);
+}
+
 void MainWindow::slotEnableAll()
 {
 	for(int i = 0; i < ui->vm_tabs->count(); i++)
@@ -482,48 +545,45 @@ void MainWindow::slotDisableAll()
 
 void MainWindow::slotShowSummary()
 {
+	VMTabSettings::loadAll(VMTabSettings_vec);
 	summaryDialog->refresh();
 	summaryDialog->show();
 	summaryDialog->raise();
 }
 
+void MainWindow::slotShowOperations()
+{
+	operationsDialog->show();
+	operationsDialog->raise();
+}
+
 void MainWindow::slotStart()
 {
 	requestedACPIstop = false;
-	VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->start();
-
-	uint32_t machineState = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine->getState();
-	setSettingsPolicy(ui->vm_tabs->currentIndex(), machineState);
-
-	refreshUI(ui->vm_tabs->currentIndex());
+	VMTabSettings *vmTabSettings = VMTabSettings_vec.at(ui->vm_tabs->currentIndex());
+	VMCommandExecutor::instance()->start(vmTabSettings->machine, vmTabSettings->getVM());
 }
 
 void MainWindow::slotPause()
 {
-	uint32_t machineState = ((VMTabSettings *)VMTabSettings_vec.at(ui->vm_tabs->currentIndex()))->machine->getState();
-
-	if(machineState != MachineState::Paused)
-		VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->enterPause();
-	else
-		VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->exitPause();
+	MachineBridge *machine = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine;
+	VMCommandExecutor::instance()->pause(machine, machine->getState() != MachineState::Paused);
 }
 
 void MainWindow::slotReset()
 {
-	VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->reset();
+	VMCommandExecutor::instance()->reset(VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine);
 }
 
 void MainWindow::slotStop()
 {
-	uint32_t machineState = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine->getState();
-	bool acpiEnabled = false;
+	MachineBridge *machine = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine;
+	bool wasPaused = (machine->getState() == MachineState::Paused);
+	bool acpiEnabled = machine->supportsACPI();
 
-	bool wasPaused = (machineState == MachineState::Paused);
-	if(wasPaused)
-		slotPause();
-	
-	acpiEnabled = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine->supportsACPI();
-	slotPause();
+	//The machine is paused while the user decides, commands on it run in order
+	if(!wasPaused)
+		VMCommandExecutor::instance()->pause(machine, true);
 
 	QMessageBox qm(QMessageBox::Question, "Chiudi la macchina virtuale", "Arrestare la macchina virtuale?", QMessageBox::Yes|QMessageBox::No, this);
 	QCheckBox *c = new QCheckBox("Forza arresto", &qm);
@@ -541,22 +601,17 @@ void MainWindow::slotStop()
 	if (qm.exec() == QMessageBox::Yes)
 	{
 		if(c->isChecked())
-			VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->stop();
+			VMCommandExecutor::instance()->stop(machine, true);
 		else
 		{
-			machineState = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine->getState();
-			if(machineState == MachineState::Paused)
-				slotPause();
-			VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->ACPIstop();
+			//A paused guest does not handle the ACPI power button
+			VMCommandExecutor::instance()->pause(machine, false);
+			VMCommandExecutor::instance()->stop(machine, false);
 			requestedACPIstop = true;
 		}
 	}
-	else
-	{
-		machineState = VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->machine->getState();
-		if(!wasPaused && machineState == MachineState::Paused)
-			slotPause();
-	}
+	else if(!wasPaused)
+		VMCommandExecutor::instance()->pause(machine, false);
 
 	delete c;
 }
@@ -564,7 +619,7 @@ void MainWindow::slotStop()
 #if 0
 void MainWindow::slotSettings()
 {
-	VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->openSettings();
+	VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->getVM()->openSettings();
 }
 #endif
 
@@ -584,6 +639,10 @@ void MainWindow::slotClone()
 
 int MainWindow::launchCreateProcess(QString qName, bool reInitIfaces, bool restoreFromFile)
 {
+	//The nbd module is reloaded, no queued command may have a disk mounted
+	if(!checkPendingCommands())
+		return -1;
+
 	ProgressDialog p("");
 	p.ui->label->setText(QString::fromUtf8("Caricamento macchina \"").append(qName).append("\""));
 	p.ui->progressBar->setValue(0);
@@ -595,8 +654,8 @@ int MainWindow::launchCreateProcess(QString qName, bool reInitIfaces, bool resto
 
 	if(!restoreFromFile)
 	{
-		vmTabSettings->vm->cleanIfaces(VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->ifaces, VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->ifaces_size);
-		vmTabSettings->vm->saveSettings();
+		vmTabSettings->getVM()->cleanIfaces(VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->getVM()->ifaces, VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->getVM()->ifaces_size);
+		vmTabSettings->getVM()->saveSettings();
 		vmTabSettings->refreshTable();
 	}
 
@@ -611,25 +670,38 @@ int MainWindow::launchCreateProcess(QString qName, bool reInitIfaces, bool resto
 
 void MainWindow::launchCloneProcess(QString qName, bool reInitIfaces)
 {
-	ProgressDialog p("");
-	p.ui->label->setText(QString::fromUtf8("Caricamento macchina \"").append(qName).append("\""));
-	p.ui->progressBar->setValue(0);
-	p.open();
+	//The tab of the clone is added once VirtualBox has copied its disks
+	VMCommandExecutor::instance()->clone(VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->getVM(), qName, reInitIfaces);
+}
 
-	VMTabSettings *vmTabSettings = addMachine(VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->clone(qName, reInitIfaces));
+void MainWindow::finishClone(const vm_command_result_t &result)
+{
+	VMTabSettings *vmTabSettings = addMachine(result.clone);
 	if(vmTabSettings == NULL)
 		return;
 
-	vmTabSettings->vm->cleanIfaces(VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->ifaces, VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->ifaces_size);
-	vmTabSettings->vm->copyIfaces(VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->ifaces, VMTabSettings_vec.at(ui->vm_tabs->currentIndex())->vm->ifaces_size);
-	vmTabSettings->vm->saveSettings();
+	//Guest settings of the original ifaces were removed by the clone command
+	vmTabSettings->getVM()->copyIfaces(result.vm->ifaces, result.vm->ifaces_size);
 	vmTabSettings->refreshTable();
+	VMCommandExecutor::instance()->saveSettings(vmTabSettings->getVM(), false);
 
-	int newTab = ui->vm_tabs->addTab(vmTabSettings, qName);
+	int newTab = ui->vm_tabs->addTab(vmTabSettings, result.name);
 	VMTabSettings_vec.push_back(vmTabSettings);
-	p.ui->progressBar->setValue(100);
 
 	ui->vm_tabs->setCurrentIndex(newTab);
+	emit machinesPoolChanged();
+
+	//Clones keeping their MAC addresses share them with the original machine
+	QStringList collisions = vboxbridge->getMacAllocator()->collisions(vmTabSettings->getVM());
+	if(!collisions.isEmpty())
+	{
+		QMessageBox qm(QMessageBox::Warning, "Indirizzi MAC duplicati",
+			       QString::fromUtf8("La macchina \"").append(result.name).append(QString::fromUtf8("\" usa %1 indirizzi MAC già assegnati ad altre macchine.").arg(collisions.size())),
+			       QMessageBox::Ok, this);
+		qm.setDetailedText(collisions.join("\n"));
+		qm.setPalette(palette());
+		qm.exec();
+	}
 }
 
 VMTabSettings *MainWindow::addMachine(IMachine *m)
@@ -655,6 +727,7 @@ VMTabSettings *MainWindow::addMachine(IMachine *m)
 	int newTabIndex = ui->vm_tabs->count();
 
 	machines_vec.push_back(new MachineBridge(vboxbridge, m, this));
+	vboxbridge->getMacAllocator()->addMachine(machines_vec.at(newTabIndex));
 
 	const char *tmpdir = getenv("TMPDIR");
 	if(tmpdir == NULL)
@@ -666,12 +739,35 @@ VMTabSettings *MainWindow::addMachine(IMachine *m)
 
 	QString tabname = machines_vec.at(newTabIndex)->getName();
 	VMTabSettings *vmSettings = new VMTabSettings(ui->vm_tabs, tabname, vboxbridge, machines_vec.at(newTabIndex), mountpoint_ss.str(), partition_mountpoint_prefix_ss.str());
+	connect(vmSettings, SIGNAL(machineLoaded(VirtualMachine*)), this, SLOT(watchMachine(VirtualMachine*)));
 
 	return vmSettings;
 }
 
+void MainWindow::watchMachine(VirtualMachine *vm)
+{
+	//The topology is connected first, so the summary is updated over an up to date index
+	topology->addMachine(vm);
+	connect(vm, SIGNAL(settingsChanged(VirtualMachine*)), topology, SLOT(updateMachine(VirtualMachine*)));
+	connect(vm, SIGNAL(attachmentChanged(VirtualMachine*, int)), topology, SLOT(updateIface(VirtualMachine*, int)));
+#ifdef CONFIGURABLE_IP
+	ipPlan->addMachine(vm);
+	connect(vm, SIGNAL(settingsChanged(VirtualMachine*)), ipPlan, SLOT(updateMachine(VirtualMachine*)));
+	connect(vm, SIGNAL(attachmentChanged(VirtualMachine*, int)), ipPlan, SLOT(updateIface(VirtualMachine*, int)));
+#endif
+	vboxbridge->getMacAllocator()->updateMachine(vm);
+	connect(vm, SIGNAL(settingsChanged(VirtualMachine*)), vboxbridge->getMacAllocator(), SLOT(updateMachine(VirtualMachine*)));
+	connect(vm, SIGNAL(attachmentChanged(VirtualMachine*, int)), vboxbridge->getMacAllocator(), SLOT(updateIface(VirtualMachine*, int)));
+	connect(vm, SIGNAL(settingsChanged(VirtualMachine*)), summaryDialog, SLOT(slotMachineChanged(VirtualMachine*)));
+	connect(vm, SIGNAL(attachmentChanged(VirtualMachine*, int)), summaryDialog, SLOT(slotMachineChanged(VirtualMachine*)));
+}
+
 void MainWindow::slotRemove()
 {
+	//Queued commands may refer to the machine being removed
+	if(!checkPendingCommands())
+		return;
+
 	QMessageBox qm(QMessageBox::Question, "Rimuovi la macchina virtuale", "Eliminare la macchina virtuale?", QMessageBox::Yes|QMessageBox::No, this);
 	qm.setPalette(palette());
 	for(int i = 0; i < qm.buttons().size(); i++)
@@ -687,7 +783,9 @@ void MainWindow::slotRemove()
 
 	if (qm.exec() == QMessageBox::Yes)
 	{
-		if(VMTabSettings_vec.at(tabIndex)->vm->remove())
+		//A tab not opened yet is not loaded just to be removed
+		VMTabSettings *vmtab = VMTabSettings_vec.at(tabIndex);
+		if(vmtab->isLoaded() ? vmtab->getVM()->remove() : machines_vec.at(tabIndex)->remove())
 		{
 			std::vector<VMTabSettings*> VMTabSettings_vec_shadow;
 			std::vector<MachineBridge*> machines_vec_shadow;
@@ -707,6 +805,14 @@ void MainWindow::slotRemove()
 			VMTabSettings_vec = VMTabSettings_vec_shadow;
 			machines_vec = machines_vec_shadow;
 
+			if(v->isLoaded())
+			{
+				topology->removeMachine(v->getVM());
+#ifdef CONFIGURABLE_IP
+				ipPlan->removeMachine(v->getVM());
+#endif
+			}
+			vboxbridge->getMacAllocator()->removeMachine(mb);
 			delete v;
 			delete mb;
 		}
@@ -741,12 +847,8 @@ void MainWindow::slotRename()
 
 		if(lineEdit.text().length() > 0 && lineEdit.text() == vboxbridge->validateMachineName(lineEdit.text(), VMTabSettings_vec.size()))
 		{
-			if(vmtab->setMachineName(lineEdit.text()))
-			{
-				std::cout << "new_name: " << lineEdit.text().toStdString() << std::endl;
-				ui->vm_tabs->setTabText(ui->vm_tabs->currentIndex(), lineEdit.text());
-			}
-			emit machinesPoolChanged();
+			//The tab is renamed once VirtualBox has saved the new name
+			VMCommandExecutor::instance()->rename(vmtab->machine, lineEdit.text());
 			break;
 		}
 		else
@@ -770,12 +872,97 @@ void MainWindow::slotStateChange(MachineBridge *machine, uint32_t state)
 
 	if(state == MachineState::PoweredOff)
 	{
-		VMTabSettings_vec.at(tabIndex)->vm->shutdownVMProcess();
+		VMCommandExecutor::instance()->release(VMTabSettings_vec.at(tabIndex)->machine);
 		requestedACPIstop = false;
 	}
 
 	setSettingsPolicy(tabIndex, state);
 	refreshUI(tabIndex, state);
+	operationsDialog->slotStateChange(machine, state);
+}
+
+void MainWindow::slotCommandProgress(uint32_t id, QString label, uint32_t percent)
+{
+	ui->statusbar->showMessage(QString("%1 %2%").arg(label).arg(percent));
+}
+
+void MainWindow::slotCommandFinished(vm_command_result_t result)
+{
+	if(VMCommandExecutor::instance()->pending() == 0)
+		ui->statusbar->clearMessage();
+
+	switch(result.type)
+	{
+		case VM_COMMAND_START:
+		{
+			for(int i = 0; i < VMTabSettings_vec.size(); i++)
+				if(VMTabSettings_vec.at(i)->hasThisMachine(result.machine))
+				{
+					setSettingsPolicy(i, result.machine->getState());
+					refreshUI(i);
+					break;
+				}
+			break;
+		}
+		case VM_COMMAND_CLONE:
+		{
+			if(!result.succeeded)
+			{
+				addMachine(NULL);
+				break;
+			}
+
+			//Adding a machine reloads the nbd module, no command may have a disk mounted
+			pending_clones.push_back(result);
+			break;
+		}
+		case VM_COMMAND_RENAME:
+		{
+			if(!result.succeeded)
+				break;
+
+			for(int i = 0; i < VMTabSettings_vec.size(); i++)
+				if(VMTabSettings_vec.at(i)->hasThisMachine(result.machine))
+				{
+					ui->vm_tabs->setTabText(i, result.name);
+					break;
+				}
+			emit machinesPoolChanged();
+			break;
+		}
+		case VM_COMMAND_EXPORT:
+		{
+			if(!result.succeeded)
+			{
+				QMessageBox qm(QMessageBox::Critical, "Esportazione macchine", QString::fromUtf8("Errore durante il salvataggio delle macchine."), QMessageBox::Ok, this);
+				qm.setPalette(palette());
+				qm.exec();
+			}
+			break;
+		}
+		default:
+			break;
+	}
+
+	//The settings of each clone are saved before the next one is added
+	if(VMCommandExecutor::instance()->pending() == 0 && !pending_clones.empty())
+	{
+		vm_command_result_t clone = pending_clones.front();
+		pending_clones.erase(pending_clones.begin());
+		finishClone(clone);
+	}
+}
+
+bool MainWindow::checkPendingCommands()
+{
+	int pending = VMCommandExecutor::instance()->pending();
+	if(pending == 0)
+		return true;
+
+	QMessageBox qm(QMessageBox::Information, "Operazioni in corso", QString::fromUtf8("Attendere il completamento delle %1 operazioni in corso sulle macchine.").arg(pending), QMessageBox::Ok, this);
+	qm.setPalette(palette());
+	qm.exec();
+	return false;
 }
 
 void MainWindow::setSettingsPolicy(int tab, uint32_t state)
@@ -806,8 +993,15 @@ void MainWindow::slotNetworkAdapterChange(MachineBridge *machine, INetworkAdapte
 			break;
 		}
 
-	VMTabSettings_vec.at(tabIndex)->vm->refreshIface(machine->getIfaceSlot(nic), nic);
-	VMTabSettings_vec.at(tabIndex)->refreshTableUI();
+	//The adapter may have been attached to a network new to VirtualBox
+	vboxbridge->getHostNetworkCatalog()->invalidate(NetworkAttachmentType::Internal);
+
+	//Placeholder tabs read the adapter when built
+	if(VMTabSettings_vec.at(tabIndex)->isLoaded())
+	{
+		VMTabSettings_vec.at(tabIndex)->getVM()->refreshIface(machine->getIfaceSlot(nic), nic);
+		VMTabSettings_vec.at(tabIndex)->refreshTableUI();
+	}
 
 	setSettingsPolicy(tabIndex, VMTabSettings_vec.at(tabIndex)->machine->getState());
 	refreshUI(tabIndex);
@@ -34,8 +34,12 @@
 #include "VMTabSettings.h"
 #include "VirtualBoxBridge.h"
 #include "SummaryDialog.h"
+#include "OperationsDialog.h"
 #include "VMSettings.h"
 #include "MachinesDialog.h"
+#include "NetworkTopology.h"
+#include "IpPlan.h"
+#include "VMCommandExecutor.h"
 
 class Ui_MainWindow;
 class Ui_Info_dialog;
@@ -45,6 +49,7 @@ class MainWindow : public QMainWindow
 {
 	friend class CloneDialog;
 	friend class SummaryDialog;
+	friend class OperationsDialog;
 	Q_OBJECT
 	
 	public:
@@ -70,9 +75,11 @@ class MainWindow : public QMainWindow
 		void slotRename();
 		void slotStartAll();
 		void slotInterrompiAll();
+		void slotApplyAll();
 		void slotEnableAll();
 		void slotDisableAll();
 		void slotShowSummary();
+		void slotShowOperations();
 		void slotStart();
 		void slotPause();
 		void slotReset();
@@ -89,6 +96,9 @@ class MainWindow : public QMainWindow
 #endif
 		void slotImportMachines();
 		void slotExportMachines();
+		void watchMachine(VirtualMachine *vm);
+		void slotCommandProgress(uint32_t id, QString label, uint32_t percent);
+		void slotCommandFinished(vm_command_result_t result);
 		
 	private:
 		bool queryClose();
@@ -96,12 +106,25 @@ class MainWindow : public QMainWindow
 		void setSettingsPolicy(int tab, uint32_t state);
 		void refreshUI(int tab, uint32_t state = -1);
 		VMTabSettings *addMachine(IMachine *m);
+		void finishClone(const vm_command_result_t &result);
+
+		/**
+		 * This function returns true if no machine command is queued,
+		 * otherwise it asks to wait for them
+		 */
+		bool checkPendingCommands();
 		
 		Ui_MainWindow *ui;
 		std::vector<VMTabSettings*> VMTabSettings_vec;
 		std::vector<MachineBridge*> machines_vec;
+		std::vector<vm_command_result_t> pending_clones;
 		InfoDialog infoDialog;
 		SummaryDialog *summaryDialog;
+		OperationsDialog *operationsDialog;
+		NetworkTopology *topology;
+#ifdef CONFIGURABLE_IP
+		IpPlan *ipPlan;
+#endif
 		QString fileName;
 		bool requestedACPIstop;
 
@@ -0,0 +1,70 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "NameTable.h"
+
+pthread_mutex_t NameTable::mutex = PTHREAD_MUTEX_INITIALIZER;
+QHash<QString, uint32_t> NameTable::ids;
+std::vector<QString> NameTable::names(1, QString());
+
+uint32_t NameTable::intern(const QString &name)
+{
+	if(name.isEmpty())
+		return NAME_NONE;
+
+	//Settings may be restored from several import threads at once
+	pthread_mutex_lock(&mutex);
+	QHash<QString, uint32_t>::const_iterator it = ids.constFind(name);
+	uint32_t id;
+	if(it != ids.constEnd())
+		id = it.value();
+	else
+	{
+		id = names.size();
+		names.push_back(name);
+		ids.insert(name, id);
+	}
+	pthread_mutex_unlock(&mutex);
+
+	return id;
+}
+
+uint32_t NameTable::find(const QString &name)
+{
+	if(name.isEmpty())
+		return NAME_NONE;
+
+	pthread_mutex_lock(&mutex);
+	uint32_t id = ids.value(name, NAME_NONE);
+	pthread_mutex_unlock(&mutex);
+
+	return id;
+}
+
+QString NameTable::name(uint32_t id)
+{
+	pthread_mutex_lock(&mutex);
+	QString name = (id < names.size()) ? names.at(id) : QString();
+	pthread_mutex_unlock(&mutex);
+
+	return name;
+}
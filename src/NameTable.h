@@ -0,0 +1,63 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <QString>
+#include <QHash>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+
+/** Id of the empty name */
+#define NAME_NONE 0
+
+/**
+ * Global table of interned names: each distinct name gets a stable id, so
+ * names can be stored and compared as integers. Names are never removed,
+ * they are only the few network names known to the program.
+ */
+class NameTable
+{
+	public:
+		/**
+		 * This function returns the id of name, adding it to the table if
+		 * needed
+		 */
+		static uint32_t intern(const QString &name);
+
+		/**
+		 * This function returns the id of name without adding it, NAME_NONE
+		 * if name is not in the table
+		 */
+		static uint32_t find(const QString &name);
+
+		static QString name(uint32_t id);
+
+	private:
+		static pthread_mutex_t mutex;
+		static QHash<QString, uint32_t> ids;
+		static std::vector<QString> names;
+};
+
+#endif //NAMETABLE_H
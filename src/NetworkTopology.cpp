@@ -0,0 +1,186 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "NetworkTopology.h"
+#include "VirtualMachine.h"
+#include "NameTable.h"
+
+NetworkTopology::NetworkTopology(QObject *parent)
+: QObject(parent), next_sequence(0)
+{
+
+}
+
+NetworkTopology::~NetworkTopology()
+{
+
+}
+
+void NetworkTopology::addMachine(VirtualMachine *vm)
+{
+	if(sequences.find(vm) != sequences.end())
+		return;
+
+	sequences[vm] = next_sequence++;
+	attachments[vm] = std::vector<uint32_t>();
+	updateMachine(vm);
+}
+
+void NetworkTopology::removeMachine(VirtualMachine *vm)
+{
+	std::map<VirtualMachine*, std::vector<uint32_t> >::iterator it = attachments.find(vm);
+	if(it == attachments.end())
+		return;
+
+	for(int iface = it->second.size() - 1; iface >= 0; iface--)
+		moveIface(vm, iface, NAME_NONE);
+
+	attachments.erase(vm);
+	sequences.erase(vm);
+}
+
+void NetworkTopology::updateMachine(VirtualMachine *vm)
+{
+	std::map<VirtualMachine*, std::vector<uint32_t> >::iterator it = attachments.find(vm);
+	if(it == attachments.end())
+		return;
+
+	//Ifaces no longer present are detached
+	for(int iface = it->second.size() - 1; iface >= vm->ifaces_size; iface--)
+		moveIface(vm, iface, NAME_NONE);
+	it->second.resize(vm->ifaces_size);
+
+	for(int iface = 0; iface < vm->ifaces_size; iface++)
+		updateIface(vm, iface);
+}
+
+void NetworkTopology::updateIface(VirtualMachine *vm, int iface)
+{
+	std::map<VirtualMachine*, std::vector<uint32_t> >::iterator it = attachments.find(vm);
+	if(it == attachments.end() || iface < 0 || iface >= vm->ifaces_size)
+		return;
+
+	if(iface >= it->second.size())
+		it->second.resize(iface + 1);
+
+	if(vm->ifaces[iface]->attachmentType == NetworkAttachmentType::Internal)
+		moveIface(vm, iface, vm->ifaces[iface]->record.attachmentData);
+	else
+		moveIface(vm, iface, NAME_NONE);
+}
+
+void NetworkTopology::moveIface(VirtualMachine *vm, int iface, uint32_t newNetwork)
+{
+	uint32_t oldNetwork = attachments[vm].at(iface);
+	if(oldNetwork == newNetwork)
+		return;
+
+	topology_endpoint_t endpoint;
+	endpoint.machine_sequence = sequences[vm];
+	endpoint.vm = vm;
+	endpoint.iface = iface;
+
+	if(oldNetwork != NAME_NONE)
+	{
+		std::map<uint32_t, std::set<topology_endpoint_t> >::iterator network_it = networks.find(oldNetwork);
+		network_it->second.erase(endpoint);
+		if(network_it->second.empty())
+			networks.erase(network_it);
+	}
+
+	if(newNetwork != NAME_NONE)
+		networks[newNetwork].insert(endpoint);
+
+	attachments[vm][iface] = newNetwork;
+	emit ifaceMoved(vm, iface, NameTable::name(oldNetwork), NameTable::name(newNetwork));
+}
+
+QStringList NetworkTopology::networkNames() const
+{
+	QStringList names;
+	for(std::map<uint32_t, std::set<topology_endpoint_t> >::const_iterator it = networks.begin(); it != networks.end(); ++it)
+		names << NameTable::name(it->first);
+
+	names.sort();
+	return names;
+}
+
+bool NetworkTopology::hasNetwork(QString network) const
+{
+	return networks.find(NameTable::find(network)) != networks.end();
+}
+
+QString NetworkTopology::network(VirtualMachine *vm, int iface) const
+{
+	return NameTable::name(networkId(vm, iface));
+}
+
+uint32_t NetworkTopology::networkId(VirtualMachine *vm, int iface) const
+{
+	std::map<VirtualMachine*, std::vector<uint32_t> >::const_iterator it = attachments.find(vm);
+	if(it == attachments.end() || iface < 0 || iface >= it->second.size())
+		return NAME_NONE;
+
+	return it->second.at(iface);
+}
+
+std::vector<topology_endpoint_t> NetworkTopology::endpoints(QString network) const
+{
+	std::map<uint32_t, std::set<topology_endpoint_t> >::const_iterator it = networks.find(NameTable::find(network));
+	if(it == networks.end())
+		return std::vector<topology_endpoint_t>();
+
+	return std::vector<topology_endpoint_t>(it->second.begin(), it->second.end());
+}
+
+std::vector<topology_endpoint_t> NetworkTopology::neighbors(VirtualMachine *vm, int iface) const
+{
+	std::vector<topology_endpoint_t> neighbors;
+
+	std::map<uint32_t, std::set<topology_endpoint_t> >::const_iterator it = networks.find(networkId(vm, iface));
+	if(it == networks.end())
+		return neighbors;
+
+	for(std::set<topology_endpoint_t>::const_iterator endpoint = it->second.begin(); endpoint != it->second.end(); ++endpoint)
+		if(endpoint->vm != vm)
+			neighbors.push_back(*endpoint);
+
+	return neighbors;
+}
+
+std::set<VirtualMachine*> NetworkTopology::neighbors(VirtualMachine *vm) const
+{
+	std::set<VirtualMachine*> neighbors;
+
+	std::map<VirtualMachine*, std::vector<uint32_t> >::const_iterator it = attachments.find(vm);
+	if(it == attachments.end())
+		return neighbors;
+
+	for(int iface = 0; iface < it->second.size(); iface++)
+	{
+		std::vector<topology_endpoint_t> iface_neighbors = this->neighbors(vm, iface);
+		for(int i = 0; i < iface_neighbors.size(); i++)
+			neighbors.insert(iface_neighbors.at(i).vm);
+	}
+
+	return neighbors;
+}
@@ -0,0 +1,114 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef NETWORKTOPOLOGY_H
+#define NETWORKTOPOLOGY_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include <map>
+#include <set>
+#include <stdint.h>
+
+class VirtualMachine;
+
+typedef struct topology_endpoint
+{
+	uint32_t machine_sequence;
+	VirtualMachine *vm;
+	int iface;
+
+	bool operator<(const struct topology_endpoint &endpoint) const
+	{
+		if(machine_sequence != endpoint.machine_sequence)
+			return machine_sequence < endpoint.machine_sequence;
+		return iface < endpoint.iface;
+	}
+} topology_endpoint_t;
+
+/**
+ * Index of the internal networks of the machines: each network maps to the
+ * set of (machine, iface) attached to it, ordered as the machines were
+ * added. The index is updated one machine or one iface at a time, so lookups
+ * never scan every machine. Networks are keyed by their NameTable id.
+ */
+class NetworkTopology : public QObject
+{
+	Q_OBJECT
+
+	public:
+		NetworkTopology(QObject *parent = 0);
+		virtual ~NetworkTopology();
+
+		void addMachine(VirtualMachine *vm);
+		void removeMachine(VirtualMachine *vm);
+
+		/**
+		 * This function returns the names of the networks with at least
+		 * one attached iface, sorted by name
+		 */
+		QStringList networkNames() const;
+		bool hasNetwork(QString network) const;
+
+		/**
+		 * This function returns the network of iface, or an empty string
+		 * if iface is not attached to an internal network
+		 */
+		QString network(VirtualMachine *vm, int iface) const;
+		std::vector<topology_endpoint_t> endpoints(QString network) const;
+
+		/**
+		 * This function returns the ifaces of other machines attached to
+		 * the same network of iface
+		 */
+		std::vector<topology_endpoint_t> neighbors(VirtualMachine *vm, int iface) const;
+
+		/**
+		 * This function returns the other machines sharing at least one
+		 * network with vm
+		 */
+		std::set<VirtualMachine*> neighbors(VirtualMachine *vm) const;
+
+	public slots:
+		void updateMachine(VirtualMachine *vm);
+		void updateIface(VirtualMachine *vm, int iface);
+
+	signals:
+		/**
+		 * Emitted when iface moves from a network to another; an empty
+		 * name stands for no internal network
+		 */
+		void ifaceMoved(VirtualMachine *vm, int iface, QString oldNetwork, QString newNetwork);
+
+	private:
+		void moveIface(VirtualMachine *vm, int iface, uint32_t newNetwork);
+		uint32_t networkId(VirtualMachine *vm, int iface) const;
+
+		uint32_t next_sequence;
+		std::map<VirtualMachine*, uint32_t> sequences;
+		std::map<VirtualMachine*, std::vector<uint32_t> > attachments;
+		std::map<uint32_t, std::set<topology_endpoint_t> > networks;
+};
+
+#endif //NETWORKTOPOLOGY_H
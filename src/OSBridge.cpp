@@ -20,7 +20,10 @@
  */
 
 #include "OSBridge.h"
-#include "MainWindow.h"
+#include "Trace.h"
+#ifndef HEADLESS
+	#include "MainWindow.h"
+#endif
 
 #include <stddef.h>
 #include <stdio.h>
@@ -41,9 +44,15 @@
 #include <iostream>
 #include <string>
 #include <sstream>
-#include <QMessageBox>
-#include <QDialogButtonBox>
-#include <QAbstractButton>
+#ifndef HEADLESS
+	#include <QMessageBox>
+	#include <QDialogButtonBox>
+	#include <QAbstractButton>
+	#include <QApplication>
+#else
+	#include <QCoreApplication>
+#endif
+#include <QThread>
 
 // #define USE_SUDO
 #define GRAPHIC_SUDO "kdesudo"
@@ -51,6 +60,8 @@
 
 int OSBridge::execute_cmd(int argc, char **argv, bool from_path)
 {
+	TRACE_SCOPE_ARG("os", "execute_cmd", (argc > 2) ? argv[1] : argv[0]);
+
 	char **argv_cmd = argv;
 	int argc_cmd = argc;
 
@@ -71,7 +82,7 @@ int OSBridge::execute_cmd(int argc, char **argv, bool from_path)
 #endif
 	
 	pid_t pid;
-	int status;
+	int status = 0;
 	
 	if((pid = fork()) < 0)
 	{
@@ -94,7 +105,14 @@ int OSBridge::execute_cmd(int argc, char **argv, bool from_path)
 	}
 	else
 	{
-		while(wait(&status) != pid);
+		//Other threads may be running commands too, only this child is reaped
+		pid_t waited;
+		while((waited = waitpid(pid, &status, 0)) < 0 && errno == EINTR);
+		if(waited < 0)
+		{
+			std::cerr << "*** ERROR: waitpid() failed. Errno: " << errno << std::endl;
+			return 1;
+		}
 #ifdef DEBUG_FLAG
 		std::cout << "*** Child process (pid: " << pid << ", ppid: " << getppid() << ") terminated.";
 #endif
@@ -103,7 +121,17 @@ int OSBridge::execute_cmd(int argc, char **argv, bool from_path)
 #ifdef DEBUG_FLAG
 			std::cout << " Return value: " << strerror(WEXITSTATUS(status)) << " (" << WEXITSTATUS(status) << ")";
 #endif
+#ifdef HEADLESS
 			if(WEXITSTATUS(status) == ENOENT)
+#else
+			if(WEXITSTATUS(status) == ENOENT && QThread::currentThread() != qApp->thread())
+#endif
+			{
+				std::cerr << "*** ERROR: qemu-nbd not found" << std::endl;
+				exit(ENOENT);
+			}
+#ifndef HEADLESS
+			else if(WEXITSTATUS(status) == ENOENT)
 			{
 				QMessageBox qm(QMessageBox::Critical, "Errore", "Errore: qemu-nbd non trovato.\nAssicurarsi che sia installato e di avere i privilegi per eseguirlo", QMessageBox::Close);
 				qm.setPalette(MainWindow::getPalette());
@@ -117,6 +145,7 @@ int OSBridge::execute_cmd(int argc, char **argv, bool from_path)
 				qm.exec();
 				exit(ENOENT);
 			}
+#endif
 		}
 #ifdef DEBUG_FLAG
 		std::cout << std::endl;
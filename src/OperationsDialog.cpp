@@ -0,0 +1,217 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QHeaderView>
+#include <QStringList>
+#include <vector>
+
+#include "OperationsDialog.h"
+#include "OperationsStats.h"
+#include "MainWindow.h"
+
+#define MACHINES_HEADERS_LABELS "Macchina;Stato;Dispositivo NBD;Partizioni montate;Scritture disco;Tempo I/O disco (ms)"
+#define XPCOM_HEADERS_LABELS "Chiamata VirtualBox;Chiamate;Errori;Media (us);Massimo (us)"
+
+#define COLUMN_MACHINE_NAME		0
+#define COLUMN_MACHINE_STATE		1
+#define COLUMN_MACHINE_NBD		2
+#define COLUMN_MACHINE_PARTITIONS	3
+#define COLUMN_MACHINE_IO_WRITES	4
+#define COLUMN_MACHINE_IO_TIME		5
+
+OperationsDialog::OperationsDialog(MainWindow *mainWindow)
+: mainWindow(mainWindow)
+{
+	setWindowTitle(QString::fromUtf8("Operazioni"));
+	resize(720, 480);
+
+	verticalLayout = new QVBoxLayout(this);
+	verticalLayout->setObjectName(QString::fromUtf8("verticalLayout"));
+
+	summaryLabel = new QLabel(this);
+	summaryLabel->setObjectName(QString::fromUtf8("summaryLabel"));
+	verticalLayout->addWidget(summaryLabel);
+
+	machinesTree = new QTreeWidget(this);
+	machinesTree->setObjectName(QString::fromUtf8("machinesTree"));
+	machinesTree->setRootIsDecorated(false);
+	machinesTree->setHeaderLabels(QString(MACHINES_HEADERS_LABELS).split(";"));
+	verticalLayout->addWidget(machinesTree);
+
+	xpcomTree = new QTreeWidget(this);
+	xpcomTree->setObjectName(QString::fromUtf8("xpcomTree"));
+	xpcomTree->setRootIsDecorated(false);
+	xpcomTree->setHeaderLabels(QString(XPCOM_HEADERS_LABELS).split(";"));
+	verticalLayout->addWidget(xpcomTree);
+
+	setPalette(mainWindow->palette());
+
+	refreshTimer = new QTimer(this);
+	refreshTimer->setInterval(OPERATIONS_REFRESH_INTERVAL);
+	connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+OperationsDialog::~OperationsDialog()
+{
+	refreshTimer->stop();
+}
+
+void OperationsDialog::showEvent(QShowEvent *event)
+{
+	populate();
+	refreshTimer->start();
+	QDialog::showEvent(event);
+}
+
+void OperationsDialog::hideEvent(QHideEvent *event)
+{
+	refreshTimer->stop();
+	QDialog::hideEvent(event);
+}
+
+void OperationsDialog::populate()
+{
+	std::vector<VMTabSettings*> *vmTab_vec = &mainWindow->VMTabSettings_vec;
+	std::map<MachineBridge*, uint32_t> machineStates;
+
+	machinesTree->clear();
+	for(int i = 0; i < vmTab_vec->size(); i++)
+	{
+		MachineBridge *machine = vmTab_vec->at(i)->machine;
+
+		//States are read once, then they are kept up to date by the events
+		std::map<MachineBridge*, uint32_t>::iterator it = states.find(machine);
+		machineStates[machine] = (it != states.end()) ? it->second : machine->getState();
+
+		QTreeWidgetItem *item = new QTreeWidgetItem(machinesTree);
+		item->setText(COLUMN_MACHINE_NAME, vmTab_vec->at(i)->getMachineName());
+		for(int column = COLUMN_MACHINE_PARTITIONS; column <= COLUMN_MACHINE_IO_TIME; column++)
+			item->setTextAlignment(column, Qt::AlignRight);
+	}
+	states = machineStates;
+
+	refresh();
+
+	for(int column = 0; column < machinesTree->columnCount(); column++)
+		machinesTree->resizeColumnToContents(column);
+}
+
+void OperationsDialog::refresh()
+{
+	if(machinesTree->topLevelItemCount() != mainWindow->VMTabSettings_vec.size())
+	{
+		populate();
+		return;
+	}
+
+	for(int i = 0; i < machinesTree->topLevelItemCount(); i++)
+		refreshMachine(i);
+
+	std::vector<xpcom_method_stats_t> stats = XpcomStats::snapshot();
+	uint64_t calls = 0, total_ns = 0;
+	for(int i = 0; i < stats.size(); i++)
+	{
+		calls += stats.at(i).calls;
+		total_ns += stats.at(i).total_ns;
+	}
+
+	summaryLabel->setText(QString::fromUtf8("Operazioni multiple in corso: %1\nLatenza media chiamate VirtualBox: %2 us (%3 chiamate)\nTempo I/O disco guest: %4 ms (%5 scritture)")
+		.arg(OperationsStats::getPendingBulk())
+		.arg((calls > 0) ? total_ns / 1e3 / calls : 0.0, 0, 'f', 1).arg(calls)
+		.arg(OperationsStats::getGuestIoTime() / 1e6, 0, 'f', 1).arg(OperationsStats::getGuestIoWrites()));
+
+	refreshXpcom(stats);
+}
+
+void OperationsDialog::refreshMachine(int tab)
+{
+	VMTabSettings *vmTab = mainWindow->VMTabSettings_vec.at(tab);
+	QTreeWidgetItem *item = machinesTree->topLevelItem(tab);
+
+	item->setText(COLUMN_MACHINE_STATE, stateName(states[vmTab->machine]));
+
+	//Placeholder tabs have never touched the guest disk
+	if(!vmTab->isLoaded())
+	{
+		for(int column = COLUMN_MACHINE_NBD; column <= COLUMN_MACHINE_IO_TIME; column++)
+			item->setText(column, "-");
+		return;
+	}
+
+	VirtualMachine *vm = vmTab->getVM();
+	const vm_operations_stats_t *stats = &vm->operationsStats;
+
+	item->setText(COLUMN_MACHINE_NBD, stats->vhd_mounted ? QString::fromStdString(vm->vhd_mountpoint) : QString("-"));
+	item->setText(COLUMN_MACHINE_PARTITIONS, QString::number(stats->mounted_partitions));
+	item->setText(COLUMN_MACHINE_IO_WRITES, QString::number(stats->guest_io_writes));
+	item->setText(COLUMN_MACHINE_IO_TIME, QString::number(stats->guest_io_ns / 1e6, 'f', 1));
+}
+
+void OperationsDialog::refreshXpcom(const std::vector<xpcom_method_stats_t> &stats)
+{
+	while(xpcomTree->topLevelItemCount() > stats.size())
+		delete xpcomTree->topLevelItem(xpcomTree->topLevelItemCount() - 1);
+
+	for(int i = 0; i < stats.size(); i++)
+	{
+		const xpcom_method_stats_t *s = &stats.at(i);
+		QTreeWidgetItem *item = xpcomTree->topLevelItem(i);
+		if(item == NULL)
+		{
+			item = new QTreeWidgetItem(xpcomTree);
+			for(int column = 1; column < xpcomTree->columnCount(); column++)
+				item->setTextAlignment(column, Qt::AlignRight);
+		}
+
+		item->setText(0, QString::fromUtf8(s->name));
+		item->setText(1, QString::number(s->calls));
+		item->setText(2, QString::number(s->failures));
+		item->setText(3, QString::number((s->calls > 0) ? s->total_ns / 1e3 / s->calls : 0.0, 'f', 1));
+		item->setText(4, QString::number(s->max_ns / 1e3, 'f', 1));
+	}
+}
+
+void OperationsDialog::slotStateChange(MachineBridge *machine, uint32_t state)
+{
+	states[machine] = state;
+
+	for(int i = 0; i < machinesTree->topLevelItemCount() && i < mainWindow->VMTabSettings_vec.size(); i++)
+		if(mainWindow->VMTabSettings_vec.at(i)->hasThisMachine(machine))
+			machinesTree->topLevelItem(i)->setText(COLUMN_MACHINE_STATE, stateName(state));
+}
+
+QString OperationsDialog::stateName(uint32_t state)
+{
+	switch(state)
+	{
+		case MachineState::PoweredOff:	return QString::fromUtf8("Spenta");
+		case MachineState::Saved:	return QString::fromUtf8("Salvata");
+		case MachineState::Aborted:	return QString::fromUtf8("Terminata in modo anomalo");
+		case MachineState::Running:	return QString::fromUtf8("In esecuzione");
+		case MachineState::Paused:	return QString::fromUtf8("In pausa");
+		case MachineState::Stuck:	return QString::fromUtf8("Bloccata");
+		case MachineState::Starting:	return QString::fromUtf8("In avvio");
+		case MachineState::Stopping:	return QString::fromUtf8("In arresto");
+		case MachineState::Saving:	return QString::fromUtf8("In salvataggio");
+		case MachineState::Restoring:	return QString::fromUtf8("In ripristino");
+		default:			return QString::fromUtf8("Sconosciuto");
+	}
+}
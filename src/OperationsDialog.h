@@ -0,0 +1,80 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef OPERATIONSDIALOG_H
+#define OPERATIONSDIALOG_H
+
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QTreeWidget>
+#include <QTimer>
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+#include "VirtualBoxBridge.h"
+#include "XpcomStats.h"
+
+/** Interval between refreshes of the counters while the dashboard is shown, in ms */
+#define OPERATIONS_REFRESH_INTERVAL 500
+
+class MainWindow;
+
+/**
+ * Dashboard of the running operations: state, NBD device and mounted
+ * partitions of each machine, pending bulk operations, time spent writing
+ * guest disks and latency of the VirtualBox calls. Machine states are
+ * updated by the VirtualBox events; every other value is read from atomic
+ * counters while the dashboard is shown.
+ */
+class OperationsDialog : public QDialog
+{
+	Q_OBJECT;
+
+	public:
+		OperationsDialog(MainWindow *mainWindow);
+		virtual ~OperationsDialog();
+
+	public slots:
+		void populate();
+		void refresh();
+		void slotStateChange(MachineBridge *machine, uint32_t state);
+
+	protected:
+		void showEvent(QShowEvent *event);
+		void hideEvent(QHideEvent *event);
+
+	private:
+		static QString stateName(uint32_t state);
+		void refreshMachine(int tab);
+		void refreshXpcom(const std::vector<xpcom_method_stats_t> &stats);
+
+		MainWindow *mainWindow;
+		QVBoxLayout *verticalLayout;
+		QLabel *summaryLabel;
+		QTreeWidget *machinesTree;
+		QTreeWidget *xpcomTree;
+		QTimer *refreshTimer;
+		std::map<MachineBridge*, uint32_t> states;
+};
+
+#endif //OPERATIONSDIALOG_H
@@ -0,0 +1,68 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef OPERATIONSSTATS_H
+#define OPERATIONSSTATS_H
+
+#include <stdint.h>
+
+/**
+ * Counters of the guest disk of a machine. They are updated by the thread
+ * saving the machine settings and read by the operations dashboard.
+ */
+typedef struct
+{
+	volatile int32_t vhd_mounted;
+	volatile int32_t mounted_partitions;
+	volatile uint64_t guest_io_ns;
+	volatile uint64_t guest_io_writes;
+} vm_operations_stats_t;
+
+/**
+ * Process wide counters shown by the operations dashboard. Every counter is
+ * updated with atomic operations, so they may be updated from any thread and
+ * read without locks.
+ */
+class OperationsStats
+{
+	public:
+		/**
+		 * This function adds operations (negative once they are done) to
+		 * the operations of bulk start, stop and import still pending
+		 */
+		static inline void addPendingBulk(int32_t operations) { __sync_add_and_fetch(&pending_bulk, operations); };
+		static inline int32_t getPendingBulk() { return __sync_add_and_fetch(&pending_bulk, 0); };
+
+		/**
+		 * This function adds ns spent writing the guest disk to the
+		 * counters of a machine and to the process wide ones
+		 */
+		static void addGuestIo(vm_operations_stats_t *stats, uint64_t ns);
+		static inline uint64_t getGuestIoTime() { return __sync_add_and_fetch(&guest_io_ns, 0); };
+		static inline uint64_t getGuestIoWrites() { return __sync_add_and_fetch(&guest_io_writes, 0); };
+
+	private:
+		static volatile int32_t pending_bulk;
+		static volatile uint64_t guest_io_ns;
+		static volatile uint64_t guest_io_writes;
+};
+
+#endif //OPERATIONSSTATS_H
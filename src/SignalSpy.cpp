@@ -20,64 +20,254 @@
  */
 
 #include "SignalSpy.h"
+#include "Trace.h"
+#include <QMetaObject>
+#include <QMetaMethod>
+#include <QMetaType>
 #include <iostream>
-#include <unistd.h>
-#include <typeinfo>
+#include <stdio.h>
 
-static void *spyThread(void *_thread_data)
+SignalLogger *SignalLogger::__instance = NULL;
+static pthread_mutex_t __instance_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread SignalQueue *thread_queue = NULL;
+static __thread SignalLogger *thread_queue_logger = NULL;
+
+SignalQueue::SignalQueue()
+: head(0), tail(0)
+{
+
+}
+
+bool SignalQueue::push(const signal_event_t &event)
+{
+	uint32_t t = tail;
+	if(t - __sync_add_and_fetch(&head, 0) == SIGNAL_QUEUE_SIZE)
+		return false;
+
+	events[t & (SIGNAL_QUEUE_SIZE - 1)] = event;
+
+	//The event is written before the consumer can see it
+	__sync_synchronize();
+	tail = t + 1;
+	return true;
+}
+
+bool SignalQueue::pop(signal_event_t *event)
+{
+	uint32_t h = head;
+	if(h == __sync_add_and_fetch(&tail, 0))
+		return false;
+
+	signal_event_t *e = &events[h & (SIGNAL_QUEUE_SIZE - 1)];
+	*event = *e;
+	e->args = QList<QVariant>();
+
+	//The slot is released only once it has been read
+	__sync_synchronize();
+	head = h + 1;
+	return true;
+}
+
+SignalLogger::SignalLogger()
+: requested(0), logged(0), dropped(0), stop(false)
+{
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&idle_cond, NULL);
+	sem_init(&sem, 0, 0);
+	pthread_create(&thread, NULL, loggerThread, this);
+}
+
+SignalLogger::~SignalLogger()
+{
+	pthread_mutex_lock(&mutex);
+	stop = true;
+	pthread_mutex_unlock(&mutex);
+	sem_post(&sem);
+
+	pthread_join(thread, NULL);
+
+	for(int i = 0; i < queues.size(); i++)
+		delete queues.at(i);
+
+	sem_destroy(&sem);
+	pthread_cond_destroy(&idle_cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+SignalLogger *SignalLogger::instance()
+{
+	pthread_mutex_lock(&__instance_mutex);
+	if(__instance == NULL)
+		__instance = new SignalLogger();
+	SignalLogger *logger = __instance;
+	pthread_mutex_unlock(&__instance_mutex);
+
+	return logger;
+}
+
+void SignalLogger::shutdown()
+{
+	pthread_mutex_lock(&__instance_mutex);
+	delete __instance;
+	__instance = NULL;
+	pthread_mutex_unlock(&__instance_mutex);
+}
+
+void SignalLogger::push(const SignalSpy *spy, void **args)
+{
+	//Queues are registered once for each emitting thread and logger
+	if(thread_queue_logger != this)
+	{
+		thread_queue = new SignalQueue();
+		thread_queue_logger = this;
+		pthread_mutex_lock(&mutex);
+		queues.push_back(thread_queue);
+		pthread_mutex_unlock(&mutex);
+	}
+
+	signal_event_t event;
+	event.timestamp = Trace::now();
+	event.spy = spy;
+
+	//Pointers are kept as addresses, other unregistered types cannot be copied
+	for(int i = 0; i < spy->types.size(); i++)
+	{
+		if(spy->types.at(i) != 0)
+			event.args << QVariant(spy->types.at(i), args[i + 1]);
+		else if(spy->parameterTypes.at(i).endsWith('*'))
+			event.args << QVariant((qulonglong) *(quintptr *) args[i + 1]);
+		else
+			event.args << QVariant();
+	}
+
+	if(thread_queue->push(event))
+		sem_post(&sem);
+	else
+		__sync_fetch_and_add(&dropped, 1);
+}
+
+void SignalLogger::sync()
 {
-	thread_data_t *thread_data = (thread_data_t *)_thread_data;
-	void *obj = thread_data->obj;
+	pthread_mutex_lock(&mutex);
+	uint64_t ticket = ++requested;
+	pthread_mutex_unlock(&mutex);
+
+	sem_post(&sem);
+
+	pthread_mutex_lock(&mutex);
+	while(logged < ticket)
+		pthread_cond_wait(&idle_cond, &mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+void *SignalLogger::loggerThread(void *__logger)
+{
+	SignalLogger *logger = (SignalLogger *)__logger;
+	bool stop = false;
+
+	while(!stop)
+	{
+		while(sem_wait(&logger->sem) < 0);
+
+		//A single pass logs every emission posted so far
+		while(sem_trywait(&logger->sem) == 0);
+
+		pthread_mutex_lock(&logger->mutex);
+		std::vector<SignalQueue*> queues = logger->queues;
+		uint64_t requested = logger->requested;
+		stop = logger->stop;
+		pthread_mutex_unlock(&logger->mutex);
 
-	QString signalName = thread_data->signal;
-	signalName = signalName.mid(0, signalName.indexOf("("));
+		signal_event_t event;
+		for(int i = 0; i < queues.size(); i++)
+			while(queues.at(i)->pop(&event))
+				logger->print(event);
 
-	while(1)
+		uint32_t dropped = __sync_fetch_and_and(&logger->dropped, 0);
+		if(dropped > 0)
+			std::cout << "[SignalSpy] " << dropped << " emissions dropped, queue full" << std::endl;
+
+		pthread_mutex_lock(&logger->mutex);
+		logger->logged = requested;
+		pthread_cond_broadcast(&logger->idle_cond);
+		pthread_mutex_unlock(&logger->mutex);
+	}
+
+	return NULL;
+}
+
+void SignalLogger::print(const signal_event_t &event)
+{
+	const SignalSpy *spy = event.spy;
+	char timestamp[32];
+	snprintf(timestamp, sizeof(timestamp), "%.6f", event.timestamp / 1e9);
+
+	std::cout << "[" << timestamp << "] " << spy->objectName.toStdString() << " emitted signal: " << spy->signalName.constData() << "(";
+	for(int i = 0; i < event.args.size(); i++)
 	{
-		if(thread_data->spy == NULL)
-			break;
-
-		if(thread_data->spy->count())
-		{
-			QList<QVariant> arg = thread_data->spy->takeFirst();
-			std::cout << "[" << __PRETTY_FUNCTION__ << "] " << typeid(obj).name() << " emitted signal: " << signalName.toStdString() << "(";
-			for(int i = 0; i < arg.length(); i++)
-			{
-				std::cout << "(" << arg.at(i).typeName() << ") " << arg.at(i).toString().toStdString();
-				if(i < arg.length() - 1)
-					std::cout << ", ";
-			}
-			std::cout << ")" << std::endl;
-		}
-		usleep(250000);
+		const QVariant &arg = event.args.at(i);
+		std::cout << "(" << spy->parameterTypes.at(i).constData() << ") ";
+		if(spy->types.at(i) == 0 && arg.isValid())
+			std::cout << "0x" << std::hex << arg.toULongLong() << std::dec;
+		else
+			std::cout << arg.toString().toStdString();
+
+		if(i < event.args.size() - 1)
+			std::cout << ", ";
 	}
-	
-	std::cout << "QSignalSpy object destroyed, stopping spying ;)" << std::endl;
-	
-	int retval = 0;
-	pthread_exit(&retval);
+	std::cout << ")" << std::endl;
 }
 
 SignalSpy::SignalSpy(QObject *obj, const char *signal)
-: spy(new QSignalSpy(obj, signal)), thread_data((thread_data_t *)malloc(sizeof(thread_data_t)))
+: QObject(), obj(obj), signalIndex(-1), objectName(QString::fromUtf8(obj->metaObject()->className()))
 {
-	std::cout << "[" << __PRETTY_FUNCTION__ << "] " << "SignalSpy initialized. Obj: \"" << obj->objectName().toStdString() << "\", signal: \"" << signal << "\""<< std::endl;
-	thread_data->obj = obj;
-	thread_data->signal = signal;
-	thread_data->spy = spy;
+	if(!obj->objectName().isEmpty())
+		objectName.append("(\"").append(obj->objectName()).append("\")");
 
-	launchSpyThread(thread_data);
+	//Signals are given as SIGNAL(...), whose text is prefixed by its type
+	QByteArray signature = QMetaObject::normalizedSignature(signal[0] == '2' ? signal + 1 : signal);
+	int index = obj->metaObject()->indexOfSignal(signature.constData());
+	if(index < 0)
+	{
+		std::cerr << "[" << __PRETTY_FUNCTION__ << "] " << objectName.toStdString() << " has no signal \"" << signature.constData() << "\"" << std::endl;
+		return;
+	}
+	signalIndex = index;
+
+	QMetaMethod method = obj->metaObject()->method(signalIndex);
+	signalName = signature.left(signature.indexOf('('));
+	parameterTypes = method.parameterTypes();
+	for(int i = 0; i < parameterTypes.size(); i++)
+		types << QMetaType::type(parameterTypes.at(i).constData());
+
+	//Slot 0 of the relay, past the methods of QObject, receives every emission
+	QMetaObject::connect(obj, signalIndex, this, QObject::staticMetaObject.methodCount(), Qt::DirectConnection, 0);
+	std::cout << "[" << __PRETTY_FUNCTION__ << "] " << "SignalSpy initialized. Obj: \"" << objectName.toStdString() << "\", signal: \"" << signature.constData() << "\"" << std::endl;
 }
 
 SignalSpy::~SignalSpy()
 {
-	delete spy;
-	int *retval;
-	pthread_join(thread, (void **)&retval);
-	free(thread_data);
+	if(signalIndex >= 0 && !obj.isNull())
+		QMetaObject::disconnect(obj, signalIndex, this, QObject::staticMetaObject.methodCount());
+
+	//Queued emissions refer to the spy, they are logged before it is freed
+	if(signalIndex >= 0)
+		SignalLogger::instance()->sync();
 }
 
-void SignalSpy::launchSpyThread(thread_data_t *thread_data)
+int SignalSpy::qt_metacall(QMetaObject::Call call, int methodId, void **a)
 {
-	pthread_create(&thread, NULL, spyThread, thread_data);
+	methodId = QObject::qt_metacall(call, methodId, a);
+	if(methodId < 0)
+		return methodId;
+
+	if(call == QMetaObject::InvokeMetaMethod)
+	{
+		if(methodId == 0)
+			SignalLogger::instance()->push(this, a);
+		methodId--;
+	}
+
+	return methodId;
 }
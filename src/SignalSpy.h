@@ -22,26 +22,116 @@
 #ifndef SIGNALSPY_H
 #define SIGNALSPY_H
 
-#include <QSignalSpy>
+#include <QObject>
+#include <QPointer>
+#include <QList>
+#include <QVariant>
+#include <QByteArray>
+#include <QString>
+#include <vector>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+
+/** Emissions kept for each emitting thread until logged, must be a power of two */
+#define SIGNAL_QUEUE_SIZE 1024
+
+class SignalSpy;
 
 typedef struct
 {
-	QObject *obj;
-	const char* signal;
-	QSignalSpy *spy;
-} thread_data_t;
+	uint64_t timestamp;
+	const SignalSpy *spy;
+	QList<QVariant> args;
+} signal_event_t;
+
+/**
+ * Single producer, single consumer ring of emissions: only the emitting
+ * thread pushes and only the logger thread pops, so neither takes a lock.
+ * When the ring is full the emission is dropped.
+ */
+class SignalQueue
+{
+	public:
+		SignalQueue();
+		bool push(const signal_event_t &event);
+		bool pop(signal_event_t *event);
+
+	private:
+		signal_event_t events[SIGNAL_QUEUE_SIZE];
+		volatile uint32_t head;
+		volatile uint32_t tail;
+};
 
-class SignalSpy
+/**
+ * Logger of the emissions recorded by every SignalSpy. Each emitting thread
+ * has its own SignalQueue; a single thread sleeps on a semaphore until an
+ * emission is pushed and then writes the queued ones to std::cout.
+ */
+class SignalLogger
 {
+	public:
+		static SignalLogger *instance();
+
+		/**
+		 * This function logs pending emissions and stops the logger thread
+		 */
+		static void shutdown();
+
+		/**
+		 * This function queues an emission of the signal spied by spy,
+		 * args being the arguments of the signal as passed to qt_metacall
+		 */
+		void push(const SignalSpy *spy, void **args);
+
+		/**
+		 * This function waits until every emission queued so far has been
+		 * logged
+		 */
+		void sync();
+
+	private:
+		SignalLogger();
+		virtual ~SignalLogger();
+
+		static void *loggerThread(void *__logger);
+		void print(const signal_event_t &event);
+
+		static SignalLogger *__instance;
+
+		std::vector<SignalQueue*> queues;
+		pthread_t thread;
+		pthread_mutex_t mutex;
+		pthread_cond_t idle_cond;
+		sem_t sem;
+		uint64_t requested;
+		uint64_t logged;
+		volatile uint32_t dropped;
+		bool stop;
+};
+
+/**
+ * Tracer of a signal of obj: a relay connected to the signal records each
+ * emission synchronously, with its timestamp and arguments, in the queue of
+ * the emitting thread. Emissions are logged by the SignalLogger thread.
+ */
+class SignalSpy : public QObject
+{
+	friend class SignalLogger;
+
 	public:
 		SignalSpy(QObject *obj, const char* signal);
 		~SignalSpy();
 
+		int qt_metacall(QMetaObject::Call call, int methodId, void **a);
+
 	private:
-		void launchSpyThread(thread_data_t *thread_data);
-		QSignalSpy *spy;
-		thread_data_t *thread_data;
-		pthread_t thread;
+		QPointer<QObject> obj;
+		int signalIndex;
+		QString objectName;
+		QByteArray signalName;
+		QList<QByteArray> parameterTypes;
+		QList<int> types;
 };
 
 #endif //SIGNALSPY_H
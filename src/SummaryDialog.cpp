@@ -26,6 +26,8 @@
 #include <QSpacerItem>
 #include <QComboBox>
 #include <QCheckBox>
+#include <QBrush>
+#include <iterator>
 
 #include "SummaryDialog.h"
 #include "MainWindow.h"
@@ -94,6 +96,11 @@ SummaryDialog::SummaryDialog(MainWindow *mainWindow)
 
 	setPalette(mainWindow->palette());
 
+	refreshTimer = new QTimer(this);
+	refreshTimer->setSingleShot(true);
+	refreshTimer->setInterval(SUMMARY_REFRESH_DELAY);
+	connect(refreshTimer, SIGNAL(timeout()), this, SLOT(applyChanges()));
+
 	populateComboBox();
 
 	lan_radioButton->setChecked(true);
@@ -128,53 +135,121 @@ SummaryDialog::~SummaryDialog()
 void SummaryDialog::showByVirtualLan()
 {
 	ui->treeWidget->clear();
+	networkItems.clear();
 
 	QStringList headerLabels = QString(VLAN_HEADERS_LABELS).split(";");
 
 	ui->treeWidget->setColumnCount(headerLabels.count());
 	ui->treeWidget->setHeaderLabels(headerLabels);
 
-	std::vector<QString> internalNetworks_vec = mainWindow->vboxbridge->getInternalNetworkList();
-	std::vector<QTreeWidgetItem*> emptyNetworks;
+	QStringList networks = mainWindow->topology->networkNames();
+	std::set<QString> visibleNetworks(networks.begin(), networks.end());
+	if(showEmptyNetworks->isChecked())
+		visibleNetworks.insert(internalNetworks.begin(), internalNetworks.end());
 
-	for(int internalNetwork_index = 0; internalNetwork_index < internalNetworks_vec.size(); internalNetwork_index++)
+	for(std::set<QString>::iterator network = visibleNetworks.begin(); network != visibleNetworks.end(); ++network)
 	{
 		QTreeWidgetItem *item = new QTreeWidgetItem();
-		item->setText(0, QString("Nome rete: ").append(internalNetworks_vec.at(internalNetwork_index)));
+		fillNetworkItem(item, *network);
+		ui->treeWidget->addTopLevelItem(item);
+		networkItems[*network] = item;
+	}
 
-		for(int machine_index = 0; machine_index < mainWindow->VMTabSettings_vec.size(); machine_index++)
-		{
-			VirtualMachine *vm = mainWindow->VMTabSettings_vec.at(machine_index)->vm;
-			for(int iface_index = 0; iface_index < vm->ifaces_size; iface_index++)
-				if(vm->ifaces[iface_index]->attachmentType == NetworkAttachmentType::Internal &&
-				   vm->ifaces[iface_index]->attachmentData == internalNetworks_vec.at(internalNetwork_index))
-				{
-					QTreeWidgetItem *childItem = new QTreeWidgetItem(item);
-					childItem->setText(0, vm->machine->getName());
-					childItem->setText(1, vm->ifaces[iface_index]->name);
-					childItem->setText(2, vm->ifaces[iface_index]->mac);
+	ui->treeWidget->expandAll();
+	resizeColumns();
+}
+
+void SummaryDialog::fillNetworkItem(QTreeWidgetItem *item, QString network)
+{
+	while(item->childCount() > 0)
+		delete item->takeChild(0);
+
+	item->setText(0, QString("Nome rete: ").append(network));
+
+	bool conflicts = false;
+	std::vector<topology_endpoint_t> endpoints = mainWindow->topology->endpoints(network);
+	for(int endpoint_index = 0; endpoint_index < endpoints.size(); endpoint_index++)
+	{
+		VirtualMachine *vm = endpoints.at(endpoint_index).vm;
+		Iface *iface = vm->ifaces[endpoints.at(endpoint_index).iface];
+
+		QTreeWidgetItem *childItem = new QTreeWidgetItem(item);
+		childItem->setText(0, vm->machine->getName());
+		childItem->setText(1, iface->name);
+		childItem->setText(2, iface->mac);
 #ifdef CONFIGURABLE_IP
-					childItem->setText(3, vm->ifaces[iface_index]->ip);
-					childItem->setText(4, vm->ifaces[iface_index]->subnetMask);
+		childItem->setText(3, iface->ip);
+		childItem->setText(4, iface->subnetMask);
+		conflicts = markConflicts(childItem, vm, endpoints.at(endpoint_index).iface, 3) || conflicts;
 #endif
-					if(!vm->ifaces[iface_index]->enabled)
-						childItem->setDisabled(true);
-				}
+		if(!iface->enabled)
+			childItem->setDisabled(true);
+	}
+
+	if(conflicts)
+		item->setText(0, item->text(0).append(QString::fromUtf8(" (conflitti di indirizzamento)")));
+}
+
+#ifdef CONFIGURABLE_IP
+bool SummaryDialog::markConflicts(QTreeWidgetItem *item, VirtualMachine *vm, int iface, int ipColumn)
+{
+	int conflicts = mainWindow->ipPlan->conflicts(vm, iface);
+	if(conflicts == IP_CONFLICT_NONE)
+		return false;
+
+	QStringList descriptions;
+	if(conflicts & IP_CONFLICT_DUPLICATE)
+		descriptions << QString::fromUtf8("Indirizzo IP assegnato a più interfacce della rete");
+	if(conflicts & IP_CONFLICT_SUBNET)
+		descriptions << QString::fromUtf8("Sottorete diversa da quella delle altre interfacce della rete");
+
+	for(int column = ipColumn; column <= ipColumn + 1; column++)
+	{
+		item->setForeground(column, QBrush(Qt::red));
+		item->setToolTip(column, descriptions.join("\n"));
+	}
+
+	return true;
+}
+#endif
+
+void SummaryDialog::updateNetwork(QString network)
+{
+	bool visible = mainWindow->topology->hasNetwork(network) ||
+		(showEmptyNetworks->isChecked() && internalNetworks.find(network) != internalNetworks.end());
+
+	std::map<QString, QTreeWidgetItem*>::iterator it = networkItems.find(network);
+
+	if(!visible)
+	{
+		if(it != networkItems.end())
+		{
+			delete it->second;
+			networkItems.erase(it);
 		}
+		return;
+	}
 
-		if(item->childCount() > 0)
-			ui->treeWidget->addTopLevelItem(item);
-		else if(showEmptyNetworks->isChecked())
-			emptyNetworks.push_back(item);
+	if(it != networkItems.end())
+	{
+		fillNetworkItem(it->second, network);
+		it->second->setExpanded(true);
+		return;
 	}
 
-	if(showEmptyNetworks->isChecked())
-		for(int i = 0; i < emptyNetworks.size(); i++)
-			ui->treeWidget->addTopLevelItem(emptyNetworks.at(i));
+	//Networks are kept sorted by name
+	int index = std::distance(networkItems.begin(), networkItems.lower_bound(network));
+	QTreeWidgetItem *item = new QTreeWidgetItem();
+	fillNetworkItem(item, network);
+	ui->treeWidget->insertTopLevelItem(index, item);
+	item->setExpanded(true);
+	networkItems[network] = item;
+}
 
-	ui->treeWidget->expandAll();
+void SummaryDialog::resizeColumns()
+{
 	if(ui->treeWidget->topLevelItemCount())
-		for(int column = 0; column < headerLabels.size(); column++)
+		for(int column = 0; column < ui->treeWidget->columnCount(); column++)
 			ui->treeWidget->resizeColumnToContents(column);
 }
 
@@ -190,51 +265,61 @@ void SummaryDialog::showByMachine(int vm_index)
 	ui->treeWidget->setColumnCount(headerLabels.count());
 	ui->treeWidget->setHeaderLabels(headerLabels);
 
-	VMTabSettings *vmTabSettings = mainWindow->VMTabSettings_vec.at(vm_index);
+	if(vm_index < 0 || vm_index >= mainWindow->VMTabSettings_vec.size())
+		return;
 
-	for(int iface_index = 0; iface_index < vmTabSettings->vm->ifaces_size; iface_index++)
+	VirtualMachine *vm = mainWindow->VMTabSettings_vec.at(vm_index)->getVM();
+
+	for(int iface_index = 0; iface_index < vm->ifaces_size; iface_index++)
 	{
-		if(vmTabSettings->vm->ifaces[iface_index]->attachmentType == NetworkAttachmentType::Internal)	
+		std::vector<topology_endpoint_t> neighbors = mainWindow->topology->neighbors(vm, iface_index);
+		if(neighbors.size() == 0)
+			continue;
+
+		QTreeWidgetItem *item = new QTreeWidgetItem();
+		item->setText(0, QString("Nome interfaccia: ").append(vm->ifaces[iface_index]->name));
+#ifdef CONFIGURABLE_IP
+		if(mainWindow->ipPlan->conflicts(vm, iface_index) != IP_CONFLICT_NONE)
+			item->setText(0, item->text(0).append(QString::fromUtf8(" (conflitti di indirizzamento)")));
+#endif
+
+		for(int neighbor_index = 0; neighbor_index < neighbors.size(); neighbor_index++)
 		{
-			QTreeWidgetItem *item = new QTreeWidgetItem();
-			item->setText(0, QString("Nome interfaccia: ").append(vmTabSettings->vm->ifaces[iface_index]->name));
-
-			for(int machine_index = 0; machine_index < mainWindow->VMTabSettings_vec.size(); machine_index++)
-			{
-				VMTabSettings *foreign_vmTabSettings = mainWindow->VMTabSettings_vec.at(machine_index);
-				if(machine_index != vm_index)
-					for(int foreign_iface_index = 0; foreign_iface_index < vmTabSettings->vm->ifaces_size; foreign_iface_index++)
-					{
-						if(vmTabSettings->vm->ifaces[iface_index]->attachmentData == foreign_vmTabSettings->vm->ifaces[foreign_iface_index]->attachmentData)
-						{
-							QTreeWidgetItem *childItem = new QTreeWidgetItem(item);
-							childItem->setText(0, vmTabSettings->vm->ifaces[iface_index]->attachmentData);
-							childItem->setText(1, foreign_vmTabSettings->vm->machine->getName());
-							childItem->setText(2, foreign_vmTabSettings->vm->ifaces[foreign_iface_index]->name);
-							childItem->setText(3, foreign_vmTabSettings->vm->ifaces[foreign_iface_index]->mac);
+			VirtualMachine *foreign_vm = neighbors.at(neighbor_index).vm;
+			Iface *foreign_iface = foreign_vm->ifaces[neighbors.at(neighbor_index).iface];
+
+			QTreeWidgetItem *childItem = new QTreeWidgetItem(item);
+			childItem->setText(0, vm->ifaces[iface_index]->attachmentData);
+			childItem->setText(1, foreign_vm->machine->getName());
+			childItem->setText(2, foreign_iface->name);
+			childItem->setText(3, foreign_iface->mac);
 #ifdef CONFIGURABLE_IP
-							childItem->setText(4, foreign_vmTabSettings->vm->ifaces[foreign_iface_index]->ip);
-							childItem->setText(5, foreign_vmTabSettings->vm->ifaces[foreign_iface_index]->subnetMask);
+			childItem->setText(4, foreign_iface->ip);
+			childItem->setText(5, foreign_iface->subnetMask);
+			markConflicts(childItem, foreign_vm, neighbors.at(neighbor_index).iface, 4);
 #endif
-							if(!vmTabSettings->vm->ifaces[iface_index]->enabled)
-								childItem->setDisabled(true);
-						}
-					}
-			}
-
-			if(item->childCount() > 0)
-				ui->treeWidget->addTopLevelItem(item);
+			if(!vm->ifaces[iface_index]->enabled)
+				childItem->setDisabled(true);
 		}
+
+		ui->treeWidget->addTopLevelItem(item);
 	}
 
 	ui->treeWidget->expandAll();
-	if(ui->treeWidget->topLevelItemCount())
-		for(int column = 0; column < headerLabels.size(); column++)
-			ui->treeWidget->resizeColumnToContents(column);
+	resizeColumns();
 }
 
 void SummaryDialog::refresh()
 {
+	refreshTimer->stop();
+	dirtyNetworks.clear();
+	dirtyMachines.clear();
+
+	HostNetworkCatalog *catalog = mainWindow->vboxbridge->getHostNetworkCatalog();
+	catalog->invalidate(NetworkAttachmentType::Internal);
+	QStringList internalNetworks_list = catalog->list(NetworkAttachmentType::Internal);
+	internalNetworks = std::set<QString>(internalNetworks_list.begin(), internalNetworks_list.end());
+
 	if(lan_radioButton->isChecked())
 		showByVirtualLan();
 	else if(machine_radioButton->isChecked())
@@ -246,11 +331,72 @@ void SummaryDialog::populateComboBox()
 	machine_comboBox->blockSignals(true);
 	machine_comboBox->clear();
 	for(int machine_index = 0; machine_index < mainWindow->VMTabSettings_vec.size(); machine_index++)
-	{
-		VirtualMachine *vm = mainWindow->VMTabSettings_vec.at(machine_index)->vm;
-		machine_comboBox->addItem(vm->machine->getName());
-	}
+		machine_comboBox->addItem(mainWindow->VMTabSettings_vec.at(machine_index)->getMachineName());
 	machine_comboBox->blockSignals(false);
 
 	refresh();
 }
+
+void SummaryDialog::slotMachineChanged(VirtualMachine *vm)
+{
+	dirtyMachines.insert(vm);
+	for(int iface = 0; iface < vm->ifaces_size; iface++)
+	{
+		QString network = mainWindow->topology->network(vm, iface);
+		if(!network.isEmpty())
+			dirtyNetworks.insert(network);
+	}
+
+	if(!refreshTimer->isActive())
+		refreshTimer->start();
+}
+
+void SummaryDialog::slotIfaceMoved(VirtualMachine *vm, int iface, QString oldNetwork, QString newNetwork)
+{
+	dirtyMachines.insert(vm);
+	if(!oldNetwork.isEmpty())
+		dirtyNetworks.insert(oldNetwork);
+	if(!newNetwork.isEmpty())
+		dirtyNetworks.insert(newNetwork);
+
+	if(!refreshTimer->isActive())
+		refreshTimer->start();
+}
+
+void SummaryDialog::applyChanges()
+{
+	//A hidden summary is rebuilt by refresh() when shown again
+	if(!isVisible())
+	{
+		dirtyNetworks.clear();
+		dirtyMachines.clear();
+		return;
+	}
+
+	if(lan_radioButton->isChecked())
+	{
+		for(std::set<QString>::iterator network = dirtyNetworks.begin(); network != dirtyNetworks.end(); ++network)
+			updateNetwork(*network);
+
+		if(!dirtyNetworks.empty())
+			resizeColumns();
+	}
+	else if(machine_radioButton->isChecked())
+	{
+		int vm_index = machine_comboBox->currentIndex();
+		if(vm_index >= 0 && vm_index < mainWindow->VMTabSettings_vec.size())
+		{
+			VirtualMachine *vm = mainWindow->VMTabSettings_vec.at(vm_index)->getVM();
+			bool affected = dirtyMachines.find(vm) != dirtyMachines.end();
+
+			for(int iface = 0; iface < vm->ifaces_size && !affected; iface++)
+				affected = dirtyNetworks.find(mainWindow->topology->network(vm, iface)) != dirtyNetworks.end();
+
+			if(affected)
+				showByMachine(vm_index);
+		}
+	}
+
+	dirtyNetworks.clear();
+	dirtyMachines.clear();
+}
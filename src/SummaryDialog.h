@@ -29,10 +29,17 @@
 #include <QSpacerItem>
 #include <QComboBox>
 #include <QCheckBox>
+#include <QTimer>
+#include <QTreeWidgetItem>
+#include <map>
+#include <set>
 
 #include "ui_MachinesDialog.h"
 #include "VirtualMachine.h"
 
+/** Delay used to coalesce summary updates, in ms */
+#define SUMMARY_REFRESH_DELAY 200
+
 class Ui_MachinesDialog;
 class MainWindow;
 
@@ -49,8 +56,20 @@ class SummaryDialog : public QDialog
 		void showByMachine(int vm_index = -1);
 		void refresh();
 		void populateComboBox();
+		void slotMachineChanged(VirtualMachine *vm);
+		void slotIfaceMoved(VirtualMachine *vm, int iface, QString oldNetwork, QString newNetwork);
+
+	private slots:
+		void applyChanges();
 
 	private:
+		void updateNetwork(QString network);
+		void fillNetworkItem(QTreeWidgetItem *item, QString network);
+		void resizeColumns();
+#ifdef CONFIGURABLE_IP
+		bool markConflicts(QTreeWidgetItem *item, VirtualMachine *vm, int iface, int ipColumn);
+#endif
+
 		Ui_MachinesDialog *ui;
 		QHBoxLayout *radioButtonsLayout;
 		QLabel *label;
@@ -60,6 +79,12 @@ class SummaryDialog : public QDialog
 		QComboBox *machine_comboBox;
 		QCheckBox *showEmptyNetworks;
 		MainWindow *mainWindow;
+
+		QTimer *refreshTimer;
+		std::set<QString> internalNetworks;
+		std::map<QString, QTreeWidgetItem*> networkItems;
+		std::set<QString> dirtyNetworks;
+		std::set<VirtualMachine*> dirtyMachines;
 };
 
 #endif //SUMMARYDIALOG_H
@@ -0,0 +1,216 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "Trace.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+
+volatile bool Trace::enabled = false;
+std::string Trace::fileName;
+pthread_t Trace::dumper;
+int Trace::dump_pipe[2] = { -1, -1 };
+
+/** Buffer of the calling thread, created at its first span */
+static __thread trace_buffer_t *thread_buffer = NULL;
+
+/** Every buffer created, kept until exit so spans of ended threads are dumped too */
+static std::vector<trace_buffer_t*> buffers;
+static pthread_mutex_t buffers_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void Trace::init()
+{
+	const char *env = getenv(TRACE_ENV);
+	if(env == NULL || *env == '\0' || enabled)
+		return;
+
+	fileName = env;
+
+	//The signal handler only wakes the dumper thread, which writes the file
+	if(pipe(dump_pipe) == 0)
+	{
+		fcntl(dump_pipe[1], F_SETFL, O_NONBLOCK);
+		pthread_create(&dumper, NULL, dumperThread, NULL);
+		signal(SIGUSR1, requestDump);
+	}
+	else
+		dump_pipe[0] = dump_pipe[1] = -1;
+
+	enabled = true;
+	std::cout << "Tracing to " << fileName << " (SIGUSR1 to write it now)" << std::endl;
+}
+
+void Trace::shutdown()
+{
+	if(!enabled)
+		return;
+
+	if(dump_pipe[1] >= 0)
+	{
+		signal(SIGUSR1, SIG_DFL);
+		char c = 'q';
+		if(write(dump_pipe[1], &c, 1) == 1)
+			pthread_join(dumper, NULL);
+		close(dump_pipe[0]);
+		close(dump_pipe[1]);
+		dump_pipe[0] = dump_pipe[1] = -1;
+	}
+
+	dump(fileName);
+	enabled = false;
+}
+
+void Trace::requestDump(int sig)
+{
+	char c = 'd';
+	if(write(dump_pipe[1], &c, 1) < 0)
+		return;
+}
+
+void *Trace::dumperThread(void *)
+{
+	char c;
+	while(read(dump_pipe[0], &c, 1) == 1 && c == 'd')
+		dump(fileName);
+
+	return NULL;
+}
+
+uint64_t Trace::now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+trace_buffer_t *Trace::buffer()
+{
+	if(thread_buffer != NULL)
+		return thread_buffer;
+
+	trace_buffer_t *b = (trace_buffer_t *)malloc(sizeof(trace_buffer_t));
+	b->count = 0;
+	pthread_mutex_init(&b->mutex, NULL);
+	b->tid = syscall(SYS_gettid);
+	memset(b->thread_name, 0, sizeof(b->thread_name));
+	prctl(PR_GET_NAME, b->thread_name);
+
+	pthread_mutex_lock(&buffers_mutex);
+	buffers.push_back(b);
+	pthread_mutex_unlock(&buffers_mutex);
+
+	thread_buffer = b;
+	return b;
+}
+
+void Trace::record(const char *category, const char *name, const char *arg, uint64_t begin, uint64_t end)
+{
+	trace_buffer_t *b = buffer();
+
+	pthread_mutex_lock(&b->mutex);
+	trace_event_t *event = &b->events[b->count % TRACE_BUFFER_EVENTS];
+	event->category = category;
+	event->name = name;
+	strncpy(event->arg, (arg != NULL) ? arg : "", TRACE_ARG_SIZE - 1);
+	event->arg[TRACE_ARG_SIZE - 1] = '\0';
+	event->begin = begin;
+	event->duration = end - begin;
+	b->count++;
+	pthread_mutex_unlock(&b->mutex);
+}
+
+std::string Trace::escape(const char *s)
+{
+	std::string escaped;
+	for(; *s != '\0'; s++)
+	{
+		if(*s == '"' || *s == '\\')
+			escaped.push_back('\\');
+
+		//Control characters are not valid in a JSON string
+		escaped.push_back(((unsigned char) *s < 0x20) ? ' ' : *s);
+	}
+
+	return escaped;
+}
+
+bool Trace::dump(std::string fileName)
+{
+	std::ofstream out(fileName.c_str());
+	if(!out)
+	{
+		std::cerr << "Cannot write trace " << fileName << std::endl;
+		return false;
+	}
+
+	pthread_mutex_lock(&buffers_mutex);
+	std::vector<trace_buffer_t*> dumped_buffers = buffers;
+	pthread_mutex_unlock(&buffers_mutex);
+
+	int pid = getpid();
+	bool first = true;
+	char timing[64];
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+
+	for(int i = 0; i < dumped_buffers.size(); i++)
+	{
+		trace_buffer_t *b = dumped_buffers.at(i);
+
+		//Spans are copied, so a thread is never blocked while the file is written
+		pthread_mutex_lock(&b->mutex);
+		uint64_t count = b->count;
+		uint64_t oldest = (count > TRACE_BUFFER_EVENTS) ? count - TRACE_BUFFER_EVENTS : 0;
+		std::vector<trace_event_t> events;
+		for(uint64_t j = oldest; j < count; j++)
+			events.push_back(b->events[j % TRACE_BUFFER_EVENTS]);
+		pthread_mutex_unlock(&b->mutex);
+
+		out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << b->tid
+		    << ",\"args\":{\"name\":\"" << escape(b->thread_name) << "\"}}";
+		first = false;
+
+		for(int j = 0; j < events.size(); j++)
+		{
+			const trace_event_t *event = &events.at(j);
+			snprintf(timing, sizeof(timing), "\"ts\":%.3f,\"dur\":%.3f", event->begin / 1000.0, event->duration / 1000.0);
+
+			out << ",\n{\"name\":\"" << escape(event->name) << "\",\"cat\":\"" << event->category << "\",\"ph\":\"X\","
+			    << timing << ",\"pid\":" << pid << ",\"tid\":" << b->tid;
+			if(event->arg[0] != '\0')
+				out << ",\"args\":{\"arg\":\"" << escape(event->arg) << "\"}";
+			out << "}";
+		}
+	}
+
+	out << std::endl << "]}" << std::endl;
+	out.close();
+
+	return !out.fail();
+}
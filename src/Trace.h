@@ -0,0 +1,149 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+/** Environment variable with the trace file name, tracing is enabled only if it is set */
+#define TRACE_ENV "VBANT_TRACE"
+
+/** Spans kept for each thread, older ones are overwritten */
+#define TRACE_BUFFER_EVENTS 16384
+
+/** Bytes of the argument kept with each span */
+#define TRACE_ARG_SIZE 48
+
+typedef struct
+{
+	const char *category;
+	const char *name;
+	char arg[TRACE_ARG_SIZE];
+	uint64_t begin;
+	uint64_t duration;
+} trace_event_t;
+
+/**
+ * Ring buffer of the spans of a thread. Only its thread writes it; the lock
+ * is taken by a dump too, so it is never contended otherwise.
+ */
+typedef struct
+{
+	trace_event_t events[TRACE_BUFFER_EVENTS];
+	uint64_t count;
+	pthread_mutex_t mutex;
+	long tid;
+	char thread_name[16];
+} trace_buffer_t;
+
+/**
+ * Span tracer. Spans are recorded by TRACE_SCOPE in a ring buffer of the
+ * calling thread and written as a Chrome trace (chrome://tracing, Perfetto)
+ * to the file named by TRACE_ENV at exit, or whenever the process receives
+ * SIGUSR1. When TRACE_ENV is not set a span costs a flag check; without the
+ * TRACE_FLAG build flag it is not compiled at all.
+ */
+class Trace
+{
+	public:
+		/**
+		 * This function enables tracing if TRACE_ENV is set
+		 */
+		static void init();
+
+		/**
+		 * This function writes the trace file and disables tracing
+		 */
+		static void shutdown();
+
+		/**
+		 * This function writes every recorded span to fileName
+		 */
+		static bool dump(std::string fileName);
+
+		static inline bool isEnabled() { return enabled; };
+		static uint64_t now();
+		static void record(const char *category, const char *name, const char *arg, uint64_t begin, uint64_t end);
+
+	private:
+		static trace_buffer_t *buffer();
+		static void *dumperThread(void *);
+		static void requestDump(int sig);
+		static std::string escape(const char *s);
+
+		static volatile bool enabled;
+		static std::string fileName;
+		static pthread_t dumper;
+		static int dump_pipe[2];
+};
+
+/**
+ * Span lasting as long as this object, recorded if tracing is enabled when
+ * it is created. arg is copied, so it may be a temporary.
+ * TRACE_SCOPE_ARG evaluates arg only when tracing is enabled.
+ */
+class TraceScope
+{
+	public:
+		inline TraceScope(const char *category, const char *name, const char *arg = NULL)
+		: category(category), name(name), begin(0)
+		{
+			if(!Trace::isEnabled())
+				return;
+
+			this->arg[0] = '\0';
+			if(arg != NULL)
+			{
+				strncpy(this->arg, arg, TRACE_ARG_SIZE - 1);
+				this->arg[TRACE_ARG_SIZE - 1] = '\0';
+			}
+			begin = Trace::now();
+		};
+
+		inline ~TraceScope()
+		{
+			if(begin != 0)
+				Trace::record(category, name, arg, begin, Trace::now());
+		};
+
+	private:
+		const char *category;
+		const char *name;
+		char arg[TRACE_ARG_SIZE];
+		uint64_t begin;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef TRACE_FLAG
+	#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(__trace_scope_, __LINE__)(category, name)
+	#define TRACE_SCOPE_ARG(category, name, arg) TraceScope TRACE_CONCAT(__trace_scope_, __LINE__)(category, name, Trace::isEnabled() ? (const char *)(arg) : NULL)
+#else
+	#define TRACE_SCOPE(category, name) do {} while (0)
+	#define TRACE_SCOPE_ARG(category, name, arg) do {} while (0)
+#endif
+
+#endif //TRACE_H
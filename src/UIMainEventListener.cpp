@@ -48,8 +48,13 @@ HRESULT UIMainEventListener::init(QObject *pParent)
 {
 	setParent(pParent);
 	
-	connect(this, SIGNAL(sigStateChange(MachineBridge*, uint32_t)), parent(), SLOT(slotStateChange(MachineBridge*, uint32_t)));
 	connect(this, SIGNAL(sigMachineStateChange(MachineBridge*,uint32_t)), this, SIGNAL(sigStateChange(MachineBridge*, uint32_t)));
+
+	//Machines of the command line tool have no window to notify
+	if(pParent == NULL)
+		return NS_OK;
+
+	connect(this, SIGNAL(sigStateChange(MachineBridge*, uint32_t)), parent(), SLOT(slotStateChange(MachineBridge*, uint32_t)));
 	connect(this, SIGNAL(sigNetworkAdapterChange(MachineBridge*,INetworkAdapter*)), parent(), SLOT(slotNetworkAdapterChange(MachineBridge*,INetworkAdapter*)));
 	return NS_OK;
 }
@@ -0,0 +1,352 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "VMCommandExecutor.h"
+#include "VirtualMachine.h"
+#include "VMSettings.h"
+#include "OperationsStats.h"
+#include "Trace.h"
+#include "Log.h"
+
+static const char *command_names[] = { "start", "stop", "save settings", "clone", "export", "pause", "reset", "rename", "release", "save settings run time" };
+
+VMCommandExecutor *VMCommandExecutor::__instance = NULL;
+
+VMCommandWorker::VMCommandWorker()
+: QObject(), current_id(0)
+{
+
+}
+
+void VMCommandWorker::progress(QString label, uint32_t percent)
+{
+	emit commandProgress(current_id, label, percent);
+}
+
+void VMCommandWorker::execute(vm_command_t command)
+{
+	TRACE_SCOPE_ARG("command", "VMCommandWorker::execute", command_names[command.type]);
+
+	//Progress of VirtualBox operations is sent to the GUI instead of a dialog
+	VirtualBoxBridge::setProgressSink(this);
+	current_id = command.id;
+
+	vm_command_result_t result;
+	result.id = command.id;
+	result.type = command.type;
+	result.machine = command.machine;
+	result.vm = command.vm;
+	result.name = command.name;
+	result.clone = NULL;
+	result.vm_vec = (command.type == VM_COMMAND_SAVE_SETTINGS_RUNTIME) ? command.vm_vec : std::vector<VirtualMachine*>();
+	result.succeeded = run(command, &result);
+
+	if(!result.succeeded)
+		LOG_WARNING(LOG_VM, "Command %u (%s) failed", command.id, command_names[command.type]);
+
+	emit commandFinished(result);
+}
+
+void VMCommandWorker::finish()
+{
+	thread()->quit();
+}
+
+bool VMCommandWorker::run(const vm_command_t &command, vm_command_result_t *result)
+{
+	switch(command.type)
+	{
+		case VM_COMMAND_START:
+			//Cable state of a placeholder tab is already the one on the adapters
+			if(command.vm != NULL)
+				return command.vm->start(command.ifaces);
+			return command.machine->start();
+		case VM_COMMAND_STOP:
+			return command.machine->stop(command.flag);
+		case VM_COMMAND_SAVE_SETTINGS:
+			if(command.flag)
+				return command.vm->saveSettingsRunTime();
+			return command.vm->saveSettings();
+		case VM_COMMAND_SAVE_SETTINGS_RUNTIME:
+			return VirtualMachine::saveSettingsRunTime(command.vm_vec);
+		case VM_COMMAND_CLONE:
+			result->clone = command.vm->clone(command.name, command.flag);
+			if(result->clone == NULL)
+				return false;
+
+			//The clone keeps the guest settings of the original ifaces until cleaned
+			if(!command.vm->cleanClone(result->clone))
+				LOG_WARNING(LOG_VM, "Cannot clean guest settings of %s", command.name.toStdString().c_str());
+			return true;
+		case VM_COMMAND_EXPORT:
+			return MachinesArchive::writeSnapshot(command.name, command.records, command.archiveType, command.base_fileName);
+		case VM_COMMAND_PAUSE:
+			return command.machine->pause(command.flag);
+		case VM_COMMAND_RESET:
+			return command.machine->reset();
+		case VM_COMMAND_RENAME:
+			return command.machine->rename(command.name);
+		case VM_COMMAND_RELEASE:
+			return command.machine->shutdownVMProcess();
+	}
+
+	return false;
+}
+
+VMCommandExecutor::VMCommandExecutor()
+: QObject(), worker(new VMCommandWorker()), next_id(1), in_flight(0)
+{
+	qRegisterMetaType<uint32_t>("uint32_t");
+	qRegisterMetaType<vm_command_t>("vm_command_t");
+	qRegisterMetaType<vm_command_result_t>("vm_command_result_t");
+
+	worker->moveToThread(&workerThread);
+	connect(this, SIGNAL(commandQueued(vm_command_t)), worker, SLOT(execute(vm_command_t)), Qt::QueuedConnection);
+	connect(worker, SIGNAL(commandProgress(uint32_t, QString, uint32_t)), this, SIGNAL(commandProgress(uint32_t, QString, uint32_t)), Qt::QueuedConnection);
+	connect(worker, SIGNAL(commandFinished(vm_command_result_t)), this, SLOT(slotFinished(vm_command_result_t)), Qt::QueuedConnection);
+	workerThread.start();
+}
+
+VMCommandExecutor::~VMCommandExecutor()
+{
+	//Commands queued before are run first
+	QMetaObject::invokeMethod(worker, "finish", Qt::QueuedConnection);
+	workerThread.wait();
+
+	//Saves of the deferred exports are done, the GUI thread runs them alone now
+	for(int i = 0; i < deferred.size(); i++)
+	{
+		deferred.at(i).records = MachinesArchive::snapshot(deferred.at(i).vm_vec);
+		worker->execute(deferred.at(i));
+	}
+
+	delete worker;
+}
+
+VMCommandExecutor *VMCommandExecutor::instance()
+{
+	//Commands are only queued by the GUI thread
+	if(__instance == NULL)
+		__instance = new VMCommandExecutor();
+
+	return __instance;
+}
+
+void VMCommandExecutor::shutdown()
+{
+	delete __instance;
+	__instance = NULL;
+}
+
+uint32_t VMCommandExecutor::start(MachineBridge *machine, VirtualMachine *vm)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_START;
+	command.machine = machine;
+	command.vm = vm;
+	command.flag = false;
+
+	if(vm != NULL)
+		for(int i = 0; i < vm->ifaces_size; i++)
+			command.ifaces.push_back(vm->ifaces[i]->getSerializableIface());
+
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::stop(MachineBridge *machine, bool force)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_STOP;
+	command.machine = machine;
+	command.vm = NULL;
+	command.flag = force;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::saveSettings(VirtualMachine *vm, bool runTime)
+{
+	block(vm);
+
+	vm_command_t command;
+	command.type = VM_COMMAND_SAVE_SETTINGS;
+	command.machine = vm->machine;
+	command.vm = vm;
+	command.flag = runTime;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::saveSettingsRunTime(std::vector<VirtualMachine*> vm_vec)
+{
+	for(int i = 0; i < vm_vec.size(); i++)
+		block(vm_vec.at(i));
+
+	vm_command_t command;
+	command.type = VM_COMMAND_SAVE_SETTINGS_RUNTIME;
+	command.machine = NULL;
+	command.vm = NULL;
+	command.flag = true;
+	command.vm_vec = vm_vec;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::clone(VirtualMachine *vm, QString qName, bool reInitIfaces)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_CLONE;
+	command.machine = vm->machine;
+	command.vm = vm;
+	command.flag = reInitIfaces;
+	command.name = qName;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::exportMachines(QString fileName, std::vector<VirtualMachine*> vm_vec, char type, QString base_fileName)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_EXPORT;
+	command.machine = NULL;
+	command.vm = NULL;
+	command.flag = false;
+	command.name = fileName;
+	command.vm_vec = vm_vec;
+	command.archiveType = type;
+	command.base_fileName = base_fileName;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::pause(MachineBridge *machine, bool pauseEnabled)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_PAUSE;
+	command.machine = machine;
+	command.vm = NULL;
+	command.flag = pauseEnabled;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::reset(MachineBridge *machine)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_RESET;
+	command.machine = machine;
+	command.vm = NULL;
+	command.flag = false;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::rename(MachineBridge *machine, QString qName)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_RENAME;
+	command.machine = machine;
+	command.vm = NULL;
+	command.flag = false;
+	command.name = qName;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::release(MachineBridge *machine)
+{
+	vm_command_t command;
+	command.type = VM_COMMAND_RELEASE;
+	command.machine = machine;
+	command.vm = NULL;
+	command.flag = false;
+	return submit(command);
+}
+
+uint32_t VMCommandExecutor::submit(vm_command_t command)
+{
+	command.id = next_id++;
+	in_flight++;
+	OperationsStats::addPendingBulk(1);
+
+	//Saved settings of a machine are written by the worker until its save completes
+	if(command.type == VM_COMMAND_EXPORT && (!deferred.empty() || saving(command.vm_vec)))
+		deferred.push_back(command);
+	else
+		dispatch(command);
+
+	return command.id;
+}
+
+void VMCommandExecutor::dispatch(vm_command_t command)
+{
+	if(command.type == VM_COMMAND_EXPORT)
+		command.records = MachinesArchive::snapshot(command.vm_vec);
+
+	emit commandQueued(command);
+}
+
+void VMCommandExecutor::slotFinished(vm_command_result_t result)
+{
+	in_flight--;
+	OperationsStats::addPendingBulk(-1);
+
+	if(result.type == VM_COMMAND_SAVE_SETTINGS)
+		unblock(result.vm);
+	else if(result.type == VM_COMMAND_SAVE_SETTINGS_RUNTIME)
+	{
+		for(int i = 0; i < result.vm_vec.size(); i++)
+			unblock(result.vm_vec.at(i));
+	}
+	else if(result.type == VM_COMMAND_START && result.succeeded)
+		result.machine->registerListener();
+
+	//Exports are queued in order once the machines they write are saved
+	while(!deferred.empty() && !saving(deferred.front().vm_vec))
+	{
+		dispatch(deferred.front());
+		deferred.erase(deferred.begin());
+	}
+
+	emit commandFinished(result);
+}
+
+void VMCommandExecutor::block(VirtualMachine *vm)
+{
+	//Slots of GUI objects are called on the GUI thread once saved
+	if(blocked[vm]++ == 0)
+		vm->blockSignals(true);
+}
+
+bool VMCommandExecutor::saving(const std::vector<VirtualMachine*> &vm_vec) const
+{
+	for(int i = 0; i < vm_vec.size(); i++)
+		if(blocked.find(vm_vec.at(i)) != blocked.end())
+			return true;
+
+	return false;
+}
+
+void VMCommandExecutor::unblock(VirtualMachine *vm)
+{
+	std::map<VirtualMachine*, int>::iterator it = blocked.find(vm);
+	if(it == blocked.end() || --it->second > 0)
+		return;
+
+	blocked.erase(it);
+	vm->blockSignals(false);
+
+	for(int iface = 0; iface < vm->ifaces_size; iface++)
+		emit vm->ifaceChanged(iface);
+	emit vm->settingsChanged(vm);
+}
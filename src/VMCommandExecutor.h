@@ -0,0 +1,185 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef VMCOMMANDEXECUTOR_H
+#define VMCOMMANDEXECUTOR_H
+
+#include <QObject>
+#include <QThread>
+#include <QString>
+#include <QMetaType>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include "VirtualBoxBridge.h"
+#include "MachinesArchive.h"
+
+typedef enum
+{
+	VM_COMMAND_START,
+	VM_COMMAND_STOP,
+	VM_COMMAND_SAVE_SETTINGS,
+	VM_COMMAND_CLONE,
+	VM_COMMAND_EXPORT,
+	VM_COMMAND_PAUSE,
+	VM_COMMAND_RESET,
+	VM_COMMAND_RENAME,
+	VM_COMMAND_RELEASE,
+	VM_COMMAND_SAVE_SETTINGS_RUNTIME
+} vm_command_type_t;
+
+typedef struct
+{
+	uint32_t id;
+	vm_command_type_t type;
+	MachineBridge *machine;
+	VirtualMachine *vm;
+	bool flag;			//stop: force, save: run time, clone: reinit ifaces, pause: enter
+	QString name;			//clone, rename: machine name, export: file name
+	std::vector<VirtualMachine*> vm_vec;	//export, run time save: machines
+	std::vector<settings_iface_t> ifaces;	//start: ifaces copied on the GUI thread
+	std::vector<machine_record_t> records;	//export: snapshot taken on the GUI thread
+	char archiveType;		//export only
+	QString base_fileName;		//export only
+} vm_command_t;
+
+typedef struct
+{
+	uint32_t id;
+	vm_command_type_t type;
+	MachineBridge *machine;
+	VirtualMachine *vm;
+	QString name;
+	bool succeeded;
+	IMachine *clone;		//clone only, NULL on failure
+	std::vector<VirtualMachine*> vm_vec;	//run time save only
+} vm_command_result_t;
+
+Q_DECLARE_METATYPE(vm_command_t)
+Q_DECLARE_METATYPE(vm_command_result_t)
+
+/**
+ * Runs the commands of a VMCommandExecutor, one at a time and in order, on
+ * the executor thread. Sessions and consoles of a machine are only replaced
+ * by these commands, the GUI thread reads them through the snapshots taken by
+ * MachineBridge. Guest disks mounted by a command are unmounted before it
+ * finishes.
+ */
+class VMCommandWorker : public QObject, public ProgressSink
+{
+	Q_OBJECT
+
+	public:
+		VMCommandWorker();
+		void progress(QString label, uint32_t percent);
+
+	public slots:
+		void execute(vm_command_t command);
+		void finish();
+
+	signals:
+		void commandProgress(uint32_t id, QString label, uint32_t percent);
+		void commandFinished(vm_command_result_t result);
+
+	private:
+		bool run(const vm_command_t &command, vm_command_result_t *result);
+
+		uint32_t current_id;
+};
+
+/**
+ * Queue of VirtualBox and guest disk operations requested by the GUI. Each
+ * function returns the id of the queued command at once; the command runs on
+ * a single worker thread and its result is delivered on the GUI thread by
+ * commandFinished. Signals of a machine whose settings are being saved are
+ * blocked and emitted again on the GUI thread when the save completes.
+ * Start and export commands carry a copy of the ifaces and of the saved
+ * settings taken on the GUI thread, and the listener of a started machine is
+ * registered on the GUI thread too.
+ */
+class VMCommandExecutor : public QObject
+{
+	Q_OBJECT
+
+	public:
+		static VMCommandExecutor *instance();
+
+		/**
+		 * This function waits for every queued command and stops the
+		 * worker thread
+		 */
+		static void shutdown();
+
+		uint32_t start(MachineBridge *machine, VirtualMachine *vm = NULL);
+		uint32_t stop(MachineBridge *machine, bool force);
+		uint32_t saveSettings(VirtualMachine *vm, bool runTime);
+
+		/**
+		 * This function applies the changed attachments of every running
+		 * machine of vm_vec, notifying the changes once all are applied
+		 */
+		uint32_t saveSettingsRunTime(std::vector<VirtualMachine*> vm_vec);
+		uint32_t clone(VirtualMachine *vm, QString qName, bool reInitIfaces);
+		uint32_t exportMachines(QString fileName, std::vector<VirtualMachine*> vm_vec, char type, QString base_fileName = "");
+		uint32_t pause(MachineBridge *machine, bool pauseEnabled);
+		uint32_t reset(MachineBridge *machine);
+		uint32_t rename(MachineBridge *machine, QString qName);
+
+		/**
+		 * This function closes the session of a machine powered off
+		 */
+		uint32_t release(MachineBridge *machine);
+
+		/**
+		 * This function returns the number of queued or running commands
+		 */
+		int pending() const { return in_flight; };
+
+	signals:
+		void commandQueued(vm_command_t command);
+		void commandProgress(uint32_t id, QString label, uint32_t percent);
+		void commandFinished(vm_command_result_t result);
+
+	private slots:
+		void slotFinished(vm_command_result_t result);
+
+	private:
+		VMCommandExecutor();
+		virtual ~VMCommandExecutor();
+
+		uint32_t submit(vm_command_t command);
+		void dispatch(vm_command_t command);
+		void block(VirtualMachine *vm);
+		void unblock(VirtualMachine *vm);
+		bool saving(const std::vector<VirtualMachine*> &vm_vec) const;
+
+		static VMCommandExecutor *__instance;
+
+		QThread workerThread;
+		VMCommandWorker *worker;
+		uint32_t next_id;
+		int in_flight;
+		std::map<VirtualMachine*, int> blocked;
+		std::vector<vm_command_t> deferred;
+};
+
+#endif //VMCOMMANDEXECUTOR_H
@@ -20,9 +20,16 @@
  */
 
 #include "VMSettings.h"
+#include "VMSettingsJournal.h"
+#include "MachinesArchive.h"
+#include "Log.h"
 #include "crc32.h"
 #include <malloc.h>
+#include <map>
+#include <fcntl.h>
+#include <unistd.h>
 #include <QFile>
+#include <QFileInfo>
 
 static int toupper_wrapper(int c)
 {
@@ -30,8 +37,9 @@ static int toupper_wrapper(int c)
 }
 
 VMSettings::VMSettings(VirtualMachine *vm)
-: fileName(""), vm(vm), savedIfaces(NULL), savedIfaces_size(0)
+: fileName(""), vm(vm), savedIfaces(NULL), savedIfaces_size(0), journaledIfaces(NULL), journaledIfaces_size(0), journal_records(0)
 {
+	memset(journaled_checksum, 0, sizeof(journaled_checksum));
 	memset(&settings_header, 0, sizeof(settings_header_t));
 	strcpy(settings_header.machine_name, vm->machine->getName().toStdString().c_str());
 	strcpy(settings_header.machine_uuid, vm->machine->getUUID().toStdString().c_str());
@@ -41,6 +49,7 @@ VMSettings::VMSettings(VirtualMachine *vm)
 VMSettings::~VMSettings()
 {
 	free(savedIfaces);
+	free(journaledIfaces);
 }
 
 bool VMSettings::operator==(VMSettings *s)
@@ -62,38 +71,170 @@ void VMSettings::backup()
 	savedIfaces_size = vm->ifaces_size;
 }
 
+const settings_iface_t *VMSettings::getSavedIface(int iface) const
+{
+	if(iface < 0 || iface >= savedIfaces_size)
+		return NULL;
+
+	return &savedIfaces[iface];
+}
+
+void VMSettings::backupAttachment(int iface)
+{
+	if(iface < 0 || iface >= savedIfaces_size || iface >= vm->ifaces_size)
+		return;
+
+	settings_iface_t settings_iface = vm->ifaces[iface]->getSerializableIface();
+	savedIfaces[iface].attachmentType = settings_iface.attachmentType;
+	memcpy(savedIfaces[iface].attachmentData, settings_iface.attachmentData, sizeof(settings_iface.attachmentData));
+}
+
 bool VMSettings::save(QString selected_filename)
 {
 	if(selected_filename.isEmpty())
 		selected_filename = fileName;
 
-	CRC32 crc32;
 	char *serializedIfaces = NULL;
-	uint32_t size = serialize(&serializedIfaces, savedIfaces, savedIfaces_size);
+	uint32_t size = get_savable_settings(&serializedIfaces);
+	fileName = selected_filename;
 
-	settings_header.settings_iface_size = savedIfaces_size;
+	//Queued journal entries for this file must not overwrite it later
+	VMSettingsJournal::instance()->sync();
 
-	QFile file(selected_filename);
-	fileName = selected_filename;
+	bool retval = write_file(selected_filename, &settings_header, serializedIfaces, size);
+	free(serializedIfaces);
+
+	if(retval)
+	{
+		unlink((selected_filename + JOURNAL_SUFFIX).toStdString().c_str());
+		reset_journal();
+	}
+
+	return retval;
+}
+
+bool VMSettings::write_file(QString fileName, settings_header_t *settings_header, char *serialized_ifaces, uint32_t serialized_ifaces_size)
+{
+	TRACE_SCOPE_ARG("io", "VMSettings::write_file", fileName.toUtf8().constData());
+
+	std::string path = fileName.toStdString();
+	std::string temp_path = path + ".tmp";
+
+	int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		return false;
+
+	const char *magicBytes = "M" SAVEFILE_MAGIC_BYTES;
+	bool succeeded = (::write(fd, magicBytes, strlen(magicBytes)) == strlen(magicBytes));
+	succeeded = succeeded && (::write(fd, settings_header, sizeof(settings_header_t)) == sizeof(settings_header_t));
+	succeeded = succeeded && (::write(fd, serialized_ifaces, serialized_ifaces_size) == serialized_ifaces_size);
+	succeeded = succeeded && (fsync(fd) == 0);
+	::close(fd);
+
+	if(!succeeded || rename(temp_path.c_str(), path.c_str()) < 0)
+	{
+		unlink(temp_path.c_str());
+		return false;
+	}
+
+	//Make the rename itself durable
+	int dir_fd = ::open(QFileInfo(fileName).absolutePath().toStdString().c_str(), O_RDONLY);
+	if(dir_fd >= 0)
+	{
+		fsync(dir_fd);
+		::close(dir_fd);
+	}
+
+	return true;
+}
+
+uint32_t VMSettings::get_savable_settings(char **serialized_ifaces)
+{
+	uint32_t size = serialize(serialized_ifaces, savedIfaces, savedIfaces_size);
+	settings_header.settings_iface_size = savedIfaces_size;
 
 	//Calculate CRC32 of ifaces settings
-		
-	std::string ifaces_checksum_str = get_ifaces_checksum(&serializedIfaces, savedIfaces_size);
+	std::string ifaces_checksum_str = get_ifaces_checksum(serialized_ifaces, savedIfaces_size);
 	std::transform(ifaces_checksum_str.begin(), ifaces_checksum_str.end(), ifaces_checksum_str.begin(), toupper_wrapper);
-
 	strcpy(settings_header.ifaces_checksum, ifaces_checksum_str.c_str());
-	
-	if(file.open(QIODevice::WriteOnly))
+
+	return size;
+}
+
+void VMSettings::reset_journal()
+{
+	journaledIfaces = (settings_iface_t *)realloc(journaledIfaces, savedIfaces_size * sizeof(settings_iface_t));
+	memcpy(journaledIfaces, savedIfaces, savedIfaces_size * sizeof(settings_iface_t));
+	journaledIfaces_size = savedIfaces_size;
+
+	char *serialized_ifaces = NULL;
+	get_savable_settings(&serialized_ifaces);
+	free(serialized_ifaces);
+
+	strcpy(journaled_checksum, settings_header.ifaces_checksum);
+	journal_records = 0;
+}
+
+void VMSettings::journal()
+{
+	//Journaling starts once settings are associated to a save file
+	if(fileName.isEmpty() || journaledIfaces == NULL)
+		return;
+
+	std::vector<uint8_t> changed_ifaces;
+	for(int i = 0; i < savedIfaces_size; i++)
+		if(i >= journaledIfaces_size || memcmp(&savedIfaces[i], &journaledIfaces[i], sizeof(settings_iface_t)))
+			changed_ifaces.push_back(i);
+
+	if(changed_ifaces.empty() && savedIfaces_size == journaledIfaces_size)
+		return;
+
+	char *serialized_ifaces = NULL;
+	uint32_t size = get_savable_settings(&serialized_ifaces);
+
+	journal_entry_t *entry = new journal_entry_t;
+	entry->fileName = fileName.toStdString();
+	entry->settings_header = settings_header;
+
+	if(++journal_records >= JOURNAL_COMPACT_RECORDS)
 	{
-		uint32_t bytes_written = file.write("M" SAVEFILE_MAGIC_BYTES);
-		bytes_written += file.write((char *)&settings_header, sizeof(settings_header_t));
-		bytes_written += file.write(serializedIfaces, size);
-		
-		file.close();
-		return bytes_written == size + sizeof(settings_header_t) + 1 + strlen(SAVEFILE_MAGIC_BYTES);
+		entry->type = JOURNAL_COMPACT;
+		entry->data = serialized_ifaces;
+		entry->data_size = size;
+		journal_records = 0;
 	}
 	else
-		return false;
+	{
+		uint8_t changed_ifaces_size = changed_ifaces.size();
+
+		entry->type = JOURNAL_APPEND;
+		entry->data_size = sizeof(journaled_checksum) + sizeof(settings_header_t) + sizeof(uint8_t) + changed_ifaces_size * (sizeof(uint8_t) + sizeof(settings_iface_t));
+		entry->data = (char *)malloc(entry->data_size);
+
+		char *record = entry->data;
+		memcpy(record, journaled_checksum, sizeof(journaled_checksum));
+		record += sizeof(journaled_checksum);
+		memcpy(record, &settings_header, sizeof(settings_header_t));
+		record += sizeof(settings_header_t);
+		memcpy(record, &changed_ifaces_size, sizeof(uint8_t));
+		record += sizeof(uint8_t);
+
+		for(int i = 0; i < changed_ifaces_size; i++)
+		{
+			memcpy(record, &changed_ifaces.at(i), sizeof(uint8_t));
+			memcpy(record + sizeof(uint8_t), &savedIfaces[changed_ifaces.at(i)], sizeof(settings_iface_t));
+			record += sizeof(uint8_t) + sizeof(settings_iface_t);
+		}
+
+		free(serialized_ifaces);
+	}
+
+	VMSettingsJournal::instance()->push(entry);
+
+	journaledIfaces = (settings_iface_t *)realloc(journaledIfaces, savedIfaces_size * sizeof(settings_iface_t));
+	memcpy(journaledIfaces, savedIfaces, savedIfaces_size * sizeof(settings_iface_t));
+	journaledIfaces_size = savedIfaces_size;
+	strcpy(journaled_checksum, settings_header.ifaces_checksum);
 }
 
 read_result_t VMSettings::read(settings_header_t *settings_header, char **serialized_ifaces, QString selected_filename)
@@ -133,6 +274,9 @@ read_result_t VMSettings::read(settings_header_t *settings_header, char **serial
 
 			if(strcmp(settings_header->ifaces_checksum, ifaces_checksum_str.c_str()))
 				return E_INVALID_CHECKSUM;
+
+			//Apply changes saved after the last compaction
+			VMSettingsJournal::replay(selected_filename, settings_header, serialized_ifaces);
 			if(strcmp(settings_header->machine_uuid, vm->machine->getUUID().toStdString().c_str()))
 				return E_MACHINE_MISMATCH;
 			return NO_ERROR;
@@ -146,6 +290,7 @@ read_result_t VMSettings::read(settings_header_t *settings_header, char **serial
 void VMSettings::load(settings_header_t settings_header, char *settings_ifaces)
 {
 	savedIfaces_size = deserialize(&savedIfaces, settings_ifaces, settings_header.settings_iface_size);
+	reset_journal();
 }
 
 uint32_t VMSettings::get_serializable_machine(settings_header_t *settings_header, char **serialized_ifaces)
@@ -161,19 +306,7 @@ uint32_t VMSettings::get_serializable_machine(settings_header_t *settings_header
 	return serialized_ifaces_size;
 }
 
-std::string VMSettings::get_ifaces_checksum(char **serialized_ifaces, int serialized_ifaces_size)
-{
-	CRC32 crc32;
-	return crc32(*serialized_ifaces, serialized_ifaces_size * sizeof(settings_iface_t));
-}
-
-std::string VMSettings::get_ifaces_checksum(settings_header_t settings_header, settings_iface_t *settings_ifaces)
-{
-	CRC32 crc32;
-	return crc32(settings_ifaces, settings_header.settings_iface_size * sizeof(settings_iface_t));
-}
-
-bool VMSettings::set_machine(settings_header_t _settings_header, settings_iface_t *_settings_ifaces)
+bool VMSettings::set_machine(settings_header_t _settings_header, const settings_iface_view_t *_settings_ifaces)
 {
 	if(get_ifaces_checksum(_settings_header, _settings_ifaces) != _settings_header.ifaces_checksum)
 		return false;
@@ -187,22 +320,7 @@ bool VMSettings::set_machine(settings_header_t _settings_header, settings_iface_
 	return true;
 }
 
-uint32_t VMSettings::serialize(char **dest, settings_iface_t *src, uint8_t size)
-{
-	*dest = (char *)realloc(*dest, size * sizeof(settings_iface_t));
-	memset(*dest, 0, size * sizeof(settings_iface_t));
-	for(int i = 0; i < size; i++)
-		memcpy((*dest)+(i * sizeof(settings_iface_t)), &src[i], sizeof(settings_iface_t));
-
-	return size * sizeof(settings_iface_t);
-}
-
-uint8_t VMSettings::deserialize(settings_iface_t **dest, char *src, uint8_t size)
+bool VMSettings::write_machines(QString fileName, std::vector<VirtualMachine*> vm_vec, char type, QString base_fileName)
 {
-	*dest = (settings_iface_t *)realloc(*dest, size * sizeof(settings_iface_t));
-	memset(*dest, 0, size * sizeof(settings_iface_t));
-	for(int i = 0; i < (int) size; i++)
-		memcpy((*dest+i), src+(i * sizeof(settings_iface_t)), sizeof(settings_iface_t));
-
-	return size;
+	return MachinesArchive::writeSnapshot(fileName, MachinesArchive::snapshot(vm_vec), type, base_fileName);
 }
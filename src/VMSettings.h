@@ -64,6 +64,13 @@ typedef struct
 	uint8_t settings_iface_size;
 } settings_header_t;
 
+/**
+ * Machine records are packed back to back inside a machines set file, so an
+ * iface record read in place can start at any byte offset. This type has the
+ * same layout of settings_iface_t but no alignment requirement.
+ */
+typedef settings_iface_t settings_iface_view_t __attribute__((aligned(1)));
+
 typedef enum
 {
         NO_ERROR,
@@ -76,10 +83,12 @@ typedef enum
 } read_result_t;
 
 class MachinesDialog;
+class MachinesArchive;
 
 class VMSettings
 {
 	friend class MachinesDialog;
+	friend class MachinesArchive;
 
 	public:
 		VMSettings(VirtualMachine *vm);
@@ -88,7 +97,26 @@ class VMSettings
 		void backup();
 		void restore();
 
+		/**
+		 * This function returns the last applied settings of iface, NULL
+		 * if iface was not present at the last backup
+		 */
+		const settings_iface_t *getSavedIface(int iface) const;
+
+		/**
+		 * This function updates attachment type and data of iface in the
+		 * last applied settings, after they are changed on a running machine
+		 */
+		void backupAttachment(int iface);
+
 		bool save(QString selected_filename = "");
+
+		/**
+		 * Queues the ifaces changed since the last journal record to the
+		 * journal of fileName, compacting it into fileName every
+		 * JOURNAL_COMPACT_RECORDS records (see VMSettingsJournal.h)
+		 */
+		void journal();
 		read_result_t read(settings_header_t *settings_header, char **settings_ifaces, QString selected_filename);
 		void load(settings_header_t settings_header, char *settings_ifaces);
 
@@ -96,8 +124,8 @@ class VMSettings
 		QString fileName;
 		settings_header_t settings_header;
 		static std::string get_ifaces_checksum(char **serialized_ifaces, int serialized_ifaces_size);
-		static std::string get_ifaces_checksum(settings_header_t settings_header, settings_iface_t *settings_ifaces);
-		bool set_machine(settings_header_t settings_header, settings_iface_t *settings_ifaces);
+		static std::string get_ifaces_checksum(settings_header_t settings_header, const settings_iface_view_t *settings_ifaces);
+		bool set_machine(settings_header_t settings_header, const settings_iface_view_t *settings_ifaces);
 
 		/**
 		 * Allocate SIZE * sizeof(settings_iface_t) bytes in DEST and copies
@@ -111,12 +139,33 @@ class VMSettings
 		 */
 		static uint8_t deserialize(settings_iface_t **dest, char *src, uint8_t size);
 
+		/**
+		 * Writes a machine save file to a temporary file, syncs it and
+		 * renames it to FILENAME, so FILENAME is never left half written
+		 */
+		static bool write_file(QString fileName, settings_header_t *settings_header, char *serialized_ifaces, uint32_t serialized_ifaces_size);
+
+		/**
+		 * Writes the current settings of VM_VEC to a machines set file of
+		 * the specified TYPE (see MachinesArchive::write). Machines matching
+		 * the base archive of a delta archive by name and ifaces checksum
+		 * are skipped.
+		 */
+		static bool write_machines(QString fileName, std::vector<VirtualMachine*> vm_vec, char type, QString base_fileName = "");
+
 	private:
 		uint32_t get_serializable_machine(settings_header_t *settings_header, char **settings_ifaces);
+		uint32_t get_savable_settings(char **serialized_ifaces);
+		void reset_journal();
 
 		VirtualMachine *vm;
 		settings_iface_t *savedIfaces;
 		uint8_t savedIfaces_size;
+
+		settings_iface_t *journaledIfaces;
+		uint8_t journaledIfaces_size;
+		char journaled_checksum[10];
+		int journal_records;
 };
 
 #endif //VMSETTINGS_H
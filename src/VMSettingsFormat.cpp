@@ -0,0 +1,61 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Settings format helpers of VMSettings, which need no machine
+ */
+
+#include "VMSettings.h"
+#include "crc32.h"
+#include <malloc.h>
+#include <string.h>
+
+std::string VMSettings::get_ifaces_checksum(char **serialized_ifaces, int serialized_ifaces_size)
+{
+	CRC32 crc32;
+	return crc32(*serialized_ifaces, serialized_ifaces_size * sizeof(settings_iface_t));
+}
+
+std::string VMSettings::get_ifaces_checksum(settings_header_t settings_header, const settings_iface_view_t *settings_ifaces)
+{
+	CRC32 crc32;
+	return crc32(settings_ifaces, settings_header.settings_iface_size * sizeof(settings_iface_t));
+}
+
+uint32_t VMSettings::serialize(char **dest, settings_iface_t *src, uint8_t size)
+{
+	*dest = (char *)realloc(*dest, size * sizeof(settings_iface_t));
+	memset(*dest, 0, size * sizeof(settings_iface_t));
+	for(int i = 0; i < size; i++)
+		memcpy((*dest)+(i * sizeof(settings_iface_t)), &src[i], sizeof(settings_iface_t));
+
+	return size * sizeof(settings_iface_t);
+}
+
+uint8_t VMSettings::deserialize(settings_iface_t **dest, char *src, uint8_t size)
+{
+	*dest = (settings_iface_t *)realloc(*dest, size * sizeof(settings_iface_t));
+	memset(*dest, 0, size * sizeof(settings_iface_t));
+	for(int i = 0; i < (int) size; i++)
+		memcpy((*dest+i), src+(i * sizeof(settings_iface_t)), sizeof(settings_iface_t));
+
+	return size;
+}
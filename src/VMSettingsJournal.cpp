@@ -0,0 +1,242 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "VMSettingsJournal.h"
+#include "Trace.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <QFile>
+#include <QByteArray>
+
+VMSettingsJournal *VMSettingsJournal::__instance = NULL;
+static pthread_mutex_t __instance_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+VMSettingsJournal::VMSettingsJournal()
+: busy(false), stop(false)
+{
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&cond, NULL);
+	pthread_cond_init(&idle_cond, NULL);
+	pthread_create(&thread, NULL, writerThread, this);
+}
+
+VMSettingsJournal::~VMSettingsJournal()
+{
+	pthread_mutex_lock(&mutex);
+	stop = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	pthread_join(thread, NULL);
+
+	pthread_cond_destroy(&idle_cond);
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+}
+
+VMSettingsJournal *VMSettingsJournal::instance()
+{
+	//Settings may be saved from several import threads at once
+	pthread_mutex_lock(&__instance_mutex);
+	if(__instance == NULL)
+		__instance = new VMSettingsJournal();
+	VMSettingsJournal *journal = __instance;
+	pthread_mutex_unlock(&__instance_mutex);
+
+	return journal;
+}
+
+void VMSettingsJournal::shutdown()
+{
+	pthread_mutex_lock(&__instance_mutex);
+	delete __instance;
+	__instance = NULL;
+	pthread_mutex_unlock(&__instance_mutex);
+}
+
+void VMSettingsJournal::push(journal_entry_t *__entry)
+{
+	pthread_mutex_lock(&mutex);
+	queue.push_back(__entry);
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+}
+
+void VMSettingsJournal::sync()
+{
+	pthread_mutex_lock(&mutex);
+	while(busy || !queue.empty())
+		pthread_cond_wait(&idle_cond, &mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+void *VMSettingsJournal::writerThread(void *__journal)
+{
+	VMSettingsJournal *journal = (VMSettingsJournal *)__journal;
+
+	pthread_mutex_lock(&journal->mutex);
+	while(true)
+	{
+		while(journal->queue.empty() && !journal->stop)
+			pthread_cond_wait(&journal->cond, &journal->mutex);
+
+		//Pending entries are written before stopping
+		if(journal->queue.empty())
+			break;
+
+		journal_entry_t *entry = journal->queue.front();
+		journal->queue.pop_front();
+		journal->busy = true;
+		pthread_mutex_unlock(&journal->mutex);
+
+		journal->write(entry);
+		free(entry->data);
+		delete entry;
+
+		pthread_mutex_lock(&journal->mutex);
+		journal->busy = false;
+		if(journal->queue.empty())
+			pthread_cond_broadcast(&journal->idle_cond);
+	}
+	pthread_mutex_unlock(&journal->mutex);
+
+	return NULL;
+}
+
+void VMSettingsJournal::write(journal_entry_t *__entry)
+{
+	TRACE_SCOPE_ARG("io", "VMSettingsJournal::write", __entry->fileName.c_str());
+
+	std::string journal_fileName = __entry->fileName + JOURNAL_SUFFIX;
+
+	switch(__entry->type)
+	{
+		case JOURNAL_APPEND:
+		{
+			int fd = ::open(journal_fileName.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+			if(fd < 0)
+			{
+				std::cerr << "Cannot open journal " << journal_fileName << std::endl;
+				return;
+			}
+
+			bool succeeded = (::write(fd, &__entry->data_size, sizeof(uint32_t)) == sizeof(uint32_t));
+			succeeded = succeeded && (::write(fd, __entry->data, __entry->data_size) == __entry->data_size);
+			succeeded = succeeded && (fdatasync(fd) == 0);
+			::close(fd);
+
+			if(!succeeded)
+				std::cerr << "Cannot write journal " << journal_fileName << std::endl;
+			break;
+		}
+		case JOURNAL_COMPACT:
+		{
+			if(VMSettings::write_file(QString::fromStdString(__entry->fileName), &__entry->settings_header, __entry->data, __entry->data_size))
+				unlink(journal_fileName.c_str());
+			else
+				std::cerr << "Cannot compact journal " << journal_fileName << std::endl;
+			break;
+		}
+	}
+}
+
+int VMSettingsJournal::replay(QString __fileName, settings_header_t *__settings_header, char **__serialized_ifaces)
+{
+	QFile file(__fileName + JOURNAL_SUFFIX);
+	if(!file.open(QIODevice::ReadOnly))
+		return 0;
+
+	QByteArray journal = file.readAll();
+	file.close();
+
+	const uint32_t record_min_size = sizeof(__settings_header->ifaces_checksum) + sizeof(settings_header_t) + sizeof(uint8_t);
+	const uint32_t change_size = sizeof(uint8_t) + sizeof(settings_iface_t);
+
+	int applied_records = 0;
+	uint32_t offset = 0;
+
+	while(journal.size() - offset >= sizeof(uint32_t))
+	{
+		uint32_t record_size;
+		memcpy(&record_size, journal.constData() + offset, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+
+		//Last record may have been truncated by a crash
+		if(record_size < record_min_size || record_size > journal.size() - offset)
+			break;
+
+		const char *record = journal.constData() + offset;
+		offset += record_size;
+
+		char previous_checksum[sizeof(__settings_header->ifaces_checksum)];
+		settings_header_t settings_header;
+		uint8_t changed_ifaces;
+
+		memcpy(previous_checksum, record, sizeof(previous_checksum));
+		memcpy(&settings_header, record + sizeof(previous_checksum), sizeof(settings_header_t));
+		memcpy(&changed_ifaces, record + sizeof(previous_checksum) + sizeof(settings_header_t), sizeof(uint8_t));
+		previous_checksum[sizeof(previous_checksum) - 1] = '\0';
+		settings_header.ifaces_checksum[sizeof(settings_header.ifaces_checksum) - 1] = '\0';
+
+		if(strcasecmp(previous_checksum, __settings_header->ifaces_checksum))
+			continue;
+
+		if(record_size != record_min_size + changed_ifaces * change_size)
+			break;
+
+		uint32_t old_size = __settings_header->settings_iface_size * sizeof(settings_iface_t);
+		uint32_t new_size = settings_header.settings_iface_size * sizeof(settings_iface_t);
+		char *serialized_ifaces = (char *)malloc(new_size);
+		memset(serialized_ifaces, 0, new_size);
+		memcpy(serialized_ifaces, *__serialized_ifaces, (old_size < new_size) ? old_size : new_size);
+
+		const char *change = record + record_min_size;
+		bool valid = true;
+		for(int i = 0; i < changed_ifaces && valid; i++, change += change_size)
+		{
+			uint8_t iface = (uint8_t) change[0];
+			if(iface >= settings_header.settings_iface_size)
+				valid = false;
+			else
+				memcpy(serialized_ifaces + iface * sizeof(settings_iface_t), change + sizeof(uint8_t), sizeof(settings_iface_t));
+		}
+
+		if(!valid || strcasecmp(VMSettings::get_ifaces_checksum(&serialized_ifaces, settings_header.settings_iface_size).c_str(), settings_header.ifaces_checksum))
+		{
+			free(serialized_ifaces);
+			break;
+		}
+
+		free(*__serialized_ifaces);
+		*__serialized_ifaces = serialized_ifaces;
+		*__settings_header = settings_header;
+		applied_records++;
+	}
+
+	if(applied_records > 0)
+		std::cout << "Recovered " << applied_records << " journal records for " << __fileName.toStdString() << std::endl;
+
+	return applied_records;
+}
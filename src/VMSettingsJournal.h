@@ -0,0 +1,122 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef VMSETTINGSJOURNAL_H
+#define VMSETTINGSJOURNAL_H
+
+#include <QString>
+#include <string>
+#include <deque>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "VMSettings.h"
+
+#define JOURNAL_SUFFIX ".journal"
+
+/** Number of journal records after which the machine save file is rewritten */
+#define JOURNAL_COMPACT_RECORDS 16
+
+/**
+ * Format for journal record, appended to <machine save file>.journal:
+ * 	record lenght				[   4 B]
+ * 	previous ifaces checksum		[  10 B]
+ * 	header (see VMSettings.h)		[2059 B]
+ * 	number of changed ifaces		[   1 B]
+ * 	changed iface #1:
+ * 		iface index			[   1 B]
+ * 		iface data (see VMSettings.h)	[sizeof(settings_iface_t)]
+ * 	changed iface #n
+ *
+ * Iface data is copied as a whole settings_iface_t, so it includes the
+ * padding after the 5186 B of fields listed in VMSettings.h.
+ *
+ * A record is replayed only if the ifaces checksum of the current settings
+ * matches its previous ifaces checksum and the result matches the checksum
+ * in its header, so stale or truncated records are never applied.
+ */
+
+typedef enum
+{
+	JOURNAL_APPEND,
+	JOURNAL_COMPACT
+} journal_entry_type_t;
+
+typedef struct
+{
+	journal_entry_type_t type;
+	std::string fileName;
+	settings_header_t settings_header;
+	char *data;
+	uint32_t data_size;
+} journal_entry_t;
+
+/**
+ * Background writer for machine settings journals. Entries are queued by the
+ * GUI thread and written by a single thread, so saving settings never waits
+ * for the disk.
+ */
+class VMSettingsJournal
+{
+	public:
+		static VMSettingsJournal *instance();
+
+		/**
+		 * This function queues __entry, which is freed once written
+		 */
+		void push(journal_entry_t *__entry);
+
+		/**
+		 * This function waits until every queued entry has been written
+		 */
+		void sync();
+
+		/**
+		 * This function writes pending entries and stops the writer thread
+		 */
+		static void shutdown();
+
+		/**
+		 * This function applies to __serialized_ifaces the journal records
+		 * of __fileName which follow __settings_header, updating both.
+		 * This function returns the number of applied records.
+		 */
+		static int replay(QString __fileName, settings_header_t *__settings_header, char **__serialized_ifaces);
+
+	private:
+		VMSettingsJournal();
+		virtual ~VMSettingsJournal();
+
+		static void *writerThread(void *__journal);
+		void write(journal_entry_t *__entry);
+
+		static VMSettingsJournal *__instance;
+
+		std::deque<journal_entry_t*> queue;
+		pthread_t thread;
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		pthread_cond_t idle_cond;
+		bool busy;
+		bool stop;
+};
+
+#endif //VMSETTINGSJOURNAL_H
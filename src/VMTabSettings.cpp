@@ -22,6 +22,9 @@
 #include "VMTabSettings.h"
 #include "VirtualBoxBridge.h"
 #include "VMSettings.h"
+#include "ProgressDialog.h"
+#include "VMCommandExecutor.h"
+#include "Log.h"
 #include <QTabWidget>
 
 #include <QString>
@@ -35,12 +38,12 @@
 #include <QHeaderView>
 
 #include <iostream>
+#include <algorithm>
 
 VMTabSettings::VMTabSettings(QTabWidget *parent, QString tabname, VirtualBoxBridge *vboxbridge, MachineBridge *machine, std::string vhd_mountpoint, std::string partition_mountpoint_prefix) : QWidget(parent)
-, vboxbridge(vboxbridge), machine(machine), vm(new VirtualMachine(machine, vhd_mountpoint, partition_mountpoint_prefix)), vmSettings(new VMSettings(vm))
+, ifaces_table(NULL), vm(NULL), vhd_mountpoint(vhd_mountpoint), partition_mountpoint_prefix(partition_mountpoint_prefix)
+, buttonBox(NULL), ifaces(NULL), vboxbridge(vboxbridge), machine(machine), vmSettings(NULL)
 {
-	vm->vmSettings = vmSettings;
-
 	setObjectName(tabname);
 
 	verticalLayout = new QVBoxLayout(this);
@@ -53,7 +56,31 @@ VMTabSettings::VMTabSettings(QTabWidget *parent, QString tabname, VirtualBoxBrid
 	vm_enabled->setObjectName(QString::fromUtf8("vm_enabled"));
 	verticalLayout->addWidget(vm_enabled);
 
-	ifaces_table = new IfacesTable(this, verticalLayout, vboxbridge, machine, vm->getIfaces());
+	connect(vm_enabled, SIGNAL(toggled(bool)), this, SLOT(vm_enabledSlot(bool)));
+}
+
+VMTabSettings::~VMTabSettings()
+{
+	delete buttonBox;
+	delete vm;
+
+	delete ifaces_table;
+	delete vm_enabled;
+	delete verticalLayout;
+}
+
+void VMTabSettings::ensureLoaded()
+{
+	if(vm != NULL)
+		return;
+
+	vm = new VirtualMachine(machine, vhd_mountpoint, partition_mountpoint_prefix);
+	vmSettings = new VMSettings(vm);
+	vm->vmSettings = vmSettings;
+	ifaces = vm->getIfaces();
+
+	ifaces_table = new IfacesTable(this, verticalLayout, vboxbridge, machine, ifaces);
+	ifaces_table->setDisabled(!vm_enabled->isChecked());
 	verticalLayout->addWidget(ifaces_table);
 
 	buttonBox = new QDialogButtonBox(this);
@@ -71,26 +98,53 @@ VMTabSettings::VMTabSettings(QTabWidget *parent, QString tabname, VirtualBoxBrid
 
 	verticalLayout->addWidget(buttonBox);
 
-	connect(vm_enabled, SIGNAL(toggled(bool)), this, SLOT(vm_enabledSlot(bool)));
 	connect(buttonBox, SIGNAL(clicked(QAbstractButton*)), this, SLOT(clickedSlot(QAbstractButton*)));
 
 	refreshTable();
 	connect(ifaces_table, SIGNAL(sigIfaceChange(int, ifacekey_t, void*)), this, SLOT(slotIfaceChange(int, ifacekey_t, void*)));
+	connect(ifaces_table, SIGNAL(ifaceEdited(int)), this, SLOT(slotIfaceEdited(int)));
 	connect(vm, SIGNAL(ifaceChanged(int)), ifaces_table, SLOT(slotRefreshIface(int)));
+	connect(VMCommandExecutor::instance(), SIGNAL(commandFinished(vm_command_result_t)), this, SLOT(slotCommandFinished(vm_command_result_t)));
+
+	//Settings of a machine started before the tab was built are locked now
+	uint32_t machineState = machine->getState();
+	if(machineState == MachineState::Starting ||
+	   machineState == MachineState::Running ||
+	   machineState == MachineState::Paused)
+		lockSettings();
+
+	emit machineLoaded(vm);
 }
 
-VMTabSettings::~VMTabSettings()
+void VMTabSettings::loadAll(const std::vector<VMTabSettings*> &__vmTab_vec)
 {
-	delete buttonBox;
-	delete vm;
+	std::vector<VMTabSettings*> pending;
+	for(int i = 0; i < __vmTab_vec.size(); i++)
+		if(!__vmTab_vec.at(i)->isLoaded())
+			pending.push_back(__vmTab_vec.at(i));
 
-	delete ifaces_table;
-	delete vm_enabled;
-	delete verticalLayout;
+	if(pending.empty())
+		return;
+
+	ProgressDialog p("");
+	p.ui->progressBar->setValue(0);
+	p.show();
+
+	for(int i = 0; i < pending.size(); i++)
+	{
+		p.ui->label->setText(QString::fromUtf8("Caricamento macchina \"").append(pending.at(i)->getMachineName()).append("\""));
+		p.refresh();
+		pending.at(i)->ensureLoaded();
+		p.ui->progressBar->setValue(((i+1)*100)/pending.size());
+		p.refresh();
+	}
 }
 
 void VMTabSettings::refreshTable()
 {
+	if(vm == NULL)
+		return;
+
 	vm->mountVpartition(OS_PARTITION_NUMBER, true);
 	for(int row = 0; row < ifaces_table->rowCount(); row++)
 	{
@@ -118,6 +172,9 @@ void VMTabSettings::refreshTable()
 
 void VMTabSettings::refreshTableUI()
 {
+	if(vm == NULL)
+		return;
+
 	ifaces_table->blockSignals(true);
 	for(int row = 0; row < ifaces_table->rowCount(); row++)
 	{
@@ -143,24 +200,12 @@ void VMTabSettings::clickedSlot(QAbstractButton *button)
 		case QDialogButtonBox::Apply:
 		{
 			uint32_t machineState = machine->getState();
-			if(machineState == MachineState::Starting ||
-			   machineState == MachineState::Running ||
-			   machineState == MachineState::Paused)
-				std::cout << "vm->saveSettingsRuntime(): " << std::string(vm->saveSettingsRunTime() ? "true" : "false") << std::endl;
-			else
-				std::cout << "vm->saveSettings(): " << std::string(vm->saveSettings() ? "true" : "false") << std::endl;
+			bool runTime = (machineState == MachineState::Starting ||
+					machineState == MachineState::Running ||
+					machineState == MachineState::Paused);
 
-/*
-			for (int i = 0; i < 8; i++)
-			{
-				QStringList iface_info = ifaces_table->getIfaceInfo(i);
-				int j;
-				for(j = 0; j < iface_info.size() - 1; j++)
-					std::cout << iface_info.at(j).toStdString() << " \t";
-				std::cout << iface_info.at(j).toStdString() << std::endl;
-			}
-*/
-			refreshTable();
+			lockForSave();
+			VMCommandExecutor::instance()->saveSettings(vm, runTime);
 			break;
 		}
 		case QDialogButtonBox::Reset:
@@ -171,9 +216,42 @@ void VMTabSettings::clickedSlot(QAbstractButton *button)
 	}
 }
 
+void VMTabSettings::lockForSave()
+{
+	//The table is read only until the settings are saved, see slotCommandFinished()
+	ifaces_table->setDisabled(true);
+	buttonBox->setDisabled(true);
+}
+
+void VMTabSettings::slotCommandFinished(vm_command_result_t result)
+{
+	bool saved = (result.type == VM_COMMAND_SAVE_SETTINGS && result.vm == vm) ||
+		     (result.type == VM_COMMAND_SAVE_SETTINGS_RUNTIME && vm != NULL &&
+		      std::find(result.vm_vec.begin(), result.vm_vec.end(), vm) != result.vm_vec.end());
+	if(!saved)
+		return;
+
+	LOG_DEBUG(LOG_GUI, "vm->saveSettings(): %s", result.succeeded ? "true" : "false");
+	vboxbridge->getHostNetworkCatalog()->invalidate(NetworkAttachmentType::Internal);
+
+	refreshTable();
+	buttonBox->setEnabled(true);
+	vm_enabledSlot(vm_enabled->isChecked());
+
+	//The refreshed table is editable again as allowed by the current machine state
+	uint32_t machineState = machine->getState();
+	if(machineState == MachineState::Starting ||
+	   machineState == MachineState::Running ||
+	   machineState == MachineState::Paused)
+		lockSettings();
+	else
+		unlockSettings();
+}
+
 void VMTabSettings::vm_enabledSlot(bool checked)
 {
-	ifaces_table->setDisabled(!checked);
+	if(ifaces_table != NULL)
+		ifaces_table->setDisabled(!checked);
 }
 
 void VMTabSettings::slotIfaceChange(int iface, ifacekey_t key, void *value_ptr)
@@ -181,14 +259,26 @@ void VMTabSettings::slotIfaceChange(int iface, ifacekey_t key, void *value_ptr)
 	vm->setNetworkAdapterData(iface, key, value_ptr);
 }
 
+void VMTabSettings::slotIfaceEdited(int iface)
+{
+	//Indexes over the ifaces of every machine follow the edits before they are applied
+	emit vm->attachmentChanged(vm, iface);
+}
+
 void VMTabSettings::lockSettings()
 {
+	if(ifaces_table == NULL)
+		return;
+
 	ifaces_table->lockSettings();
 // 	buttonBox->button(QDialogButtonBox::Apply)->setEnabled(false);
 }
 
 void VMTabSettings::unlockSettings()
 {
+	if(ifaces_table == NULL)
+		return;
+
 	ifaces_table->unlockSettings();
 // 	buttonBox->button(QDialogButtonBox::Apply)->setEnabled(true);
 }
@@ -198,30 +288,6 @@ bool VMTabSettings::hasThisMachine(MachineBridge *_machine)
 	return machine == _machine;
 }
 
-bool VMTabSettings::setMachineName(const QString &qName)
-{
-	bool succeeded = true;
-
-	if(!machine->lockMachine())
-	{
-		std::cerr << "[" << machine->getName().toStdString() <<  "] Cannot lock machine" << std::endl;
-		return false;
-	}
-
-	if(!machine->setName(qName))
-	{
-		std::cout << "setName(" << qName.toStdString() << "): false" << std::endl;
-		succeeded = false;
-	}
-
-	machine->saveSettings();
-
-	if(!machine->unlockMachine())
-		return false;
-
-	return succeeded;
-}
-
 bool VMTabSettings::setMachineUUID(const char *uuid)
 {
 	bool succeeded = true;
@@ -23,6 +23,7 @@
 #define VMTABSETTINGS_H
 
 #include <vector>
+#include <string>
 #include <QWidget>
 #include <QCheckBox>
 #include <QVBoxLayout>
@@ -34,17 +35,24 @@
 #include "VirtualBoxBridge.h"
 #include "SummaryDialog.h"
 #include "VMSettings.h"
+#include "VMCommandExecutor.h"
 
 class MachinesDialog;
 class MainWindow;
 
+/**
+ * Tab of a virtual machine. The tab is built as a placeholder holding only
+ * its MachineBridge: the VirtualMachine, which reads the guest disk, and the
+ * ifaces table are built when the tab is first shown or when an operation
+ * needs them (see getVM()).
+ */
 class VMTabSettings : public QWidget
 {
 	friend class MachinesDialog;
 	friend class MainWindow;
 	friend class IfacesTable;
-	friend class AttachmentDataWidget;
 	friend class SummaryDialog;
+	friend class OperationsDialog;
 
 	Q_OBJECT
 	
@@ -56,14 +64,40 @@ class VMTabSettings : public QWidget
 		void refreshTableUI();
 		void lockSettings();
 		void unlockSettings();
+
+		/**
+		 * This function makes the tab read only until the settings queued
+		 * for saving are saved
+		 */
+		void lockForSave();
 		bool hasThisMachine(MachineBridge *_machine);
-		QString getMachineName() const { return vm->machine->getName(); };
-		bool setMachineName(const QString &qName);
-		QString getMachineUUID() const { return vm->machine->getUUID(); };
+		QString getMachineName() const { return machine->getName(); };
+		QString getMachineUUID() const { return machine->getUUID(); };
 		bool setMachineUUID(const char *uuid);
-		VirtualMachine *vm;
-		
+
+		/**
+		 * This function builds the virtual machine and the ifaces table of
+		 * the tab, if not built yet
+		 */
+		void ensureLoaded();
+		bool isLoaded() const { return vm != NULL; };
+
+		/**
+		 * This function returns the virtual machine of the tab, building it
+		 * if needed
+		 */
+		VirtualMachine *getVM() { ensureLoaded(); return vm; };
+
+		/**
+		 * This function builds every tab in __vmTab_vec not built yet,
+		 * showing a progress dialog
+		 */
+		static void loadAll(const std::vector<VMTabSettings*> &__vmTab_vec);
+
 	private:
+		VirtualMachine *vm;
+		std::string vhd_mountpoint;
+		std::string partition_mountpoint_prefix;
 		QCheckBox *vm_enabled;
 		QWidget *vm_tab;
 		QVBoxLayout *verticalLayout;
@@ -77,6 +111,11 @@ class VMTabSettings : public QWidget
 		void clickedSlot(QAbstractButton*);
 		void vm_enabledSlot(bool checked);
 		void slotIfaceChange(int iface, ifacekey_t key, void *value_ptr);
+		void slotIfaceEdited(int iface);
+		void slotCommandFinished(vm_command_result_t result);
+
+	signals:
+		void machineLoaded(VirtualMachine *vm);
 };
 
 #endif //VMTABSETTINGS_H
@@ -22,6 +22,8 @@
 #define VBOX_WITH_XPCOM
 
 #include "VirtualBoxBridge.h"
+#include "MacAllocator.h"
+#include "AddressParser.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,6 +33,7 @@
 #include <QPointer>
 #include <QStringList>
 #include <QRegExp>
+#include <QSet>
 
 /*
  * Include the XPCOM headers
@@ -62,7 +65,9 @@
 #include "VirtualBox_XPCOM.h"
 #include "Iface.h"
 #include "OSBridge.h"
-#include "ProgressDialog.h"
+#ifndef HEADLESS
+	#include "ProgressDialog.h"
+#endif
 #include <QVector>
 #include <QFile>
 
@@ -95,7 +100,7 @@ static void *knockAPI(void *_tparam)
 }
 
 VirtualBoxBridge::VirtualBoxBridge()
-: virtualBox(nsnull)
+: virtualBox(nsnull), hostNetworkCatalog(new HostNetworkCatalog(this)), macAllocator(new MacAllocator())
 {
 	if(initXPCOM())
 	{
@@ -120,6 +125,9 @@ VirtualBoxBridge::VirtualBoxBridge()
 
 VirtualBoxBridge::~VirtualBoxBridge()
 {
+	delete hostNetworkCatalog;
+	delete macAllocator;
+
 	/* this is enough to free the IVirtualBox instance -- smart pointers rule! */
 	virtualBox = nsnull;
 
@@ -272,6 +280,7 @@ std::vector<nsCOMPtr<IHostNetworkInterface> > VirtualBoxBridge::getHostNetworkIn
 
 	uint32_t host_ifaces_size;
 	IHostNetworkInterface **host_ifaces;
+	QSet<QString> names;
 
 	getHost()->GetNetworkInterfaces(&host_ifaces_size, &host_ifaces);
 
@@ -282,20 +291,17 @@ std::vector<nsCOMPtr<IHostNetworkInterface> > VirtualBoxBridge::getHostNetworkIn
 		nsXPIDLString iface_name;
 
 		host_ifaces[i]->GetInterfaceType(&iface_type);
+		if(iface_type != HostNetworkInterfaceType::Bridged)
+			continue;
+
+		//Each name is read once, duplicates are found through a hash set
 		host_ifaces[i]->GetName(getter_Copies(iface_name));
-		if(iface_type == HostNetworkInterfaceType::Bridged)
-		{
-			bool new_iface = true;
-			for(int j = 0; j < i; j++)
-			{
-				nsXPIDLString name;
-				host_ifaces[j]->GetName(getter_Copies(name));
-				if(returnQStringValue(name) == returnQStringValue(iface_name))
-					new_iface = false;
-			}
-			if(new_iface)
-				host_ifaces_vec.push_back(host_ifaces[i]);
-		}
+		QString qName = returnQStringValue(iface_name);
+		if(names.contains(qName))
+			continue;
+
+		names.insert(qName);
+		host_ifaces_vec.push_back(host_ifaces[i]);
 	}
 
 	return host_ifaces_vec;
@@ -307,6 +313,7 @@ std::vector<nsCOMPtr<IHostNetworkInterface> > VirtualBoxBridge::getHostOnlyInter
 
 	uint32_t hostOnly_ifaces_size;
 	IHostNetworkInterface **hostOnly_ifaces;
+	QSet<QString> names;
 
 	getHost()->GetNetworkInterfaces(&hostOnly_ifaces_size, &hostOnly_ifaces);
 
@@ -317,20 +324,16 @@ std::vector<nsCOMPtr<IHostNetworkInterface> > VirtualBoxBridge::getHostOnlyInter
 		nsXPIDLString iface_name;
 		
 		hostOnly_ifaces[i]->GetInterfaceType(&iface_type);
+		if(iface_type != HostNetworkInterfaceType::HostOnly)
+			continue;
+
 		hostOnly_ifaces[i]->GetName(getter_Copies(iface_name));
-		if(iface_type == HostNetworkInterfaceType::HostOnly)
-		{
-			bool new_iface = true;
-			for(int j = 0; j < i; j++)
-			{
-				nsXPIDLString name;
-				hostOnly_ifaces[j]->GetName(getter_Copies(name));
-				if(returnQStringValue(name) == returnQStringValue(iface_name))
-					new_iface = false;
-			}
-			if(new_iface)
-				hostOnly_ifaces_vec.push_back(hostOnly_ifaces[i]);
-		}
+		QString qName = returnQStringValue(iface_name);
+		if(names.contains(qName))
+			continue;
+
+		names.insert(qName);
+		hostOnly_ifaces_vec.push_back(hostOnly_ifaces[i]);
 	}
 
 	return hostOnly_ifaces_vec;
@@ -364,13 +367,7 @@ std::vector<QString> VirtualBoxBridge::getGenericDriversList()
 
 bool VirtualBoxBridge::isNewGenericDriver(QString qGenericDriver)
 {
-	std::vector<QString> genericDriversList = getGenericDriversList();
-
-	for(int i = 0; i < genericDriversList.size(); i++)
-		if(genericDriversList.at(i) == qGenericDriver)
-			return false;
-
-	return true;
+	return !hostNetworkCatalog->contains(NetworkAttachmentType::Generic, qGenericDriver);
 }
 
 std::vector<QString> VirtualBoxBridge::getInternalNetworkList()
@@ -401,13 +398,7 @@ std::vector<QString> VirtualBoxBridge::getInternalNetworkList()
 
 bool VirtualBoxBridge::isNewInternalNetwork(QString qInternalNetwork)
 {
-	std::vector<QString> internalNetwork = getInternalNetworkList();
-
-	for(int i = 0; i < internalNetwork.size(); i++)
-		if(internalNetwork.at(i) == qInternalNetwork)
-			return false;
-
-	return true;
+	return !hostNetworkCatalog->contains(NetworkAttachmentType::Internal, qInternalNetwork);
 }
 
 std::vector<nsCOMPtr<INATNetwork> > VirtualBoxBridge::getNatNetworks()
@@ -424,6 +415,152 @@ std::vector<nsCOMPtr<INATNetwork> > VirtualBoxBridge::getNatNetworks()
 	return natNetworks_vec;
 }
 
+HostNetworkCatalog::HostNetworkCatalog(VirtualBoxBridge *vboxbridge)
+: vboxbridge(vboxbridge)
+{
+
+}
+
+HostNetworkCatalog::~HostNetworkCatalog()
+{
+	for(std::map<uint32_t, catalog_entry_t>::iterator it = entries.begin(); it != entries.end(); ++it)
+		delete it->second.model;
+}
+
+HostNetworkCatalog::catalog_entry_t *HostNetworkCatalog::entry(uint32_t attachmentType)
+{
+	switch(attachmentType)
+	{
+		case NetworkAttachmentType::Bridged:
+		case NetworkAttachmentType::Generic:
+		case NetworkAttachmentType::HostOnly:
+		case NetworkAttachmentType::Internal:
+		case NetworkAttachmentType::NATNetwork:
+			break;
+		default:
+			return NULL;
+	}
+
+	std::map<uint32_t, catalog_entry_t>::iterator it = entries.find(attachmentType);
+	if(it == entries.end())
+	{
+		catalog_entry_t new_entry;
+		new_entry.model = new QStringListModel();
+		new_entry.valid = false;
+		it = entries.insert(std::pair<uint32_t, catalog_entry_t>(attachmentType, new_entry)).first;
+	}
+
+	catalog_entry_t *catalog_entry = &it->second;
+	if(!catalog_entry->valid || catalog_entry->loaded.elapsed() > HOST_NETWORK_CATALOG_TTL)
+	{
+		QStringList names = load(attachmentType);
+
+		//Open editors keep their selection if nothing changed
+		if(names != catalog_entry->model->stringList())
+			catalog_entry->model->setStringList(names);
+
+		catalog_entry->loaded.start();
+		catalog_entry->valid = true;
+	}
+
+	return catalog_entry;
+}
+
+QStringList HostNetworkCatalog::load(uint32_t attachmentType)
+{
+	QStringList names;
+	QSet<QString> known;
+
+	switch(attachmentType)
+	{
+		case NetworkAttachmentType::NATNetwork:
+		{
+			std::vector<nsCOMPtr<INATNetwork> > natNetworks_vec = vboxbridge->getNatNetworks();
+			for(int i = 0; i < natNetworks_vec.size(); i++)
+			{
+				nsXPIDLString name;
+				natNetworks_vec.at(i)->GetNetworkName(getter_Copies(name));
+				names << returnQStringValue(name);
+			}
+			break;
+		}
+		case NetworkAttachmentType::Bridged:
+		case NetworkAttachmentType::HostOnly:
+		{
+			std::vector<nsCOMPtr<IHostNetworkInterface> > host_ifaces_vec;
+			if(attachmentType == NetworkAttachmentType::Bridged)
+				host_ifaces_vec = vboxbridge->getHostNetworkInterfaces();
+			else
+				host_ifaces_vec = vboxbridge->getHostOnlyInterfaces();
+
+			for(int i = 0; i < host_ifaces_vec.size(); i++)
+			{
+				nsXPIDLString name;
+				host_ifaces_vec.at(i)->GetName(getter_Copies(name));
+				names << returnQStringValue(name);
+			}
+			break;
+		}
+		case NetworkAttachmentType::Internal:
+		{
+			std::vector<QString> internalNetworks_vec = vboxbridge->getInternalNetworkList();
+			for(int i = 0; i < internalNetworks_vec.size(); i++)
+				names << internalNetworks_vec.at(i);
+			break;
+		}
+		case NetworkAttachmentType::Generic:
+		{
+			std::vector<QString> genericDrivers_vec = vboxbridge->getGenericDriversList();
+			for(int i = 0; i < genericDrivers_vec.size(); i++)
+				names << genericDrivers_vec.at(i);
+			break;
+		}
+	}
+
+	//Order of VirtualBox is kept, only later duplicates are dropped
+	QStringList unique_names;
+	for(int i = 0; i < names.size(); i++)
+	{
+		if(known.contains(names.at(i)))
+			continue;
+
+		known.insert(names.at(i));
+		unique_names << names.at(i);
+	}
+
+	return unique_names;
+}
+
+QStringListModel *HostNetworkCatalog::model(uint32_t attachmentType)
+{
+	catalog_entry_t *catalog_entry = entry(attachmentType);
+	return (catalog_entry == NULL) ? NULL : catalog_entry->model;
+}
+
+QStringList HostNetworkCatalog::list(uint32_t attachmentType)
+{
+	catalog_entry_t *catalog_entry = entry(attachmentType);
+	return (catalog_entry == NULL) ? QStringList() : catalog_entry->model->stringList();
+}
+
+bool HostNetworkCatalog::contains(uint32_t attachmentType, QString name)
+{
+	return list(attachmentType).contains(name);
+}
+
+void HostNetworkCatalog::invalidate(uint32_t attachmentType)
+{
+	std::map<uint32_t, catalog_entry_t>::iterator it = entries.find(attachmentType);
+	if(it != entries.end())
+		it->second.valid = false;
+}
+
+void HostNetworkCatalog::invalidate()
+{
+	for(std::map<uint32_t, catalog_entry_t>::iterator it = entries.begin(); it != entries.end(); ++it)
+		it->second.valid = false;
+}
+
 IMachine *VirtualBoxBridge::existVM(QString qName)
 {
 	nsXPIDLString name; name.AssignWithConversion(qName.toStdString().c_str());
@@ -447,7 +584,7 @@ IMachine *VirtualBoxBridge::newVM(QString qName)
 
 	nsXPIDLString settingsFile;
 	virtualBox->ComposeMachineFilename(name, NULL, NULL, NULL, getter_Copies(settingsFile));
-	std::cout << "Predicted settings file name: " << returnQStringValue(settingsFile).toStdString() << std::endl;
+	LOG_DEBUG(LOG_VBOX, "Predicted settings file name: %s", returnQStringValue(settingsFile).toStdString().c_str());
 
 	QFile file(returnQStringValue(settingsFile));
 	QFile file_prev(returnQStringValue(settingsFile).append("-prev"));
@@ -455,16 +592,16 @@ IMachine *VirtualBoxBridge::newVM(QString qName)
 	if(file.exists())
 	{
 		if(file.remove())
-			std::cerr  << "Deleted old settings file: " << file.fileName().toStdString() << std::endl;
+			LOG_WARNING(LOG_VBOX, "Deleted old settings file: %s", file.fileName().toStdString().c_str());
 		else
-			std::cerr  << "Error while deleting old settings file: " << file.fileName().toStdString() << std::endl;
+			LOG_ERROR(LOG_VBOX, "Error while deleting old settings file: %s", file.fileName().toStdString().c_str());
 	}
 	if(file_prev.exists())
 	{
 		if(file_prev.remove())
-			std::cerr  << "Deleted old backup settings file: " << file_prev.fileName().toStdString() << std::endl;
+			LOG_WARNING(LOG_VBOX, "Deleted old backup settings file: %s", file_prev.fileName().toStdString().c_str());
 		else
-			std::cerr  << "Error while deleting old backup settings file: " << file_prev.fileName().toStdString() << std::endl;
+			LOG_ERROR(LOG_VBOX, "Error while deleting old backup settings file: %s", file_prev.fileName().toStdString().c_str());
 	}
 
 	do
@@ -475,29 +612,11 @@ IMachine *VirtualBoxBridge::newVM(QString qName)
 		NS_CHECK_AND_DEBUG_ERROR(virtualBox, CreateAppliance(pAppliance.asOutParam()), rc);
 		NS_CHECK_AND_DEBUG_ERROR(pAppliance, Read(pszAbsFilePath, progressRead.asOutParam()), rc);
 
-		QString label = QString::fromUtf8("Caricamento impostazioni macchina \"").append(qName).append("\"...");
-		ProgressDialog p(label);
-		p.ui->progressBar->setValue(0);
-		p.ui->label->setText(label);
-		p.open();
-
-		int32_t resultCode;
-		PRBool progress_completed;
-		do
-		{
-			uint32_t percent;
-			progressRead->GetCompleted(&progress_completed);
-			progressRead->GetPercent(&percent);
-			p.ui->progressBar->setValue(percent);
-			p.refresh();
-			usleep(750000);
-		} while(!progress_completed);
-
-		progressRead->GetResultCode(&resultCode);
+		int32_t resultCode = waitForProgress(progressRead, QString::fromUtf8("Caricamento impostazioni macchina \"").append(qName).append("\"..."));
 
 		if(resultCode != 0)
 		{
-			std::cout << "Appliance read failed -> resultCode: " << resultCode << std::endl;
+			LOG_ERROR(LOG_VBOX, "Appliance read failed -> resultCode: %d", resultCode);
 			break;
 		}
 
@@ -513,9 +632,9 @@ IMachine *VirtualBoxBridge::newVM(QString qName)
 
 		if (NS_FAILED(rc))     // during interpret, after printing warnings
 		{
-			std::cerr << "Fail during interpret:" << std::endl;
-			for(int i; i < aWarnings_size; i++)
-				std::cerr << "Warning: " << aWarnings[i] << std::endl;
+			LOG_ERROR(LOG_VBOX, "Fail during interpret:");
+			for(int i = 0; i < aWarnings_size; i++)
+				LOG_WARNING(LOG_VBOX, "%s", QString::fromUtf16(aWarnings[i]).toStdString().c_str());
 			break;
 		}
 
@@ -568,7 +687,7 @@ IMachine *VirtualBoxBridge::newVM(QString qName)
 						int end_index = disk_image_path.lastIndexOf('/');
 						disk_image_path = disk_image_path.mid(0, end_index).append("/").append(qName).append(".vmdk");
 
-						std::cout << "disk_image_path: " << disk_image_path.toStdString() << std::endl;
+						LOG_DEBUG(LOG_VBOX, "disk_image_path: %s", disk_image_path.toStdString().c_str());
 
 						aVBoxValues[a] = (PRUnichar *)realloc(aVBoxValues[a], sizeof(PRUnichar*) * (disk_image_path.length() + 1));
 						memset(aVBoxValues[a], 0, sizeof(PRUnichar*) * (disk_image_path.length() + 1));
@@ -588,37 +707,20 @@ IMachine *VirtualBoxBridge::newVM(QString qName)
 			// go!
 			ComPtr<IProgress> progress;
 			NS_CHECK_AND_DEBUG_ERROR(pAppliance, ImportMachines(0, NULL, progress.asOutParam()), rc);
-			std::cout << "Wait for importing appliance" << std::endl;
+			LOG_DEBUG(LOG_VBOX, "Wait for importing appliance");
 
-			QString label = QString::fromUtf8("Creazione macchina \"").append(qName).append("\"...");
-			p.ui->progressBar->setValue(0);
-			p.ui->label->setText(label);
-			p.open();
-
-			int32_t resultCode;
-			PRBool progress_completed;
-			do
-			{
-				uint32_t percent;
-				progress->GetCompleted(&progress_completed);
-				progress->GetPercent(&percent);
-				p.ui->progressBar->setValue(percent);
-				p.refresh();
-				usleep(750000);
-			} while(!progress_completed);
-
-			progress->GetResultCode(&resultCode);
+			int32_t resultCode = waitForProgress(progress, QString::fromUtf8("Creazione macchina \"").append(qName).append("\"..."));
 
 			if(resultCode != 0)
 			{
-				std::cout << "Appliance import failed -> resultCode: " << resultCode << std::endl;
+				LOG_ERROR(LOG_VBOX, "Appliance import failed -> resultCode: %d", resultCode);
 				break;
 			}
 
 			if (NS_SUCCEEDED(rc))
 			{
 				import_done = true;
-				std::cout << "Successfully imported the appliance." << std::endl;
+				LOG_INFO(LOG_VBOX, "Successfully imported the appliance.");
 			}
 		} // end if (aVirtualSystemDescriptions.size() > 0)
 	} while (0);
@@ -643,13 +745,13 @@ IMachine *VirtualBoxBridge::cloneVM(QString qName, bool reInitIfaces, IMachine *
 	NS_CHECK_AND_DEBUG_ERROR(virtualBox, FindMachine(name, &new_machine), rc);
 	if(rc != VBOX_E_OBJECT_NOT_FOUND)
 	{
-		std::cout << "machine: " << &new_machine << std::endl;
+		LOG_ERROR(LOG_VBOX, "Machine %s already exists", qName.toStdString().c_str());
 		return NULL;
 	}
 
 	nsXPIDLString settingsFile;
 	virtualBox->ComposeMachineFilename(name, NULL, NULL, NULL, getter_Copies(settingsFile));
-	std::cout << "Predicted settings file name: " << returnQStringValue(settingsFile).toStdString() << std::endl;
+	LOG_DEBUG(LOG_VBOX, "Predicted settings file name: %s", returnQStringValue(settingsFile).toStdString().c_str());
 
 	QFile file(returnQStringValue(settingsFile));
 	QFile file_prev(returnQStringValue(settingsFile).append("-prev"));
@@ -657,29 +759,23 @@ IMachine *VirtualBoxBridge::cloneVM(QString qName, bool reInitIfaces, IMachine *
 	if(file.exists())
 	{
 		if(file.remove())
-			std::cerr  << "Deleted old settings file: " << file.fileName().toStdString() << std::endl;
+			LOG_WARNING(LOG_VBOX, "Deleted old settings file: %s", file.fileName().toStdString().c_str());
 		else
-			std::cerr  << "Error while deleting old settings file: " << file.fileName().toStdString() << std::endl;
+			LOG_ERROR(LOG_VBOX, "Error while deleting old settings file: %s", file.fileName().toStdString().c_str());
 	}
 	if(file_prev.exists())
 	{
 		if(file_prev.remove())
-			std::cerr  << "Deleted old backup settings file: " << file_prev.fileName().toStdString() << std::endl;
+			LOG_WARNING(LOG_VBOX, "Deleted old backup settings file: %s", file_prev.fileName().toStdString().c_str());
 		else
-			std::cerr  << "Error while deleting old backup settings file: " << file_prev.fileName().toStdString() << std::endl;
+			LOG_ERROR(LOG_VBOX, "Error while deleting old backup settings file: %s", file_prev.fileName().toStdString().c_str());
 	}
 	
-	QString label = QString::fromUtf8("Creazione macchina \"").append(qName).append("\"...");
-	ProgressDialog p(label);
-	p.ui->progressBar->setValue(0);
-	p.ui->label->setText(label);
-	p.open();
-	
 	NS_CHECK_AND_DEBUG_ERROR(virtualBox, CreateMachine(NULL, name, 0, NULL, osTypeId, NULL, &new_machine), rc);
 	if(NS_FAILED(rc))
 		return NULL;
 
-	std::cout << "Machine " << qName.toStdString() << " created" << std::endl;
+	LOG_DEBUG(LOG_VBOX, "Machine %s created", qName.toStdString().c_str());
 
 	if(!reInitIfaces)
 	{
@@ -693,34 +789,21 @@ IMachine *VirtualBoxBridge::cloneVM(QString qName, bool reInitIfaces, IMachine *
 	if(NS_FAILED(rc))
 		return NULL;
 
-	int32_t resultCode;
-	PRBool progress_completed;
-	do
-	{
-		uint32_t percent;
-		progress->GetCompleted(&progress_completed);
-		progress->GetPercent(&percent);
-		p.ui->progressBar->setValue(percent);
-		p.refresh();
-		usleep(750000);
-	} while(!progress_completed);
-
-	progress->GetResultCode(&resultCode);
+	int32_t resultCode = waitForProgress(progress, QString::fromUtf8("Creazione macchina \"").append(qName).append("\"..."));
 
 	if (resultCode != 0) // check success
 	{
-		std::cout << "Error during clone process: " << resultCode << std::endl;
+		LOG_ERROR(LOG_VBOX, "Error during clone process: %d", resultCode);
 		return NULL;
 	}
 
-	std::cout << "Machine " << qName.toStdString() << " cloned" << std::endl;
+	LOG_DEBUG(LOG_VBOX, "Machine %s cloned", qName.toStdString().c_str());
 
-	p.ui->label->setText(QString::fromUtf8("Registrazione macchina \"").append(qName).append("\"..."));
 	NS_CHECK_AND_DEBUG_ERROR(virtualBox, RegisterMachine(new_machine), rc);
 	if(NS_FAILED(rc))
 		return NULL;
 	
-	std::cout << "Machine " << qName.toStdString() << " registered" << std::endl;
+	LOG_INFO(LOG_VBOX, "Machine %s registered", qName.toStdString().c_str());
 	return new_machine;
 }
 
@@ -754,7 +837,7 @@ bool VirtualBoxBridge::deleteVM(IMachine *m)
 	if(NS_FAILED(rc))
 		return false;
 	
-	std::cout << "medias_size: " << medias_size << std::endl;
+	LOG_DEBUG(LOG_VBOX, "medias_size: %u", medias_size);
 
 	bool succeeded = true;
 	for(int i = 0; i < medias_size; i++)
@@ -764,8 +847,7 @@ bool VirtualBoxBridge::deleteVM(IMachine *m)
 		medias[i]->GetName(getter_Copies(media_name));
 		medias[i]->GetLocation(getter_Copies(media_location));
 
-		std::cout << "Deleting media " << returnQStringValue(media_name).toStdString()
-		<< " (" << returnQStringValue(media_location).toStdString() << ")" << std::endl;
+		LOG_INFO(LOG_VBOX, "Deleting media %s (%s)", returnQStringValue(media_name).toStdString().c_str(), returnQStringValue(media_location).toStdString().c_str());
 		
 		IProgress *progress;
 		int32_t resultCode;
@@ -776,8 +858,7 @@ bool VirtualBoxBridge::deleteVM(IMachine *m)
 		if(resultCode != 0)
 		{
 			succeeded= false;
-			std::cerr << "Error while deleting media " << returnQStringValue(media_name).toStdString()
-				<< " (" << returnQStringValue(media_location).toStdString() << ")" << std::endl;
+			LOG_ERROR(LOG_VBOX, "Error while deleting media %s (%s)", returnQStringValue(media_name).toStdString().c_str(), returnQStringValue(media_location).toStdString().c_str());
 		}
 		
 		if(resultCode == 0)
@@ -791,6 +872,67 @@ bool VirtualBoxBridge::deleteVM(IMachine *m)
 	return succeeded;
 }
 
+//Operations run by worker threads report their progress to a sink
+static __thread ProgressSink *progress_sink = NULL;
+
+void VirtualBoxBridge::setProgressSink(ProgressSink *sink)
+{
+	progress_sink = sink;
+}
+
+int32_t VirtualBoxBridge::waitForProgress(IProgress *progress, QString label)
+{
+	TRACE_SCOPE_ARG("progress", "waitForProgress", label.toUtf8().constData());
+
+	int32_t resultCode = -1;
+	PRBool progress_completed = PR_FALSE;
+	uint32_t percent = 0;
+	uint32_t shown_percent = (uint32_t) -1;
+
+#ifndef HEADLESS
+	ProgressDialog *p = NULL;
+	if(progress_sink == NULL)
+	{
+		p = new ProgressDialog(label);
+		p->ui->progressBar->setValue(0);
+		p->open();
+	}
+#endif
+
+	do
+	{
+		progress->GetPercent(&percent);
+		if(progress_sink != NULL)
+		{
+			if(percent != shown_percent)
+				progress_sink->progress(label, percent);
+		}
+		else
+		{
+#ifdef HEADLESS
+			if(percent != shown_percent)
+				std::cerr << label.toStdString() << " " << percent << "%" << std::endl;
+#else
+			p->ui->progressBar->setValue(percent);
+			p->refresh();
+#endif
+		}
+		shown_percent = percent;
+
+		//Returns as soon as the operation completes
+		progress->WaitForCompletion(PROGRESS_REFRESH_INTERVAL);
+		if(NS_FAILED(progress->GetCompleted(&progress_completed)))
+			break;
+	} while(!progress_completed);
+
+#ifndef HEADLESS
+	delete p;
+#endif
+
+	progress->GetResultCode(&resultCode);
+	return resultCode;
+}
+
 QString VirtualBoxBridge::getVBoxVersion()
 {
 	QString retVal = QString::fromUtf8("ERROR: Object virtualBox not initialized");
@@ -806,6 +948,11 @@ QString VirtualBoxBridge::getVBoxVersion()
 
 QString VirtualBoxBridge::generateMac()
 {
+	//Addresses are generated locally, so they are checked against every machine
+	uint64_t mac = macAllocator->generate();
+	if(mac != MAC_NONE)
+		return AddressParser::formatMac(mac);
+
 	nsCOMPtr<IHost> host = nsnull;
 	nsXPIDLString new_mac;
 
@@ -841,8 +988,10 @@ std::vector<MachineBridge*> VirtualBoxBridge::getMachines(QObject *parent)
 }
 
 MachineBridge::MachineBridge(VirtualBoxBridge *vboxbridge, IMachine *machine, QObject *parent)
-: vboxbridge(vboxbridge), machine(machine), session(nsnull)
+: vboxbridge(vboxbridge), machine(machine), session(nsnull), sessionMachine(nsnull)
 {
+	pthread_mutex_init(&session_mutex, NULL);
+
 	eventListener.createObject();
 	eventListener->init(new UIMainEventListener(this), parent);
 
@@ -854,6 +1003,43 @@ MachineBridge::~MachineBridge()
 	if(session != nsnull)
 		session->UnlockMachine();
 	while(machine->Release() > 0);
+
+	pthread_mutex_destroy(&session_mutex);
+}
+
+nsCOMPtr<ISession> MachineBridge::getSession()
+{
+	pthread_mutex_lock(&session_mutex);
+	nsCOMPtr<ISession> current = session;
+	pthread_mutex_unlock(&session_mutex);
+
+	return current;
+}
+
+nsCOMPtr<IConsole> MachineBridge::getConsole()
+{
+	pthread_mutex_lock(&session_mutex);
+	nsCOMPtr<IConsole> current = console;
+	pthread_mutex_unlock(&session_mutex);
+
+	return current;
+}
+
+void MachineBridge::setSession(ISession *newSession)
+{
+	//Machine and console of the previous session are not valid anymore
+	pthread_mutex_lock(&session_mutex);
+	session = newSession;
+	sessionMachine = nsnull;
+	console = nsnull;
+	pthread_mutex_unlock(&session_mutex);
+}
+
+void MachineBridge::setConsole(IConsole *newConsole)
+{
+	pthread_mutex_lock(&session_mutex);
+	console = newConsole;
+	pthread_mutex_unlock(&session_mutex);
 }
 
 uint32_t MachineBridge::getMaxNetworkAdapters()
@@ -899,8 +1085,37 @@ bool MachineBridge::setName(QString qName)
 	return NS_SUCCEEDED(rc);
 }
 
+bool MachineBridge::rename(QString qName)
+{
+	if(!lockMachine())
+	{
+		LOG_ERROR(LOG_VBOX, "[%s] Cannot lock machine", getName().toStdString().c_str());
+		return false;
+	}
+
+	bool succeeded = setName(qName);
+	if(!succeeded)
+		LOG_ERROR(LOG_VBOX, "setName(%s): false", qName.toStdString().c_str());
+
+	saveSettings();
+
+	return unlockMachine() && succeeded;
+}
+
+bool MachineBridge::remove()
+{
+	uint32_t machineState = getState();
+	if(machineState == MachineState::Paused ||
+	   machineState == MachineState::Starting ||
+	   machineState == MachineState::Running)
+		return false;
+
+	return vboxbridge->deleteVM(machine);
+}
+
 uint32_t MachineBridge::getState()
 {
+	nsCOMPtr<ISession> session = getSession();
 	if(session != nsnull)
 	{
 		uint32_t machineState;
@@ -925,6 +1140,7 @@ uint32_t MachineBridge::getState()
 
 uint32_t MachineBridge::getSessionState()
 {
+	nsCOMPtr<ISession> session = getSession();
 	if(session != nsnull)
 	{
 		uint32_t sessionState;
@@ -942,29 +1158,30 @@ bool MachineBridge::supportsACPI()
 	nsresult rc;
 	PRBool acpiSupported = false;
 
+	//Called by the GUI thread, the console of the session is not cached here
+	nsCOMPtr<IConsole> console = getConsole();
 	if(console == nsnull)
 	{
-		if(session != nsnull)
-		{
-			rc = session->GetConsole(getter_AddRefs(console));
-			if(NS_FAILED(rc))
-			{
-				console = nsnull;
-				return false;
-			}
-			
-		}
-		else
+		nsCOMPtr<ISession> session = getSession();
+		if(session == nsnull)
+			return false;
+
+		rc = session->GetConsole(getter_AddRefs(console));
+		if(NS_FAILED(rc))
 			return false;
 	}
 
-	if(console != nsnull)
-		console->GetGuestEnteredACPIMode(&acpiSupported);
+	console->GetGuestEnteredACPIMode(&acpiSupported);
 
 	return acpiSupported;
 }
 
 QString MachineBridge::getHardDiskFilePath()
+{
+	return getHardDiskFilePath(machine);
+}
+
+QString MachineBridge::getHardDiskFilePath(IMachine *machine)
 {
 	nsresult rc;
 	uint32_t mediumAttachments_size;
@@ -1200,23 +1417,67 @@ ComPtr<INetworkAdapter> MachineBridge::getIface(uint32_t iface)
 	return network_adptr;
 }
 
+ComPtr<IMachine> MachineBridge::getSessionMachine()
+{
+	//The mutable machine is kept until the session changes
+	pthread_mutex_lock(&session_mutex);
+	if(sessionMachine == nsnull && session != nsnull)
+	{
+		nsresult rc;
+		NS_CHECK_AND_DEBUG_ERROR(session, GetMachine(sessionMachine.asOutParam()), rc);
+		if(NS_FAILED(rc))
+			sessionMachine = nsnull;
+	}
+	ComPtr<IMachine> current = sessionMachine;
+	pthread_mutex_unlock(&session_mutex);
+
+	return current;
+}
+
 ComPtr<INetworkAdapter> MachineBridge::getIfaceRunTimeEditable(uint32_t iface)
 {
 	nsresult rc;
-	ComPtr<IMachine> tmp_machine;
 	ComPtr<INetworkAdapter> nic;
 
-	NS_CHECK_AND_DEBUG_ERROR(session, GetMachine(tmp_machine.asOutParam()), rc);
-// 	NS_CHECK_AND_DEBUG_ERROR(tmp_machine, LockMachine(session, LockType::Write), rc);
-	if(NS_SUCCEEDED(rc))
+	for(int attempt = 0; attempt < 2; attempt++)
+	{
+		ComPtr<IMachine> tmp_machine = getSessionMachine();
+		if(tmp_machine == nsnull)
+			return NULL;
+
 		NS_CHECK_AND_DEBUG_ERROR(tmp_machine, GetNetworkAdapter(iface, nic.asOutParam()), rc);
+		if(NS_SUCCEEDED(rc))
+			return nic;
 
-	if(NS_SUCCEEDED(rc))
-		return nic;
+		//A cached machine of a closed session is dropped and fetched again
+		pthread_mutex_lock(&session_mutex);
+		sessionMachine = nsnull;
+		pthread_mutex_unlock(&session_mutex);
+	}
 
 	return NULL;
 }
 
+bool MachineBridge::setAttachmentRunTime(uint32_t iface, uint32_t attachmentType, QString qAttachmentData, bool typeChanged, bool dataChanged)
+{
+	if(!typeChanged && !dataChanged)
+		return true;
+
+	ComPtr<INetworkAdapter> nic = getIfaceRunTimeEditable(iface);
+	if(nic == NULL)
+		return false;
+
+	bool succeeded = true;
+	if(typeChanged)
+		succeeded = setIfaceAttachmentType(nic, attachmentType);
+
+	//The attachment type is known, so it is not read back from the adapter
+	if(succeeded && dataChanged)
+		succeeded = setAttachmentData(nic, attachmentType, qAttachmentData);
+
+	return succeeded;
+}
+
 bool MachineBridge::setIfaceEnabled(ComPtr<INetworkAdapter> iface, bool enabled)
 {
 	nsresult rc;
@@ -1347,10 +1608,27 @@ int MachineBridge::getIfaceSlot(INetworkAdapter *iface)
 }
 
 bool MachineBridge::start()
+{
+	nsCOMPtr<IProgress> progress = launch();
+	if(progress == nsnull)
+		return false;
+
+	PRInt32 resultCode = VirtualBoxBridge::waitForProgress(progress, QString::fromUtf8("Avvio macchina ").append(getName()));
+	progress = nsnull;
+
+	if (resultCode != 0) // check success
+	{
+		LOG_ERROR(LOG_VBOX, "[%s] Cannot launch VM! Result code: 0x%x", getName().toStdString().c_str(), resultCode);
+		return false;
+	}
+
+	return true;
+}
+
+nsCOMPtr<IProgress> MachineBridge::launch()
 {
 	nsresult rc;
-	bool launchSucceeded;
-	uint32_t sessionState, machineState;
+	uint32_t machineState;
 	
 	/*
 	 * Session checking: check session for first launch or if it is still running
@@ -1362,8 +1640,8 @@ bool MachineBridge::start()
 			|| machineState == MachineState::Running
 			|| machineState == MachineState::Paused)
 		{
-			std::cout << "[" << getName().toStdString() << "] VM is starting/running/paused" << std::endl;
-			return false;
+			LOG_INFO(LOG_VBOX, "[%s] VM is starting/running/paused", getName().toStdString().c_str());
+			return nsnull;
 		}
 
 		// Try to unlock session, then check if this action succeeded
@@ -1376,13 +1654,13 @@ bool MachineBridge::start()
 		// If Session is not unlocked, VM is still running
 		if(NS_FAILED(rc) || state != SessionState::Unlocked)
 		{
-			std::cout << "[" << getName().toStdString() << "] Session locked!" << std::endl;
-			return false;
+			LOG_WARNING(LOG_VBOX, "[%s] Session locked!", getName().toStdString().c_str());
+			return nsnull;
 		}
 	}
 
 	// Create new session
-	session = vboxbridge->newSession();
+	setSession(vboxbridge->newSession());
 
 	/*
 	 * Launch routine: launch machine and check if it is launched or in starting state
@@ -1391,101 +1669,81 @@ bool MachineBridge::start()
 	nsXPIDLString environment; environment.AssignWithConversion("", 0);
 	nsCOMPtr<IProgress> progress;
 
-/*
-	NS_CHECK_AND_DEBUG_ERROR(machine, LockMachine(session, LockType::Shared), rc);
-	uint32_t state;
-
-	nsresult rc_tmp;
-	NS_CHECK_AND_DEBUG_ERROR(session, GetState(&state), rc_tmp);
-
-	if(NS_FAILED(rc) || state != SessionState::Locked)
-	{
-		std::cout << "[" << getName().toStdString() << "] Can't lock Session!" << std::endl;
-		return false;
-	}
-*/
-	ProgressDialog p(QString::fromUtf8("Avvio macchina ").append(getName()));
-	p.ui->progressBar->setValue(0);
-	p.open();
-
 	NS_CHECK_AND_DEBUG_ERROR(machine, LaunchVMProcess(session, type, environment, getter_AddRefs(progress)), rc);
 	if(NS_FAILED(rc))
 	{
-		launchSucceeded = false;
-		std::cout << "[" << getName().toStdString() << "] Cannot launch VM!" << std::endl;
+		LOG_ERROR(LOG_VBOX, "[%s] Cannot launch VM!", getName().toStdString().c_str());
 		progress = nsnull;
 	}
-	else
-	{
-		launchSucceeded = true;
-		PRInt32 resultCode;
-		PRBool progress_completed;
-		do
-		{
-			uint32_t percent;
-			progress->GetCompleted(&progress_completed);
-			progress->GetPercent(&percent);
-			p.ui->progressBar->setValue(percent);
-			p.refresh();
-			usleep(750000);
-		} while(!progress_completed);
-		
-		progress->GetResultCode(&resultCode);
 
-		if (resultCode != 0) // check success
-		{
-			std::cout << "[" << getName().toStdString() << "] Cannot launch VM! Result code: 0x" << std::hex << resultCode << std::dec << std::endl;
-			return false;
-		}
-		registerListener();
-	}	
-
-	return launchSucceeded;
+	return progress;
 }
 
 bool MachineBridge::stop(bool force)
 {
 	nsresult rc;
-	
-	if(console == nsnull)
+
+	if(force)
 	{
-		rc = session->GetConsole(getter_AddRefs(console));
+		nsCOMPtr<IProgress> progress = powerDown();
+		if(progress == nsnull)
+			return false;
+
+		VirtualBoxBridge::waitForProgress(progress, QString::fromUtf8("Arresto macchina ").append(getName()));
+		progress = nsnull;
+	}
+	else
+	{
+		if(!openConsole())
+			return false;
+
+		rc = console->PowerButton();
 		if(NS_FAILED(rc))
-		{
-			console = nsnull;
 			return false;
-		}
 	}
 
+	setSession(nsnull);
+	return true;
+}
+
+nsCOMPtr<IProgress> MachineBridge::powerDown()
+{
 	nsCOMPtr<IProgress> progress;
 
-	ProgressDialog p(QString::fromUtf8("Arresto macchina ").append(getName()));
-	p.ui->progressBar->setValue(0);
-	p.open();
+	if(!openConsole())
+		return nsnull;
 
-	if(force)
-	{
-		rc = console->PowerDown(getter_AddRefs(progress));
-		PRBool progress_completed;
-		do
-		{
-			uint32_t percent;
-			progress->GetCompleted(&progress_completed);
-			progress->GetPercent(&percent);
-			p.ui->progressBar->setValue(percent);
-			p.refresh();
-			usleep(750000);
-		} while(!progress_completed);
-		
+	nsresult rc = console->PowerDown(getter_AddRefs(progress));
+	if(NS_FAILED(rc))
 		progress = nsnull;
+
+	return progress;
+}
+
+bool MachineBridge::openConsole()
+{
+	nsresult rc;
+
+	if(console != nsnull)
+		return true;
+
+	//Machines launched by another process have no session here, a shared one is opened
+	if(session == nsnull)
+	{
+		nsCOMPtr<ISession> sharedSession = vboxbridge->newSession();
+		NS_CHECK_AND_DEBUG_ERROR(machine, LockMachine(sharedSession, LockType::Shared), rc);
+		if(NS_FAILED(rc))
+			return false;
+
+		setSession(sharedSession);
 	}
-	else
-		rc = console->PowerButton();
 
+	nsCOMPtr<IConsole> newConsole;
+	rc = session->GetConsole(getter_AddRefs(newConsole));
 	if(NS_FAILED(rc))
 		return false;
 
-	session = nsnull;
+	setConsole(newConsole);
 	return true;
 }
 
@@ -1493,15 +1751,8 @@ bool MachineBridge::pause(bool pauseEnabled)
 {
 	nsresult rc;
 
-	if(console == nsnull)
-	{
-		rc = session->GetConsole(getter_AddRefs(console));
-		if(NS_FAILED(rc))
-		{
-			console = nsnull;
-			return false;
-		}
-	}
+	if(!openConsole())
+		return false;
 	
 	if(pauseEnabled)
 		rc = console->Pause();
@@ -1515,15 +1766,8 @@ bool MachineBridge::reset()
 {
 	nsresult rc;
 	
-	if(console == nsnull)
-	{
-		rc = session->GetConsole(getter_AddRefs(console));
-		if(NS_FAILED(rc))
-		{
-			console = nsnull;
-			return false;
-		}
-	}
+	if(!openConsole())
+		return false;
 	
 	rc = console->Reset();
 	
@@ -1601,7 +1845,7 @@ bool MachineBridge::shutdownVMProcess()
 			|| machineState == MachineState::Running
 			|| machineState == MachineState::Paused)
 		{
-			std::cout << "[" << getName().toStdString() << "] VM is starting/running/paused" << std::endl;
+			LOG_INFO(LOG_VBOX, "[%s] VM is starting/running/paused", getName().toStdString().c_str());
 			return false;
 		}
 
@@ -1615,12 +1859,12 @@ bool MachineBridge::shutdownVMProcess()
 		// If Session is not unlocked, VM is still running
 		if(NS_FAILED(rc) || state != SessionState::Unlocked)
 		{
-			std::cout << "[" << getName().toStdString() << "] Session locked!" << std::endl;
+			LOG_WARNING(LOG_VBOX, "[%s] Session locked!", getName().toStdString().c_str());
 			return false;
 		}
 	}
 
-	session = nsnull;
+	setSession(nsnull);
 	return true;
 }
 
@@ -1628,14 +1872,18 @@ bool MachineBridge::registerListener() //TODO select only events that I'm intere
 {
 	nsresult rc;
 
-	if(session == nsnull)
+	//Called on the GUI thread, while the executor may replace the session
+	nsCOMPtr<ISession> current = getSession();
+	if(current == nsnull)
 		return false;
 	
-	NS_CHECK_AND_DEBUG_ERROR(session, GetConsole(getter_AddRefs(console)), rc);
+	nsCOMPtr<IConsole> newConsole;
+	NS_CHECK_AND_DEBUG_ERROR(current, GetConsole(getter_AddRefs(newConsole)), rc);
 	if(NS_FAILED(rc))
 		return false;
+	setConsole(newConsole);
 
-	NS_CHECK_AND_DEBUG_ERROR(console, GetEventSource(getter_AddRefs(eventSource)), rc);
+	NS_CHECK_AND_DEBUG_ERROR(newConsole, GetEventSource(getter_AddRefs(eventSource)), rc);
 	if(NS_FAILED(rc))
 		return false;
 	
@@ -1680,7 +1928,7 @@ bool MachineBridge::lockMachine()
 		}
 	}
 
-	session = vboxbridge->newSession();
+	setSession(vboxbridge->newSession());
 
 	GET_AND_DEBUG_MACHINE_STATE(session, state, rc);
 
@@ -1720,7 +1968,7 @@ bool MachineBridge::unlockMachine()
 	//HACK FIXME Renew machine object because actual object is unlockable
 	NS_CHECK_AND_DEBUG_ERROR(vboxbridge->virtualBox, FindMachine(machineUUID, &machine), rc);
 
-	session = nsnull;
+	setSession(nsnull);
 
 	return NS_SUCCEEDED(rc);
 }
@@ -34,11 +34,19 @@
 #include "VirtualBox_XPCOM.h"
 #include "Iface.h"
 #include "UIMainEventListener.h"
+#include "Trace.h"
+#include "XpcomStats.h"
+#include "Log.h"
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include <QStringListModel>
+#include <QElapsedTimer>
 #include <vector>
+#include <map>
 #include <pthread.h>
+#include <typeinfo>
 
 static QString returnQStringValue(nsXPIDLString s)
 {
@@ -48,18 +56,27 @@ static QString returnQStringValue(nsXPIDLString s)
 	return retVal;
 }
 
+/**
+ * Every VirtualBox call made through this macro is counted in XpcomStats and
+ * traced; the counters of the call site are looked up at its first call
+ */
+#define NS_CALL_AND_COUNT(ptr, func, out_rc_value) \
+	static xpcom_method_stats_t *__xpcom_stats = XpcomStats::method(typeid(__typeof__(*ptr)).name(), #func); \
+	TRACE_SCOPE("xpcom", __xpcom_stats->name); \
+	uint64_t __xpcom_begin = Trace::now(); \
+	out_rc_value = ptr->func; \
+	XpcomStats::add(__xpcom_stats, Trace::now() - __xpcom_begin, NS_FAILED(out_rc_value))
+
 #ifdef DEBUG_FLAG
 	#define NS_CHECK_AND_DEBUG_ERROR(ptr, func, out_rc_value) \
 	do { \
-		out_rc_value = ptr->func; \
+		NS_CALL_AND_COUNT(ptr, func, out_rc_value); \
 		if (NS_FAILED(out_rc_value)) \
-		{ \
-			std::cerr << "[" << __FILE__ << ":" << __LINE__ << " -> " << __func__ << "] " << #ptr << "->" << #func << ": 0x" << std::hex << out_rc_value << std::dec << std::endl; \
-		} \
+			LOG_ERROR(LOG_VBOX, "[%s:%d -> %s] %s->%s: 0x%x", __FILE__, __LINE__, __func__, #ptr, #func, (unsigned) out_rc_value); \
 	} while (0)
 #else
 	#define NS_CHECK_AND_DEBUG_ERROR(ptr, func, out_rc_value) \
-	do { out_rc_value = ptr->func; } while (0)
+	do { NS_CALL_AND_COUNT(ptr, func, out_rc_value); } while (0)
 #endif
 
 #ifdef DEBUG_FLAG
@@ -105,7 +122,66 @@ static QString returnQStringValue(nsXPIDLString s)
 class MachineBridge;
 class VMTabSettings;
 class VirtualMachine;
+class MacAllocator;
 class UIMainEventListener;
+class VirtualBoxBridge;
+class CliController;
+class XpcomBackend;
+
+/** Interval between progress refreshes while waiting for VirtualBox, in ms */
+#define PROGRESS_REFRESH_INTERVAL 750
+
+/** Milliseconds after which a host network list is read again */
+#define HOST_NETWORK_CATALOG_TTL 5000
+
+/**
+ * Names of host networks available for each attachment type, read once from
+ * VirtualBox and shared by every ifaces table through one QStringListModel
+ * per attachment type. A list is read again when invalidated or when older
+ * than HOST_NETWORK_CATALOG_TTL.
+ */
+class HostNetworkCatalog
+{
+	public:
+		HostNetworkCatalog(VirtualBoxBridge *vboxbridge);
+		~HostNetworkCatalog();
+
+		/**
+		 * This function returns the shared model of attachmentType, NULL if
+		 * attachmentType has no network names (Null, NAT)
+		 */
+		QStringListModel *model(uint32_t attachmentType);
+		QStringList list(uint32_t attachmentType);
+		bool contains(uint32_t attachmentType, QString name);
+
+		void invalidate(uint32_t attachmentType);
+		void invalidate();
+
+	private:
+		typedef struct
+		{
+			QStringListModel *model;
+			QElapsedTimer loaded;
+			bool valid;
+		} catalog_entry_t;
+
+		catalog_entry_t *entry(uint32_t attachmentType);
+		QStringList load(uint32_t attachmentType);
+
+		VirtualBoxBridge *vboxbridge;
+		std::map<uint32_t, catalog_entry_t> entries;
+};
+
+/**
+ * Receiver of the progress of VirtualBox operations run outside the GUI
+ * thread, where no progress dialog can be shown
+ */
+class ProgressSink
+{
+	public:
+		virtual ~ProgressSink() {};
+		virtual void progress(QString label, uint32_t percent) = 0;
+};
 
 typedef struct
 {
@@ -134,11 +210,27 @@ class VirtualBoxBridge
 		std::vector<QString> getInternalNetworkList();
 		bool isNewInternalNetwork(QString qInternalNetwork);
 		std::vector<nsCOMPtr<INATNetwork> > getNatNetworks();
+		HostNetworkCatalog *getHostNetworkCatalog() { return hostNetworkCatalog; };
+		MacAllocator *getMacAllocator() { return macAllocator; };
 		IMachine *existVM(QString name);
 		IMachine *newVM(QString name);
 		IMachine *cloneVM(QString name, bool reInitIfaces, IMachine *m);
 		QString validateMachineName(QString qName, int machines_size);
 		bool deleteVM(IMachine *m);
+
+		/**
+		 * This function waits for progress to complete, showing label and
+		 * its percent in a progress dialog (on stderr if HEADLESS is
+		 * defined, to the sink of the calling thread if set), and returns
+		 * its result code
+		 */
+		static int32_t waitForProgress(IProgress *progress, QString label);
+
+		/**
+		 * This function sets the progress sink of the calling thread, NULL
+		 * to restore the default output
+		 */
+		static void setProgressSink(ProgressSink *sink);
 		
 	private:
 		bool initXPCOM();
@@ -151,6 +243,8 @@ class VirtualBoxBridge
 		nsCOMPtr<nsIComponentManager> nsCOM_manager;
 		pthread_t knockThread;
 		tparam_t tparam;
+		HostNetworkCatalog *hostNetworkCatalog;
+		MacAllocator *macAllocator;
 };
 
 /* Wrap the IListener interface around our implementation class. */
@@ -161,6 +255,10 @@ class MachineBridge
 	friend class VirtualMachine;
 	friend class UIMainEventListener;
 	friend class VMTabSettings;
+	friend class CliController;
+	friend class XpcomBackend;
+	friend class VMCommandWorker;
+	friend class VMCommandExecutor;
 
 	public:
 		MachineBridge(VirtualBoxBridge *vboxbridge, IMachine *machine, QObject *parent);
@@ -170,8 +268,20 @@ class MachineBridge
 		QString getUUID();
 		bool setUUID(QString newUUID);
 		QString getHardDiskFilePath();
+		static QString getHardDiskFilePath(IMachine *machine);
 		QString getName();
 		bool setName(QString qName);
+
+		/**
+		 * This function renames the machine, locking it for the change
+		 */
+		bool rename(QString qName);
+
+		/**
+		 * This function deletes the machine and its disks from VirtualBox,
+		 * unless it is running
+		 */
+		bool remove();
 		uint32_t getState();
 		uint32_t getSessionState();
 		bool supportsACPI();
@@ -205,7 +315,17 @@ class MachineBridge
 		bool setAttachmentData(uint32_t iface, QString qAttachmentData);
 		bool setAttachmentDataRunTime(uint32_t iface, QString qAttachmentData);
 		bool setAttachmentData(uint32_t iface, uint32_t AttachmentType, QString qAttachmentData);
+
+		/**
+		 * This function sets attachment type and data of a running machine
+		 * with a single adapter lookup, skipping the unchanged ones
+		 */
+		bool setAttachmentRunTime(uint32_t iface, uint32_t attachmentType, QString qAttachmentData, bool typeChanged, bool dataChanged);
 		
+		/**
+		 * This function launches the machine and waits for it; its events
+		 * are listened after registerListener() is called on the GUI thread
+		 */
 		bool start();
 		bool stop(bool force = false);
 		bool pause(bool pauseEnabled);
@@ -217,10 +337,30 @@ class MachineBridge
 	private:
 		bool shutdownVMProcess();
 		bool registerListener();
+		bool openConsole();
 		bool lockMachine();
 		bool unlockMachine();
 		ComPtr<INetworkAdapter> getIface(uint32_t iface);
+		ComPtr<IMachine> getSessionMachine();
+
+		/**
+		 * These functions start and power down the machine without
+		 * waiting, returning the progress of the operation, nsnull if it
+		 * cannot be started
+		 */
+		nsCOMPtr<IProgress> launch();
+		nsCOMPtr<IProgress> powerDown();
 		ComPtr<INetworkAdapter> getIfaceRunTimeEditable(uint32_t iface);
+
+		/**
+		 * Session, session machine and console are replaced by the thread
+		 * running machine commands while the GUI thread reads the machine
+		 * state, so other threads read them only through these functions
+		 */
+		nsCOMPtr<ISession> getSession();
+		nsCOMPtr<IConsole> getConsole();
+		void setSession(ISession *newSession);
+		void setConsole(IConsole *newConsole);
 		
 		QString getNatNetwork(INetworkAdapter *iface);
 		QString getBridgedIface(INetworkAdapter *iface);
@@ -243,10 +383,12 @@ class MachineBridge
 		VirtualBoxBridge *vboxbridge;
 		IMachine *machine;
 		nsCOMPtr<ISession> session;
+		ComPtr<IMachine> sessionMachine;
 		nsCOMPtr<IEventSource> eventSource;
 		ComObjPtr<UIMainEventListenerImpl> eventListener;
 		nsCOMPtr<IConsole> console;
 		nsXPIDLString machineUUID;
+		pthread_mutex_t session_mutex;
 };
 
 #endif //VIRTUALBOXBRIDGE_H
@@ -31,20 +31,29 @@
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <malloc.h>
+#include <string.h>
 #include <string>
 #include <sstream>
 
 #include "VirtualBoxBridge.h"
+#include "XpcomBackend.h"
+#include "AdapterSync.h"
+#include "GuestConfig.h"
 #include "OSBridge.h"
 #include "VMSettings.h"
+#include "Log.h"
 
 #define NET_HW_SETTINGS_FILE "etc/udev/rules.d/70-persistent-net.rules"
 #define NET_SW_SETTINGS_PREFIX "etc/sysconfig/network-scripts/ifcfg-"
 
-VirtualMachine::VirtualMachine(MachineBridge *machine, std::string vhd_mountpoint, std::string partition_mountpoint_prefix)
-: machine(machine), ifaces_size(0), ifaces(NULL), vhd_mountpoint(vhd_mountpoint)
+VirtualMachine::VirtualMachine(MachineBridge *machine, std::string vhd_mountpoint, std::string partition_mountpoint_prefix, HypervisorBackend *backend, int backend_machine)
+: machine(machine), backend(backend), backend_machine(backend_machine), backend_owned(backend == NULL), ifaces_size(0), ifaces(NULL), vhd_mountpoint(vhd_mountpoint)
 , partition_mountpoint_prefix(partition_mountpoint_prefix), vhd_mounted(false), vmSettings(NULL)
 {
+	if(backend_owned)
+		this->backend = new XpcomBackend(machine);
+
+	memset(&operationsStats, 0, sizeof(vm_operations_stats_t));
 	populateIfaces();
 }
 
@@ -54,16 +63,22 @@ VirtualMachine::~VirtualMachine()
 		delete ifaces[ifaces_size-- - 1];
 	
 	free(ifaces);
+
+	if(backend_owned)
+		delete backend;
 	
 	umountVHD();
 }
 
 bool VirtualMachine::mountVHD()
 {
+	TRACE_SCOPE_ARG("vm", "mountVHD", vhd_mountpoint.c_str());
+
 	if(!vhd_mounted)
 	{
-		std::cout << "Mounting " << machine->getHardDiskFilePath().toStdString() << " on " << vhd_mountpoint << std::endl;
+		LOG_INFO(LOG_VM, "Mounting %s on %s", machine->getHardDiskFilePath().toStdString().c_str(), vhd_mountpoint.c_str());
 		vhd_mounted = OSBridge::mountVHD(machine->getHardDiskFilePath().toStdString(), vhd_mountpoint);
+		operationsStats.vhd_mounted = vhd_mounted;
 		return vhd_mounted;
 	}
 
@@ -72,6 +87,8 @@ bool VirtualMachine::mountVHD()
 
 bool VirtualMachine::umountVHD()
 {
+	TRACE_SCOPE_ARG("vm", "umountVHD", vhd_mountpoint.c_str());
+
 	if(!vhd_mounted)
 		return true;
 
@@ -79,35 +96,42 @@ bool VirtualMachine::umountVHD()
 	{
 		int i = mounted_partitions_vec.back().find_last_of('p');
 		if(umountVpartition(atoi(mounted_partitions_vec.back().substr(i).c_str())))
+		{
 			mounted_partitions_vec.pop_back();
+			operationsStats.mounted_partitions = mounted_partitions_vec.size();
+		}
 		else
 			return false;
 	}
 
-	std::cout << "Unmounting " << machine->getHardDiskFilePath().toStdString() << " from " << vhd_mountpoint << std::endl;
+	LOG_INFO(LOG_VM, "Unmounting %s from %s", machine->getHardDiskFilePath().toStdString().c_str(), vhd_mountpoint.c_str());
 	vhd_mounted = !OSBridge::umountVHD(vhd_mountpoint);
+	operationsStats.vhd_mounted = vhd_mounted;
 	return !vhd_mounted;
 }
 
 bool VirtualMachine::mountVpartition(int index, bool readonly)
 {
+	TRACE_SCOPE_ARG("vm", "mountVpartition", vhd_mountpoint.c_str());
+
 	mountVHD();
 
 	std::stringstream partition; partition << vhd_mountpoint << "p" << index;
 	std::stringstream partition_mountpoint;	partition_mountpoint << partition_mountpoint_prefix << "p" << index;
 	std::stringstream partition_usermountpoint; partition_usermountpoint << partition_mountpoint_prefix << "p" << index<< "-u";
 
-	std::cout << "Mounting " << partition.str() << " on " << partition_mountpoint.str() << std::endl;
+	LOG_DEBUG(LOG_VM, "Mounting %s on %s", partition.str().c_str(), partition_mountpoint.str().c_str());
 	for(int i = 0; i < mounted_partitions_vec.size(); i++)
 		if(mounted_partitions_vec.at(i) == partition.str())
 		{
-			std::cout << partition.str() << " already mounted" << std::endl;
+			LOG_DEBUG(LOG_VM, "%s already mounted", partition.str().c_str());
 			return true;
 		}
 
 	if(OSBridge::mountVpartition(partition.str(), partition_mountpoint.str(), partition_usermountpoint.str(), readonly))
 	{
 		mounted_partitions_vec.push_back(partition.str());
+		operationsStats.mounted_partitions = mounted_partitions_vec.size();
 		return true;
 	}
 
@@ -116,6 +140,8 @@ bool VirtualMachine::mountVpartition(int index, bool readonly)
 
 bool VirtualMachine::umountVpartition(int index)
 {
+	TRACE_SCOPE_ARG("vm", "umountVpartition", vhd_mountpoint.c_str());
+
 	std::stringstream partition; partition << vhd_mountpoint << "p" << index;
 	std::stringstream mpoint; mpoint << partition_mountpoint_prefix << "p" << index;
 	std::stringstream usermpoint; usermpoint << partition_mountpoint_prefix << "p" << index << "-u";
@@ -123,10 +149,13 @@ bool VirtualMachine::umountVpartition(int index)
 	for(int i = 0; i < mounted_partitions_vec.size(); i++)
 		if(mounted_partitions_vec.at(i) == partition.str())
 		{
-			std::cout << "Unmounting " << partition.str() << std::endl;
+			LOG_DEBUG(LOG_VM, "Unmounting %s", partition.str().c_str());
 			OSBridge::umountVpartition(usermpoint.str());
 			if(OSBridge::umountVpartition(mpoint.str()))
+			{
 				mounted_partitions_vec.erase(mounted_partitions_vec.begin() + i);
+				operationsStats.mounted_partitions = mounted_partitions_vec.size();
+			}
 			break;
 		}
 
@@ -136,37 +165,37 @@ bool VirtualMachine::umountVpartition(int index)
 	return true;	
 }
 
-bool VirtualMachine::start()
+bool VirtualMachine::start(const std::vector<settings_iface_t> &settings_ifaces)
 {
-	bool succeeded = true;
-
-	if(!machine->lockMachine())
+	if(!backend->lockMachine(backend_machine))
 	{
-		std::cerr << "[" << machine->getName().toStdString() <<  "] Cannot lock machine" << std::endl;
+		LOG_ERROR(LOG_VM, "[%s] Cannot lock machine", machine->getName().toStdString().c_str());
 		return false;
 	}
 
-	for(int i = 0; i < ifaces_size; i++)
-		if(ifaces[i]->enabled)
-			if(!machine->setCableConnected(i, ifaces[i]->cableConnected))
-				succeeded = false;
+	bool succeeded = settings_ifaces.empty() || AdapterSync::writeCableStates(backend, backend_machine, &settings_ifaces[0], settings_ifaces.size());
 
-	if(!machine->saveSettings())
+	if(!backend->saveSettings(backend_machine))
 	{
-		std::cout << "saveCableConnectedSettings(): false" << std::endl;
+		LOG_ERROR(LOG_VM, "saveCableConnectedSettings(): false");
 		succeeded = false;
 	}
 
-	if(!machine->unlockMachine())
+	if(!backend->unlockMachine(backend_machine))
 		return false;
 
+	//The launch reports its progress, events are listened once it is started
 	return machine->start() && succeeded;
 }
 
 Iface *VirtualMachine::getIfaceByMAC(QString mac)
 {
+	uint64_t value;
+	if(!AddressParser::parseMac(mac.constData(), mac.length(), &value))
+		return NULL;
+
 	for (int i = 0; i < ifaces_size; i++)
-		if (ifaces[i]->mac == mac)
+		if (ifaces[i]->record.mac == value)
 			return ifaces[i];
 	
 	return NULL;
@@ -201,176 +230,53 @@ void VirtualMachine::refreshIface(uint32_t iface, INetworkAdapter *nic)
 	ifaces[iface]->setIp(getIp(iface));
 	ifaces[iface]->setSubnetMask(getSubnetMask(iface));
 #endif
+	ifaces[iface]->clearDirty();
+
+	emit attachmentChanged(this, iface);
 }
 
 QString VirtualMachine::getIfaceName(uint32_t iface)
 {
-	//read from /etc/udev/rules.d/70-persistent-net.rules
-	/* .
-	 * .
-	 * 
-	 * # (01:23:45:67:89:0A) iface0
-	 * SUBSYSTEM=="net", ACTION=="add", DRIVERS=="?*", ATTR{address}=="01:23:45:67:89:0A", ATTR{dev_id}=="0x0", ATTR{type}=="1", KERNEL=="eth*", NAME="iface0"
-	 * 
-	 * -
-	 * -
-	 */
-	QString iface_name = QString("noname%1").arg(iface);
-	QString match = QString::fromUtf8("{address}==\"").toUpper().append(machine->getIfaceFormattedMac(iface).toUpper()).append("\"");
-
 	QString filename = QString::fromStdString(partition_mountpoint_prefix);
 	filename.append(QString::fromUtf8("p%1-u/").arg(OS_PARTITION_NUMBER)).append(NET_HW_SETTINGS_FILE);
 
-	QFile file(filename);
-
-	if(file.open(QIODevice::ReadOnly))
-	{
-		while(!file.atEnd())
-		{
-			QString line = file.readLine();
-			if(!line.trimmed().startsWith('#') && line.toUpper().contains(match))
-			{
-				int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("NAME="));
-				int ifacename_index_end = QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 6)).lastIndexOf(QString::fromUtf8("\""));
-				iface_name = QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 6, ifacename_index_end));
-				break;
-			}
-		}
-		file.close();
-	}
-
-	return iface_name;
+	return GuestConfig::parseIfaceName(filename, machine->getIfaceFormattedMac(iface), QString("noname%1").arg(iface));
 }
 
 QString VirtualMachine::getIp(uint32_t iface)
 {
-	//read from /etc/sysconfig/network-scripts/ifcfg-IFACE_NAME
-	/*
-	 * DEVICE=eth0
-	 * HWADDR=08:00:27:C9:2D:87
-	 * IPADDR=208.164.186.1
-	 * NETMASK=255.255.255.0
-	 * ONBOOT=yes
-	 * BOOTPROTO=none
-	 */
-	QString iface_ip = QString::fromUtf8("");
 	const QString iface_name = getIfaceName(iface);
 	const QString iface_mac = machine->getIfaceFormattedMac(iface).toUpper();
 
-	bool correct_name = false;
-	bool correct_mac = false;
-
-	QString match_name = QString::fromUtf8("DEVICE=").append(iface_name.toUpper());
-	QString match_mac = QString::fromUtf8("HWADDR=").append(iface_mac.toUpper());
-
 	QString filename = QString::fromStdString(partition_mountpoint_prefix);
 	filename.append(QString::fromUtf8("p%1-u/").arg(OS_PARTITION_NUMBER)).append(NET_SW_SETTINGS_PREFIX).append(iface_name);
 
-// 	QString filename = QString::fromUtf8("/dev/shm/ifcfg-eth0");
-	QFile file(filename);
-
-	if(file.open(QIODevice::ReadOnly))
-	{
-		QString iface_ip_tmp = QString::fromUtf8("");
-		while(!file.atEnd())
-		{
-			QString line = file.readLine();
-			if(!correct_name && line.toUpper().contains(match_name))
-				correct_name = true;
-			if(!correct_mac && line.toUpper().contains(match_mac))
-				correct_mac = true;
-
-			if(line.toUpper().contains(QString::fromUtf8("IPADDR=")))
-			{
-				int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("IPADDR="));
-				iface_ip_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 7))).trimmed();
-			}
-			else if(line.toUpper().contains(QString::fromUtf8("IPV6ADDR=")))
-			{
-				int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("IPV6ADDR="));
-				int ifacename_index_end = line.lastIndexOf(QString::fromUtf8("/"));
-				iface_ip_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 9, ifacename_index_end - (ifacename_index_begin + 9)))).trimmed();
-			}
-				
-		}
+	ifcfg_settings_t ifcfg;
+	if(!GuestConfig::parseIfcfg(filename, iface_name, iface_mac, &ifcfg))
+		return QString::fromUtf8("");
 
-		if(!correct_name)
-			std::cerr << "Warning: iface " << iface << " (" << iface_mac.toStdString() << ", " << iface_name.toStdString() << ") does not match the ifcfg-" << iface_name.toStdString() << " settings file" << std::endl;
+	if(!ifcfg.nameMatches)
+		LOG_WARNING(LOG_VM, "iface %u (%s, %s) does not match the ifcfg-%s settings file", iface, iface_mac.toStdString().c_str(), iface_name.toStdString().c_str(), iface_name.toStdString().c_str());
 
-		if(correct_mac)
-			iface_ip = iface_ip_tmp;
-
-		file.close();
-	}
-
-	return iface_ip;
+	return ifcfg.ip;
 }
 
 QString VirtualMachine::getSubnetMask(uint32_t iface)
 {
-	//read from /etc/sysconfig/network-scripts/ifcfg-IFACE_NAME
-	/*
-	 * DEVICE=eth0
-	 * HWADDR=08:00:27:C9:2D:87
-	 * IPADDR=208.164.186.1
-	 * NETMASK=255.255.255.0
-	 * ONBOOT=yes
-	 * BOOTPROTO=none
-	 */
-	QString iface_subnetMask = QString::fromUtf8("");
 	const QString iface_name = getIfaceName(iface);
 	const QString iface_mac = machine->getIfaceFormattedMac(iface).toUpper();
 
-	bool correct_name = false;
-	bool correct_mac = false;
-
-	QString match_name = QString::fromUtf8("DEVICE=").append(iface_name.toUpper());
-	QString match_mac = QString::fromUtf8("HWADDR=").append(iface_mac.toUpper());
-
 	QString filename = QString::fromStdString(partition_mountpoint_prefix);
 	filename.append(QString::fromUtf8("p%1-u/").arg(OS_PARTITION_NUMBER)).append(NET_SW_SETTINGS_PREFIX).append(iface_name);
 
-// 	QString filename = QString::fromUtf8("/dev/shm/ifcfg-eth0");
-	QFile file(filename);
-
-	if(file.open(QIODevice::ReadOnly))
-	{
-		QString iface_subnetMask_tmp = QString::fromUtf8("");;
-		while(!file.atEnd())
-		{
-			QString line = file.readLine();
-			if(!correct_name && line.toUpper().contains(match_name))
-				correct_name = true;
-			if(!correct_mac && line.toUpper().contains(match_mac))
-				correct_mac = true;
-			
-			if(line.toUpper().contains(QString::fromUtf8("NETMASK=")))
-			{
-				int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("NETMASK="));
-				iface_subnetMask_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 8))).trimmed();
-			}
-#ifdef ENABLE_IPv6
-			else if(line.toUpper().contains(QString::fromUtf8("IPV6ADDR=")))
-			{
-				int ifacename_index_begin = line.lastIndexOf(QString::fromUtf8("/"));
-				if(ifacename_index_begin > -1)
-					iface_subnetMask_tmp = (QString::fromStdString(line.toStdString().substr(ifacename_index_begin + 1))).trimmed();
-			}
-#endif
-		}
-
-		if(correct_mac)
-		{
-			if(!correct_name)
-				std::cerr << "Warning: iface " << iface << " (" << iface_mac.toStdString() << ", " << iface_name.toStdString() << ") does not match the ifcfg-" << iface_name.toStdString() << " settings file" << std::endl;
+	ifcfg_settings_t ifcfg;
+	if(!GuestConfig::parseIfcfg(filename, iface_name, iface_mac, &ifcfg))
+		return QString::fromUtf8("");
 
-			iface_subnetMask = iface_subnetMask_tmp;
-		}
+	if(ifcfg.macMatches && !ifcfg.nameMatches)
+		LOG_WARNING(LOG_VM, "iface %u (%s, %s) does not match the ifcfg-%s settings file", iface, iface_mac.toStdString().c_str(), iface_name.toStdString().c_str(), iface_name.toStdString().c_str());
 
-		file.close();
-	}
-	
-	return iface_subnetMask;
+	return ifcfg.subnetMask;
 }
 
 IMachine *VirtualMachine::clone(QString qName, bool reInitIfaces)
@@ -380,74 +286,59 @@ IMachine *VirtualMachine::clone(QString qName, bool reInitIfaces)
 
 bool VirtualMachine::remove()
 {
-	uint32_t machineState = machine->getState();
-	if(machineState == MachineState::Paused ||
-	   machineState == MachineState::Starting ||
-	   machineState == MachineState::Running)
-		return false;
-
-	return machine->vboxbridge->deleteVM(machine->machine);
+	return machine->remove();
 }
 
 bool VirtualMachine::saveSettings()
 {
+	TRACE_SCOPE_ARG("vm", "saveSettings", vhd_mountpoint.c_str());
+
 	bool succeeded = true;
-	
-	if(!machine->lockMachine())
+	bool machineChanged = false, guestChanged = false;
+
+	for(int i = 0; i < ifaces_size; i++)
+	{
+		machineChanged = machineChanged || ifaces[i]->isDirty(IFACE_DIRTY_MACHINE);
+		guestChanged = guestChanged || ifaces[i]->isDirty(IFACE_DIRTY_GUEST);
+	}
+
+	if(machineChanged && !backend->lockMachine(backend_machine))
 	{
-		std::cerr << "[" << machine->getName().toStdString() <<  "] Cannot lock machine" << std::endl;
+		LOG_ERROR(LOG_VM, "[%s] Cannot lock machine", machine->getName().toStdString().c_str());
 		return false;
 	}
-	
-	/*
-	 * SET VIRTUALBOX PARAMS
-	 */
-	for(int i = 0; i < ifaces_size; i++)
+
+	if(machineChanged && !AdapterSync::writeIfaces(backend, backend_machine, ifaces, ifaces_size))
+		succeeded = false;
+
+	//The guest partition is mounted only if the guest configuration changed
+	if(guestChanged)
+		writeGuestSettings();
+
+	if(machineChanged && !backend->saveSettings(backend_machine))
 	{
-		//Interfaccia abilitata
-		if(!machine->setIfaceEnabled(i, ifaces[i]->enabled))
-		{
-			std::cout << (ifaces[i]->enabled ? "enableIface" : "disableIface") << "(" << i << ")" << std::endl;
-			ifaces[i]->enabled = machine->getIfaceEnabled(machine->getIface(i));
-			succeeded = false;
-		}
-		
-		//Indirizzo MAC
-		if(!machine->setIfaceMac(i, ifaces[i]->mac))
-		{
-			std::cout << "setIfaceMac(" << i << "): false" << std::endl;
-			ifaces[i]->mac = machine->getIfaceMac(i);
-			succeeded = false;
-		}
-		
-		if(ifaces[i]->enabled)
-		{
-			//Collegata
-			if(!machine->setCableConnected(i, ifaces[i]->cableConnected))
-			{
-				std::cout << (ifaces[i]->cableConnected ? "connected" : "not connected") << "(" << i << ")" << std::endl;
-				ifaces[i]->cableConnected = machine->getIfaceCableConnected(machine->getIface(i));
-				succeeded = false;
-			}
-		
-			//Tipo interfaccia
-			if(!machine->setIfaceAttachmentType(i, ifaces[i]->attachmentType))
-			{
-				std::cout << "setIfaceAttachmentType(" << i << ", " << ifaces[i]->attachmentType << ")" << std::endl;
-				ifaces[i]->attachmentType = machine->getAttachmentType(machine->getIface(i));
-				succeeded = false;
-			}
-			
-			//Parametro in base al tipo di interfaccia
-			if(!machine->setAttachmentData(i, ifaces[i]->attachmentType, ifaces[i]->attachmentData))
-			{
-				std::cout << "setAttachmentData(" << i << ", " << ifaces[i]->attachmentData.toStdString() << ")" << std::endl;
-				ifaces[i]->attachmentData = machine->getAttachmentData(i, ifaces[i]->attachmentType);
-				succeeded = false;
-			}
-		}
+		LOG_ERROR(LOG_VM, "saveSettings(): false");
+		succeeded = false;
 	}
 
+	for(int i = 0; i < ifaces_size; i++)
+		ifaces[i]->clearDirty();
+
+	emit settingsChanged(this);
+	vmSettings->backup();
+	vmSettings->journal();
+
+	if(machineChanged && !backend->unlockMachine(backend_machine))
+		return false;
+
+	return succeeded;
+}
+
+void VirtualMachine::writeGuestSettings()
+{
+	TRACE_SCOPE_ARG("vm", "writeGuestSettings", vhd_mountpoint.c_str());
+	uint64_t begin = Trace::now();
+
 	mountVpartition(OS_PARTITION_NUMBER);
 	/*
 	 * SET OS PARAMS
@@ -457,11 +348,11 @@ bool VirtualMachine::saveSettings()
 	filename.append(QString::fromUtf8("p%1-u/").arg(OS_PARTITION_NUMBER)).append(NET_HW_SETTINGS_FILE);
 	
 	QFile hw_file(filename);
-	std::cout << "filename: " << filename.toStdString() << std::endl;
+	LOG_DEBUG(LOG_VM, "filename: %s", filename.toStdString().c_str());
 
 	if(hw_file.exists() && hw_file.open(QIODevice::WriteOnly))
 	{
-		std::cout << "Scrivo sul file " << filename.toStdString() << std::endl;
+		LOG_DEBUG(LOG_VM, "Writing %s", filename.toStdString().c_str());
 		hw_file.write("# This file was automatically generated by the " PROGRAM_NAME " program\n#\n# You can modify it, as long as you keep each rule on a single\n# line, and change only the value of the NAME= key.\n\n");
 
 		for(int i = 0; i < ifaces_size; i++)
@@ -494,11 +385,8 @@ bool VirtualMachine::saveSettings()
 		QString last_filename = QString::fromStdString(partition_mountpoint_prefix).append(QString::fromUtf8("p%1-u/").arg(OS_PARTITION_NUMBER)).append(NET_SW_SETTINGS_PREFIX).append(ifaces[i]->last_valid_name);
 		if(QFile::exists(last_filename))
 		{
-			std::cout << "Removing old configuration file: " << last_filename.toStdString() << "...";
-			if(QFile::remove(last_filename))
-				std::cout << "OK" << std::endl;
-			else
-				std::cout << "FAIL" << std::endl;
+			bool removed = QFile::remove(last_filename);
+			LOG_DEBUG(LOG_VM, "Removing old configuration file: %s...%s", last_filename.toStdString().c_str(), removed ? "OK" : "FAIL");
 		}
 
 		filename = QString::fromStdString(partition_mountpoint_prefix);
@@ -523,7 +411,7 @@ bool VirtualMachine::saveSettings()
 // 			file.write("TYPE=Ethernet\n");
 #ifdef CONFIGURABLE_IP
 #ifdef ENABLE_IPv6
-			if(ifaces[i]->ip.length() > 0 && Iface::isValidIPv6(ifaces[i]->ip))
+			if(ifaces[i]->record.ip.family == IP_FAMILY_IPV6)
 			{
 				file.write("IPV6ADDR="); file.write(ifaces[i]->ip.toStdString().c_str());
 				if(ifaces[i]->subnetMask.length() > 0)
@@ -551,44 +439,54 @@ bool VirtualMachine::saveSettings()
 		file.close();
 	}
 	umountVpartition(OS_PARTITION_NUMBER);
+	OperationsStats::addGuestIo(&operationsStats, Trace::now() - begin);
+}
 
-	if(!machine->saveSettings())
-	{
-		std::cout << "saveSettings(): false" << std::endl;
-		succeeded = false;
-	}
+bool VirtualMachine::saveSettingsRunTime()
+{
+	std::vector<VirtualMachine*> vms(1, this);
+	return saveSettingsRunTime(vms);
+}
 
-	emit settingsChanged(this);
-	vmSettings->backup();
+bool VirtualMachine::saveSettingsRunTime(const std::vector<VirtualMachine*> &vms)
+{
+	bool succeeded = true;
 
-	if(!machine->unlockMachine())
-		return false;
+	//Every machine is reconfigured before any signal, so slots see the whole change at once
+	for(int i = 0; i < vms.size(); i++)
+		succeeded = vms.at(i)->applyRunTime() && succeeded;
+
+	for(int i = 0; i < vms.size(); i++)
+		emit vms.at(i)->settingsChanged(vms.at(i));
 
 	return succeeded;
 }
 
-bool VirtualMachine::saveSettingsRunTime()
+bool VirtualMachine::applyRunTime()
 {
 	bool succeeded = true;
 
 	for(int i = 0; i < ifaces_size; i++)
 	{
-		//Tipo interfaccia
-		if(!machine->setIfaceAttachmentTypeRunTime(i, ifaces[i]->attachmentType))
-		{
-			std::cout << "setIfaceAttachmentType(" << i << ", " << ifaces[i]->attachmentType << ")" << std::endl;
-			succeeded = false;
-		}
+		//Only the fields changed since the last applied settings are sent to VirtualBox
+		const settings_iface_t *saved = (vmSettings != NULL) ? vmSettings->getSavedIface(i) : NULL;
+		bool typeChanged = (saved == NULL || saved->attachmentType != ifaces[i]->attachmentType);
+		bool dataChanged = (typeChanged || QString::fromUtf8(saved->attachmentData) != ifaces[i]->attachmentData);
+
+		if(!typeChanged && !dataChanged)
+			continue;
 
-		//Parametro in base al tipo di interfaccia
-		if(!machine->setAttachmentDataRunTime(i, ifaces[i]->attachmentData))
+		if(!machine->setAttachmentRunTime(i, ifaces[i]->attachmentType, ifaces[i]->attachmentData, typeChanged, dataChanged))
 		{
-			std::cout << "setAttachmentData(" << i << ", " << ifaces[i]->attachmentData.toStdString() << ")" << std::endl;
+			LOG_ERROR(LOG_VM, "setAttachmentRunTime(%d, %u, %s): false", i, ifaces[i]->attachmentType, ifaces[i]->attachmentData.toStdString().c_str());
 			succeeded = false;
+			continue;
 		}
+
+		if(vmSettings != NULL)
+			vmSettings->backupAttachment(i);
 	}
 
-	emit settingsChanged(this);
 	return succeeded;
 }
 
@@ -608,10 +506,11 @@ int VirtualMachine::setIface(int iface, QString name, QString mac)
 
 void VirtualMachine::populateIfaces()
 {
-	std::vector<nsCOMPtr<INetworkAdapter> > networkAdapter_vec = machine->getNetworkInterfaces();
+	std::vector<backend_adapter_t> adapters;
+	AdapterSync::readAdapters(backend, backend_machine, &adapters);
 
 	uint8_t old_ifaces_size = ifaces_size;
-	ifaces_size = networkAdapter_vec.size();
+	ifaces_size = adapters.size();
 	if(old_ifaces_size != ifaces_size || ifaces == NULL)
 	{
 		ifaces = (Iface **)realloc(ifaces, sizeof(Iface*) * ifaces_size);
@@ -624,11 +523,11 @@ void VirtualMachine::populateIfaces()
 	{
 // 		Iface(enabled, mac, cableConnected, attachmentType, attachmentData, name, ip, subnetMask);
 		ifaces[i] = new Iface(
-			  machine->getIfaceEnabled(networkAdapter_vec.at(i))
-			, machine->getIfaceMac(networkAdapter_vec.at(i))
-			, machine->getIfaceCableConnected(networkAdapter_vec.at(i))
-			, machine->getAttachmentType(networkAdapter_vec.at(i))
-			, machine->getAttachmentData(networkAdapter_vec.at(i), machine->getAttachmentType(networkAdapter_vec.at(i)))
+			  adapters.at(i).enabled
+			, adapters.at(i).mac
+			, adapters.at(i).cableConnected
+			, adapters.at(i).attachmentType
+			, adapters.at(i).attachmentData
 			, getIfaceName(i)
 #ifdef CONFIGURABLE_IP
 			, getIp(i)
@@ -637,30 +536,52 @@ void VirtualMachine::populateIfaces()
 		);
 	}
 	umountVpartition(OS_PARTITION_NUMBER);
+}
+
+void VirtualMachine::cleanIfaces(Iface **ifaces_src, int ifaces_src_size)
+{
+	mountVpartition(OS_PARTITION_NUMBER);
+	removeGuestIfaces(ifaces_src, std::min((int) ifaces_size, ifaces_src_size));
+	umountVpartition(OS_PARTITION_NUMBER);
+}
+
+bool VirtualMachine::cleanClone(IMachine *clone)
+{
+	TRACE_SCOPE_ARG("vm", "cleanClone", vhd_mountpoint.c_str());
+
+	if(vhd_mounted)
+		return false;
 
-	while(networkAdapter_vec.size() > 0)
+	std::stringstream partition; partition << vhd_mountpoint << "p" << OS_PARTITION_NUMBER;
+	std::stringstream partition_mountpoint;	partition_mountpoint << partition_mountpoint_prefix << "p" << OS_PARTITION_NUMBER;
+	std::stringstream partition_usermountpoint; partition_usermountpoint << partition_mountpoint_prefix << "p" << OS_PARTITION_NUMBER << "-u";
+
+	if(!OSBridge::mountVHD(MachineBridge::getHardDiskFilePath(clone).toStdString(), vhd_mountpoint))
+		return false;
+
+	bool succeeded = OSBridge::mountVpartition(partition.str(), partition_mountpoint.str(), partition_usermountpoint.str());
+	if(succeeded)
 	{
-		networkAdapter_vec.back() = nsnull;
-		networkAdapter_vec.pop_back();
+		removeGuestIfaces(ifaces, ifaces_size);
+		OSBridge::umountVpartition(partition_usermountpoint.str());
+		OSBridge::umountVpartition(partition_mountpoint.str());
 	}
+
+	OSBridge::umountVHD(vhd_mountpoint);
+	return succeeded;
 }
 
-void VirtualMachine::cleanIfaces(Iface **ifaces_src, int ifaces_src_size)
+void VirtualMachine::removeGuestIfaces(Iface **ifaces_src, int ifaces_src_size)
 {
-	mountVpartition(OS_PARTITION_NUMBER);
-	for(int i = 0; i < std::min((int) ifaces_size, ifaces_src_size); i++)
+	for(int i = 0; i < ifaces_src_size; i++)
 	{
 		QString filename = QString::fromStdString(partition_mountpoint_prefix).append(QString::fromUtf8("p%1-u/").arg(OS_PARTITION_NUMBER)).append(NET_SW_SETTINGS_PREFIX).append(ifaces_src[i]->last_valid_name);
 		if(QFile::exists(filename))
 		{
-			std::cout << "Removing old configuration file: " << filename.toStdString() << "...";
-			if(QFile::remove(filename))
-				std::cout << "OK" << std::endl;
-			else
-				std::cout << "FAIL" << std::endl;
+			bool removed = QFile::remove(filename);
+			LOG_DEBUG(LOG_VM, "Removing old configuration file: %s...%s", filename.toStdString().c_str(), removed ? "OK" : "FAIL");
 		}
 	}
-	umountVpartition(OS_PARTITION_NUMBER);
 }
 
 void VirtualMachine::copyIfaces(Iface **ifaces_src, int ifaces_src_size)
@@ -668,15 +589,20 @@ void VirtualMachine::copyIfaces(Iface **ifaces_src, int ifaces_src_size)
 	for(int i = 0; i < std::min((int) ifaces_size, ifaces_src_size); i++)
 	{
 		ifaces[i]->name = ifaces_src[i]->name;
+		ifaces[i]->markDirty(IFACE_DIRTY_NAME);
 #ifdef CONFIGURABLE_IP
-		ifaces[i]->ip = ifaces_src[i]->ip;
-		ifaces[i]->subnetMask = ifaces_src[i]->subnetMask;
+		ifaces[i]->setIp(ifaces_src[i]->ip);
+		ifaces[i]->setSubnetMask(ifaces_src[i]->subnetMask);
+		ifaces[i]->markDirty(IFACE_DIRTY_IP | IFACE_DIRTY_SUBNETMASK);
 #endif
 	}
 }
 
 bool VirtualMachine::setNetworkAdapterData(int iface, ifacekey_t key, void *value_ptr)
 {
+	if(iface < ifaces_size)
+		ifaces[iface]->markDirty(dirtyField(key));
+
 	switch(key)
 	{
 		case IFACE_ENABLED:
@@ -733,6 +659,24 @@ bool VirtualMachine::setNetworkAdapterData(int iface, ifacekey_t key, void *valu
 	return false;
 }
 
+uint32_t VirtualMachine::dirtyField(ifacekey_t key)
+{
+	switch(key)
+	{
+		case IFACE_ENABLED:		return IFACE_DIRTY_ENABLED;
+		case IFACE_MAC:			return IFACE_DIRTY_MAC;
+		case IFACE_CONNECTED:		return IFACE_DIRTY_CONNECTED;
+		case IFACE_NAME:		return IFACE_DIRTY_NAME;
+#ifdef CONFIGURABLE_IP
+		case IFACE_IP:			return IFACE_DIRTY_IP;
+		case IFACE_SUBNETMASK:		return IFACE_DIRTY_SUBNETMASK;
+#endif
+		case IFACE_ATTACHMENT_TYPE:	return IFACE_DIRTY_ATTACHMENT_TYPE;
+		case IFACE_ATTACHMENT_DATA:	return IFACE_DIRTY_ATTACHMENT_DATA;
+		default:			return 0;
+	}
+}
+
 void VirtualMachine::setSerializableIface(int iface, settings_iface_t settings_iface)
 {
 	if(iface < ifaces_size)
@@ -751,6 +695,7 @@ void VirtualMachine::setSerializableIface(int iface, settings_iface_t settings_i
 	}
 
 	emit ifaceChanged(iface);
+	emit attachmentChanged(this, iface);
 }
 
 bool VirtualMachine::operator==(VirtualMachine *vm)
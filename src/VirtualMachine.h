@@ -28,6 +28,8 @@
 #include <iostream>
 #include "Iface.h"
 #include "VirtualBoxBridge.h"
+#include "HypervisorBackend.h"
+#include "OperationsStats.h"
 
 typedef enum
 {
@@ -48,6 +50,13 @@ class VMTabSettings;
 class SummaryDialog;
 class VMSettings;
 class MachinesDialog;
+class ImportExecutor;
+class NetworkTopology;
+class MacAllocator;
+class IpPlan;
+class MachinesArchive;
+class CliController;
+class OperationsDialog;
 
 class VirtualMachine : QObject
 {
@@ -56,16 +65,35 @@ class VirtualMachine : QObject
 	friend class SummaryDialog;
 	friend class VMSettings;
 	friend class MachinesDialog;
+	friend class ImportExecutor;
+	friend class NetworkTopology;
+	friend class MacAllocator;
+	friend class IpPlan;
+	friend class MachinesArchive;
+	friend class CliController;
+	friend class OperationsDialog;
+	friend class VMCommandExecutor;
 
 	Q_OBJECT;
 
 	public:
-		VirtualMachine(MachineBridge *machine, std::string vhd_mountpoint, std::string partition_mountpoint_prefix);
+		/**
+		 * Adapters, locks and state of machine are handled through
+		 * backend, machine index backend_machine; a backend over machine
+		 * alone is created if it is NULL
+		 */
+		VirtualMachine(MachineBridge *machine, std::string vhd_mountpoint, std::string partition_mountpoint_prefix, HypervisorBackend *backend = NULL, int backend_machine = 0);
 		~VirtualMachine();
 
 		bool mountVpartition(int index, bool readonly = false);
 		bool umountVpartition(int index);
-		bool start();
+
+		/**
+		 * This function writes the cable states of settings_ifaces, a copy
+		 * of the ifaces taken on the GUI thread, and starts the machine
+		 */
+		bool start(const std::vector<settings_iface_t> &settings_ifaces);
+		uint32_t getState() const { return backend->getState(backend_machine); };
 		bool ACPIstop() const { return machine->stop(); };
 		bool stop() const { return machine->stop(true); };
 		bool enterPause() const { return machine->pause(true); };
@@ -76,7 +104,19 @@ class VirtualMachine : QObject
 		IMachine *clone(QString qName, bool reInitIfaces);
 		bool remove();
 		bool saveSettings();
+
+		/**
+		 * This function applies to the running machine the attachments
+		 * changed since its last applied settings, then notifies the changes
+		 */
 		bool saveSettingsRunTime();
+
+		/**
+		 * This function applies to each running machine of vms the
+		 * attachments changed since its last applied settings, then
+		 * notifies the changes of every machine
+		 */
+		static bool saveSettingsRunTime(const std::vector<VirtualMachine*> &vms);
 		bool loadSettings(QString filename);
 
 #ifdef CONFIGURABLE_IP
@@ -86,6 +126,13 @@ class VirtualMachine : QObject
 #endif
 		void populateIfaces();	
 		void cleanIfaces(Iface **ifaces_src, int ifaces_src_size);
+
+		/**
+		 * This function removes the guest settings of the ifaces of this
+		 * machine from the disk of clone, mounted on the nbd device of this
+		 * machine since clone has none yet
+		 */
+		bool cleanClone(IMachine *clone);
 		void copyIfaces(Iface **ifaces_src, int ifaces_src_size);
 		bool setNetworkAdapterData(int iface, ifacekey_t key, void *value_ptr);
 		void setSerializableIface(int iface, settings_iface_t settings_iface);
@@ -103,9 +150,16 @@ class VirtualMachine : QObject
 		void operator=(const VirtualMachine &vm);
 
 	private:
+		bool applyRunTime();
+		static uint32_t dirtyField(ifacekey_t key);
+		void writeGuestSettings();
+		void removeGuestIfaces(Iface **ifaces_src, int ifaces_src_size);
 		bool mountVHD();
 		bool umountVHD();
 		MachineBridge *machine;
+		HypervisorBackend *backend;
+		int backend_machine;
+		bool backend_owned;
 		uint8_t ifaces_size;
 		Iface **ifaces;
 		std::string vhd_mountpoint;
@@ -113,10 +167,12 @@ class VirtualMachine : QObject
 		std::vector<std::string> mounted_partitions_vec;
 		bool vhd_mounted;
 		VMSettings *vmSettings;
+		vm_operations_stats_t operationsStats;
 
 	signals:
 		void settingsChanged(VirtualMachine *vm);
 		void ifaceChanged(int iface);
+		void attachmentChanged(VirtualMachine *vm, int iface);
 };
 
 #endif //VIRTUALMACHINE_H
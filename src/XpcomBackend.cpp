@@ -0,0 +1,184 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "XpcomBackend.h"
+
+XpcomProgress::XpcomProgress(IProgress *progress)
+: progress(progress)
+{
+
+}
+
+XpcomProgress::~XpcomProgress()
+{
+	progress = nsnull;
+}
+
+bool XpcomProgress::isCompleted()
+{
+	PRBool completed;
+	nsresult rc;
+
+	NS_CHECK_AND_DEBUG_ERROR(progress, GetCompleted(&completed), rc);
+
+	//A progress which cannot be read anymore is never going to complete
+	return NS_FAILED(rc) || completed;
+}
+
+uint32_t XpcomProgress::getPercent()
+{
+	PRUint32 percent;
+	nsresult rc;
+
+	NS_CHECK_AND_DEBUG_ERROR(progress, GetPercent(&percent), rc);
+
+	return NS_SUCCEEDED(rc) ? percent : 0;
+}
+
+int32_t XpcomProgress::getResultCode()
+{
+	PRInt32 resultCode;
+	nsresult rc;
+
+	NS_CHECK_AND_DEBUG_ERROR(progress, GetResultCode(&resultCode), rc);
+
+	return NS_SUCCEEDED(rc) ? resultCode : rc;
+}
+
+void XpcomProgress::waitForCompletion(int timeout)
+{
+	nsresult rc;
+	NS_CHECK_AND_DEBUG_ERROR(progress, WaitForCompletion(timeout), rc);
+}
+
+XpcomBackend::XpcomBackend(std::vector<MachineBridge*> *machines_vec)
+: machines_vec(machines_vec)
+{
+
+}
+
+XpcomBackend::XpcomBackend(MachineBridge *machine)
+: machines_vec(&single_machine_vec), single_machine_vec(1, machine)
+{
+
+}
+
+XpcomBackend::~XpcomBackend()
+{
+
+}
+
+int XpcomBackend::getMachinesCount()
+{
+	return machines_vec->size();
+}
+
+QString XpcomBackend::getName(int machine)
+{
+	return machines_vec->at(machine)->getName();
+}
+
+QString XpcomBackend::getUUID(int machine)
+{
+	return machines_vec->at(machine)->getUUID();
+}
+
+uint32_t XpcomBackend::getState(int machine)
+{
+	return machines_vec->at(machine)->getState();
+}
+
+uint32_t XpcomBackend::getMaxNetworkAdapters(int machine)
+{
+	return machines_vec->at(machine)->getMaxNetworkAdapters();
+}
+
+bool XpcomBackend::getAdapter(int machine, uint32_t slot, backend_adapter_t *adapter)
+{
+	MachineBridge *machineBridge = machines_vec->at(machine);
+	ComPtr<INetworkAdapter> iface = machineBridge->getIface(slot);
+	if(iface == nsnull)
+		return false;
+
+	adapter->enabled = MachineBridge::getIfaceEnabled(iface);
+	adapter->mac = machineBridge->getIfaceFormattedMac(iface);
+	adapter->cableConnected = machineBridge->getIfaceCableConnected(iface);
+	adapter->attachmentType = machineBridge->getAttachmentType(iface);
+	adapter->attachmentData = machineBridge->getAttachmentData(iface, adapter->attachmentType);
+
+	return true;
+}
+
+bool XpcomBackend::setAdapter(int machine, uint32_t slot, const backend_adapter_t *adapter, uint32_t fields)
+{
+	MachineBridge *machineBridge = machines_vec->at(machine);
+	ComPtr<INetworkAdapter> iface = machineBridge->getIface(slot);
+	if(iface == nsnull)
+		return false;
+
+	bool succeeded = true;
+
+	if(fields & ADAPTER_FIELD_ENABLED)
+		succeeded = machineBridge->setIfaceEnabled(iface, adapter->enabled) && succeeded;
+	if(fields & ADAPTER_FIELD_MAC)
+		succeeded = machineBridge->setIfaceMac(iface, adapter->mac) && succeeded;
+	if(fields & ADAPTER_FIELD_CONNECTED)
+		succeeded = machineBridge->setCableConnected(iface, adapter->cableConnected) && succeeded;
+	if(fields & ADAPTER_FIELD_ATTACHMENT_TYPE)
+		succeeded = machineBridge->setIfaceAttachmentType(iface, adapter->attachmentType) && succeeded;
+	if(fields & ADAPTER_FIELD_ATTACHMENT_DATA)
+		succeeded = machineBridge->setAttachmentData(iface, adapter->attachmentType, adapter->attachmentData) && succeeded;
+
+	return succeeded;
+}
+
+bool XpcomBackend::lockMachine(int machine)
+{
+	return machines_vec->at(machine)->lockMachine();
+}
+
+bool XpcomBackend::saveSettings(int machine)
+{
+	return machines_vec->at(machine)->saveSettings();
+}
+
+bool XpcomBackend::unlockMachine(int machine)
+{
+	return machines_vec->at(machine)->unlockMachine();
+}
+
+HypervisorProgress *XpcomBackend::launch(int machine)
+{
+	nsCOMPtr<IProgress> progress = machines_vec->at(machine)->launch();
+	if(progress == nsnull)
+		return NULL;
+
+	return new XpcomProgress(progress);
+}
+
+HypervisorProgress *XpcomBackend::powerDown(int machine)
+{
+	nsCOMPtr<IProgress> progress = machines_vec->at(machine)->powerDown();
+	if(progress == nsnull)
+		return NULL;
+
+	return new XpcomProgress(progress);
+}
@@ -0,0 +1,85 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef XPCOMBACKEND_H
+#define XPCOMBACKEND_H
+
+#include <vector>
+
+#include "HypervisorBackend.h"
+#include "VirtualBoxBridge.h"
+
+/**
+ * Progress of a VirtualBox operation
+ */
+class XpcomProgress : public HypervisorProgress
+{
+	public:
+		XpcomProgress(IProgress *progress);
+		virtual ~XpcomProgress();
+
+		bool isCompleted();
+		uint32_t getPercent();
+		int32_t getResultCode();
+		void waitForCompletion(int timeout);
+
+	private:
+		nsCOMPtr<IProgress> progress;
+};
+
+/**
+ * HypervisorBackend over the MachineBridges read from VirtualBox. The
+ * machines vector is not copied, so machines appended later are seen too.
+ */
+class XpcomBackend : public HypervisorBackend
+{
+	public:
+		XpcomBackend(std::vector<MachineBridge*> *machines_vec);
+
+		/**
+		 * This function creates a backend with machine as its only
+		 * machine, index 0
+		 */
+		XpcomBackend(MachineBridge *machine);
+		virtual ~XpcomBackend();
+
+		int getMachinesCount();
+		QString getName(int machine);
+		QString getUUID(int machine);
+		uint32_t getState(int machine);
+		uint32_t getMaxNetworkAdapters(int machine);
+
+		bool getAdapter(int machine, uint32_t slot, backend_adapter_t *adapter);
+		bool setAdapter(int machine, uint32_t slot, const backend_adapter_t *adapter, uint32_t fields = ADAPTER_FIELD_ALL);
+
+		bool lockMachine(int machine);
+		bool saveSettings(int machine);
+		bool unlockMachine(int machine);
+
+		HypervisorProgress *launch(int machine);
+		HypervisorProgress *powerDown(int machine);
+
+	private:
+		std::vector<MachineBridge*> *machines_vec;
+		std::vector<MachineBridge*> single_machine_vec;
+};
+
+#endif //XPCOMBACKEND_H
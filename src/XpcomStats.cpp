@@ -0,0 +1,104 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "XpcomStats.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cxxabi.h>
+
+std::map<std::string, xpcom_method_stats_t*> XpcomStats::methods;
+pthread_mutex_t XpcomStats::mutex = PTHREAD_MUTEX_INITIALIZER;
+
+xpcom_method_stats_t *XpcomStats::method(const char *interface, const char *call)
+{
+	int status;
+	char *demangled = abi::__cxa_demangle(interface, NULL, NULL, &status);
+	std::string name = (status == 0 && demangled != NULL) ? demangled : interface;
+	free(demangled);
+
+	//Arguments are dropped, only the method name is kept
+	name.append("::");
+	for(const char *c = call; *c != '\0' && *c != '('; c++)
+		if(*c != ' ')
+			name.push_back(*c);
+
+	pthread_mutex_lock(&mutex);
+	xpcom_method_stats_t *stats;
+	std::map<std::string, xpcom_method_stats_t*>::iterator it = methods.find(name);
+	if(it != methods.end())
+		stats = it->second;
+	else
+	{
+		stats = (xpcom_method_stats_t *)malloc(sizeof(xpcom_method_stats_t));
+		memset(stats, 0, sizeof(xpcom_method_stats_t));
+		strncpy(stats->name, name.c_str(), sizeof(stats->name) - 1);
+		methods[name] = stats;
+	}
+	pthread_mutex_unlock(&mutex);
+
+	return stats;
+}
+
+static bool moreCalls(const xpcom_method_stats_t &a, const xpcom_method_stats_t &b)
+{
+	return a.calls > b.calls;
+}
+
+std::vector<xpcom_method_stats_t> XpcomStats::snapshot()
+{
+	std::vector<xpcom_method_stats_t> stats;
+
+	pthread_mutex_lock(&mutex);
+	for(std::map<std::string, xpcom_method_stats_t*>::iterator it = methods.begin(); it != methods.end(); it++)
+		stats.push_back(*it->second);
+	pthread_mutex_unlock(&mutex);
+
+	std::sort(stats.begin(), stats.end(), moreCalls);
+	return stats;
+}
+
+void XpcomStats::report(std::ostream &out)
+{
+	std::vector<xpcom_method_stats_t> stats = snapshot();
+	uint64_t calls = 0, failures = 0, total_ns = 0;
+	char line[256];
+
+	snprintf(line, sizeof(line), "%10s %10s %12s %10s %10s  %s", "calls", "failures", "total ms", "avg us", "max us", "method");
+	out << "XPCOM calls:" << std::endl << line << std::endl;
+
+	for(int i = 0; i < stats.size(); i++)
+	{
+		const xpcom_method_stats_t *s = &stats.at(i);
+		snprintf(line, sizeof(line), "%10llu %10llu %12.3f %10.1f %10.1f  %s",
+			 (unsigned long long) s->calls, (unsigned long long) s->failures,
+			 s->total_ns / 1e6, (s->calls > 0) ? s->total_ns / 1e3 / s->calls : 0.0, s->max_ns / 1e3, s->name);
+		out << line << std::endl;
+
+		calls += s->calls;
+		failures += s->failures;
+		total_ns += s->total_ns;
+	}
+
+	snprintf(line, sizeof(line), "%10llu %10llu %12.3f  total, %d methods", (unsigned long long) calls, (unsigned long long) failures, total_ns / 1e6, (int) stats.size());
+	out << line << std::endl;
+}
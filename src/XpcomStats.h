@@ -0,0 +1,88 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef XPCOMSTATS_H
+#define XPCOMSTATS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <pthread.h>
+#include <stdint.h>
+
+/** Command line option printing the XPCOM call statistics on exit */
+#define XPCOM_STATS_ARG "--stats"
+
+typedef struct
+{
+	char name[128];
+	volatile uint64_t calls;
+	volatile uint64_t failures;
+	volatile uint64_t total_ns;
+	volatile uint64_t max_ns;
+} xpcom_method_stats_t;
+
+/**
+ * Counters of the VirtualBox calls made through NS_CHECK_AND_DEBUG_ERROR,
+ * one for each interface method (e.g. IMachine::GetNetworkAdapter): calls,
+ * failures, cumulative and maximum latency. Each call site looks its counters
+ * up once; afterwards a call only adds to them atomically.
+ */
+class XpcomStats
+{
+	public:
+		/**
+		 * This function returns the counters of the method called by
+		 * call (the call text, e.g. "GetState(&state)") on the interface
+		 * whose mangled type name is interface, creating them if needed
+		 */
+		static xpcom_method_stats_t *method(const char *interface, const char *call);
+
+		static inline void add(xpcom_method_stats_t *stats, uint64_t ns, bool failed)
+		{
+			__sync_fetch_and_add(&stats->calls, 1);
+			__sync_fetch_and_add(&stats->total_ns, ns);
+			if(failed)
+				__sync_fetch_and_add(&stats->failures, 1);
+
+			uint64_t max_ns = stats->max_ns;
+			while(ns > max_ns && !__sync_bool_compare_and_swap(&stats->max_ns, max_ns, ns))
+				max_ns = stats->max_ns;
+		};
+
+		/**
+		 * This function returns a copy of the counters of every method
+		 * called so far, the most called first
+		 */
+		static std::vector<xpcom_method_stats_t> snapshot();
+
+		/**
+		 * This function writes a table of the counters to out
+		 */
+		static void report(std::ostream &out);
+
+	private:
+		static std::map<std::string, xpcom_method_stats_t*> methods;
+		static pthread_mutex_t mutex;
+};
+
+#endif //XPCOMSTATS_H
@@ -24,6 +24,12 @@
 #include <QtGui/QApplication>
 #include "MainWindow.h"
 #include "OSBridge.h"
+#include "VMSettingsJournal.h"
+#include "VMCommandExecutor.h"
+#include "Trace.h"
+#include "XpcomStats.h"
+#include "SignalSpy.h"
+#include "Log.h"
 #ifdef EXAM_MODE
 	#include "ExamDialog.h"
 #endif
@@ -36,6 +42,11 @@ int main(int argc, char** argv)
 {
 	QApplication app(argc, argv);
 	QStringList args = QApplication::arguments();
+	Trace::init();
+	Log::init();
+
+	//Statistics of the VirtualBox calls are reported on exit
+	bool stats = args.removeAll(XPCOM_STATS_ARG) > 0;
 
 	if(OSBridge::checkNbdModule())
 		std::cout << "Module nbd loaded" << std::endl;
@@ -65,7 +76,15 @@ int main(int argc, char** argv)
 	mw.show();
 	retval = app.exec();
 #endif
-	
+
+	//Queued machine commands complete before their journal entries are written
+	VMCommandExecutor::shutdown();
+	VMSettingsJournal::shutdown();
+	SignalLogger::shutdown();
+	Log::shutdown();
+	Trace::shutdown();
+	if(stats)
+		XpcomStats::report(std::cout);
 	std::cout << "All done." << std::endl;
 	return retval;
 }
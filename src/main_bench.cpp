@@ -0,0 +1,708 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// VB-ANT - VirtualBox - Advanced Network Tool, benchmark dei percorsi critici
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <QFile>
+#include <QByteArray>
+
+#include "AdapterSync.h"
+#include "Benchmark.h"
+#include "crc32.h"
+#include "FakeBackend.h"
+#include "GuestConfig.h"
+#include "Iface.h"
+#include "MachinesArchive.h"
+#include "VMSettings.h"
+#include "Log.h"
+#ifdef USE_ZLIB
+#include "ZlibWrapper.h"
+#endif
+
+#define EXIT_USAGE 2
+
+/** Ifaces of each synthetic machine, as a machine with the PIIX3 chipset */
+#define BENCH_IFACES 8
+
+/** Machines of the synthetic lab used by the backend benchmarks */
+#define BENCH_BACKEND_MACHINES 100
+
+/** Directory of the generated files, a tmpfs if available */
+static std::string bench_dir;
+
+/** The compiler cannot drop the measured calls whose result is added here */
+static volatile uint64_t sink;
+
+static void usage(const char *program)
+{
+	std::cerr << "Usage: " << program << " [options]" << std::endl
+		  << "  --out <file>      write the JSON results to file instead of stdout" << std::endl
+		  << "  --filter <text>   run only the benchmarks whose name contains text" << std::endl
+		  << "  --min-time <ms>   minimum duration of each benchmark (default " << BENCHMARK_MIN_TIME << ")" << std::endl
+		  << "  --latency <us>    latency of each fake backend call (default 0)" << std::endl
+		  << "  --progress <ms>   duration of each fake backend launch and power down (default 0)" << std::endl;
+}
+
+static std::string number(int n)
+{
+	std::stringstream ss; ss << n;
+	return ss.str();
+}
+
+static void fillIface(settings_iface_t *settings_iface, int machine, int iface)
+{
+	memset(settings_iface, 0, sizeof(settings_iface_t));
+	snprintf(settings_iface->last_valid_name, sizeof(settings_iface->last_valid_name), "eth%d", iface);
+	snprintf(settings_iface->name, sizeof(settings_iface->name), "eth%d", iface);
+	snprintf(settings_iface->mac, sizeof(settings_iface->mac), "08:00:27:%02X:%02X:%02X", (machine >> 8) & 0xFF, machine & 0xFF, iface);
+	snprintf(settings_iface->attachmentData, sizeof(settings_iface->attachmentData), "intnet%d", iface);
+	snprintf(settings_iface->ip, sizeof(settings_iface->ip), "10.%d.%d.%d", iface, machine / 250, machine % 250 + 1);
+	snprintf(settings_iface->subnetMask, sizeof(settings_iface->subnetMask), "255.255.0.0");
+	settings_iface->attachmentType = NetworkAttachmentType::Internal;
+	settings_iface->enabled = true;
+	settings_iface->cableConnected = true;
+}
+
+/*
+ * Checksum and compression
+ */
+
+typedef struct
+{
+	char *buffer;
+	uint32_t size;
+} buffer_data_t;
+
+static void bench_crc32_add(void *data, uint64_t iterations)
+{
+	buffer_data_t *d = (buffer_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		CRC32 crc32;
+		crc32.add(d->buffer, d->size);
+		sink += crc32.getHash().size();
+	}
+}
+
+#ifdef USE_ZLIB
+static void bench_zlib_def(void *data, uint64_t iterations)
+{
+	buffer_data_t *d = (buffer_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		char *deflated;
+		sink += ZlibWrapper::def(&deflated, d->buffer, d->size, -1);
+		free(deflated);
+	}
+}
+
+static void bench_zlib_inf(void *data, uint64_t iterations)
+{
+	buffer_data_t *d = (buffer_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		char *inflated;
+		sink += ZlibWrapper::inf(&inflated, d->buffer, d->size);
+		free(inflated);
+	}
+}
+#endif
+
+/*
+ * Machine settings
+ */
+
+typedef struct
+{
+	settings_iface_t ifaces[BENCH_IFACES];
+	char *serialized_ifaces;
+} ifaces_data_t;
+
+static void bench_serialize(void *data, uint64_t iterations)
+{
+	ifaces_data_t *d = (ifaces_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		char *serialized_ifaces = NULL;
+		sink += VMSettings::serialize(&serialized_ifaces, d->ifaces, BENCH_IFACES);
+		free(serialized_ifaces);
+	}
+}
+
+static void bench_deserialize(void *data, uint64_t iterations)
+{
+	ifaces_data_t *d = (ifaces_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		settings_iface_t *settings_ifaces = NULL;
+		sink += VMSettings::deserialize(&settings_ifaces, d->serialized_ifaces, BENCH_IFACES);
+		free(settings_ifaces);
+	}
+}
+
+static void bench_ifaces_checksum(void *data, uint64_t iterations)
+{
+	ifaces_data_t *d = (ifaces_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += VMSettings::get_ifaces_checksum(&d->serialized_ifaces, BENCH_IFACES).size();
+}
+
+/*
+ * Machines set files
+ */
+
+typedef struct
+{
+	std::vector<machine_record_t> records;
+	std::vector<char*> serialized_ifaces;
+	QString fileName;
+	char type;
+} archive_data_t;
+
+static void archive_init(archive_data_t *d, int machines, char type)
+{
+	for(int m = 0; m < machines; m++)
+	{
+		settings_iface_t ifaces[BENCH_IFACES];
+		for(int i = 0; i < BENCH_IFACES; i++)
+			fillIface(&ifaces[i], m, i);
+
+		char *serialized_ifaces = NULL;
+		machine_record_t record;
+		memset(&record.settings_header, 0, sizeof(settings_header_t));
+		snprintf(record.settings_header.machine_name, sizeof(record.settings_header.machine_name), "vm%d", m);
+		snprintf(record.settings_header.machine_uuid, sizeof(record.settings_header.machine_uuid), "00000000-0000-0000-0000-%012x", m);
+		record.settings_header.settings_iface_size = BENCH_IFACES;
+		record.serialized_ifaces_size = VMSettings::serialize(&serialized_ifaces, ifaces, BENCH_IFACES);
+		record.serialized_ifaces = serialized_ifaces;
+		strncpy(record.settings_header.ifaces_checksum, VMSettings::get_ifaces_checksum(&serialized_ifaces, BENCH_IFACES).c_str(), sizeof(record.settings_header.ifaces_checksum) - 1);
+
+		d->records.push_back(record);
+		d->serialized_ifaces.push_back(serialized_ifaces);
+	}
+
+	d->type = type;
+	d->fileName = QString::fromStdString(bench_dir + "/machines_" + number(machines) + "_" + type + ".vbs");
+	MachinesArchive::write(d->fileName, d->records, d->type);
+}
+
+static void archive_free(archive_data_t *d)
+{
+	for(int i = 0; i < d->serialized_ifaces.size(); i++)
+		free(d->serialized_ifaces.at(i));
+
+	QFile::remove(d->fileName);
+}
+
+static void bench_archive_write(void *data, uint64_t iterations)
+{
+	archive_data_t *d = (archive_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += MachinesArchive::write(d->fileName, d->records, d->type);
+}
+
+static void bench_archive_read(void *data, uint64_t iterations)
+{
+	archive_data_t *d = (archive_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		//As an import: every iface of every machine is read
+		MachinesArchive archive;
+		if(archive.open(d->fileName) != NO_ERROR)
+			continue;
+
+		for(uint32_t m = 0; m < archive.size(); m++)
+			for(int j = 0; j < archive.header(m)->settings_iface_size; j++)
+				sink += MachinesArchive::field(archive.ifaces(m)[j].ip, sizeof(settings_iface_t::ip)).size();
+	}
+}
+
+/*
+ * Iface validators
+ */
+
+typedef struct
+{
+	std::vector<QString> names;
+	std::vector<QString> macs;
+	std::vector<QString> ips;
+	std::vector<QString> subnetMasks;
+} validators_data_t;
+
+static void bench_valid_name(void *data, uint64_t iterations)
+{
+	validators_data_t *d = (validators_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += Iface::isValidName(d->names.at(i % d->names.size()));
+}
+
+static void bench_valid_mac(void *data, uint64_t iterations)
+{
+	validators_data_t *d = (validators_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += Iface::isValidMac(d->macs.at(i % d->macs.size()));
+}
+
+static void bench_format_mac(void *data, uint64_t iterations)
+{
+	validators_data_t *d = (validators_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += Iface::formatMac(d->macs.at(i % d->macs.size())).size();
+}
+
+#ifdef CONFIGURABLE_IP
+static void bench_valid_ip(void *data, uint64_t iterations)
+{
+	validators_data_t *d = (validators_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += Iface::isValidIPv4(d->ips.at(i % d->ips.size()));
+}
+
+static void bench_valid_subnetmask(void *data, uint64_t iterations)
+{
+	validators_data_t *d = (validators_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += Iface::isValidSubnetMask(d->subnetMasks.at(i % d->subnetMasks.size()), d->ips.at(i % d->ips.size()));
+}
+#endif
+
+/*
+ * Guest configuration files
+ */
+
+typedef struct
+{
+	QString udev_fileName;
+	QString ifcfg_prefix;
+	std::vector<QString> macs;
+} guest_data_t;
+
+static void guest_init(guest_data_t *d)
+{
+	d->udev_fileName = QString::fromStdString(bench_dir + "/70-persistent-net.rules");
+	d->ifcfg_prefix = QString::fromStdString(bench_dir + "/ifcfg-");
+
+	//Files as written by a guest which saw each adapter once
+	std::ofstream udev(d->udev_fileName.toStdString().c_str());
+	udev << "# This file was automatically generated by the /lib/udev/write_net_rules" << std::endl
+	     << "# program, run by the persistent-net-generator.rules rules file." << std::endl << std::endl;
+
+	for(int i = 0; i < BENCH_IFACES; i++)
+	{
+		settings_iface_t settings_iface;
+		fillIface(&settings_iface, 1, i);
+		d->macs.push_back(QString::fromUtf8(settings_iface.mac));
+
+		udev << "# PCI device 0x8086:0x100e (e1000)" << std::endl
+		     << "SUBSYSTEM==\"net\", ACTION==\"add\", DRIVERS==\"?*\", ATTR{address}==\"" << settings_iface.mac
+		     << "\", ATTR{dev_id}==\"0x0\", ATTR{type}==\"1\", KERNEL==\"eth*\", NAME=\"" << settings_iface.name << "\"" << std::endl << std::endl;
+
+		std::ofstream ifcfg((d->ifcfg_prefix.toStdString() + settings_iface.name).c_str());
+		ifcfg << "DEVICE=" << settings_iface.name << std::endl
+		      << "HWADDR=" << settings_iface.mac << std::endl
+		      << "IPADDR=" << settings_iface.ip << std::endl
+		      << "NETMASK=" << settings_iface.subnetMask << std::endl
+		      << "ONBOOT=yes" << std::endl
+		      << "BOOTPROTO=none" << std::endl;
+	}
+}
+
+static void guest_free(guest_data_t *d)
+{
+	QFile::remove(d->udev_fileName);
+	for(int i = 0; i < BENCH_IFACES; i++)
+		QFile::remove(d->ifcfg_prefix + QString("eth%1").arg(i));
+}
+
+static void bench_parse_iface_name(void *data, uint64_t iterations)
+{
+	guest_data_t *d = (guest_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+		sink += GuestConfig::parseIfaceName(d->udev_fileName, d->macs.at(i % BENCH_IFACES), "noname").size();
+}
+
+static void bench_parse_ifcfg(void *data, uint64_t iterations)
+{
+	guest_data_t *d = (guest_data_t *) data;
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		//As VirtualMachine::getIp: the udev rules are read first to find the ifcfg file
+		QString name = GuestConfig::parseIfaceName(d->udev_fileName, d->macs.at(i % BENCH_IFACES), "noname");
+		ifcfg_settings_t ifcfg;
+		if(GuestConfig::parseIfcfg(d->ifcfg_prefix + name, name, d->macs.at(i % BENCH_IFACES), &ifcfg))
+			sink += ifcfg.ip.size();
+	}
+}
+
+/*
+ * Hypervisor backend
+ */
+
+typedef struct
+{
+	FakeBackend *backend;
+	std::vector<std::vector<Iface*> > ifaces;
+} backend_data_t;
+
+/**
+ * This function writes the machine settings of ifaces as
+ * VirtualMachine::saveSettings, the guest partition aside
+ */
+static bool backend_save(FakeBackend *backend, int machine, std::vector<Iface*> &ifaces)
+{
+	bool machineChanged = false;
+	for(int i = 0; i < ifaces.size(); i++)
+		machineChanged = machineChanged || ifaces.at(i)->isDirty(IFACE_DIRTY_MACHINE);
+
+	if(!machineChanged)
+		return true;
+
+	if(!backend->lockMachine(machine))
+		return false;
+
+	bool succeeded = AdapterSync::writeIfaces(backend, machine, ifaces.data(), ifaces.size());
+	succeeded = backend->saveSettings(machine) && succeeded;
+
+	for(int i = 0; i < ifaces.size(); i++)
+		ifaces.at(i)->clearDirty();
+
+	return backend->unlockMachine(machine) && succeeded;
+}
+
+static void backend_init(backend_data_t *d, FakeBackend *backend)
+{
+	d->backend = backend;
+	d->ifaces.resize(backend->getMachinesCount());
+
+	//Every machine of the lab is imported once, so all of its ifaces are enabled
+	for(int m = 0; m < d->ifaces.size(); m++)
+	{
+		for(int i = 0; i < BENCH_IFACES; i++)
+		{
+			settings_iface_t settings_iface;
+			fillIface(&settings_iface, m, i);
+			d->ifaces.at(m).push_back(new Iface(settings_iface));
+		}
+		backend_save(backend, m, d->ifaces.at(m));
+	}
+}
+
+static void backend_free(backend_data_t *d)
+{
+	for(int m = 0; m < d->ifaces.size(); m++)
+		for(int i = 0; i < d->ifaces.at(m).size(); i++)
+			delete d->ifaces.at(m).at(i);
+
+	d->ifaces.clear();
+}
+
+static void bench_backend_startup(void *data, uint64_t iterations)
+{
+	backend_data_t *d = (backend_data_t *) data;
+	FakeBackend *backend = d->backend;
+
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		//As the main window with VirtualMachine::populateIfaces, guest names aside
+		for(int m = 0; m < backend->getMachinesCount(); m++)
+		{
+			sink += backend->getName(m).size() + backend->getUUID(m).size() + backend->getState(m);
+
+			std::vector<backend_adapter_t> adapters;
+			sink += AdapterSync::readAdapters(backend, m, &adapters);
+			for(int j = 0; j < adapters.size(); j++)
+			{
+				Iface iface(adapters.at(j).enabled, adapters.at(j).mac, adapters.at(j).cableConnected, adapters.at(j).attachmentType, adapters.at(j).attachmentData);
+				sink += iface.record.mac;
+			}
+		}
+	}
+}
+
+static void bench_backend_import(void *data, uint64_t iterations)
+{
+	backend_data_t *d = (backend_data_t *) data;
+
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		//As a machine created by the import: nothing of its ifaces has been written yet
+		for(int m = 0; m < d->ifaces.size(); m++)
+		{
+			for(int j = 0; j < d->ifaces.at(m).size(); j++)
+				d->ifaces.at(m).at(j)->markDirty(IFACE_DIRTY_ALL);
+
+			sink += backend_save(d->backend, m, d->ifaces.at(m));
+		}
+	}
+}
+
+static void bench_backend_import_dirty(void *data, uint64_t iterations)
+{
+	backend_data_t *d = (backend_data_t *) data;
+	QString attachmentData[2] = { QString::fromUtf8("intnet0"), QString::fromUtf8("intnet0b") };
+
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		//Only the attachment of one iface changed, as a typical topology edit
+		for(int m = 0; m < d->ifaces.size(); m++)
+		{
+			d->ifaces.at(m).at(0)->setAttachmentData(attachmentData[(i + 1) % 2]);
+			sink += backend_save(d->backend, m, d->ifaces.at(m));
+		}
+	}
+
+	//The lab is left as imported
+	for(int m = 0; m < d->ifaces.size(); m++)
+	{
+		d->ifaces.at(m).at(0)->setAttachmentData(attachmentData[0]);
+		backend_save(d->backend, m, d->ifaces.at(m));
+	}
+}
+
+static void bench_backend_bulk_start(void *data, uint64_t iterations)
+{
+	backend_data_t *d = (backend_data_t *) data;
+	FakeBackend *backend = d->backend;
+
+	for(uint64_t i = 0; i < iterations; i++)
+	{
+		//As "Avvia tutte": the commands run one at a time, as VirtualMachine::start
+		for(int m = 0; m < d->ifaces.size(); m++)
+		{
+			if(!backend->lockMachine(m))
+				continue;
+
+			sink += AdapterSync::writeCableStates(backend, m, d->ifaces.at(m).data(), d->ifaces.at(m).size());
+			sink += backend->saveSettings(m);
+			sink += backend->unlockMachine(m);
+
+			HypervisorProgress *progress = backend->launch(m);
+			if(progress != NULL)
+				sink += HypervisorBackend::wait(progress);
+			delete progress;
+		}
+
+		for(int m = 0; m < d->ifaces.size(); m++)
+		{
+			HypervisorProgress *progress = backend->powerDown(m);
+			if(progress != NULL)
+				sink += HypervisorBackend::wait(progress);
+			delete progress;
+		}
+	}
+}
+
+static bool makeBenchDir()
+{
+	//Guest partitions are read from a mounted disk, tmpfs keeps the disk out of the measure
+	std::string prefix = "/dev/shm";
+	struct stat s;
+	if(stat(prefix.c_str(), &s) < 0 || !S_ISDIR(s.st_mode) || access(prefix.c_str(), W_OK) < 0)
+	{
+		const char *tmpdir = getenv("TMPDIR");
+		prefix = (tmpdir == NULL) ? "/tmp" : tmpdir;
+	}
+
+	std::string dir_template = prefix + "/" + PROGRAM_NAME + "-bench.XXXXXX";
+	std::vector<char> dir(dir_template.begin(), dir_template.end());
+	dir.push_back('\0');
+
+	if(mkdtemp(&dir[0]) == NULL)
+		return false;
+
+	bench_dir = &dir[0];
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string out_fileName, filter;
+	uint32_t min_time = BENCHMARK_MIN_TIME, latency = 0, progress = 0;
+
+	for(int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if(i + 1 >= argc)
+		{
+			usage(argv[0]);
+			return EXIT_USAGE;
+		}
+
+		if(arg == "--out")
+			out_fileName = argv[++i];
+		else if(arg == "--filter")
+			filter = argv[++i];
+		else if(arg == "--min-time")
+			min_time = atoi(argv[++i]);
+		else if(arg == "--latency")
+			latency = atoi(argv[++i]);
+		else if(arg == "--progress")
+			progress = atoi(argv[++i]);
+		else
+		{
+			usage(argv[0]);
+			return EXIT_USAGE;
+		}
+	}
+
+	if(!makeBenchDir())
+	{
+		std::cerr << "Cannot create the benchmark directory" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	//Messages of the shared core go to stderr, stdout carries only the results
+	std::ostream out(std::cout.rdbuf());
+	std::cout.rdbuf(std::cerr.rdbuf());
+	Log::init();
+
+	Benchmark benchmark(min_time);
+	benchmark.setFilter(filter);
+	benchmark.addContext("executable", argv[0]);
+	benchmark.addContext("program_version", PROGRAM_NAME " " PROGRAM_VERSION);
+	benchmark.addContext("backend_latency_us", number(latency));
+	benchmark.addContext("backend_progress_ms", number(progress));
+#ifdef USE_ZLIB
+	benchmark.addContext("zlib_version", ZlibWrapper::getZlibVersion().toStdString());
+#endif
+
+	ifaces_data_t ifaces_data;
+	ifaces_data.serialized_ifaces = NULL;
+	for(int i = 0; i < BENCH_IFACES; i++)
+		fillIface(&ifaces_data.ifaces[i], 0, i);
+	uint32_t serialized_ifaces_size = VMSettings::serialize(&ifaces_data.serialized_ifaces, ifaces_data.ifaces, BENCH_IFACES);
+
+	benchmark.run("vmsettings_serialize/8", bench_serialize, &ifaces_data, serialized_ifaces_size);
+	benchmark.run("vmsettings_deserialize/8", bench_deserialize, &ifaces_data, serialized_ifaces_size);
+	benchmark.run("vmsettings_ifaces_checksum/8", bench_ifaces_checksum, &ifaces_data, serialized_ifaces_size);
+
+	//The machines set file format counts machines in one byte
+	int archive_sizes[] = { 10, 100, UINT8_MAX };
+	for(int i = 0; i < sizeof(archive_sizes) / sizeof(int); i++)
+	{
+		archive_data_t plain;
+		archive_init(&plain, archive_sizes[i], 'P');
+		uint64_t plain_size = archive_sizes[i] * (sizeof(uint32_t) + sizeof(settings_header_t) + serialized_ifaces_size);
+
+		benchmark.run("archive_write_plain/" + number(archive_sizes[i]), bench_archive_write, &plain, plain_size);
+		benchmark.run("archive_read_plain/" + number(archive_sizes[i]), bench_archive_read, &plain, plain_size);
+		archive_free(&plain);
+
+#ifdef USE_ZLIB
+		archive_data_t deflated;
+		archive_init(&deflated, archive_sizes[i], 'Z');
+		benchmark.run("archive_write_zlib/" + number(archive_sizes[i]), bench_archive_write, &deflated, plain_size);
+		benchmark.run("archive_read_zlib/" + number(archive_sizes[i]), bench_archive_read, &deflated, plain_size);
+		archive_free(&deflated);
+#endif
+	}
+
+	//A 100 machines set, as deflated in a machines set file
+	archive_data_t lab;
+	archive_init(&lab, 100, 'P');
+	QFile lab_file(lab.fileName);
+	lab_file.open(QIODevice::ReadOnly);
+	QByteArray lab_data = lab_file.readAll();
+	lab_file.close();
+	archive_free(&lab);
+
+	buffer_data_t crc_data;
+	crc_data.buffer = lab_data.data();
+	crc_data.size = lab_data.size();
+	benchmark.run("crc32_add/" + number(crc_data.size), bench_crc32_add, &crc_data, crc_data.size);
+
+#ifdef USE_ZLIB
+	benchmark.run("zlib_def/" + number(crc_data.size), bench_zlib_def, &crc_data, crc_data.size);
+
+	buffer_data_t inf_data;
+	inf_data.size = ZlibWrapper::def(&inf_data.buffer, lab_data.data(), lab_data.size(), -1);
+	benchmark.run("zlib_inf/" + number(crc_data.size), bench_zlib_inf, &inf_data, crc_data.size);
+	free(inf_data.buffer);
+#endif
+
+	validators_data_t validators_data;
+	for(int m = 0; m < 64; m++)
+	{
+		settings_iface_t settings_iface;
+		fillIface(&settings_iface, m, m % BENCH_IFACES);
+		validators_data.names.push_back(QString::fromUtf8(settings_iface.name));
+		validators_data.macs.push_back(QString::fromUtf8(settings_iface.mac));
+		validators_data.ips.push_back(QString::fromUtf8(settings_iface.ip));
+		validators_data.subnetMasks.push_back(QString::fromUtf8(settings_iface.subnetMask));
+	}
+
+	benchmark.run("iface_is_valid_name", bench_valid_name, &validators_data);
+	benchmark.run("iface_is_valid_mac", bench_valid_mac, &validators_data);
+	benchmark.run("iface_format_mac", bench_format_mac, &validators_data);
+#ifdef CONFIGURABLE_IP
+	benchmark.run("iface_is_valid_ipv4", bench_valid_ip, &validators_data);
+	benchmark.run("iface_is_valid_subnetmask", bench_valid_subnetmask, &validators_data);
+#endif
+
+	guest_data_t guest_data;
+	guest_init(&guest_data);
+	benchmark.run("guest_parse_iface_name", bench_parse_iface_name, &guest_data);
+	benchmark.run("guest_parse_ifcfg", bench_parse_ifcfg, &guest_data);
+	guest_free(&guest_data);
+
+	FakeBackend backend(BENCH_BACKEND_MACHINES, BENCH_IFACES);
+	backend_data_t backend_data;
+	backend_init(&backend_data, &backend);
+	backend.setCallLatency(latency);
+	backend.setProgressDuration(progress);
+
+	benchmark.run("backend_startup/" + number(BENCH_BACKEND_MACHINES), bench_backend_startup, &backend_data);
+	benchmark.run("backend_import/" + number(BENCH_BACKEND_MACHINES), bench_backend_import, &backend_data);
+	benchmark.run("backend_import_dirty/" + number(BENCH_BACKEND_MACHINES), bench_backend_import_dirty, &backend_data);
+	benchmark.run("backend_bulk_start/" + number(BENCH_BACKEND_MACHINES), bench_backend_bulk_start, &backend_data);
+	backend_free(&backend_data);
+
+	free(ifaces_data.serialized_ifaces);
+	rmdir(bench_dir.c_str());
+
+	int retval = EXIT_SUCCESS;
+	if(out_fileName.empty())
+		benchmark.writeJson(out);
+	else
+	{
+		std::ofstream out_file(out_fileName.c_str());
+		if(out_file)
+			benchmark.writeJson(out_file);
+		else
+		{
+			std::cerr << "Cannot write " << out_fileName << std::endl;
+			retval = EXIT_FAILURE;
+		}
+	}
+
+	Log::shutdown();
+	std::cout.rdbuf(out.rdbuf());
+	return retval;
+}
@@ -0,0 +1,144 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// VB-ANT - VirtualBox - Advanced Network Tool, strumento a riga di comando
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <iostream>
+#include <stdlib.h>
+#include "CliController.h"
+#include "VMSettingsJournal.h"
+#include "Trace.h"
+#include "XpcomStats.h"
+#include "Log.h"
+
+#define EXIT_USAGE 2
+
+static void usage(const char *program)
+{
+	std::cerr << "Usage: " << program << " <command> [options]" << std::endl
+		  << "  list" << std::endl
+		  << "  start (--all | <machine>...)" << std::endl
+		  << "  stop [--acpi] (--all | <machine>...)" << std::endl
+#ifdef USE_ZLIB
+		  << "  export [--deflate] [--base <archive>] <archive> [<machine>...]" << std::endl
+#else
+		  << "  export [--base <archive>] <archive> [<machine>...]" << std::endl
+#endif
+		  << "  import [--stop] [--create] <archive> [<machine>...]" << std::endl
+		  << "Machines are selected by name or UUID, every machine if none is given to export and import." << std::endl
+		  << "With " XPCOM_STATS_ARG " the VirtualBox calls made are reported on exit." << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+	QStringList args = QCoreApplication::arguments();
+
+	if(args.count() < 2)
+	{
+		usage(argv[0]);
+		return EXIT_USAGE;
+	}
+
+	QString command = args.at(1);
+	bool all = false, acpi = false, deflate = false, stopRunning = false, create = false, stats = false;
+	QString base_fileName;
+	QStringList operands;
+
+	for(int i = 2; i < args.count(); i++)
+	{
+		if(args.at(i) == "--all")
+			all = true;
+		else if(args.at(i) == "--acpi")
+			acpi = true;
+		else if(args.at(i) == "--deflate")
+			deflate = true;
+		else if(args.at(i) == "--stop")
+			stopRunning = true;
+		else if(args.at(i) == "--create")
+			create = true;
+		else if(args.at(i) == XPCOM_STATS_ARG)
+			stats = true;
+		else if(args.at(i) == "--base" && i + 1 < args.count())
+			base_fileName = args.at(++i);
+		else if(args.at(i).startsWith("--"))
+		{
+			usage(argv[0]);
+			return EXIT_USAGE;
+		}
+		else
+			operands << args.at(i);
+	}
+
+	//Start and stop never select every machine implicitly
+	bool valid;
+	if(command == "list")
+		valid = operands.isEmpty();
+	else if(command == "start" || command == "stop")
+		valid = (all && operands.isEmpty()) || (!all && !operands.isEmpty());
+	else if(command == "export" || command == "import")
+		valid = !operands.isEmpty();
+	else
+		valid = false;
+
+	if(!valid)
+	{
+		usage(argv[0]);
+		return EXIT_USAGE;
+	}
+
+	//Messages of the shared core go to stderr, stdout carries only command results
+	std::ostream out(std::cout.rdbuf());
+	std::cout.rdbuf(std::cerr.rdbuf());
+	Trace::init();
+	Log::init();
+
+	//Archive operands are followed by the selected machines
+	QString fileName;
+	if(command == "export" || command == "import")
+		fileName = operands.takeFirst();
+
+	int retval;
+	{
+		CliController controller(out);
+
+		if(command == "list")
+			retval = controller.list();
+		else if(command == "start")
+			retval = controller.start(operands);
+		else if(command == "stop")
+			retval = controller.stop(operands, acpi);
+		else if(command == "export")
+			retval = controller.exportMachines(fileName, operands, deflate, base_fileName);
+		else
+			retval = controller.importMachines(fileName, operands, stopRunning, create);
+	}
+
+	VMSettingsJournal::shutdown();
+	Log::shutdown();
+	Trace::shutdown();
+	if(stats)
+		XpcomStats::report(std::cerr);
+	std::cout.rdbuf(out.rdbuf());
+	return retval;
+}
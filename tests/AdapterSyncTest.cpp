@@ -0,0 +1,293 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QtTest/QtTest>
+#include <string.h>
+#include <vector>
+
+#include "AdapterSync.h"
+#include "FakeBackend.h"
+#include "Iface.h"
+
+/**
+ * Startup, import and start paths of VirtualMachine, run over FakeBackend
+ */
+class AdapterSyncTest : public QObject
+{
+	Q_OBJECT;
+
+	private:
+		static std::vector<Iface*> readIfaces(HypervisorBackend *backend, int machine);
+		static void deleteIfaces(std::vector<Iface*> &ifaces);
+		static settings_iface_t settingsIface(bool enabled, const char *mac, bool cableConnected, uint32_t attachmentType, const char *attachmentData);
+
+	private slots:
+		void startupReadsAdapters();
+		void importWritesSettings();
+		void importWritesOnlyDirtyFields();
+		void importRollsBackFailedFields();
+		void bulkStartWritesCables();
+		void bulkStartReportsFailedLaunch();
+		void startWritesCopiedCables();
+};
+
+std::vector<Iface*> AdapterSyncTest::readIfaces(HypervisorBackend *backend, int machine)
+{
+	std::vector<backend_adapter_t> adapters;
+	std::vector<Iface*> ifaces;
+
+	if(!AdapterSync::readAdapters(backend, machine, &adapters))
+		return ifaces;
+
+	//As in VirtualMachine::populateIfaces, with no guest partition to read names from
+	for(int i = 0; i < adapters.size(); i++)
+		ifaces.push_back(new Iface(adapters.at(i).enabled, adapters.at(i).mac, adapters.at(i).cableConnected, adapters.at(i).attachmentType, adapters.at(i).attachmentData));
+
+	return ifaces;
+}
+
+void AdapterSyncTest::deleteIfaces(std::vector<Iface*> &ifaces)
+{
+	while(!ifaces.empty())
+	{
+		delete ifaces.back();
+		ifaces.pop_back();
+	}
+}
+
+settings_iface_t AdapterSyncTest::settingsIface(bool enabled, const char *mac, bool cableConnected, uint32_t attachmentType, const char *attachmentData)
+{
+	settings_iface_t settings_iface;
+	memset(&settings_iface, 0, sizeof(settings_iface_t));
+
+	settings_iface.enabled = enabled;
+	strncpy(settings_iface.mac, mac, sizeof(settings_iface.mac) - 1);
+	settings_iface.cableConnected = cableConnected;
+	settings_iface.attachmentType = attachmentType;
+	strncpy(settings_iface.attachmentData, attachmentData, sizeof(settings_iface.attachmentData) - 1);
+
+	return settings_iface;
+}
+
+void AdapterSyncTest::startupReadsAdapters()
+{
+	FakeBackend backend(2, 8);
+	std::vector<Iface*> ifaces = readIfaces(&backend, 1);
+
+	QCOMPARE((int) ifaces.size(), 8);
+	QVERIFY(ifaces.at(0)->enabled);
+	QVERIFY(ifaces.at(0)->cableConnected);
+	QCOMPARE(ifaces.at(0)->attachmentType, (uint32_t) NetworkAttachmentType::NAT);
+	QCOMPARE(ifaces.at(0)->mac, Iface::formatMac(QString::fromUtf8("08:00:27:00:00:08")));
+	QVERIFY(!ifaces.at(7)->enabled);
+	QCOMPARE(ifaces.at(7)->mac, Iface::formatMac(QString::fromUtf8("08:00:27:00:00:0F")));
+
+	//What has just been read needs no writing
+	for(int i = 0; i < ifaces.size(); i++)
+		QVERIFY(!ifaces.at(i)->isDirty());
+
+	deleteIfaces(ifaces);
+}
+
+void AdapterSyncTest::importWritesSettings()
+{
+	FakeBackend backend(1, 4);
+
+	//Imported ifaces are created from the archive, as in VMSettings::set_machine
+	std::vector<Iface*> ifaces;
+	ifaces.push_back(new Iface(settingsIface(true, "08:00:27:AA:00:01", true, NetworkAttachmentType::Internal, "lan1")));
+	ifaces.push_back(new Iface(settingsIface(true, "08:00:27:AA:00:02", false, NetworkAttachmentType::Internal, "lan2")));
+	ifaces.push_back(new Iface(settingsIface(false, "08:00:27:AA:00:03", true, NetworkAttachmentType::Internal, "lan3")));
+	ifaces.push_back(new Iface(settingsIface(false, "08:00:27:AA:00:04", false, NetworkAttachmentType::Null, "")));
+
+	QVERIFY(backend.lockMachine(0));
+	QVERIFY(AdapterSync::writeIfaces(&backend, 0, ifaces.data(), ifaces.size()));
+	QVERIFY(backend.saveSettings(0));
+	QVERIFY(backend.unlockMachine(0));
+
+	backend_adapter_t adapter;
+	QVERIFY(backend.getAdapter(0, 0, &adapter));
+	QVERIFY(adapter.enabled);
+	QCOMPARE(Iface::formatMac(adapter.mac), ifaces.at(0)->mac);
+	QCOMPARE(adapter.attachmentType, (uint32_t) NetworkAttachmentType::Internal);
+	QCOMPARE(adapter.attachmentData, QString::fromUtf8("lan1"));
+
+	QVERIFY(backend.getAdapter(0, 1, &adapter));
+	QVERIFY(adapter.enabled);
+	QVERIFY(!adapter.cableConnected);
+	QCOMPARE(adapter.attachmentData, QString::fromUtf8("lan2"));
+
+	//Only the state and the MAC address of a disabled iface are written
+	QVERIFY(backend.getAdapter(0, 2, &adapter));
+	QVERIFY(!adapter.enabled);
+	QCOMPARE(Iface::formatMac(adapter.mac), ifaces.at(2)->mac);
+	QCOMPARE(adapter.attachmentType, (uint32_t) NetworkAttachmentType::Null);
+	QCOMPARE(adapter.attachmentData, QString::fromUtf8(""));
+
+	deleteIfaces(ifaces);
+}
+
+void AdapterSyncTest::importWritesOnlyDirtyFields()
+{
+	FakeBackend backend(1, 8);
+	std::vector<Iface*> ifaces = readIfaces(&backend, 0);
+
+	ifaces.at(0)->setAttachmentType(NetworkAttachmentType::Internal);
+	ifaces.at(0)->setAttachmentData(QString::fromUtf8("lan1"));
+	ifaces.at(5)->setAttachmentData(QString::fromUtf8("lan5"));
+
+	QVERIFY(backend.lockMachine(0));
+	uint64_t calls = backend.getCalls();
+	QVERIFY(AdapterSync::writeIfaces(&backend, 0, ifaces.data(), ifaces.size()));
+
+	//Type and data of iface 0; iface 5 is disabled, so nothing of it is written
+	QCOMPARE(backend.getCalls() - calls, (uint64_t) 2);
+
+	//As in VirtualMachine::saveSettings, written fields are no longer dirty
+	for(int i = 0; i < ifaces.size(); i++)
+		ifaces.at(i)->clearDirty();
+
+	ifaces.at(5)->enabled = true;
+	ifaces.at(5)->markDirty(IFACE_DIRTY_ENABLED);
+	calls = backend.getCalls();
+	QVERIFY(AdapterSync::writeIfaces(&backend, 0, ifaces.data(), ifaces.size()));
+
+	//A newly enabled iface has every setting written, except its MAC address
+	QCOMPARE(backend.getCalls() - calls, (uint64_t) 4);
+	QVERIFY(backend.unlockMachine(0));
+
+	backend_adapter_t adapter;
+	QVERIFY(backend.getAdapter(0, 5, &adapter));
+	QVERIFY(adapter.enabled);
+	QCOMPARE(adapter.attachmentData, QString::fromUtf8("lan5"));
+
+	deleteIfaces(ifaces);
+}
+
+void AdapterSyncTest::importRollsBackFailedFields()
+{
+	FakeBackend backend(1, 2);
+	std::vector<Iface*> ifaces = readIfaces(&backend, 0);
+
+	//Adapters cannot be written while the machine is not locked
+	ifaces.at(0)->cableConnected = false;
+	ifaces.at(0)->markDirty(IFACE_DIRTY_CONNECTED);
+	ifaces.at(0)->setAttachmentType(NetworkAttachmentType::Internal);
+	QVERIFY(!AdapterSync::writeIfaces(&backend, 0, ifaces.data(), ifaces.size()));
+
+	QVERIFY(ifaces.at(0)->cableConnected);
+	QCOMPARE(ifaces.at(0)->attachmentType, (uint32_t) NetworkAttachmentType::NAT);
+
+	deleteIfaces(ifaces);
+}
+
+void AdapterSyncTest::bulkStartWritesCables()
+{
+	FakeBackend backend(4, 2);
+	std::vector<HypervisorProgress*> progresses;
+
+	//Every machine is launched before waiting for the first one, as in the command line tool
+	for(int machine = 0; machine < backend.getMachinesCount(); machine++)
+	{
+		std::vector<Iface*> ifaces = readIfaces(&backend, machine);
+		ifaces.at(0)->cableConnected = false;
+
+		QVERIFY(backend.lockMachine(machine));
+		QVERIFY(AdapterSync::writeCableStates(&backend, machine, ifaces.data(), ifaces.size()));
+		QVERIFY(backend.saveSettings(machine));
+		QVERIFY(backend.unlockMachine(machine));
+
+		HypervisorProgress *progress = backend.launch(machine);
+		QVERIFY(progress != NULL);
+		progresses.push_back(progress);
+
+		deleteIfaces(ifaces);
+	}
+
+	for(int machine = 0; machine < progresses.size(); machine++)
+	{
+		QCOMPARE(HypervisorBackend::wait(progresses.at(machine)), (int32_t) 0);
+		delete progresses.at(machine);
+
+		backend_adapter_t adapter;
+		QVERIFY(backend.getAdapter(machine, 0, &adapter));
+		QVERIFY(!adapter.cableConnected);
+		QCOMPARE(backend.getState(machine), (uint32_t) MachineState::Running);
+	}
+
+	//A running machine is neither locked nor launched again
+	QVERIFY(!backend.lockMachine(0));
+	QVERIFY(backend.launch(0) == NULL);
+}
+
+void AdapterSyncTest::bulkStartReportsFailedLaunch()
+{
+	FakeBackend backend(3, 1);
+	backend.setProgressDuration(10);
+	backend.setLaunchResult(1, 1);
+
+	std::vector<HypervisorProgress*> progresses;
+	for(int machine = 0; machine < backend.getMachinesCount(); machine++)
+		progresses.push_back(backend.launch(machine));
+
+	QCOMPARE(HypervisorBackend::wait(progresses.at(0)), (int32_t) 0);
+	QCOMPARE(HypervisorBackend::wait(progresses.at(1)), (int32_t) 1);
+	QCOMPARE(HypervisorBackend::wait(progresses.at(2)), (int32_t) 0);
+
+	QCOMPARE(backend.getState(0), (uint32_t) MachineState::Running);
+	QCOMPARE(backend.getState(1), (uint32_t) MachineState::PoweredOff);
+	QCOMPARE(backend.getState(2), (uint32_t) MachineState::Running);
+
+	for(int machine = 0; machine < progresses.size(); machine++)
+		delete progresses.at(machine);
+}
+
+void AdapterSyncTest::startWritesCopiedCables()
+{
+	FakeBackend backend(1, 2);
+	std::vector<Iface*> ifaces = readIfaces(&backend, 0);
+	ifaces.at(0)->cableConnected = false;
+
+	//The copy is taken on the GUI thread, later edits of the ifaces are not written
+	std::vector<settings_iface_t> settings_ifaces;
+	for(int i = 0; i < ifaces.size(); i++)
+		settings_ifaces.push_back(ifaces.at(i)->getSerializableIface());
+	ifaces.at(0)->cableConnected = true;
+	settings_ifaces.at(1).cableConnected = true;
+
+	QVERIFY(backend.lockMachine(0));
+	QVERIFY(AdapterSync::writeCableStates(&backend, 0, &settings_ifaces[0], settings_ifaces.size()));
+	QVERIFY(backend.unlockMachine(0));
+
+	backend_adapter_t adapter;
+	QVERIFY(backend.getAdapter(0, 0, &adapter));
+	QVERIFY(!adapter.cableConnected);
+
+	//Disabled ifaces keep the cable state of their adapter
+	QVERIFY(backend.getAdapter(0, 1, &adapter));
+	QVERIFY(!adapter.cableConnected);
+
+	deleteIfaces(ifaces);
+}
+
+QTEST_APPLESS_MAIN(AdapterSyncTest)
+
+#include "AdapterSyncTest.moc"
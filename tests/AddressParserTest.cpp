@@ -0,0 +1,119 @@
+/*
+ * VB-ANT - VirtualBox - Advanced Network Tool
+ * Copyright (C) 2017  Dario Messina
+ *
+ * This file is part of VB-ANT
+ *
+ * VB-ANT is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * VB-ANT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QtTest/QtTest>
+#include <string.h>
+
+#include "AddressParser.h"
+
+/**
+ * Accepted and rejected forms of MAC and IPv6 addresses
+ */
+class AddressParserTest : public QObject
+{
+	Q_OBJECT;
+
+	private:
+		static bool parseMac(const char *str, uint64_t *mac);
+		static bool parseIPv6(const char *str);
+
+	private slots:
+		void macForms();
+		void macGroupDigits();
+		void macDottedGroupDigits();
+		void ipv6ZoneIndex();
+};
+
+bool AddressParserTest::parseMac(const char *str, uint64_t *mac)
+{
+	//Both the ASCII and the UTF-16 parsers have to agree
+	uint64_t value = 0;
+	QString qStr = QString::fromUtf8(str);
+	bool parsed = AddressParser::parseMac(str, strlen(str), mac);
+	if(AddressParser::parseMac(qStr.constData(), qStr.length(), &value) != parsed)
+		return false;
+
+	return parsed && value == *mac;
+}
+
+bool AddressParserTest::parseIPv6(const char *str)
+{
+	ipv6_address_t ip;
+	return AddressParser::parseIPv6(str, strlen(str), &ip);
+}
+
+void AddressParserTest::macForms()
+{
+	uint64_t mac;
+
+	QVERIFY(parseMac("08:00:27:0A:0B:0C", &mac));
+	QCOMPARE(mac, (uint64_t) 0x0800270A0B0CULL);
+	QVERIFY(parseMac("08-00-27-0a-0b-0c", &mac));
+	QCOMPARE(mac, (uint64_t) 0x0800270A0B0CULL);
+	QVERIFY(parseMac("0800.270a.0b0c", &mac));
+	QCOMPARE(mac, (uint64_t) 0x0800270A0B0CULL);
+	QVERIFY(parseMac("0800270A0B0C", &mac));
+	QCOMPARE(mac, (uint64_t) 0x0800270A0B0CULL);
+	QVERIFY(parseMac("8:0:27:a:b:c", &mac));
+	QCOMPARE(mac, (uint64_t) 0x0800270A0B0CULL);
+
+	QVERIFY(!parseMac("08:00:27:0A:0B", &mac));
+	QVERIFY(!parseMac("08:00-27:0A:0B:0C", &mac));
+	QVERIFY(!parseMac("08:00:27:0A:0B:0G", &mac));
+	QVERIFY(!parseMac("08:00:27:0A::0C", &mac));
+}
+
+void AddressParserTest::macGroupDigits()
+{
+	uint64_t mac;
+
+	//Leading zeros do not make a group longer than two digits valid
+	QVERIFY(!parseMac("001:02:03:04:05:06", &mac));
+	QVERIFY(!parseMac("00:02:03:04:05:006", &mac));
+	QVERIFY(!parseMac("00-02-003-04-05-06", &mac));
+}
+
+void AddressParserTest::macDottedGroupDigits()
+{
+	uint64_t mac;
+
+	QVERIFY(!parseMac("00001.0203.0405", &mac));
+	QVERIFY(!parseMac("0001.00203.0405", &mac));
+	QVERIFY(!parseMac("001.0203.0405", &mac));
+}
+
+void AddressParserTest::ipv6ZoneIndex()
+{
+	QVERIFY(parseIPv6("fe80::1"));
+	QVERIFY(parseIPv6("fe80::1%eth0"));
+
+	//Every address of fe80::/10 is link-local
+	QVERIFY(parseIPv6("fe81::1%eth0"));
+	QVERIFY(parseIPv6("febf::1%eth0"));
+
+	QVERIFY(parseIPv6("fec0::1"));
+	QVERIFY(!parseIPv6("fec0::1%eth0"));
+	QVERIFY(!parseIPv6("2001:db8::1%eth0"));
+}
+
+QTEST_APPLESS_MAIN(AddressParserTest)
+
+#include "AddressParserTest.moc"